@@ -335,6 +335,7 @@ protected:
   double alpha4_;
   double alpha5_;
   std::string base_frame_id_;
+  bool beam_range_lookup_;
   double beam_skip_distance_;
   double beam_skip_error_threshold_;
   double beam_skip_threshold_;
@@ -342,6 +343,7 @@ protected:
   std::string global_frame_id_;
   double lambda_short_;
   double laser_likelihood_max_dist_;
+  std::string likelihood_field_cache_dir_;
   double laser_max_range_;
   double laser_min_range_;
   std::string sensor_model_type_;
@@ -354,9 +356,11 @@ protected:
   double alpha_fast_;
   double alpha_slow_;
   int resample_interval_;
+  std::string resample_model_type_;
   std::string robot_model_type_;
   tf2::Duration save_pose_period_;
   double sigma_hit_;
+  int sensor_update_threads_;
   bool tf_broadcast_;
   tf2::Duration transform_tolerance_;
   double a_thresh_;
@@ -0,0 +1,89 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef NAV2_AMCL__MAP__CLEARANCE_FIELD_HPP_
+#define NAV2_AMCL__MAP__CLEARANCE_FIELD_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "nav2_amcl/map/map.hpp"
+
+namespace nav2_amcl
+{
+
+/*
+ * @class ClearanceField
+ * @brief Distance of every map cell, in whole cells, to the nearest cell a ray cast by
+ * map_calc_range stops at: an occupied or unknown cell, or the outside of the map. Ray casts
+ * leap over the cells this distance proves free and only step cell by cell near obstacles,
+ * returning exactly the range of map_calc_range.
+ */
+class ClearanceField
+{
+public:
+  /*
+   * @brief Take in which cells of a map stop rays. The map isn't read after this
+   * @param map Map to cast rays in
+   */
+  explicit ClearanceField(const map_t * map);
+
+  /*
+   * @brief Compute the clearance of the cells, which may run on another thread than
+   * the one that constructed the field
+   */
+  void build();
+
+  /*
+   * @brief Extract a single range reading from the map, like map_calc_range
+   * @param ox X coordinate of the ray origin
+   * @param oy Y coordinate of the ray origin
+   * @param oa Angle of the ray
+   * @param max_range Maximum range of the ray
+   * @return Range to the first cell stopping the ray, or max_range
+   */
+  double calcRange(double ox, double oy, double oa, double max_range) const;
+
+  /*
+   * @brief Get the clearance of a cell, 0 for cells stopping rays
+   * @param i X index of the cell, may be off the map
+   * @param j Y index of the cell, may be off the map
+   * @return Distance to the nearest cell stopping rays, in cells
+   */
+  inline uint16_t getClearance(int i, int j) const
+  {
+    if (i < 0 || j < 0 || i >= size_x_ || j >= size_y_) {
+      return 0;
+    }
+    return clearance_[i + j * size_x_];
+  }
+
+protected:
+  int size_x_;
+  int size_y_;
+  double origin_x_;
+  double origin_y_;
+  double scale_;
+  // Squared distances of the map padded by a border of cells stopping rays, until built
+  std::vector<double> squared_distances_;
+  std::vector<uint16_t> clearance_;
+};
+
+}  // namespace nav2_amcl
+
+#endif  // NAV2_AMCL__MAP__CLEARANCE_FIELD_HPP_
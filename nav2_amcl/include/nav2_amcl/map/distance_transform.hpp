@@ -0,0 +1,124 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef NAV2_AMCL__MAP__DISTANCE_TRANSFORM_HPP_
+#define NAV2_AMCL__MAP__DISTANCE_TRANSFORM_HPP_
+
+#include <math.h>
+
+#include <vector>
+
+namespace nav2_amcl
+{
+
+/*
+ * @brief One dimensional squared Euclidean distance transform, after Felzenszwalb and
+ * Huttenlocher: the lower envelope of the parabolas rooted at each element, in linear time
+ * @param at Accessor of the squared distance of the q-th element of the line, transformed
+ * in place
+ * @param n Number of elements in the line
+ * @param g Scratch copy of the line, n values
+ * @param v Scratch parabola roots, n values
+ * @param z Scratch parabola boundaries, n + 1 values
+ */
+template<typename AccessorT>
+void distanceTransform1D(AccessorT at, int n, double * g, int * v, double * z)
+{
+  for (int q = 0; q < n; q++) {
+    g[q] = at(q);
+  }
+
+  auto intersection = [g, v](int q, int k) {
+      double dq = q, dv = v[k];
+      return ((g[q] + dq * dq) - (g[v[k]] + dv * dv)) / (2.0 * (dq - dv));
+    };
+
+  int k = 0;
+  v[0] = 0;
+  z[0] = -HUGE_VAL;
+  z[1] = HUGE_VAL;
+  for (int q = 1; q < n; q++) {
+    double s = intersection(q, k);
+    while (s <= z[k]) {
+      k--;
+      s = intersection(q, k);
+    }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = HUGE_VAL;
+  }
+
+  k = 0;
+  for (int q = 0; q < n; q++) {
+    while (z[k + 1] < q) {
+      k++;
+    }
+    double dq = q - v[k];
+    at(q) = dq * dq + g[v[k]];
+  }
+}
+
+/*
+ * @brief Exact two dimensional squared Euclidean distance transform of a grid, a pass along
+ * the columns and then one along the rows, each line in parallel
+ * @param at Accessor of the squared distance of cell (i, j), transformed in place. Sources
+ * start at 0 and the other cells at any value larger than the squared diagonal of the grid
+ * @param size_x Number of columns
+ * @param size_y Number of rows
+ */
+template<typename AccessorT>
+void distanceTransform2D(AccessorT at, int size_x, int size_y)
+{
+  const int longest = size_x > size_y ? size_x : size_y;
+
+  #pragma omp parallel
+  {
+    std::vector<double> g(longest);
+    std::vector<int> v(longest);
+    std::vector<double> z(longest + 1);
+
+    #pragma omp for schedule(static)
+    for (int i = 0; i < size_x; i++) {
+      distanceTransform1D(
+        [&at, i](int q) -> double & {return at(i, q);}, size_y, g.data(), v.data(), z.data());
+    }
+
+    #pragma omp for schedule(static)
+    for (int j = 0; j < size_y; j++) {
+      distanceTransform1D(
+        [&at, j](int q) -> double & {return at(q, j);}, size_x, g.data(), v.data(), z.data());
+    }
+  }
+}
+
+/*
+ * @brief Get a squared distance further than any cell of a grid, that still keeps the
+ * parabola intersections of the transform exact in double precision
+ * @param size_x Number of columns
+ * @param size_y Number of rows
+ * @return Squared distance for cells without sources
+ */
+inline double farSquaredDistance(int size_x, int size_y)
+{
+  const double longest = size_x > size_y ? size_x : size_y;
+  return 2.0 * longest * longest + 1.0;
+}
+
+}  // namespace nav2_amcl
+
+#endif  // NAV2_AMCL__MAP__DISTANCE_TRANSFORM_HPP_
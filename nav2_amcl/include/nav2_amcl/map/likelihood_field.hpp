@@ -0,0 +1,141 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef NAV2_AMCL__MAP__LIKELIHOOD_FIELD_HPP_
+#define NAV2_AMCL__MAP__LIKELIHOOD_FIELD_HPP_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nav2_amcl/map/map.hpp"
+
+namespace nav2_amcl
+{
+
+/*
+ * @class LikelihoodField
+ * @brief Distance of every map cell to the nearest obstacle, quantized to a byte per cell
+ * in a dense row-major grid. Level 0 is an obstacle and level 255 is max_occ_dist or
+ * further, so beam endpoint lookups load one byte instead of a whole map_cell_t.
+ */
+class LikelihoodField
+{
+public:
+  static const int levels = 256;
+
+  /*
+   * @brief Quantize the distances of a map
+   * @param map Map whose cspace has been updated by map_update_cspace
+   */
+  explicit LikelihoodField(const map_t * map);
+
+  /*
+   * @brief LikelihoodField destructor, unmaps a field loaded from a file
+   */
+  ~LikelihoodField();
+
+  LikelihoodField(const LikelihoodField &) = delete;
+  LikelihoodField & operator=(const LikelihoodField &) = delete;
+
+  /*
+   * @brief Get the field of a map, memory mapped from the cache directory when it holds one
+   * for the same map and max_occ_dist. Otherwise the map's cspace is updated and the field
+   * computed from it is written to the cache for the next start. Cached fields are never
+   * removed.
+   * @param map Map to get the field of, its cspace is updated either way
+   * @param max_occ_dist Maximum distance for occupancy interest
+   * @param cache_dir Directory of the cached fields, empty to not use a cache
+   * @param cache_error Set to the reason the field couldn't be cached, if not null
+   * @return Field of the map
+   */
+  static std::unique_ptr<LikelihoodField> create(
+    map_t * map, double max_occ_dist, const std::string & cache_dir,
+    std::string * cache_error = NULL);
+
+  /*
+   * @brief Hash the size, resolution and occupancy of a map, the inputs of its cspace
+   * @param map Map to hash
+   * @return 64 bit FNV-1a hash
+   */
+  static uint64_t hashMap(const map_t * map);
+
+  /*
+   * @brief Memory map a field saved for a map
+   * @param filename File to load
+   * @param map Map the field must match the size of
+   * @param max_dist Maximum distance the field must cover
+   * @param hash Hash of the map the field must have been computed for
+   * @return Loaded field, null if the file is missing or doesn't match
+   */
+  static std::unique_ptr<LikelihoodField> load(
+    const std::string & filename, const map_t * map, double max_dist, uint64_t hash);
+
+  /*
+   * @brief Save the field, written to a temporary file then renamed so readers never see
+   * it partly written
+   * @param filename File to save to
+   * @param hash Hash of the map the field was computed for
+   * @return If the field was saved
+   */
+  bool save(const std::string & filename, uint64_t hash) const;
+
+  /*
+   * @brief Set the distances of a map's cells from the field
+   * @param map Map of the same size as the field
+   */
+  void toMap(map_t * map) const;
+
+  /*
+   * @brief Get the quantized distances, size_x * size_y bytes indexed like MAP_INDEX
+   */
+  const uint8_t * getData() const {return data_;}
+
+  int getSizeX() const {return size_x_;}
+  int getSizeY() const {return size_y_;}
+
+  /*
+   * @brief Get the distance covered by the levels, the map's max_occ_dist
+   */
+  double getMaxDistance() const {return max_dist_;}
+
+  /*
+   * @brief Get the distance a level stands for
+   * @param level Quantized distance
+   * @return Distance in meters
+   */
+  double toDistance(int level) const {return level * max_dist_ / (levels - 1);}
+
+protected:
+  LikelihoodField();
+
+  int size_x_;
+  int size_y_;
+  double max_dist_;
+  const uint8_t * data_;
+  // Storage of a computed field
+  std::vector<uint8_t> storage_;
+  // Mapping of a loaded field
+  void * mapping_;
+  size_t mapping_size_;
+};
+
+}  // namespace nav2_amcl
+
+#endif  // NAV2_AMCL__MAP__LIKELIHOOD_FIELD_HPP_
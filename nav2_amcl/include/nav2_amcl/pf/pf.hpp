@@ -57,6 +57,20 @@ typedef double (* pf_sensor_model_fn_t) (
   struct _pf_sample_set_t * set);
 
 
+// Schemes for drawing the new sample set from the weights of the current one
+typedef enum
+{
+  // Independent draws, by binary search of the cumulative weights
+  PF_RESAMPLE_MULTINOMIAL,
+  // One random offset, then evenly spaced draws
+  PF_RESAMPLE_SYSTEMATIC,
+  // One random draw within each evenly spaced stratum
+  PF_RESAMPLE_STRATIFIED,
+  // The whole number of copies each weight is due, then multinomial draws on the remainders
+  PF_RESAMPLE_RESIDUAL
+} pf_resample_type_t;
+
+
 // Information for a single sample
 typedef struct
 {
@@ -134,6 +148,17 @@ typedef struct _pf_t
   double dist_threshold;  // distance threshold in each axis over which the pf is considered to not
                           // be converged
   int converged;
+
+  // Resampling scheme
+  pf_resample_type_t resample_type;
+
+  // Duration of the last resampling, in seconds
+  double resample_time;
+
+  // Workspace for resampling, allocated once for max_samples: the cumulative weights and the
+  // drawn sample indices
+  double * resample_cumulative;
+  int * resample_indices;
 } pf_t;
 
 
@@ -161,6 +186,9 @@ void pf_update_sensor(pf_t * pf, pf_sensor_model_fn_t sensor_fn, void * sensor_d
 // Resample the distribution
 void pf_update_resample(pf_t * pf);
 
+// Select the resampling scheme
+void pf_set_resample_type(pf_t * pf, pf_resample_type_t resample_type);
+
 // Compute the CEP statistics (mean and variance).
 void pf_get_cep_stats(pf_t * pf, pf_vector_t * mean, double * var);
 
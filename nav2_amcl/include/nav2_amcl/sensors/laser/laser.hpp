@@ -18,10 +18,15 @@
 #ifndef NAV2_AMCL__SENSORS__LASER__LASER_HPP_
 #define NAV2_AMCL__SENSORS__LASER__LASER_HPP_
 
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
 #include "nav2_amcl/pf/pf.hpp"
 #include "nav2_amcl/pf/pf_pdf.hpp"
 #include "nav2_amcl/map/map.hpp"
+#include "nav2_amcl/map/clearance_field.hpp"
+#include "nav2_amcl/map/likelihood_field.hpp"
 
 namespace nav2_amcl
 {
@@ -62,6 +67,12 @@ public:
    */
   void SetLaserPose(pf_vector_t & laser_pose);
 
+  /*
+   * @brief Set the number of threads weighting the particles in a sensor update
+   * @param num_threads Number of threads, <= 0 to use all cores
+   */
+  void setNumThreads(int num_threads);
+
 protected:
   double z_hit_;
   double z_rand_;
@@ -79,6 +90,9 @@ protected:
   int max_samples_;
   int max_obs_;
   double ** temp_obs_;
+  // Particles are weighted independently across threads, then summed in sample order so
+  // the weights and their total don't depend on the thread count
+  int num_threads_;
 };
 
 /*
@@ -114,10 +128,13 @@ class BeamModel : public Laser
 public:
   /*
    * @brief BeamModel constructor
+   * @param use_range_lookup Whether to cast the rays through a clearance field of the map,
+   * built in the background, rather than cell by cell
    */
   BeamModel(
     double z_hit, double z_short, double z_max, double z_rand, double sigma_hit,
-    double lambda_short, double chi_outlier, size_t max_beams, map_t * map);
+    double lambda_short, double chi_outlier, size_t max_beams, map_t * map,
+    bool use_range_lookup = false);
 
   /*
    * @brief Run a sensor update on laser
@@ -133,6 +150,9 @@ private:
   double z_max_;
   double lambda_short_;
   double chi_outlier_;
+  // Clearance field of the map while it builds, and once it is ready
+  std::future<std::unique_ptr<ClearanceField>> clearance_future_;
+  std::unique_ptr<ClearanceField> clearance_;
 };
 
 /*
@@ -144,10 +164,12 @@ class LikelihoodFieldModel : public Laser
 public:
   /*
    * @brief BeamModel constructor
+   * @param field_cache_dir Directory to cache the likelihood field of the map in, empty to
+   * always compute it
    */
   LikelihoodFieldModel(
     double z_hit, double z_rand, double sigma_hit, double max_occ_dist,
-    size_t max_beams, map_t * map);
+    size_t max_beams, map_t * map, const std::string & field_cache_dir = "");
 
   /*
    * @brief Run a sensor update on laser
@@ -157,6 +179,12 @@ public:
    */
   bool sensorUpdate(pf_t * pf, LaserData * data);
 
+  /*
+   * @brief Get the reason the likelihood field couldn't be cached
+   * @return Reason, empty if it was cached or caching is disabled
+   */
+  const std::string & getFieldCacheError() const {return field_cache_error_;}
+
 private:
   /*
    * @brief Perform the update function
@@ -165,6 +193,20 @@ private:
    * @return if it was succesful
    */
   static double sensorFunction(LaserData * data, pf_sample_set_t * set);
+
+  /*
+   * @brief Gather the endpoints of the beams used in the update, in the laser frame
+   * @param data Laser data to use
+   */
+  void prepareBeams(LaserData * data);
+
+  std::unique_ptr<LikelihoodField> field_;
+  std::string field_cache_error_;
+  // z_hit weighted Gaussian of each field level, looked up instead of an exp() per beam
+  std::vector<float> gaussian_lut_;
+  // Beam endpoints in map cells, one array per coordinate so the beam loop vectorizes
+  std::vector<float> beam_x_;
+  std::vector<float> beam_y_;
 };
 
 /*
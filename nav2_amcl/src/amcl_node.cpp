@@ -86,6 +86,11 @@ AmclNode::AmclNode()
     "base_frame_id", rclcpp::ParameterValue(std::string("base_footprint")),
     "Which frame to use for the robot base");
 
+  add_parameter(
+    "beam_range_lookup", rclcpp::ParameterValue(false),
+    "Cast the rays of the beam model through a clearance field of the map, which leaps over free "
+    "space. The field is built in the background when the map arrives, with identical ranges");
+
   add_parameter("beam_skip_distance", rclcpp::ParameterValue(0.5));
   add_parameter("beam_skip_error_threshold", rclcpp::ParameterValue(0.9));
   add_parameter("beam_skip_threshold", rclcpp::ParameterValue(0.3));
@@ -103,6 +108,13 @@ AmclNode::AmclNode()
     "laser_likelihood_max_dist", rclcpp::ParameterValue(2.0),
     "Maximum distance to do obstacle inflation on map, for use in likelihood_field model");
 
+  add_parameter(
+    "likelihood_field_cache_dir", rclcpp::ParameterValue(std::string("")),
+    "Directory to cache the likelihood field of each map in, so it is loaded instead of "
+    "recomputed when AMCL starts on the same map, for use in likelihood_field model",
+    "Empty will always compute the likelihood field. Cached fields are never removed, "
+    "delete the fields of maps no longer used from the directory");
+
   add_parameter(
     "laser_max_range", rclcpp::ParameterValue(100.0),
     "Maximum scan range to be considered",
@@ -174,6 +186,13 @@ AmclNode::AmclNode()
     "resample_interval", rclcpp::ParameterValue(1),
     "Number of filter updates required before resampling");
 
+  add_parameter(
+    "resample_model_type", rclcpp::ParameterValue(std::string("multinomial")),
+    "How to draw the resampled particles, either multinomial, systematic, stratified or "
+    "residual",
+    "systematic, stratified and residual resampling are linear in the number of particles and "
+    "add less noise than multinomial resampling");
+
   add_parameter("robot_model_type", rclcpp::ParameterValue(std::string("differential")));
 
   add_parameter(
@@ -185,6 +204,11 @@ AmclNode::AmclNode()
 
   add_parameter("sigma_hit", rclcpp::ParameterValue(0.2));
 
+  add_parameter(
+    "sensor_update_threads", rclcpp::ParameterValue(1),
+    "Number of threads weighting the particles against each scan",
+    "0 or less will use all cores");
+
   add_parameter(
     "tf_broadcast", rclcpp::ParameterValue(true),
     "Set this to false to prevent amcl from publishing the transform between the global frame and "
@@ -695,6 +719,7 @@ AmclNode::laserReceived(sensor_msgs::msg::LaserScan::ConstSharedPtr laser_scan)
     if (!(++resample_count_ % resample_interval_)) {
       pf_update_resample(pf_);
       resampled = true;
+      RCLCPP_DEBUG(get_logger(), "Resampling took %f s", pf_->resample_time);
     }
 
     pf_sample_set_t * set = pf_->sets + pf_->current_set;
@@ -1025,22 +1050,28 @@ AmclNode::createLaserObject()
 {
   RCLCPP_INFO(get_logger(), "createLaserObject");
 
+  nav2_amcl::Laser * laser;
   if (sensor_model_type_ == "beam") {
-    return new nav2_amcl::BeamModel(
+    laser = new nav2_amcl::BeamModel(
       z_hit_, z_short_, z_max_, z_rand_, sigma_hit_, lambda_short_,
-      0.0, max_beams_, map_);
-  }
-
-  if (sensor_model_type_ == "likelihood_field_prob") {
-    return new nav2_amcl::LikelihoodFieldModelProb(
+      0.0, max_beams_, map_, beam_range_lookup_);
+  } else if (sensor_model_type_ == "likelihood_field_prob") {
+    laser = new nav2_amcl::LikelihoodFieldModelProb(
       z_hit_, z_rand_, sigma_hit_,
       laser_likelihood_max_dist_, do_beamskip_, beam_skip_distance_, beam_skip_threshold_,
       beam_skip_error_threshold_, max_beams_, map_);
+  } else {
+    auto likelihood_field_model = new nav2_amcl::LikelihoodFieldModel(
+      z_hit_, z_rand_, sigma_hit_,
+      laser_likelihood_max_dist_, max_beams_, map_, likelihood_field_cache_dir_);
+    if (!likelihood_field_model->getFieldCacheError().empty()) {
+      RCLCPP_WARN(get_logger(), "%s", likelihood_field_model->getFieldCacheError().c_str());
+    }
+    laser = likelihood_field_model;
   }
 
-  return new nav2_amcl::LikelihoodFieldModel(
-    z_hit_, z_rand_, sigma_hit_,
-    laser_likelihood_max_dist_, max_beams_, map_);
+  laser->setNumThreads(sensor_update_threads_);
+  return laser;
 }
 
 void
@@ -1055,6 +1086,7 @@ AmclNode::initParameters()
   get_parameter("alpha4", alpha4_);
   get_parameter("alpha5", alpha5_);
   get_parameter("base_frame_id", base_frame_id_);
+  get_parameter("beam_range_lookup", beam_range_lookup_);
   get_parameter("beam_skip_distance", beam_skip_distance_);
   get_parameter("beam_skip_error_threshold", beam_skip_error_threshold_);
   get_parameter("beam_skip_threshold", beam_skip_threshold_);
@@ -1062,6 +1094,7 @@ AmclNode::initParameters()
   get_parameter("global_frame_id", global_frame_id_);
   get_parameter("lambda_short", lambda_short_);
   get_parameter("laser_likelihood_max_dist", laser_likelihood_max_dist_);
+  get_parameter("likelihood_field_cache_dir", likelihood_field_cache_dir_);
   get_parameter("laser_max_range", laser_max_range_);
   get_parameter("laser_min_range", laser_min_range_);
   get_parameter("laser_model_type", sensor_model_type_);
@@ -1079,9 +1112,11 @@ AmclNode::initParameters()
   get_parameter("recovery_alpha_fast", alpha_fast_);
   get_parameter("recovery_alpha_slow", alpha_slow_);
   get_parameter("resample_interval", resample_interval_);
+  get_parameter("resample_model_type", resample_model_type_);
   get_parameter("robot_model_type", robot_model_type_);
   get_parameter("save_pose_rate", save_pose_rate);
   get_parameter("sigma_hit", sigma_hit_);
+  get_parameter("sensor_update_threads", sensor_update_threads_);
   get_parameter("tf_broadcast", tf_broadcast_);
   get_parameter("transform_tolerance", tmp_tol);
   get_parameter("update_min_a", a_thresh_);
@@ -1322,6 +1357,18 @@ AmclNode::initParticleFilter()
   pf_->pop_err = pf_err_;
   pf_->pop_z = pf_z_;
 
+  if (resample_model_type_ == "systematic") {
+    pf_set_resample_type(pf_, PF_RESAMPLE_SYSTEMATIC);
+  } else if (resample_model_type_ == "stratified") {
+    pf_set_resample_type(pf_, PF_RESAMPLE_STRATIFIED);
+  } else if (resample_model_type_ == "residual") {
+    pf_set_resample_type(pf_, PF_RESAMPLE_RESIDUAL);
+  } else if (resample_model_type_ != "multinomial") {
+    RCLCPP_WARN(
+      get_logger(), "Unknown resample model type %s, using multinomial resampling",
+      resample_model_type_.c_str());
+  }
+
   // Initialize the filter
   pf_vector_t pf_init_pose_mean = pf_vector_zero();
   pf_init_pose_mean.v[0] = init_pose_[0];
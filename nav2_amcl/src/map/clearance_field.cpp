@@ -0,0 +1,131 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <utility>
+#include <vector>
+
+#include "nav2_amcl/map/clearance_field.hpp"
+#include "nav2_amcl/map/distance_transform.hpp"
+
+namespace nav2_amcl
+{
+
+ClearanceField::ClearanceField(const map_t * map)
+: size_x_(map->size_x), size_y_(map->size_y),
+  origin_x_(map->origin_x), origin_y_(map->origin_y), scale_(map->scale)
+{
+  const int padded_x = size_x_ + 2;
+  const int padded_y = size_y_ + 2;
+  squared_distances_.assign(static_cast<size_t>(padded_x) * padded_y, 0.0);
+
+  const double far_squared_distance = farSquaredDistance(padded_x, padded_y);
+  for (int j = 0; j < size_y_; j++) {
+    for (int i = 0; i < size_x_; i++) {
+      if (map->cells[MAP_INDEX(map, i, j)].occ_state == -1) {
+        squared_distances_[(i + 1) + (j + 1) * padded_x] = far_squared_distance;
+      }
+    }
+  }
+}
+
+void
+ClearanceField::build()
+{
+  const int padded_x = size_x_ + 2;
+  const int padded_y = size_y_ + 2;
+  double * squared_distances = squared_distances_.data();
+  distanceTransform2D(
+    [squared_distances, padded_x](int i, int j) -> double & {
+      return squared_distances[i + j * padded_x];
+    },
+    padded_x, padded_y);
+
+  // Rounding down keeps every cell closer than the clearance free
+  clearance_.resize(static_cast<size_t>(size_x_) * size_y_);
+  for (int j = 0; j < size_y_; j++) {
+    for (int i = 0; i < size_x_; i++) {
+      const double distance = floor(sqrt(squared_distances[(i + 1) + (j + 1) * padded_x]));
+      clearance_[i + j * size_x_] = static_cast<uint16_t>(distance < 65535.0 ? distance : 65535.0);
+    }
+  }
+
+  std::vector<double>().swap(squared_distances_);
+}
+
+double
+ClearanceField::calcRange(double ox, double oy, double oa, double max_range) const
+{
+  // Same cells as map_calc_range, from the MAP_GXWX / MAP_GYWY arithmetic
+  auto cell_x = [this](double x) -> int {
+      return floor((x - origin_x_) / scale_ + 0.5) + size_x_ / 2;
+    };
+  auto cell_y = [this](double y) -> int {
+      return floor((y - origin_y_) / scale_ + 0.5) + size_y_ / 2;
+    };
+
+  int x0 = cell_x(ox);
+  int y0 = cell_y(oy);
+  int x1 = cell_x(ox + max_range * cos(oa));
+  int y1 = cell_y(oy + max_range * sin(oa));
+
+  const bool steep = abs(y1 - y0) > abs(x1 - x0);
+  if (steep) {
+    std::swap(x0, y0);
+    std::swap(x1, y1);
+  }
+
+  const int64_t deltax = abs(x1 - x0);
+  const int64_t deltay = abs(y1 - y0);
+  const int xstep = x0 < x1 ? 1 : -1;
+  const int ystep = y0 < y1 ? 1 : -1;
+
+  // Bresenham's line checks the cells n = 0 to deltax + 1 steps along the major axis, and
+  // has taken k(n) = floor(n * deltay / deltax + 1/2) steps along the minor one by then. A
+  // zero length line steps diagonally.
+  //
+  // The cells j steps further along the line are less than j * slope + 1 cells away, so
+  // with a clearance c, the next (c - 1) / slope steps only cross free cells
+  const int64_t last = deltax + 1;
+  const double inverse_slope = deltax > 0 ?
+    1.0 / sqrt(1.0 + static_cast<double>(deltay * deltay) / static_cast<double>(deltax * deltax)) :
+    M_SQRT1_2;
+
+  int64_t n = 0;
+  while (true) {
+    const int64_t k = deltax > 0 ? (2 * n * deltay + deltax) / (2 * deltax) : n;
+    const int x = x0 + xstep * n;
+    const int y = y0 + ystep * k;
+    const int clearance = steep ? getClearance(y, x) : getClearance(x, y);
+    if (clearance == 0) {
+      return sqrt(static_cast<double>(n * n + k * k)) * scale_;
+    }
+    if (n == last) {
+      return max_range;
+    }
+
+    int64_t skip = static_cast<int64_t>((clearance - 1) * inverse_slope);
+    n += skip > 1 ? skip : 1;
+    if (n > last) {
+      n = last;
+    }
+  }
+}
+
+}  // namespace nav2_amcl
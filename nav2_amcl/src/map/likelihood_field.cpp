@@ -0,0 +1,210 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include "nav2_amcl/map/likelihood_field.hpp"
+
+namespace nav2_amcl
+{
+
+namespace
+{
+
+const char kMagic[8] = {'A', 'M', 'C', 'L', 'L', 'F', '0', '1'};
+
+// Layout of the start of a saved field, the quantized distances follow
+struct FieldHeader
+{
+  char magic[8];
+  int32_t size_x;
+  int32_t size_y;
+  double max_dist;
+  uint64_t hash;
+};
+
+}  // namespace
+
+LikelihoodField::LikelihoodField()
+: size_x_(0), size_y_(0), max_dist_(0.0), data_(NULL), mapping_(NULL), mapping_size_(0)
+{
+}
+
+LikelihoodField::LikelihoodField(const map_t * map)
+: size_x_(map->size_x), size_y_(map->size_y), max_dist_(map->max_occ_dist),
+  storage_(static_cast<size_t>(map->size_x) * map->size_y, 0),
+  mapping_(NULL), mapping_size_(0)
+{
+  data_ = storage_.data();
+  if (max_dist_ <= 0.0) {
+    return;
+  }
+
+  const double steps_per_meter = (levels - 1) / max_dist_;
+  for (size_t i = 0; i < storage_.size(); i++) {
+    const double level = round(map->cells[i].occ_dist * steps_per_meter);
+    storage_[i] = static_cast<uint8_t>(level < levels - 1 ? level : levels - 1);
+  }
+}
+
+LikelihoodField::~LikelihoodField()
+{
+  if (mapping_) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+std::unique_ptr<LikelihoodField>
+LikelihoodField::create(
+  map_t * map, double max_occ_dist, const std::string & cache_dir, std::string * cache_error)
+{
+  if (cache_dir.empty()) {
+    map_update_cspace(map, max_occ_dist);
+    return std::make_unique<LikelihoodField>(map);
+  }
+
+  const uint64_t hash = hashMap(map);
+  char name[64];
+  snprintf(
+    name, sizeof(name), "/likelihood_field_%016llx_%ld.bin",
+    static_cast<unsigned long long>(hash), lround(max_occ_dist * 1000.0));  // NOLINT
+  const std::string filename = cache_dir + name;
+
+  std::unique_ptr<LikelihoodField> field = load(filename, map, max_occ_dist, hash);
+  if (field) {
+    field->toMap(map);
+    return field;
+  }
+
+  map_update_cspace(map, max_occ_dist);
+  field = std::make_unique<LikelihoodField>(map);
+  if (!field->save(filename, hash) && cache_error) {
+    *cache_error = "Unable to cache the likelihood field in " + filename;
+  }
+  return field;
+}
+
+uint64_t
+LikelihoodField::hashMap(const map_t * map)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  auto add = [&hash](const void * bytes, size_t size) {
+      for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<const uint8_t *>(bytes)[i];
+        hash *= 1099511628211ULL;
+      }
+    };
+
+  add(&map->size_x, sizeof(map->size_x));
+  add(&map->size_y, sizeof(map->size_y));
+  add(&map->scale, sizeof(map->scale));
+  const int count = map->size_x * map->size_y;
+  for (int i = 0; i < count; i++) {
+    const int8_t state = static_cast<int8_t>(map->cells[i].occ_state);
+    add(&state, sizeof(state));
+  }
+  return hash;
+}
+
+std::unique_ptr<LikelihoodField>
+LikelihoodField::load(
+  const std::string & filename, const map_t * map, double max_dist, uint64_t hash)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  const size_t cell_count = static_cast<size_t>(map->size_x) * map->size_y;
+  const size_t size = sizeof(FieldHeader) + cell_count;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != size) {
+    close(fd);
+    return nullptr;
+  }
+
+  void * mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+
+  const FieldHeader * header = static_cast<const FieldHeader *>(mapping);
+  if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+    header->size_x != map->size_x || header->size_y != map->size_y ||
+    header->max_dist != max_dist || header->hash != hash)
+  {
+    munmap(mapping, size);
+    return nullptr;
+  }
+
+  std::unique_ptr<LikelihoodField> field(new LikelihoodField());
+  field->size_x_ = map->size_x;
+  field->size_y_ = map->size_y;
+  field->max_dist_ = max_dist;
+  field->data_ = static_cast<const uint8_t *>(mapping) + sizeof(FieldHeader);
+  field->mapping_ = mapping;
+  field->mapping_size_ = size;
+  return field;
+}
+
+bool
+LikelihoodField::save(const std::string & filename, uint64_t hash) const
+{
+  FieldHeader header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.size_x = size_x_;
+  header.size_y = size_y_;
+  header.max_dist = max_dist_;
+  header.hash = hash;
+
+  const std::string tmp_filename = filename + "." + std::to_string(getpid()) + ".tmp";
+  FILE * file = fopen(tmp_filename.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  const size_t cell_count = static_cast<size_t>(size_x_) * size_y_;
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(data_, 1, cell_count, file) == cell_count;
+  written = fclose(file) == 0 && written;
+  if (!written || rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    unlink(tmp_filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+void
+LikelihoodField::toMap(map_t * map) const
+{
+  map->max_occ_dist = max_dist_;
+  const size_t cell_count = static_cast<size_t>(size_x_) * size_y_;
+  for (size_t i = 0; i < cell_count; i++) {
+    map->cells[i].occ_dist = toDistance(data_[i]);
+  }
+}
+
+}  // namespace nav2_amcl
@@ -42,6 +42,15 @@
 // with samples in them.
 static int pf_resample_limit(pf_t * pf, int k);
 
+// Find the sample the cumulative weights put r in.
+static int pf_resample_search(const double * c, int n, double r);
+
+// Draw evenly spaced samples from the cumulative weights.
+static void pf_resample_comb(const double * c, int n, int m, int stratified, int * indices);
+
+// Draw whole copies of the samples, then the remaining samples from the weight remainders.
+static void pf_resample_residual(double * c, int n, int m, int * indices);
+
 
 // Create a new filter
 pf_t * pf_alloc(
@@ -105,6 +114,11 @@ pf_t * pf_alloc(
   pf->alpha_slow = alpha_slow;
   pf->alpha_fast = alpha_fast;
 
+  pf->resample_type = PF_RESAMPLE_MULTINOMIAL;
+  pf->resample_time = 0.0;
+  pf->resample_cumulative = calloc(max_samples + 1, sizeof(double));
+  pf->resample_indices = calloc(max_samples, sizeof(int));
+
   // set converged to 0
   pf_init_converged(pf);
 
@@ -121,6 +135,8 @@ void pf_free(pf_t * pf)
     pf_kdtree_free(pf->sets[i].kdtree);
     free(pf->sets[i].samples);
   }
+  free(pf->resample_cumulative);
+  free(pf->resample_indices);
   free(pf);
 }
 
@@ -297,26 +313,44 @@ void pf_update_resample(pf_t * pf)
   double total;
   pf_sample_set_t * set_a, * set_b;
   pf_sample_t * sample_a, * sample_b;
-
-  // double r,c,U;
-  // int m;
-  // double count_inv;
   double * c;
+  int * indices;
+  int drawn;
+  struct timespec start, end;
 
   double w_diff;
 
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
   set_a = pf->sets + pf->current_set;
   set_b = pf->sets + (pf->current_set + 1) % 2;
 
   // Build up cumulative probability table for resampling.
-  // TODO(?): Replace this with a more efficient procedure
-  // (e.g., http://www.network-theory.co.uk/docs/gslref/GeneralDiscreteDistributions.html)
-  c = (double *)malloc(sizeof(double) * (set_a->sample_count + 1));
+  c = pf->resample_cumulative;
   c[0] = 0.0;
   for (i = 0; i < set_a->sample_count; i++) {
     c[i + 1] = c[i] + set_a->samples[i].weight;
   }
 
+  // Draw as many samples as the set can hold up front, for the schemes that draw them
+  // together. Those are then taken in a random order, so stopping early at the KLD limit
+  // keeps an unbiased subset of them.
+  indices = pf->resample_indices;
+  drawn = 0;
+  switch (pf->resample_type) {
+    case PF_RESAMPLE_SYSTEMATIC:
+      pf_resample_comb(c, set_a->sample_count, pf->max_samples, 0, indices);
+      break;
+    case PF_RESAMPLE_STRATIFIED:
+      pf_resample_comb(c, set_a->sample_count, pf->max_samples, 1, indices);
+      break;
+    case PF_RESAMPLE_RESIDUAL:
+      pf_resample_residual(c, set_a->sample_count, pf->max_samples, indices);
+      break;
+    default:
+      break;
+  }
+
   // Create the kd tree for adaptive sampling
   pf_kdtree_clear(set_b->kdtree);
 
@@ -330,55 +364,20 @@ void pf_update_resample(pf_t * pf)
   }
   // printf("w_diff: %9.6f\n", w_diff);
 
-  // Can't (easily) combine low-variance sampler with KLD adaptive
-  // sampling, so we'll take the more traditional route.
-  /*
-  // Low-variance resampler, taken from Probabilistic Robotics, p110
-  count_inv = 1.0/set_a->sample_count;
-  r = drand48() * count_inv;
-  c = set_a->samples[0].weight;
-  i = 0;
-  m = 0;
-  */
   while (set_b->sample_count < pf->max_samples) {
     sample_b = set_b->samples + set_b->sample_count++;
 
     if (drand48() < w_diff) {
       sample_b->pose = (pf->random_pose_fn)(pf->random_pose_data);
     } else {
-      // Can't (easily) combine low-variance sampler with KLD adaptive
-      // sampling, so we'll take the more traditional route.
-      /*
-      // Low-variance resampler, taken from Probabilistic Robotics, p110
-      U = r + m * count_inv;
-      while(U>c)
-      {
-        i++;
-        // Handle wrap-around by resetting counters and picking a new random
-        // number
-        if(i >= set_a->sample_count)
-        {
-          r = drand48() * count_inv;
-          c = set_a->samples[0].weight;
-          i = 0;
-          m = 0;
-          U = r + m * count_inv;
-          continue;
-        }
-        c += set_a->samples[i].weight;
-      }
-      m++;
-      */
-
-      // Naive discrete event sampler
-      double r;
-      r = drand48();
-      for (i = 0; i < set_a->sample_count; i++) {
-        if ((c[i] <= r) && (r < c[i + 1])) {
-          break;
-        }
+      if (pf->resample_type == PF_RESAMPLE_MULTINOMIAL) {
+        i = pf_resample_search(c, set_a->sample_count, drand48() * c[set_a->sample_count]);
+      } else {
+        int j = drawn + (int)(drand48() * (pf->max_samples - drawn));
+        i = indices[j];
+        indices[j] = indices[drawn];
+        indices[drawn++] = i;
       }
-      assert(i < set_a->sample_count);
 
       sample_a = set_a->samples + i;
 
@@ -421,7 +420,85 @@ void pf_update_resample(pf_t * pf)
 
   pf_update_converged(pf);
 
-  free(c);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  pf->resample_time = (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
+}
+
+
+// Select the resampling scheme
+void pf_set_resample_type(pf_t * pf, pf_resample_type_t resample_type)
+{
+  pf->resample_type = resample_type;
+}
+
+
+// Find the sample the cumulative weights put r in, by binary search for the last sample
+// starting at or before r. It never lands on a sample without weight, unless r is past the
+// total and the last samples have none.
+int pf_resample_search(const double * c, int n, double r)
+{
+  int lo = 0, hi = n - 1;
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    if (c[mid] <= r) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
+
+
+// Draw m samples with evenly spaced pointers into the cumulative weights of n samples, from
+// a single random offset (systematic) or a random offset per pointer (stratified). The
+// pointers only move forward, so this is O(n + m).
+void pf_resample_comb(const double * c, int n, int m, int stratified, int * indices)
+{
+  int i, k;
+  double r, u;
+  double step = c[n] / m;
+
+  i = 0;
+  r = drand48();
+  for (k = 0; k < m; k++) {
+    if (stratified) {
+      r = drand48();
+    }
+    u = (k + r) * step;
+    while (i < n - 1 && c[i + 1] <= u) {
+      i++;
+    }
+    indices[k] = i;
+  }
+}
+
+
+// Give each of n samples the whole number of the m draws its weight is due, then draw the
+// rest from the remainders. The cumulative weights in c are replaced by the cumulative
+// remainders. This is O(n + r log n) for r remainder draws, with r < n.
+void pf_resample_residual(double * c, int n, int m, int * indices)
+{
+  int i, k, copies;
+  double expected, previous;
+  double scale = m / c[n];
+
+  k = 0;
+  previous = c[0];
+  c[0] = 0.0;
+  for (i = 0; i < n; i++) {
+    expected = (c[i + 1] - previous) * scale;
+    previous = c[i + 1];
+    copies = (int)floor(expected);
+    for (; copies > 0 && k < m; copies--) {
+      indices[k++] = i;
+    }
+    c[i + 1] = c[i] + expected - floor(expected);
+  }
+
+  for (; k < m; k++) {
+    indices[k] = pf_resample_search(c, n, drand48() * c[n]);
+  }
 }
 
 
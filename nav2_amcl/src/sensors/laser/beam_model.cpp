@@ -22,6 +22,11 @@
 #include <math.h>
 #include <assert.h>
 
+#include <chrono>
+#include <future>
+#include <memory>
+#include <utility>
+
 #include "nav2_amcl/sensors/laser/laser.hpp"
 
 namespace nav2_amcl
@@ -29,7 +34,8 @@ namespace nav2_amcl
 
 BeamModel::BeamModel(
   double z_hit, double z_short, double z_max, double z_rand, double sigma_hit,
-  double lambda_short, double chi_outlier, size_t max_beams, map_t * map)
+  double lambda_short, double chi_outlier, size_t max_beams, map_t * map,
+  bool use_range_lookup)
 : Laser(max_beams, map)
 {
   z_hit_ = z_hit;
@@ -39,6 +45,16 @@ BeamModel::BeamModel(
   z_max_ = z_max;
   lambda_short_ = lambda_short;
   chi_outlier_ = chi_outlier;
+
+  if (use_range_lookup) {
+    // The map is only read here, so it may be freed before the field is done
+    auto field = std::make_unique<ClearanceField>(map);
+    clearance_future_ = std::async(
+      std::launch::async, [field = std::move(field)]() mutable {
+        field->build();
+        return std::move(field);
+      });
+  }
 }
 
 // Determine the probability for the given pose
@@ -46,21 +62,32 @@ double
 BeamModel::sensorFunction(LaserData * data, pf_sample_set_t * set)
 {
   BeamModel * self;
-  int i, j, step;
-  double z, pz;
-  double p;
-  double map_range;
-  double obs_range, obs_bearing;
+  int j, step;
   double total_weight;
-  pf_sample_t * sample;
-  pf_vector_t pose;
 
   self = reinterpret_cast<BeamModel *>(data->laser);
 
-  total_weight = 0.0;
+  step = (data->range_count - 1) / (self->max_beams_ - 1);
+
+  // Cast the rays cell by cell until the clearance field is built
+  if (self->clearance_future_.valid() &&
+    self->clearance_future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+  {
+    self->clearance_ = self->clearance_future_.get();
+  }
+  const ClearanceField * clearance = self->clearance_.get();
 
-  // Compute the sample weights
+  // Compute the sample weights. Raytracing cost varies with the pose, so the samples are
+  // handed out in small chunks
+  #pragma omp parallel for schedule(dynamic, 16) num_threads(self->num_threads_)
   for (j = 0; j < set->sample_count; j++) {
+    double z, pz;
+    double p;
+    double map_range;
+    double obs_range, obs_bearing;
+    pf_sample_t * sample;
+    pf_vector_t pose;
+
     sample = set->samples + j;
     pose = sample->pose;
 
@@ -69,15 +96,19 @@ BeamModel::sensorFunction(LaserData * data, pf_sample_set_t * set)
 
     p = 1.0;
 
-    step = (data->range_count - 1) / (self->max_beams_ - 1);
-    for (i = 0; i < data->range_count; i += step) {
+    for (int i = 0; i < data->range_count; i += step) {
       obs_range = data->ranges[i][0];
       obs_bearing = data->ranges[i][1];
 
       // Compute the range according to the map
-      map_range = map_calc_range(
-        self->map_, pose.v[0], pose.v[1],
-        pose.v[2] + obs_bearing, data->range_max);
+      if (clearance) {
+        map_range = clearance->calcRange(
+          pose.v[0], pose.v[1], pose.v[2] + obs_bearing, data->range_max);
+      } else {
+        map_range = map_calc_range(
+          self->map_, pose.v[0], pose.v[1],
+          pose.v[2] + obs_bearing, data->range_max);
+      }
       pz = 0.0;
 
       // Part 1: good, but noisy, hit
@@ -110,7 +141,11 @@ BeamModel::sensorFunction(LaserData * data, pf_sample_set_t * set)
     }
 
     sample->weight *= p;
-    total_weight += sample->weight;
+  }
+
+  total_weight = 0.0;
+  for (j = 0; j < set->sample_count; j++) {
+    total_weight += set->samples[j].weight;
   }
 
   return total_weight;
@@ -23,6 +23,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <omp.h>
 
 #include "nav2_amcl/sensors/laser/laser.hpp"
 
@@ -30,7 +31,7 @@ namespace nav2_amcl
 {
 
 Laser::Laser(size_t max_beams, map_t * map)
-: max_samples_(0), max_obs_(0), temp_obs_(NULL)
+: max_samples_(0), max_obs_(0), temp_obs_(NULL), num_threads_(1)
 {
   max_beams_ = max_beams;
   map_ = map;
@@ -70,4 +71,10 @@ Laser::SetLaserPose(pf_vector_t & laser_pose)
   laser_pose_ = laser_pose;
 }
 
+void
+Laser::setNumThreads(int num_threads)
+{
+  num_threads_ = num_threads > 0 ? num_threads : omp_get_max_threads();
+}
+
 }  // namespace nav2_amcl
@@ -20,7 +20,6 @@
  */
 
 #include <math.h>
-#include <assert.h>
 
 #include "nav2_amcl/sensors/laser/laser.hpp"
 
@@ -29,103 +28,121 @@ namespace nav2_amcl
 
 LikelihoodFieldModel::LikelihoodFieldModel(
   double z_hit, double z_rand, double sigma_hit,
-  double max_occ_dist, size_t max_beams, map_t * map)
+  double max_occ_dist, size_t max_beams, map_t * map,
+  const std::string & field_cache_dir)
 : Laser(max_beams, map)
 {
   z_hit_ = z_hit;
   z_rand_ = z_rand;
   sigma_hit_ = sigma_hit;
-  map_update_cspace(map, max_occ_dist);
+  field_ = LikelihoodField::create(map, max_occ_dist, field_cache_dir, &field_cache_error_);
+
+  // Gaussian model
+  // NOTE: this should have a normalization of 1/(sqrt(2pi)*sigma)
+  double z_hit_denom = 2 * sigma_hit_ * sigma_hit_;
+  gaussian_lut_.resize(LikelihoodField::levels);
+  for (int level = 0; level < LikelihoodField::levels; level++) {
+    double z = field_->toDistance(level);
+    gaussian_lut_[level] = z_hit_ * exp(-(z * z) / z_hit_denom);
+  }
+}
+
+void
+LikelihoodFieldModel::prepareBeams(LaserData * data)
+{
+  int step = (data->range_count - 1) / (max_beams_ - 1);
+
+  // Step size must be at least 1
+  if (step < 1) {
+    step = 1;
+  }
+
+  beam_x_.clear();
+  beam_y_.clear();
+  for (int i = 0; i < data->range_count; i += step) {
+    double obs_range = data->ranges[i][0];
+    double obs_bearing = data->ranges[i][1];
+
+    // This model ignores max range readings
+    if (obs_range >= data->range_max) {
+      continue;
+    }
+
+    // Check for NaN
+    if (obs_range != obs_range) {
+      continue;
+    }
+
+    beam_x_.push_back(obs_range * cos(obs_bearing) / map_->scale);
+    beam_y_.push_back(obs_range * sin(obs_bearing) / map_->scale);
+  }
 }
 
 double
 LikelihoodFieldModel::sensorFunction(LaserData * data, pf_sample_set_t * set)
 {
   LikelihoodFieldModel * self;
-  int i, j, step;
-  double z, pz;
-  double p;
-  double obs_range, obs_bearing;
+  int j;
   double total_weight;
-  pf_sample_t * sample;
-  pf_vector_t pose;
-  pf_vector_t hit;
 
   self = reinterpret_cast<LikelihoodFieldModel *>(data->laser);
 
-  total_weight = 0.0;
+  self->prepareBeams(data);
+
+  const map_t * map = self->map_;
+  const uint8_t * field = self->field_->getData();
+  const float * lut = self->gaussian_lut_.data();
+  const float * beam_x = self->beam_x_.data();
+  const float * beam_y = self->beam_y_.data();
+  const int beam_count = self->beam_x_.size();
+  const float size_x = map->size_x;
+  const float size_y = map->size_y;
+
+  // Part 2: random measurements
+  const float z_rand = self->z_rand_ / data->range_max;
 
   // Compute the sample weights
+  #pragma omp parallel for schedule(static) num_threads(self->num_threads_)
   for (j = 0; j < set->sample_count; j++) {
-    sample = set->samples + j;
-    pose = sample->pose;
+    pf_sample_t * sample = set->samples + j;
 
     // Take account of the laser pose relative to the robot
-    pose = pf_vector_coord_add(self->laser_pose_, pose);
-
-    p = 1.0;
-
-    // Pre-compute a couple of things
-    double z_hit_denom = 2 * self->sigma_hit_ * self->sigma_hit_;
-    double z_rand_mult = 1.0 / data->range_max;
-
-    step = (data->range_count - 1) / (self->max_beams_ - 1);
-
-    // Step size must be at least 1
-    if (step < 1) {
-      step = 1;
-    }
-
-    for (i = 0; i < data->range_count; i += step) {
-      obs_range = data->ranges[i][0];
-      obs_bearing = data->ranges[i][1];
+    pf_vector_t pose = pf_vector_coord_add(self->laser_pose_, sample->pose);
 
-      // This model ignores max range readings
-      if (obs_range >= data->range_max) {
-        continue;
-      }
-
-      // Check for NaN
-      if (obs_range != obs_range) {
-        continue;
-      }
-
-      pz = 0.0;
+    // Laser pose in continuous map cells, flooring gives the MAP_GXWX / MAP_GYWY cell
+    const float gx = (pose.v[0] - map->origin_x) / map->scale + 0.5 + map->size_x / 2;
+    const float gy = (pose.v[1] - map->origin_y) / map->scale + 0.5 + map->size_y / 2;
+    const float c = cos(pose.v[2]);
+    const float s = sin(pose.v[2]);
 
+    float p = 0.0f;
+    #pragma omp simd reduction(+:p)
+    for (int i = 0; i < beam_count; i++) {
       // Compute the endpoint of the beam
-      hit.v[0] = pose.v[0] + obs_range * cos(pose.v[2] + obs_bearing);
-      hit.v[1] = pose.v[1] + obs_range * sin(pose.v[2] + obs_bearing);
-
-      // Convert to map grid coords.
-      int mi, mj;
-      mi = MAP_GXWX(self->map_, hit.v[0]);
-      mj = MAP_GYWY(self->map_, hit.v[1]);
+      float hx = gx + c * beam_x[i] - s * beam_y[i];
+      float hy = gy + s * beam_x[i] + c * beam_y[i];
 
       // Part 1: Get distance from the hit to closest obstacle.
       // Off-map penalized as max distance
-      if (!MAP_VALID(self->map_, mi, mj)) {
-        z = self->map_->max_occ_dist;
-      } else {
-        z = self->map_->cells[MAP_INDEX(self->map_, mi, mj)].occ_dist;
-      }
-      // Gaussian model
-      // NOTE: this should have a normalization of 1/(sqrt(2pi)*sigma)
-      pz += self->z_hit_ * exp(-(z * z) / z_hit_denom);
-      // Part 2: random measurements
-      pz += self->z_rand_ * z_rand_mult;
+      bool valid = hx >= 0.0f && hy >= 0.0f && hx < size_x && hy < size_y;
+      int index = valid ? static_cast<int>(hx) + static_cast<int>(hy) * map->size_x : 0;
+      int level = valid ? field[index] : LikelihoodField::levels - 1;
+      float pz = lut[level] + z_rand;
 
       // TODO(?): outlier rejection for short readings
 
-      assert(pz <= 1.0);
-      assert(pz >= 0.0);
       //      p *= pz;
       // here we have an ad-hoc weighting scheme for combining beam probs
       // works well, though...
       p += pz * pz * pz;
     }
 
-    sample->weight *= p;
-    total_weight += sample->weight;
+    sample->weight *= 1.0 + p;
+  }
+
+  total_weight = 0.0;
+  for (j = 0; j < set->sample_count; j++) {
+    total_weight += set->samples[j].weight;
   }
 
   return total_weight;
@@ -22,6 +22,9 @@
 
 #include <math.h>
 #include <assert.h>
+#include <omp.h>
+
+#include <vector>
 
 #include "nav2_amcl/sensors/laser/laser.hpp"
 
@@ -52,14 +55,8 @@ double
 LikelihoodFieldModelProb::sensorFunction(LaserData * data, pf_sample_set_t * set)
 {
   LikelihoodFieldModelProb * self;
-  int i, j, step;
-  double z, pz;
-  double log_p;
-  double obs_range, obs_bearing;
+  int j, step;
   double total_weight;
-  pf_sample_t * sample;
-  pf_vector_t pose;
-  pf_vector_t hit;
 
   self = reinterpret_cast<LikelihoodFieldModelProb *>(data->laser);
 
@@ -91,12 +88,15 @@ LikelihoodFieldModelProb::sensorFunction(LaserData * data, pf_sample_set_t * set
     do_beamskip = false;
   }
 
-  // we need a count the no of particles for which the beam agreed with the map
-  int * obs_count = new int[self->max_beams_]();
+  // we need a count the no of particles for which the beam agreed with the map,
+  // kept per thread and added up once all the particles are weighted
+  const int num_threads = self->num_threads_;
+  std::vector<int> thread_obs_count(num_threads * self->max_beams_, 0);
+  std::vector<int> obs_count(self->max_beams_, 0);
 
   // we also need a mask of which observations to integrate (to decide which beams to integrate to
   // all particles)
-  bool * obs_mask = new bool[self->max_beams_]();
+  std::vector<bool> obs_mask(self->max_beams_, false);
 
   int beam_ind = 0;
 
@@ -119,79 +119,97 @@ LikelihoodFieldModelProb::sensorFunction(LaserData * data, pf_sample_set_t * set
   }
 
   // Compute the sample weights
-  for (j = 0; j < set->sample_count; j++) {
-    sample = set->samples + j;
-    pose = sample->pose;
+  #pragma omp parallel num_threads(num_threads)
+  {
+    int * local_obs_count = thread_obs_count.data() + omp_get_thread_num() * self->max_beams_;
 
-    // Take account of the laser pose relative to the robot
-    pose = pf_vector_coord_add(self->laser_pose_, pose);
+    #pragma omp for schedule(static)
+    for (j = 0; j < set->sample_count; j++) {
+      double z, pz;
+      double log_p;
+      double obs_range, obs_bearing;
+      pf_sample_t * sample;
+      pf_vector_t pose;
+      pf_vector_t hit;
 
-    log_p = 0;
+      sample = set->samples + j;
+      pose = sample->pose;
 
-    beam_ind = 0;
+      // Take account of the laser pose relative to the robot
+      pose = pf_vector_coord_add(self->laser_pose_, pose);
 
-    for (i = 0; i < data->range_count; i += step, beam_ind++) {
-      obs_range = data->ranges[i][0];
-      obs_bearing = data->ranges[i][1];
+      log_p = 0;
 
-      // This model ignores max range readings
-      if (obs_range >= data->range_max) {
-        continue;
-      }
+      int beam = 0;
 
-      // Check for NaN
-      if (obs_range != obs_range) {
-        continue;
-      }
+      for (int i = 0; i < data->range_count; i += step, beam++) {
+        obs_range = data->ranges[i][0];
+        obs_bearing = data->ranges[i][1];
 
-      pz = 0.0;
+        // This model ignores max range readings
+        if (obs_range >= data->range_max) {
+          continue;
+        }
+
+        // Check for NaN
+        if (obs_range != obs_range) {
+          continue;
+        }
 
-      // Compute the endpoint of the beam
-      hit.v[0] = pose.v[0] + obs_range * cos(pose.v[2] + obs_bearing);
-      hit.v[1] = pose.v[1] + obs_range * sin(pose.v[2] + obs_bearing);
+        pz = 0.0;
 
-      // Convert to map grid coords.
-      int mi, mj;
-      mi = MAP_GXWX(self->map_, hit.v[0]);
-      mj = MAP_GYWY(self->map_, hit.v[1]);
+        // Compute the endpoint of the beam
+        hit.v[0] = pose.v[0] + obs_range * cos(pose.v[2] + obs_bearing);
+        hit.v[1] = pose.v[1] + obs_range * sin(pose.v[2] + obs_bearing);
 
-      // Part 1: Get distance from the hit to closest obstacle.
-      // Off-map penalized as max distance
+        // Convert to map grid coords.
+        int mi, mj;
+        mi = MAP_GXWX(self->map_, hit.v[0]);
+        mj = MAP_GYWY(self->map_, hit.v[1]);
 
-      if (!MAP_VALID(self->map_, mi, mj)) {
-        pz += self->z_hit_ * max_dist_prob;
-      } else {
-        z = self->map_->cells[MAP_INDEX(self->map_, mi, mj)].occ_dist;
-        if (z < beam_skip_distance) {
-          obs_count[beam_ind] += 1;
+        // Part 1: Get distance from the hit to closest obstacle.
+        // Off-map penalized as max distance
+
+        if (!MAP_VALID(self->map_, mi, mj)) {
+          pz += self->z_hit_ * max_dist_prob;
+        } else {
+          z = self->map_->cells[MAP_INDEX(self->map_, mi, mj)].occ_dist;
+          if (z < beam_skip_distance) {
+            local_obs_count[beam] += 1;
+          }
+          pz += self->z_hit_ * exp(-(z * z) / z_hit_denom);
         }
-        pz += self->z_hit_ * exp(-(z * z) / z_hit_denom);
-      }
 
-      // Gaussian model
-      // NOTE: this should have a normalization of 1/(sqrt(2pi)*sigma)
+        // Gaussian model
+        // NOTE: this should have a normalization of 1/(sqrt(2pi)*sigma)
 
-      // Part 2: random measurements
-      pz += self->z_rand_ * z_rand_mult;
+        // Part 2: random measurements
+        pz += self->z_rand_ * z_rand_mult;
 
-      assert(pz <= 1.0);
-      assert(pz >= 0.0);
+        assert(pz <= 1.0);
+        assert(pz >= 0.0);
 
-      // TODO(?): outlier rejection for short readings
+        // TODO(?): outlier rejection for short readings
 
+        if (!do_beamskip) {
+          log_p += log(pz);
+        } else {
+          self->temp_obs_[j][beam] = pz;
+        }
+      }
       if (!do_beamskip) {
-        log_p += log(pz);
-      } else {
-        self->temp_obs_[j][beam_ind] = pz;
+        sample->weight *= exp(log_p);
       }
     }
-    if (!do_beamskip) {
-      sample->weight *= exp(log_p);
-      total_weight += sample->weight;
-    }
   }
 
   if (do_beamskip) {
+    for (int t = 0; t < num_threads; t++) {
+      for (beam_ind = 0; beam_ind < self->max_beams_; beam_ind++) {
+        obs_count[beam_ind] += thread_obs_count[t * self->max_beams_ + beam_ind];
+      }
+    }
+
     int skipped_beam_count = 0;
     for (beam_ind = 0; beam_ind < self->max_beams_; beam_ind++) {
       if ((obs_count[beam_ind] / static_cast<double>(set->sample_count)) > beam_skip_threshold) {
@@ -217,26 +235,26 @@ LikelihoodFieldModelProb::sensorFunction(LaserData * data, pf_sample_set_t * set
       error = true;
     }
 
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
     for (j = 0; j < set->sample_count; j++) {
-      sample = set->samples + j;
-      pose = sample->pose;
+      pf_sample_t * sample = set->samples + j;
 
-      log_p = 0;
+      double log_p = 0;
 
-      for (beam_ind = 0; beam_ind < self->max_beams_; beam_ind++) {
-        if (error || obs_mask[beam_ind]) {
-          log_p += log(self->temp_obs_[j][beam_ind]);
+      for (int beam = 0; beam < self->max_beams_; beam++) {
+        if (error || obs_mask[beam]) {
+          log_p += log(self->temp_obs_[j][beam]);
         }
       }
 
       sample->weight *= exp(log_p);
-
-      total_weight += sample->weight;
     }
   }
 
-  delete[] obs_count;
-  delete[] obs_mask;
+  for (j = 0; j < set->sample_count; j++) {
+    total_weight += set->samples[j].weight;
+  }
+
   return total_weight;
 }
 
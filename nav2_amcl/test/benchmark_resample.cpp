@@ -0,0 +1,135 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+// Measures the latency of resampling with each resampling scheme, for a fixed particle count
+// and with KLD adaptive sampling, and the noise each scheme adds: the mean squared difference
+// between the copies drawn of each particle and the copies its weight is due.
+// Usage: benchmark_resample [runs]
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nav2_amcl/pf/pf.hpp"
+
+namespace
+{
+
+pf_vector_t randomPose(void *)
+{
+  pf_vector_t pose = pf_vector_zero();
+  pose.v[0] = 20.0 * drand48();
+  pose.v[1] = 20.0 * drand48();
+  pose.v[2] = 2 * M_PI * drand48() - M_PI;
+  return pose;
+}
+
+// Spread the particles over a few hypotheses, as during global localization, with uneven
+// weights
+void fillSet(pf_sample_set_t * set, int count)
+{
+  set->sample_count = count;
+  double total = 0.0;
+  for (int i = 0; i < count; i++) {
+    pf_sample_t * sample = set->samples + i;
+    const int hypothesis = i % 4;
+    sample->pose.v[0] = 2.0 + 4.0 * hypothesis + 2.0 * (drand48() - 0.5);
+    sample->pose.v[1] = 5.0 + 2.0 * (drand48() - 0.5);
+    sample->pose.v[2] = 0.5 * (drand48() - 0.5);
+    sample->weight = exp(-4.0 * drand48()) * (hypothesis == 0 ? 4.0 : 1.0);
+    total += sample->weight;
+  }
+  for (int i = 0; i < count; i++) {
+    set->samples[i].weight /= total;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const int runs = argc > 1 ? std::atoi(argv[1]) : 20;
+
+  const std::vector<std::pair<std::string, pf_resample_type_t>> types = {
+    {"multinomial", PF_RESAMPLE_MULTINOMIAL},
+    {"systematic", PF_RESAMPLE_SYSTEMATIC},
+    {"stratified", PF_RESAMPLE_STRATIFIED},
+    {"residual", PF_RESAMPLE_RESIDUAL}};
+
+  srand48(42);
+  for (int num_particles : {1000, 10000, 100000}) {
+    for (bool adaptive : {false, true}) {
+      const int min_particles = adaptive ? 500 : num_particles;
+      for (const auto & type : types) {
+        pf_t * pf = pf_alloc(min_particles, num_particles, 0.0, 0.0, randomPose, NULL);
+        pf_set_resample_type(pf, type.second);
+
+        std::vector<double> latencies;
+        double noise = 0.0;
+        int resampled_count = 0;
+        for (int run = 0; run != runs; run++) {
+          pf_sample_set_t * set_a = pf->sets + pf->current_set;
+          fillSet(set_a, num_particles);
+
+          // The x coordinates are unique, so they identify the particles copied
+          std::vector<std::pair<double, int>> sources(num_particles);
+          std::vector<double> expected(num_particles);
+          for (int i = 0; i < num_particles; i++) {
+            sources[i] = {set_a->samples[i].pose.v[0], i};
+            expected[i] = set_a->samples[i].weight;
+          }
+          std::sort(sources.begin(), sources.end());
+
+          pf->w_slow = pf->w_fast = 0.0;
+          pf_update_resample(pf);
+          latencies.push_back(pf->resample_time * 1000.0);
+
+          pf_sample_set_t * set_b = pf->sets + pf->current_set;
+          resampled_count = set_b->sample_count;
+          std::vector<int> copies(num_particles, 0);
+          for (int i = 0; i < set_b->sample_count; i++) {
+            auto it = std::lower_bound(
+              sources.begin(), sources.end(), std::make_pair(set_b->samples[i].pose.v[0], 0));
+            copies[it->second]++;
+          }
+          double squared_error = 0.0;
+          for (int i = 0; i < num_particles; i++) {
+            const double error = copies[i] - expected[i] * set_b->sample_count;
+            squared_error += error * error;
+          }
+          noise += squared_error / num_particles / runs;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << num_particles << " particles" << (adaptive ? " (KLD), " : ", ") <<
+          type.first << ": " << latencies[latencies.size() / 2] << " ms median, " <<
+          latencies[latencies.size() * 9 / 10] << " ms p90, " << resampled_count <<
+          " resampled, " << noise << " copies squared error" << std::endl;
+
+        pf_free(pf);
+      }
+    }
+  }
+
+  return 0;
+}
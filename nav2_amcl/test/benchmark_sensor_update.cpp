@@ -0,0 +1,212 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+// Measures the latency of weighting the particle set against a scan, with each laser model and
+// several sensor update threads, and checks the weights match the single threaded update.
+// The scans are recorded by raytracing a synthetic map along a trajectory, like the scans
+// handed to the laser models by AmclNode::updateFilter.
+// Usage: benchmark_sensor_update [runs]
+
+#include <omp.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nav2_amcl/map/map.hpp"
+#include "nav2_amcl/pf/pf.hpp"
+#include "nav2_amcl/sensors/laser/laser.hpp"
+
+using namespace std::chrono;  // NOLINT
+
+namespace
+{
+
+const int kRangeCount = 360;
+const double kRangeMax = 12.0;
+
+// 20x20 m map with outer walls and scattered boxes
+map_t * createMap()
+{
+  map_t * map = map_alloc();
+  map->size_x = 400;
+  map->size_y = 400;
+  map->scale = 0.05;
+  map->origin_x = 0.0;
+  map->origin_y = 0.0;
+  map->cells = reinterpret_cast<map_cell_t *>(
+    malloc(sizeof(map_cell_t) * map->size_x * map->size_y));
+
+  for (int j = 0; j < map->size_y; j++) {
+    for (int i = 0; i < map->size_x; i++) {
+      const bool wall = i < 2 || j < 2 || i >= map->size_x - 2 || j >= map->size_y - 2;
+      map->cells[MAP_INDEX(map, i, j)].occ_state = wall ? +1 : -1;
+    }
+  }
+
+  std::srand(42);
+  for (int box = 0; box != 40; box++) {
+    const int bx = 20 + std::rand() % (map->size_x - 60);
+    const int by = 20 + std::rand() % (map->size_y - 60);
+    const int bw = 4 + std::rand() % 20;
+    const int bh = 4 + std::rand() % 20;
+    for (int j = by; j < by + bh; j++) {
+      for (int i = bx; i < bx + bw; i++) {
+        map->cells[MAP_INDEX(map, i, j)].occ_state = +1;
+      }
+    }
+  }
+  return map;
+}
+
+// Raytrace a scan from the given pose, with a little range noise and a few dropped beams
+void recordScan(map_t * map, const pf_vector_t & pose, nav2_amcl::LaserData & data)
+{
+  data.range_count = kRangeCount;
+  data.range_max = kRangeMax;
+  data.ranges = new double[kRangeCount][2];
+  for (int i = 0; i < kRangeCount; i++) {
+    const double bearing = -M_PI + i * 2.0 * M_PI / kRangeCount;
+    double range = map_calc_range(map, pose.v[0], pose.v[1], pose.v[2] + bearing, kRangeMax);
+    if (std::rand() % 50 == 0) {
+      range = kRangeMax;
+    } else if (range < kRangeMax) {
+      range += 0.02 * (std::rand() / static_cast<double>(RAND_MAX) - 0.5);
+    }
+    data.ranges[i][0] = range;
+    data.ranges[i][1] = bearing;
+  }
+}
+
+pf_vector_t randomPose(void * arg)
+{
+  map_t * map = reinterpret_cast<map_t *>(arg);
+  pf_vector_t pose = pf_vector_zero();
+  pose.v[0] = map->size_x * map->scale * drand48();
+  pose.v[1] = map->size_y * map->scale * drand48();
+  pose.v[2] = 2 * M_PI * drand48() - M_PI;
+  return pose;
+}
+
+nav2_amcl::Laser * createModel(const std::string & type, map_t * map)
+{
+  if (type == "beam") {
+    return new nav2_amcl::BeamModel(0.5, 0.05, 0.05, 0.5, 0.2, 0.1, 0.0, 60, map);
+  }
+  if (type == "beam_range_lookup") {
+    return new nav2_amcl::BeamModel(0.5, 0.05, 0.05, 0.5, 0.2, 0.1, 0.0, 60, map, true);
+  }
+  if (type == "likelihood_field_prob") {
+    return new nav2_amcl::LikelihoodFieldModelProb(
+      0.5, 0.5, 0.2, 2.0, true, 0.5, 0.3, 0.9, 60, map);
+  }
+  return new nav2_amcl::LikelihoodFieldModel(0.5, 0.5, 0.2, 2.0, 60, map);
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const int runs = argc > 1 ? std::atoi(argv[1]) : 5;
+
+  map_t * map = createMap();
+
+  // A trajectory through the free space of the map, one scan every 0.25 m
+  std::vector<pf_vector_t> trajectory;
+  for (int k = 0; k != 20; k++) {
+    pf_vector_t pose = pf_vector_zero();
+    pose.v[0] = 1.0 + 0.25 * k;
+    pose.v[1] = 0.5 + 0.05 * k;
+    pose.v[2] = 0.1 * k;
+    trajectory.push_back(pose);
+  }
+
+  std::vector<int> thread_counts = {1, 2, 4};
+  if (omp_get_max_threads() > 4) {
+    thread_counts.push_back(omp_get_max_threads());
+  }
+
+  for (const std::string type : {"likelihood_field", "likelihood_field_prob", "beam",
+      "beam_range_lookup"})
+  {
+    std::unique_ptr<nav2_amcl::Laser> laser(createModel(type, map));
+    pf_vector_t laser_pose = pf_vector_zero();
+    laser->SetLaserPose(laser_pose);
+
+    std::vector<std::unique_ptr<nav2_amcl::LaserData>> scans;
+    for (const pf_vector_t & pose : trajectory) {
+      scans.emplace_back(new nav2_amcl::LaserData());
+      scans.back()->laser = laser.get();
+      recordScan(map, pose, *scans.back());
+    }
+
+    for (int num_particles : {2000, 10000, 50000}) {
+      pf_t * pf = pf_alloc(num_particles, num_particles, 0.001, 0.1, randomPose, map);
+      pf_matrix_t cov = pf_matrix_zero();
+      cov.m[0][0] = 0.5 * 0.5;
+      cov.m[1][1] = 0.5 * 0.5;
+      cov.m[2][2] = 0.2 * 0.2;
+      srand48(7);
+      pf_init(pf, trajectory.front(), cov);
+      pf_sample_set_t * set = pf->sets + pf->current_set;
+      // Beam skipping only kicks in on a converged filter
+      set->converged = 1;
+
+      std::vector<double> reference;
+      for (int threads : thread_counts) {
+        laser->setNumThreads(threads);
+        std::vector<double> latencies;
+        std::vector<double> weights;
+        for (int run = 0; run != runs; run++) {
+          for (int i = 0; i < set->sample_count; i++) {
+            set->samples[i].weight = 1.0 / set->sample_count;
+          }
+          pf->w_slow = pf->w_fast = 0.0;
+          for (auto & scan : scans) {
+            steady_clock::time_point a = steady_clock::now();
+            laser->sensorUpdate(pf, scan.get());
+            steady_clock::time_point b = steady_clock::now();
+            latencies.push_back(duration_cast<duration<double>>(b - a).count() * 1000.0);
+          }
+        }
+        for (int i = 0; i < set->sample_count; i++) {
+          weights.push_back(set->samples[i].weight);
+        }
+        if (reference.empty()) {
+          reference = weights;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << type << ", " << num_particles << " particles, " << threads <<
+          " threads: " << latencies[latencies.size() / 2] << " ms median, " <<
+          latencies[latencies.size() * 9 / 10] << " ms p90, weights " <<
+          (weights == reference ? "match" : "DIFFER") << std::endl;
+      }
+
+      pf_free(pf);
+    }
+  }
+
+  map_free(map);
+  return 0;
+}
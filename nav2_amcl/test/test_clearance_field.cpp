@@ -0,0 +1,125 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <random>
+
+#include "gtest/gtest.h"
+#include "nav2_amcl/map/clearance_field.hpp"
+#include "nav2_amcl/map/map.hpp"
+
+namespace
+{
+
+// Map of free cells with a few occupied and unknown blocks, and an open border
+map_t * createMap(int size_x, int size_y, std::mt19937 & rng)
+{
+  map_t * map = map_alloc();
+  map->size_x = size_x;
+  map->size_y = size_y;
+  map->scale = 0.05;
+  map->origin_x = 1.3;
+  map->origin_y = -0.7;
+  map->cells = reinterpret_cast<map_cell_t *>(
+    malloc(sizeof(map_cell_t) * map->size_x * map->size_y));
+  for (int i = 0; i < size_x * size_y; i++) {
+    map->cells[i].occ_state = -1;
+  }
+
+  std::uniform_int_distribution<int> x_dist(0, size_x - 1);
+  std::uniform_int_distribution<int> y_dist(0, size_y - 1);
+  std::uniform_int_distribution<int> extent_dist(1, 6);
+  for (int block = 0; block < 12; block++) {
+    const int bx = x_dist(rng);
+    const int by = y_dist(rng);
+    const int state = block % 3 == 0 ? 0 : +1;
+    const int ex = extent_dist(rng);
+    const int ey = extent_dist(rng);
+    for (int j = by; j < by + ey && j < size_y; j++) {
+      for (int i = bx; i < bx + ex && i < size_x; i++) {
+        map->cells[MAP_INDEX(map, i, j)].occ_state = state;
+      }
+    }
+  }
+  return map;
+}
+
+}  // namespace
+
+TEST(ClearanceField, clearanceIsDistanceToNearestBlockingCell)
+{
+  std::mt19937 rng(7);
+  map_t * map = createMap(37, 23, rng);
+  nav2_amcl::ClearanceField field(map);
+  field.build();
+
+  for (int j = 0; j < map->size_y; j++) {
+    for (int i = 0; i < map->size_x; i++) {
+      // Cells just outside the map stop rays too
+      double nearest = HUGE_VAL;
+      for (int y = -1; y <= map->size_y; y++) {
+        for (int x = -1; x <= map->size_x; x++) {
+          if (MAP_VALID(map, x, y) && map->cells[MAP_INDEX(map, x, y)].occ_state == -1) {
+            continue;
+          }
+          nearest = fmin(nearest, hypot(x - i, y - j));
+        }
+      }
+      EXPECT_EQ(field.getClearance(i, j), static_cast<int>(floor(nearest)));
+    }
+  }
+  EXPECT_EQ(field.getClearance(-1, 0), 0);
+  EXPECT_EQ(field.getClearance(0, map->size_y), 0);
+
+  map_free(map);
+}
+
+TEST(ClearanceField, calcRangeMatchesMapCalcRange)
+{
+  std::mt19937 rng(11);
+  for (int trial = 0; trial < 4; trial++) {
+    map_t * map = createMap(60 + 30 * trial, 90 - 20 * trial, rng);
+    nav2_amcl::ClearanceField field(map);
+    field.build();
+
+    // Origins may lie on blocking cells or off the map
+    const double width = map->size_x * map->scale;
+    const double height = map->size_y * map->scale;
+    std::uniform_real_distribution<double> x_dist(
+      map->origin_x - 0.6 * width, map->origin_x + 0.6 * width);
+    std::uniform_real_distribution<double> y_dist(
+      map->origin_y - 0.6 * height, map->origin_y + 0.6 * height);
+    std::uniform_real_distribution<double> angle_dist(-M_PI, M_PI);
+    std::uniform_real_distribution<double> range_dist(0.0, 2.0 * (width + height));
+
+    for (int ray = 0; ray < 20000; ray++) {
+      const double ox = x_dist(rng);
+      const double oy = y_dist(rng);
+      // Include the axis aligned and diagonal rays
+      const double oa = ray % 5 == 0 ? (ray % 8) * M_PI / 4.0 : angle_dist(rng);
+      const double max_range = ray % 7 == 0 ? 0.0 : range_dist(rng);
+      ASSERT_EQ(
+        field.calcRange(ox, oy, oa, max_range),
+        map_calc_range(map, ox, oy, oa, max_range)) <<
+        "ray from (" << ox << ", " << oy << ") at " << oa << " up to " << max_range;
+    }
+
+    map_free(map);
+  }
+}
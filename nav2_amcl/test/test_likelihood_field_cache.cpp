@@ -0,0 +1,249 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "nav2_amcl/map/likelihood_field.hpp"
+#include "nav2_amcl/map/map.hpp"
+
+namespace
+{
+
+const double kMaxOccDist = 0.5;
+
+// Map with a wall along the bottom and a box in the middle
+map_t * createMap(int size_x, int size_y)
+{
+  map_t * map = map_alloc();
+  map->size_x = size_x;
+  map->size_y = size_y;
+  map->scale = 0.05;
+  map->origin_x = 0.0;
+  map->origin_y = 0.0;
+  map->cells = reinterpret_cast<map_cell_t *>(
+    malloc(sizeof(map_cell_t) * map->size_x * map->size_y));
+  for (int j = 0; j < size_y; j++) {
+    for (int i = 0; i < size_x; i++) {
+      const bool box = abs(i - size_x / 2) < 3 && abs(j - size_y / 2) < 2;
+      map->cells[MAP_INDEX(map, i, j)].occ_state = j == 0 || box ? +1 : -1;
+    }
+  }
+  return map;
+}
+
+std::vector<uint8_t> fieldData(const nav2_amcl::LikelihoodField & field)
+{
+  return std::vector<uint8_t>(
+    field.getData(), field.getData() + field.getSizeX() * field.getSizeY());
+}
+
+class LikelihoodFieldCacheTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char dir[] = "/tmp/likelihood_field_cache_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+    dir_ = dir;
+    filename_ = dir_ + "/field.bin";
+  }
+
+  void TearDown() override
+  {
+    DIR * dir = opendir(dir_.c_str());
+    if (dir) {
+      while (struct dirent * entry = readdir(dir)) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+          unlink((dir_ + "/" + entry->d_name).c_str());
+        }
+      }
+      closedir(dir);
+    }
+    rmdir(dir_.c_str());
+  }
+
+  // Number of files in the cache directory
+  int countFiles()
+  {
+    int count = 0;
+    DIR * dir = opendir(dir_.c_str());
+    while (struct dirent * entry = readdir(dir)) {
+      count += entry->d_name[0] != '.';
+    }
+    closedir(dir);
+    return count;
+  }
+
+  std::string dir_;
+  std::string filename_;
+};
+
+}  // namespace
+
+TEST_F(LikelihoodFieldCacheTest, saveLoadRoundTrip)
+{
+  map_t * map = createMap(40, 30);
+  map_update_cspace(map, kMaxOccDist);
+  nav2_amcl::LikelihoodField field(map);
+  const uint64_t hash = nav2_amcl::LikelihoodField::hashMap(map);
+  ASSERT_TRUE(field.save(filename_, hash));
+
+  auto loaded = nav2_amcl::LikelihoodField::load(filename_, map, kMaxOccDist, hash);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(loaded->getSizeX(), field.getSizeX());
+  EXPECT_EQ(loaded->getSizeY(), field.getSizeY());
+  EXPECT_EQ(loaded->getMaxDistance(), field.getMaxDistance());
+  EXPECT_EQ(fieldData(*loaded), fieldData(field));
+
+  map_free(map);
+}
+
+TEST_F(LikelihoodFieldCacheTest, toMapRestoresDistances)
+{
+  map_t * map = createMap(40, 30);
+  map_update_cspace(map, kMaxOccDist);
+  nav2_amcl::LikelihoodField field(map);
+
+  map_t * restored = createMap(40, 30);
+  field.toMap(restored);
+  EXPECT_EQ(restored->max_occ_dist, kMaxOccDist);
+  const double step = kMaxOccDist / (nav2_amcl::LikelihoodField::levels - 1);
+  for (int i = 0; i < map->size_x * map->size_y; i++) {
+    EXPECT_EQ(restored->cells[i].occ_dist, field.toDistance(field.getData()[i]));
+    EXPECT_NEAR(restored->cells[i].occ_dist, map->cells[i].occ_dist, 0.5 * step + 1e-12);
+  }
+
+  map_free(restored);
+  map_free(map);
+}
+
+TEST_F(LikelihoodFieldCacheTest, changedMapIsRejected)
+{
+  map_t * map = createMap(40, 30);
+  map_update_cspace(map, kMaxOccDist);
+  nav2_amcl::LikelihoodField field(map);
+  const uint64_t hash = nav2_amcl::LikelihoodField::hashMap(map);
+  ASSERT_TRUE(field.save(filename_, hash));
+
+  // Changed occupancy
+  map->cells[MAP_INDEX(map, 5, 20)].occ_state = +1;
+  const uint64_t changed_hash = nav2_amcl::LikelihoodField::hashMap(map);
+  EXPECT_NE(changed_hash, hash);
+  EXPECT_FALSE(nav2_amcl::LikelihoodField::load(filename_, map, kMaxOccDist, changed_hash));
+
+  // Changed size
+  map_t * larger = createMap(41, 30);
+  EXPECT_FALSE(nav2_amcl::LikelihoodField::load(filename_, larger, kMaxOccDist, hash));
+  EXPECT_FALSE(
+    nav2_amcl::LikelihoodField::load(
+      filename_, larger, kMaxOccDist, nav2_amcl::LikelihoodField::hashMap(larger)));
+
+  // Changed max distance
+  EXPECT_FALSE(nav2_amcl::LikelihoodField::load(filename_, map, 2 * kMaxOccDist, hash));
+
+  map_free(larger);
+  map_free(map);
+}
+
+TEST_F(LikelihoodFieldCacheTest, corruptFileIsRejected)
+{
+  map_t * map = createMap(40, 30);
+  map_update_cspace(map, kMaxOccDist);
+  nav2_amcl::LikelihoodField field(map);
+  const uint64_t hash = nav2_amcl::LikelihoodField::hashMap(map);
+  ASSERT_TRUE(field.save(filename_, hash));
+  ASSERT_TRUE(nav2_amcl::LikelihoodField::load(filename_, map, kMaxOccDist, hash));
+
+  // Truncated
+  struct stat st;
+  ASSERT_EQ(stat(filename_.c_str(), &st), 0);
+  ASSERT_EQ(truncate(filename_.c_str(), st.st_size - 1), 0);
+  EXPECT_FALSE(nav2_amcl::LikelihoodField::load(filename_, map, kMaxOccDist, hash));
+
+  // Same size, but not a saved field
+  std::vector<char> foreign(st.st_size, 'x');
+  FILE * file = fopen(filename_.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(fwrite(foreign.data(), 1, foreign.size(), file), foreign.size());
+  fclose(file);
+  EXPECT_FALSE(nav2_amcl::LikelihoodField::load(filename_, map, kMaxOccDist, hash));
+
+  // Missing
+  unlink(filename_.c_str());
+  EXPECT_FALSE(nav2_amcl::LikelihoodField::load(filename_, map, kMaxOccDist, hash));
+
+  map_free(map);
+}
+
+TEST_F(LikelihoodFieldCacheTest, createUsesTheCache)
+{
+  map_t * map = createMap(40, 30);
+  auto computed = nav2_amcl::LikelihoodField::create(map, kMaxOccDist, dir_);
+  ASSERT_TRUE(computed);
+  EXPECT_EQ(countFiles(), 1);
+
+  // Loaded on the next start, with the map's distances filled from it
+  map_t * reloaded_map = createMap(40, 30);
+  auto loaded = nav2_amcl::LikelihoodField::create(reloaded_map, kMaxOccDist, dir_);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(countFiles(), 1);
+  EXPECT_EQ(fieldData(*loaded), fieldData(*computed));
+  for (int i = 0; i < map->size_x * map->size_y; i++) {
+    EXPECT_EQ(reloaded_map->cells[i].occ_dist, loaded->toDistance(loaded->getData()[i]));
+  }
+
+  // Another max distance is cached separately
+  map_t * other_map = createMap(40, 30);
+  auto other = nav2_amcl::LikelihoodField::create(other_map, 2 * kMaxOccDist, dir_);
+  ASSERT_TRUE(other);
+  EXPECT_EQ(other->getMaxDistance(), 2 * kMaxOccDist);
+  EXPECT_EQ(countFiles(), 2);
+
+  map_free(other_map);
+  map_free(reloaded_map);
+  map_free(map);
+}
+
+TEST_F(LikelihoodFieldCacheTest, createReportsCacheErrors)
+{
+  map_t * map = createMap(40, 30);
+  std::string cache_error;
+  auto cached = nav2_amcl::LikelihoodField::create(map, kMaxOccDist, dir_, &cache_error);
+  ASSERT_TRUE(cached);
+  EXPECT_TRUE(cache_error.empty());
+
+  // The field is still computed when it can't be cached
+  map_t * uncached_map = createMap(40, 30);
+  auto uncached = nav2_amcl::LikelihoodField::create(
+    uncached_map, kMaxOccDist, dir_ + "/missing", &cache_error);
+  ASSERT_TRUE(uncached);
+  EXPECT_EQ(fieldData(*uncached), fieldData(*cached));
+  EXPECT_NE(cache_error.find(dir_ + "/missing"), std::string::npos);
+
+  map_free(uncached_map);
+  map_free(map);
+}
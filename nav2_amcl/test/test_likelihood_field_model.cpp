@@ -0,0 +1,225 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "nav2_amcl/map/likelihood_field.hpp"
+#include "nav2_amcl/map/map.hpp"
+#include "nav2_amcl/pf/pf.hpp"
+#include "nav2_amcl/sensors/laser/laser.hpp"
+
+namespace
+{
+
+const double kZHit = 0.5;
+const double kZRand = 0.5;
+const double kSigmaHit = 0.2;
+const double kMaxOccDist = 1.0;
+const int kMaxBeams = 31;
+const double kRangeMax = 4.0;
+
+// Map of free cells with a few occupied and unknown blocks
+map_t * createMap(int size_x, int size_y, std::mt19937 & rng)
+{
+  map_t * map = map_alloc();
+  map->size_x = size_x;
+  map->size_y = size_y;
+  map->scale = 0.1;
+  map->origin_x = 0.35;
+  map->origin_y = -0.2;
+  map->cells = reinterpret_cast<map_cell_t *>(
+    malloc(sizeof(map_cell_t) * map->size_x * map->size_y));
+  for (int i = 0; i < size_x * size_y; i++) {
+    map->cells[i].occ_state = -1;
+  }
+
+  std::uniform_int_distribution<int> x_dist(0, size_x - 1);
+  std::uniform_int_distribution<int> y_dist(0, size_y - 1);
+  std::uniform_int_distribution<int> extent_dist(1, 5);
+  for (int block = 0; block < 10; block++) {
+    const int bx = x_dist(rng);
+    const int by = y_dist(rng);
+    const int state = block % 3 == 0 ? 0 : +1;
+    const int ex = extent_dist(rng);
+    const int ey = extent_dist(rng);
+    for (int j = by; j < by + ey && j < size_y; j++) {
+      for (int i = bx; i < bx + ex && i < size_x; i++) {
+        map->cells[MAP_INDEX(map, i, j)].occ_state = state;
+      }
+    }
+  }
+  return map;
+}
+
+pf_vector_t zeroPose(void *)
+{
+  return pf_vector_zero();
+}
+
+}  // namespace
+
+TEST(LikelihoodField, quantizesDistances)
+{
+  std::mt19937 rng(3);
+  map_t * map = createMap(40, 30, rng);
+  map_update_cspace(map, kMaxOccDist);
+  nav2_amcl::LikelihoodField field(map);
+
+  ASSERT_EQ(field.getSizeX(), map->size_x);
+  ASSERT_EQ(field.getSizeY(), map->size_y);
+  EXPECT_EQ(field.getMaxDistance(), kMaxOccDist);
+  EXPECT_EQ(field.toDistance(0), 0.0);
+  EXPECT_EQ(field.toDistance(nav2_amcl::LikelihoodField::levels - 1), kMaxOccDist);
+
+  const double step = kMaxOccDist / (nav2_amcl::LikelihoodField::levels - 1);
+  for (int i = 0; i < map->size_x * map->size_y; i++) {
+    const double occ_dist = map->cells[i].occ_dist;
+    const int level = field.getData()[i];
+    if (map->cells[i].occ_state == +1) {
+      EXPECT_EQ(level, 0);
+    }
+    if (occ_dist >= kMaxOccDist) {
+      EXPECT_EQ(level, nav2_amcl::LikelihoodField::levels - 1);
+    }
+    // Rounded to the nearest level
+    EXPECT_LE(fabs(field.toDistance(level) - occ_dist), 0.5 * step + 1e-12) << "cell " << i;
+  }
+
+  map_free(map);
+}
+
+TEST(LikelihoodField, zeroMaxDistanceGivesObstacleLevels)
+{
+  std::mt19937 rng(5);
+  map_t * map = createMap(12, 9, rng);
+  map_update_cspace(map, 0.0);
+  nav2_amcl::LikelihoodField field(map);
+
+  for (int i = 0; i < map->size_x * map->size_y; i++) {
+    EXPECT_EQ(field.getData()[i], 0);
+  }
+  EXPECT_EQ(field.toDistance(nav2_amcl::LikelihoodField::levels - 1), 0.0);
+
+  map_free(map);
+}
+
+TEST(LikelihoodFieldModel, weightsMatchDoublePrecisionModel)
+{
+  std::mt19937 rng(9);
+  map_t * map = createMap(40, 30, rng);
+
+  pf_vector_t laser_pose = pf_vector_zero();
+  laser_pose.v[0] = 0.1;
+  laser_pose.v[1] = -0.05;
+  laser_pose.v[2] = 0.2;
+  std::unique_ptr<nav2_amcl::LikelihoodFieldModel> laser(
+    new nav2_amcl::LikelihoodFieldModel(kZHit, kZRand, kSigmaHit, kMaxOccDist, kMaxBeams, map));
+  laser->SetLaserPose(laser_pose);
+
+  // Every other beam is used, a few are at or beyond max range or NaN
+  const int range_count = 2 * kMaxBeams - 1;
+  nav2_amcl::LaserData data;
+  data.laser = laser.get();
+  data.range_count = range_count;
+  data.range_max = kRangeMax;
+  data.ranges = new double[range_count][2];
+  std::uniform_real_distribution<double> range_dist(0.05, 3.0);
+  for (int i = 0; i < range_count; i++) {
+    data.ranges[i][0] = range_dist(rng);
+    data.ranges[i][1] = -M_PI + i * 2.0 * M_PI / range_count;
+  }
+  data.ranges[4][0] = kRangeMax;
+  data.ranges[10][0] = kRangeMax + 1.0;
+  data.ranges[16][0] = NAN;
+  data.ranges[22][0] = NAN;
+
+  // Particles all over the map and around it, so endpoints land on the edge cells and off
+  // the map
+  const int sample_count = 500;
+  pf_t * pf = pf_alloc(sample_count, sample_count, 0.001, 0.1, zeroPose, NULL);
+  pf_sample_set_t * set = pf->sets + pf->current_set;
+  set->sample_count = sample_count;
+  const double width = map->size_x * map->scale;
+  const double height = map->size_y * map->scale;
+  std::uniform_real_distribution<double> x_dist(
+    map->origin_x - 0.7 * width, map->origin_x + 0.7 * width);
+  std::uniform_real_distribution<double> y_dist(
+    map->origin_y - 0.7 * height, map->origin_y + 0.7 * height);
+  std::uniform_real_distribution<double> angle_dist(-M_PI, M_PI);
+  for (int j = 0; j < sample_count; j++) {
+    set->samples[j].pose.v[0] = x_dist(rng);
+    set->samples[j].pose.v[1] = y_dist(rng);
+    set->samples[j].pose.v[2] = angle_dist(rng);
+    set->samples[j].weight = 1.0 / sample_count;
+  }
+
+  ASSERT_TRUE(laser->sensorUpdate(pf, &data));
+
+  // The double-precision model on the exact cspace distances, normalized like
+  // pf_update_sensor
+  map_update_cspace(map, kMaxOccDist);
+  const double z_hit_denom = 2 * kSigmaHit * kSigmaHit;
+  std::vector<double> expected(sample_count);
+  double total = 0.0;
+  int edge_hits = 0;
+  int off_map_hits = 0;
+  for (int j = 0; j < sample_count; j++) {
+    pf_vector_t pose = pf_vector_coord_add(laser_pose, set->samples[j].pose);
+    double p = 1.0;
+    for (int i = 0; i < range_count; i += 2) {
+      const double obs_range = data.ranges[i][0];
+      const double obs_bearing = data.ranges[i][1];
+      if (obs_range >= data.range_max || obs_range != obs_range) {
+        continue;
+      }
+      const int mi = MAP_GXWX(map, pose.v[0] + obs_range * cos(pose.v[2] + obs_bearing));
+      const int mj = MAP_GYWY(map, pose.v[1] + obs_range * sin(pose.v[2] + obs_bearing));
+      double z;
+      if (!MAP_VALID(map, mi, mj)) {
+        z = map->max_occ_dist;
+        off_map_hits++;
+      } else {
+        z = map->cells[MAP_INDEX(map, mi, mj)].occ_dist;
+        if (mi == 0 || mj == 0 || mi == map->size_x - 1 || mj == map->size_y - 1) {
+          edge_hits++;
+        }
+      }
+      const double pz = kZHit * exp(-(z * z) / z_hit_denom) + kZRand / data.range_max;
+      p += pz * pz * pz;
+    }
+    expected[j] = p / sample_count;
+    total += expected[j];
+  }
+  ASSERT_GT(edge_hits, 0);
+  ASSERT_GT(off_map_hits, 0);
+
+  // Quantizing the distances to max_occ_dist / 255 moves each weight by well under 1%
+  for (int j = 0; j < sample_count; j++) {
+    expected[j] /= total;
+    EXPECT_NEAR(set->samples[j].weight, expected[j], 0.01 * expected[j]) << "sample " << j;
+  }
+
+  pf_free(pf);
+  laser.reset();
+  map_free(map);
+}
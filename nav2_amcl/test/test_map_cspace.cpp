@@ -0,0 +1,123 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <random>
+
+#include "gtest/gtest.h"
+#include "nav2_amcl/map/map.hpp"
+
+namespace
+{
+
+// Map of free cells with a few occupied and unknown blocks
+map_t * createMap(int size_x, int size_y, int blocks, std::mt19937 & rng)
+{
+  map_t * map = map_alloc();
+  map->size_x = size_x;
+  map->size_y = size_y;
+  map->scale = 0.1;
+  map->origin_x = 0.0;
+  map->origin_y = 0.0;
+  map->cells = reinterpret_cast<map_cell_t *>(
+    malloc(sizeof(map_cell_t) * map->size_x * map->size_y));
+  for (int i = 0; i < size_x * size_y; i++) {
+    map->cells[i].occ_state = -1;
+  }
+
+  std::uniform_int_distribution<int> x_dist(0, size_x - 1);
+  std::uniform_int_distribution<int> y_dist(0, size_y - 1);
+  std::uniform_int_distribution<int> extent_dist(1, 4);
+  for (int block = 0; block < blocks; block++) {
+    const int bx = x_dist(rng);
+    const int by = y_dist(rng);
+    const int state = block % 3 == 0 ? 0 : +1;
+    const int ex = extent_dist(rng);
+    const int ey = extent_dist(rng);
+    for (int j = by; j < by + ey && j < size_y; j++) {
+      for (int i = bx; i < bx + ex && i < size_x; i++) {
+        map->cells[MAP_INDEX(map, i, j)].occ_state = state;
+      }
+    }
+  }
+  return map;
+}
+
+// Distance in cells from a cell to the nearest occupied one, by trying them all
+double nearestOccupied(const map_t * map, int i, int j)
+{
+  double nearest = HUGE_VAL;
+  for (int y = 0; y < map->size_y; y++) {
+    for (int x = 0; x < map->size_x; x++) {
+      if (map->cells[MAP_INDEX(map, x, y)].occ_state == +1) {
+        nearest = fmin(nearest, hypot(x - i, y - j));
+      }
+    }
+  }
+  return nearest;
+}
+
+}  // namespace
+
+TEST(MapCspace, distancesMatchBruteForce)
+{
+  std::mt19937 rng(13);
+  // max_occ_dist of 5.7 cells, so only distances up to 5 whole cells are kept
+  const double max_occ_dist = 0.57;
+  const int cell_radius = 5;
+
+  for (int trial = 0; trial < 3; trial++) {
+    map_t * map = createMap(31 + 11 * trial, 47 - 9 * trial, 4 + 3 * trial, rng);
+    map_update_cspace(map, max_occ_dist);
+    EXPECT_EQ(map->max_occ_dist, max_occ_dist);
+
+    int cut_off_cells = 0;
+    for (int j = 0; j < map->size_y; j++) {
+      for (int i = 0; i < map->size_x; i++) {
+        const double nearest = nearestOccupied(map, i, j);
+        const double occ_dist = map->cells[MAP_INDEX(map, i, j)].occ_dist;
+        if (nearest > cell_radius) {
+          EXPECT_EQ(occ_dist, max_occ_dist) << "cell (" << i << ", " << j << ")";
+          // Within max_occ_dist, but beyond the whole cell radius
+          if (nearest * map->scale < max_occ_dist) {
+            cut_off_cells++;
+          }
+        } else {
+          EXPECT_DOUBLE_EQ(occ_dist, nearest * map->scale) << "cell (" << i << ", " << j << ")";
+        }
+      }
+    }
+    EXPECT_GT(cut_off_cells, 0);
+
+    map_free(map);
+  }
+}
+
+TEST(MapCspace, noObstaclesGivesMaxDistance)
+{
+  std::mt19937 rng(17);
+  map_t * map = createMap(20, 10, 0, rng);
+  map_update_cspace(map, 0.5);
+
+  for (int i = 0; i < map->size_x * map->size_y; i++) {
+    EXPECT_EQ(map->cells[i].occ_dist, 0.5);
+  }
+
+  map_free(map);
+}
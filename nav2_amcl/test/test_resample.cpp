@@ -0,0 +1,227 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "nav2_amcl/pf/pf.hpp"
+
+namespace
+{
+
+const std::vector<std::pair<std::string, pf_resample_type_t>> kTypes = {
+  {"multinomial", PF_RESAMPLE_MULTINOMIAL},
+  {"systematic", PF_RESAMPLE_SYSTEMATIC},
+  {"stratified", PF_RESAMPLE_STRATIFIED},
+  {"residual", PF_RESAMPLE_RESIDUAL}};
+
+pf_vector_t zeroPose(void *)
+{
+  return pf_vector_zero();
+}
+
+// Give the samples unique x coordinates identifying them and the given weights, normalized
+void fillSet(pf_sample_set_t * set, const std::vector<double> & weights)
+{
+  double total = 0.0;
+  for (double weight : weights) {
+    total += weight;
+  }
+  set->sample_count = weights.size();
+  for (int i = 0; i < set->sample_count; i++) {
+    set->samples[i].pose = pf_vector_zero();
+    set->samples[i].pose.v[0] = 0.001 * i;
+    set->samples[i].weight = weights[i] / total;
+  }
+}
+
+// Resample, and count the copies drawn of each sample of the previous set
+std::vector<int> resample(pf_t * pf)
+{
+  const pf_sample_set_t * set_a = pf->sets + pf->current_set;
+  std::vector<int> copies(set_a->sample_count, 0);
+
+  // No random poses are injected without running averages
+  pf->w_slow = pf->w_fast = 0.0;
+  pf_update_resample(pf);
+
+  const pf_sample_set_t * set_b = pf->sets + pf->current_set;
+  for (int i = 0; i < set_b->sample_count; i++) {
+    const int source = static_cast<int>(lround(set_b->samples[i].pose.v[0] / 0.001));
+    EXPECT_GE(source, 0);
+    EXPECT_LT(source, static_cast<int>(copies.size()));
+    if (source >= 0 && source < static_cast<int>(copies.size())) {
+      copies[source]++;
+    }
+  }
+  return copies;
+}
+
+std::vector<double> randomWeights(int count)
+{
+  std::vector<double> weights(count);
+  for (int i = 0; i < count; i++) {
+    weights[i] = exp(-4.0 * drand48()) * (i % 4 == 0 ? 4.0 : 1.0);
+  }
+  return weights;
+}
+
+}  // namespace
+
+TEST(Resample, copiesMatchWeights)
+{
+  const int count = 2000;
+  srand48(42);
+  for (const auto & type : kTypes) {
+    // Without KLD sampling, the set is resampled to the same size
+    pf_t * pf = pf_alloc(count, count, 0.0, 0.0, zeroPose, NULL);
+    pf_set_resample_type(pf, type.second);
+    const std::vector<double> weights = randomWeights(count);
+    fillSet(pf->sets + pf->current_set, weights);
+    std::vector<double> expected(count);
+    for (int i = 0; i < count; i++) {
+      expected[i] = pf->sets[pf->current_set].samples[i].weight * count;
+    }
+
+    const std::vector<int> copies = resample(pf);
+    ASSERT_EQ(pf->sets[pf->current_set].sample_count, count) << type.first;
+
+    for (int i = 0; i < count; i++) {
+      const double deviation = 6.0 * sqrt(expected[i]) + 1.0;
+      EXPECT_NEAR(copies[i], expected[i], deviation) << type.first << " sample " << i;
+
+      // Skip the expectations too close to a whole number to tell which side they round to
+      if (fabs(expected[i] - round(expected[i])) < 1e-9) {
+        continue;
+      }
+      if (type.second == PF_RESAMPLE_SYSTEMATIC) {
+        // One pointer every 1 / count of the total weight
+        EXPECT_GE(copies[i], floor(expected[i])) << type.first << " sample " << i;
+        EXPECT_LE(copies[i], ceil(expected[i])) << type.first << " sample " << i;
+      } else if (type.second == PF_RESAMPLE_STRATIFIED) {
+        // Only the pointers in the strata the sample partly covers are random, one at each
+        // end at most
+        EXPECT_GE(copies[i], floor(expected[i]) - 1) << type.first << " sample " << i;
+        EXPECT_LE(copies[i], ceil(expected[i]) + 1) << type.first << " sample " << i;
+      } else if (type.second == PF_RESAMPLE_RESIDUAL) {
+        // At least the whole copies, the remainders only add to them
+        EXPECT_GE(copies[i], floor(expected[i])) << type.first << " sample " << i;
+      }
+    }
+
+    pf_free(pf);
+  }
+}
+
+TEST(Resample, residualDrawsWholeCopiesFirst)
+{
+  // Weights due exactly 3, 2, 0.5, 0.5 and 2 of 8 copies, binary fractions so the due
+  // copies are exact, so the one draw left goes to one of the halves
+  srand48(7);
+  pf_t * pf = pf_alloc(8, 8, 0.0, 0.0, zeroPose, NULL);
+  pf_set_resample_type(pf, PF_RESAMPLE_RESIDUAL);
+  for (int run = 0; run < 20; run++) {
+    fillSet(pf->sets + pf->current_set, {3.0, 2.0, 0.5, 0.5, 2.0});
+    const std::vector<int> copies = resample(pf);
+    EXPECT_EQ(copies[0], 3);
+    EXPECT_EQ(copies[1], 2);
+    EXPECT_EQ(copies[2] + copies[3], 1);
+    EXPECT_EQ(copies[4], 2);
+  }
+  pf_free(pf);
+}
+
+TEST(Resample, zeroWeightSamplesAreNeverDrawn)
+{
+  const int count = 500;
+  srand48(11);
+  for (const auto & type : kTypes) {
+    pf_t * pf = pf_alloc(count, count, 0.0, 0.0, zeroPose, NULL);
+    pf_set_resample_type(pf, type.second);
+
+    for (int run = 0; run < 10; run++) {
+      // Samples without weight at both ends of the cumulative weights, and in the middle
+      std::vector<double> weights = randomWeights(count);
+      for (int i = 0; i < 50; i++) {
+        weights[i] = 0.0;
+        weights[count - 1 - i] = 0.0;
+      }
+      weights[count / 2] = 0.0;
+      fillSet(pf->sets + pf->current_set, weights);
+
+      const std::vector<int> copies = resample(pf);
+      for (int i = 0; i < count; i++) {
+        if (weights[i] == 0.0) {
+          EXPECT_EQ(copies[i], 0) << type.first << " sample " << i;
+        }
+      }
+    }
+
+    // A single sample with weight, at either end
+    for (int last : {0, 1}) {
+      std::vector<double> weights(count, 0.0);
+      weights[last ? count - 1 : 0] = 1.0;
+      fillSet(pf->sets + pf->current_set, weights);
+      const std::vector<int> copies = resample(pf);
+      EXPECT_EQ(copies[last ? count - 1 : 0], count) << type.first;
+    }
+
+    pf_free(pf);
+  }
+}
+
+TEST(Resample, kldLimitStopsEarlyWithUnbiasedSubset)
+{
+  // Two hypotheses in two kd-tree bins, one due 3 times the draws of the other. That
+  // needs far fewer than max_samples for the KLD bound.
+  const int count = 10000;
+  srand48(5);
+  for (const auto & type : kTypes) {
+    pf_t * pf = pf_alloc(100, count, 0.0, 0.0, zeroPose, NULL);
+    pf_set_resample_type(pf, type.second);
+    pf_sample_set_t * set = pf->sets + pf->current_set;
+    set->sample_count = count;
+    for (int i = 0; i < count; i++) {
+      set->samples[i].pose = pf_vector_zero();
+      set->samples[i].pose.v[0] = i < count / 2 ? 1.0 : 5.0;
+      set->samples[i].weight = (i < count / 2 ? 3.0 : 1.0) / (2.0 * count);
+    }
+
+    pf->w_slow = pf->w_fast = 0.0;
+    pf_update_resample(pf);
+
+    set = pf->sets + pf->current_set;
+    EXPECT_GT(set->sample_count, pf->min_samples) << type.first;
+    EXPECT_LT(set->sample_count, count / 10) << type.first;
+
+    // The samples taken from the comb schemes are a random subset of all the draws, not
+    // its first samples, so both hypotheses keep their share
+    int first = 0;
+    for (int i = 0; i < set->sample_count; i++) {
+      first += set->samples[i].pose.v[0] == 1.0;
+    }
+    EXPECT_NEAR(static_cast<double>(first) / set->sample_count, 0.75, 0.1) << type.first;
+
+    pf_free(pf);
+  }
+}
@@ -0,0 +1,177 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <memory>
+#include <random>
+
+#include "gtest/gtest.h"
+#include "nav2_amcl/map/map.hpp"
+#include "nav2_amcl/pf/pf.hpp"
+#include "nav2_amcl/sensors/laser/laser.hpp"
+
+namespace
+{
+
+const double kZHit = 0.5;
+const double kZShort = 0.05;
+const double kZMax = 0.05;
+const double kZRand = 0.5;
+const double kSigmaHit = 0.2;
+const double kLambdaShort = 0.1;
+const double kMaxOccDist = 1.0;
+const int kMaxBeams = 31;
+const double kRangeMax = 4.0;
+const int kSampleCount = 2000;
+const int kThreads = 4;
+
+// Map of free cells with a few occupied blocks
+map_t * createMap(int size_x, int size_y, std::mt19937 & rng)
+{
+  map_t * map = map_alloc();
+  map->size_x = size_x;
+  map->size_y = size_y;
+  map->scale = 0.1;
+  map->origin_x = 0.0;
+  map->origin_y = 0.0;
+  map->cells = reinterpret_cast<map_cell_t *>(
+    malloc(sizeof(map_cell_t) * map->size_x * map->size_y));
+  for (int i = 0; i < size_x * size_y; i++) {
+    map->cells[i].occ_state = -1;
+  }
+
+  std::uniform_int_distribution<int> x_dist(0, size_x - 1);
+  std::uniform_int_distribution<int> y_dist(0, size_y - 1);
+  for (int block = 0; block < 20; block++) {
+    const int bx = x_dist(rng);
+    const int by = y_dist(rng);
+    for (int j = by; j < by + 3 && j < size_y; j++) {
+      for (int i = bx; i < bx + 3 && i < size_x; i++) {
+        map->cells[MAP_INDEX(map, i, j)].occ_state = +1;
+      }
+    }
+  }
+  return map;
+}
+
+pf_vector_t zeroPose(void *)
+{
+  return pf_vector_zero();
+}
+
+// Filter with the same particles for the same seed, spread over the map
+pf_t * createFilter(const map_t * map, unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  pf_t * pf = pf_alloc(kSampleCount, kSampleCount, 0.001, 0.1, zeroPose, NULL);
+  pf_sample_set_t * set = pf->sets + pf->current_set;
+  set->sample_count = kSampleCount;
+  set->converged = 1;
+  const double width = map->size_x * map->scale;
+  const double height = map->size_y * map->scale;
+  std::uniform_real_distribution<double> x_dist(-0.5 * width, 0.5 * width);
+  std::uniform_real_distribution<double> y_dist(-0.5 * height, 0.5 * height);
+  std::uniform_real_distribution<double> angle_dist(-M_PI, M_PI);
+  for (int j = 0; j < kSampleCount; j++) {
+    set->samples[j].pose.v[0] = x_dist(rng);
+    set->samples[j].pose.v[1] = y_dist(rng);
+    set->samples[j].pose.v[2] = angle_dist(rng);
+    set->samples[j].weight = 1.0 / kSampleCount;
+  }
+  return pf;
+}
+
+// Run one update with a single thread and one with several, on the same particles. The
+// total is checked through the normalized weights, and the unnormalized weights through
+// their average in w_slow and w_fast.
+void expectSameWeightsWithThreads(nav2_amcl::Laser * laser, const map_t * map)
+{
+  std::mt19937 rng(7);
+  const int range_count = 2 * kMaxBeams - 1;
+  nav2_amcl::LaserData data;
+  data.laser = laser;
+  data.range_count = range_count;
+  data.range_max = kRangeMax;
+  data.ranges = new double[range_count][2];
+  std::uniform_real_distribution<double> range_dist(0.05, 3.0);
+  for (int i = 0; i < range_count; i++) {
+    data.ranges[i][0] = range_dist(rng);
+    data.ranges[i][1] = -M_PI + i * 2.0 * M_PI / range_count;
+  }
+  data.ranges[4][0] = kRangeMax;
+
+  pf_t * serial = createFilter(map, 11);
+  pf_t * parallel = createFilter(map, 11);
+
+  laser->setNumThreads(1);
+  ASSERT_TRUE(laser->sensorUpdate(serial, &data));
+  laser->setNumThreads(kThreads);
+  ASSERT_TRUE(laser->sensorUpdate(parallel, &data));
+
+  const pf_sample_set_t * serial_set = serial->sets + serial->current_set;
+  const pf_sample_set_t * parallel_set = parallel->sets + parallel->current_set;
+  ASSERT_EQ(serial_set->sample_count, parallel_set->sample_count);
+  for (int j = 0; j < serial_set->sample_count; j++) {
+    EXPECT_EQ(serial_set->samples[j].weight, parallel_set->samples[j].weight) << "sample " << j;
+  }
+  EXPECT_EQ(serial->w_slow, parallel->w_slow);
+  EXPECT_EQ(serial->w_fast, parallel->w_fast);
+  EXPECT_GT(serial->w_slow, 0.0);
+
+  pf_free(parallel);
+  pf_free(serial);
+}
+
+}  // namespace
+
+TEST(SensorUpdateThreads, likelihoodFieldModel)
+{
+  std::mt19937 rng(3);
+  map_t * map = createMap(60, 50, rng);
+  std::unique_ptr<nav2_amcl::Laser> laser(
+    new nav2_amcl::LikelihoodFieldModel(kZHit, kZRand, kSigmaHit, kMaxOccDist, kMaxBeams, map));
+  expectSameWeightsWithThreads(laser.get(), map);
+  laser.reset();
+  map_free(map);
+}
+
+TEST(SensorUpdateThreads, likelihoodFieldModelProb)
+{
+  std::mt19937 rng(4);
+  map_t * map = createMap(60, 50, rng);
+  // With beam skipping, so the per-thread beam counts are added up too
+  std::unique_ptr<nav2_amcl::Laser> laser(
+    new nav2_amcl::LikelihoodFieldModelProb(
+      kZHit, kZRand, kSigmaHit, kMaxOccDist, true, 0.5, 0.3, 0.9, kMaxBeams, map));
+  expectSameWeightsWithThreads(laser.get(), map);
+  laser.reset();
+  map_free(map);
+}
+
+TEST(SensorUpdateThreads, beamModel)
+{
+  std::mt19937 rng(5);
+  map_t * map = createMap(60, 50, rng);
+  std::unique_ptr<nav2_amcl::Laser> laser(
+    new nav2_amcl::BeamModel(
+      kZHit, kZShort, kZMax, kZRand, kSigmaHit, kLambdaShort, 0.0, kMaxBeams, map));
+  expectSameWeightsWithThreads(laser.get(), map);
+  laser.reset();
+  map_free(map);
+}
@@ -156,6 +156,51 @@ public:
    */
   unsigned char getCost(unsigned int index) const;
 
+  /**
+   * @brief  Get the costs of a batch of cells, using SIMD gathers where available
+   * @param indices The indices of the cells, all must be within the costmap
+   * @param n The number of cells
+   * @param costs Array of at least n elements to fill with the costs of the cells
+   */
+  void getCosts(const unsigned int * indices, unsigned int n, unsigned char * costs) const;
+
+  /**
+   * @brief  Get the costs of a batch of cells, using SIMD gathers where available
+   * @param mx The x coordinates of the cells, all must be within the costmap
+   * @param my The y coordinates of the cells, all must be within the costmap
+   * @param n The number of cells
+   * @param costs Array of at least n elements to fill with the costs of the cells
+   */
+  void getCosts(
+    const unsigned int * mx, const unsigned int * my, unsigned int n,
+    unsigned char * costs) const;
+
+  /**
+   * @brief  Get the maximum cost of a batch of cells
+   * @param indices The indices of the cells, all must be within the costmap
+   * @param n The number of cells
+   * @return The maximum cost of the cells, 0 if there are none
+   */
+  unsigned char getMaxCost(const unsigned int * indices, unsigned int n) const;
+
+  /**
+   * @brief  Get the maximum cost of a batch of cells
+   * @param mx The x coordinates of the cells, all must be within the costmap
+   * @param my The y coordinates of the cells, all must be within the costmap
+   * @param n The number of cells
+   * @return The maximum cost of the cells, 0 if there are none
+   */
+  unsigned char getMaxCost(const unsigned int * mx, const unsigned int * my, unsigned int n) const;
+
+  /**
+   * @brief  Check whether any cell of a batch has a cost, e.g. LETHAL_OBSTACLE
+   * @param indices The indices of the cells, all must be within the costmap
+   * @param n The number of cells
+   * @param cost The cost to look for
+   * @return Whether any of the cells has the cost
+   */
+  bool hasCost(const unsigned int * indices, unsigned int n, unsigned char cost) const;
+
   /**
    * @brief  Set the cost of a cell in the costmap
    * @param mx The x coordinate of the cell
@@ -40,17 +40,28 @@
 #define NAV2_COSTMAP_2D__COSTMAP_2D_PUBLISHER_HPP_
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "rclcpp_lifecycle/lifecycle_node.hpp"
 #include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/throttled_diagnostics.hpp"
 #include "nav_msgs/msg/occupancy_grid.hpp"
 #include "map_msgs/msg/occupancy_grid_update.hpp"
+#include "nav2_msgs/msg/compressed_costmap.hpp"
 #include "nav2_msgs/msg/costmap.hpp"
+#include "nav2_msgs/msg/costmap_update.hpp"
 #include "nav2_msgs/srv/get_costmap.hpp"
 #include "tf2/transform_datatypes.h"
 #include "nav2_util/lifecycle_node.hpp"
+#include "std_msgs/msg/empty.hpp"
 #include "tf2/LinearMath/Quaternion.h"
 #include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
 
@@ -63,20 +74,44 @@ namespace nav2_costmap_2d
 class Costmap2DPublisher
 {
 public:
+  /**
+   * @struct PublishStats
+   * @brief Counters of the costmaps published
+   */
+  struct PublishStats
+  {
+    uint64_t published{0};  ///< @brief Costmaps published
+    uint64_t dropped{0};  ///< @brief Costmaps replaced by a newer one before being published
+    double last_latency{0.0};  ///< @brief Time from hand off to published of the last, in s
+    double max_latency{0.0};  ///< @brief Largest time from hand off to published, in s
+  };
+
   /**
    * @brief  Constructor for the Costmap2DPublisher
+   * @param update_keyframe_period Number of raw costmap updates between keyframes,
+   * 0 to only send keyframes when the costmap is resized, moved or on request
+   * @param asynchronous Whether to publish from a dedicated thread while active, only
+   * copying the costmap in publishCostmap
+   * @param downsample_factor Factor to max pool the costmap by for the downsampled
+   * visualization grid, 0 or 1 for none
+   * @param compression_format Format of the compressed costmap, "png" or "zlib", empty
+   * for none
    */
   Costmap2DPublisher(
     const nav2_util::LifecycleNode::WeakPtr & parent,
     Costmap2D * costmap,
     std::string global_frame,
     std::string topic_name,
-    bool always_send_full_costmap = false);
+    bool always_send_full_costmap = false,
+    unsigned int update_keyframe_period = 20,
+    bool asynchronous = false,
+    unsigned int downsample_factor = 0,
+    std::string compression_format = "");
 
   /**
    * @brief  Destructor
    */
-  ~Costmap2DPublisher();
+  virtual ~Costmap2DPublisher();
 
   /**
    * @brief Configure node
@@ -91,6 +126,17 @@ public:
     costmap_pub_->on_activate();
     costmap_update_pub_->on_activate();
     costmap_raw_pub_->on_activate();
+    costmap_raw_update_pub_->on_activate();
+    diagnostics_->activate();
+    if (costmap_downsampled_pub_) {
+      costmap_downsampled_pub_->on_activate();
+    }
+    if (costmap_compressed_pub_) {
+      costmap_compressed_pub_->on_activate();
+    }
+    if (asynchronous_) {
+      startPublishThread();
+    }
   }
 
   /**
@@ -98,9 +144,18 @@ public:
    */
   void on_deactivate()
   {
+    stopPublishThread();
     costmap_pub_->on_deactivate();
     costmap_update_pub_->on_deactivate();
     costmap_raw_pub_->on_deactivate();
+    costmap_raw_update_pub_->on_deactivate();
+    diagnostics_->deactivate();
+    if (costmap_downsampled_pub_) {
+      costmap_downsampled_pub_->on_deactivate();
+    }
+    if (costmap_compressed_pub_) {
+      costmap_compressed_pub_->on_deactivate();
+    }
   }
 
   /**
@@ -118,10 +173,18 @@ public:
   }
 
   /**
-   * @brief  Publishes the visualization data over ROS
+   * @brief  Publishes the visualization data over ROS. When asynchronous, only copies
+   * the costmap for the publishing thread, replacing the copy it didn't get to yet.
+   * The publish stats are sent to /diagnostics about once per second
    */
   void publishCostmap();
 
+  /**
+   * @brief Get the counters of the costmaps published
+   * @return Publish stats
+   */
+  PublishStats getPublishStats();
+
   /**
    * @brief Check if the publisher is active
    * @return True if the frequency for the publisher is non-zero, false otherwise
@@ -131,10 +194,54 @@ public:
     return active_;
   }
 
+protected:
+  /**
+   * @brief Publish the messages of a costmap. Only ever called by one thread at a time
+   * @param costmap Costmap to publish, locked while read
+   * @param x0, xn, y0, yn Bounds of the cells changed since the last publish
+   * @param stamp Time of the raw costmap messages
+   */
+  virtual void publish(
+    Costmap2D & costmap, unsigned int x0, unsigned int xn, unsigned int y0,
+    unsigned int yn, const rclcpp::Time & stamp);
+
 private:
   /** @brief Prepare grid_ message for publication. */
-  void prepareGrid();
-  void prepareCostmap();
+  void prepareGrid(Costmap2D & costmap);
+  void prepareCostmap(Costmap2D & costmap, const rclcpp::Time & stamp);
+
+  /**
+   * @brief Prepare costmap_raw_update_ message for publication, as the changes since
+   * the last update or as a keyframe
+   */
+  void prepareCostmapUpdate(Costmap2D & costmap, const rclcpp::Time & stamp);
+
+  /** @brief Prepare downsampled_grid_ message for publication, max pooling the costmap */
+  void prepareDownsampledGrid(Costmap2D & costmap, const rclcpp::Time & stamp);
+
+  /**
+   * @brief Prepare costmap_compressed_ message for publication
+   * @return Whether the costmap could be compressed
+   */
+  bool prepareCompressedCostmap(Costmap2D & costmap, const rclcpp::Time & stamp);
+
+  /** @brief Record a publish in the stats */
+  void recordPublish(double latency);
+
+  /** @brief Send the publish stats to /diagnostics, if they weren't sent for a second */
+  void publishDiagnostics();
+
+  /** @brief Start the thread publishing the costmaps handed off by publishCostmap */
+  void startPublishThread();
+
+  /** @brief Stop the publishing thread, dropping the costmap it didn't get to */
+  void stopPublishThread();
+
+  /** @brief Publish the latest costmap handed off, until stopped */
+  void publishLoop();
+
+  /** @brief Callback of subscribers of the raw costmap updates that lost track of them */
+  void resyncCallback(const std_msgs::msg::Empty::SharedPtr msg);
 
   /** @brief Publish the latest full costmap to the new subscriber. */
   // void onNewSubscription(const ros::SingleSubscriberPublisher& pub);
@@ -157,6 +264,16 @@ private:
   bool active_;
   bool always_send_full_costmap_;
 
+  // State of the raw costmap updates
+  unsigned int update_keyframe_period_;
+  unsigned int updates_since_keyframe_;
+  uint32_t update_seq_;
+  std::atomic<bool> keyframe_requested_;
+  std::vector<unsigned char> last_raw_;  // Costmap as of the last update
+  double last_raw_resolution_;
+  double last_raw_origin_x_;
+  double last_raw_origin_y_;
+
   // Publisher for translated costmap values as msg::OccupancyGrid used in visualization
   rclcpp_lifecycle::LifecyclePublisher<nav_msgs::msg::OccupancyGrid>::SharedPtr costmap_pub_;
   rclcpp_lifecycle::LifecyclePublisher<map_msgs::msg::OccupancyGridUpdate>::SharedPtr
@@ -165,13 +282,58 @@ private:
   // Publisher for raw costmap values as msg::Costmap from layered costmap
   rclcpp_lifecycle::LifecyclePublisher<nav2_msgs::msg::Costmap>::SharedPtr costmap_raw_pub_;
 
+  // Publisher for changes to the raw costmap, with periodic keyframes, and the
+  // requests for a keyframe from subscribers that missed an update
+  rclcpp_lifecycle::LifecyclePublisher<nav2_msgs::msg::CostmapUpdate>::SharedPtr
+    costmap_raw_update_pub_;
+  rclcpp::Subscription<std_msgs::msg::Empty>::SharedPtr resync_sub_;
+
+  // Publisher of the publish stats
+  std::unique_ptr<ThrottledDiagnostics> diagnostics_;
+
+  // Publishers for lower bandwidth versions of the costmap, only created if enabled and
+  // only built while subscribed to
+  unsigned int downsample_factor_;
+  std::string compression_format_;
+  rclcpp_lifecycle::LifecyclePublisher<nav_msgs::msg::OccupancyGrid>::SharedPtr
+    costmap_downsampled_pub_;
+  rclcpp_lifecycle::LifecyclePublisher<nav2_msgs::msg::CompressedCostmap>::SharedPtr
+    costmap_compressed_pub_;
+
   // Service for getting the costmaps
   rclcpp::Service<nav2_msgs::srv::GetCostmap>::SharedPtr costmap_service_;
 
   float grid_resolution;
   unsigned int grid_width, grid_height;
+  // Messages are reused across publishes, so their buffers are only grown
   std::unique_ptr<nav_msgs::msg::OccupancyGrid> grid_;
+  std::unique_ptr<map_msgs::msg::OccupancyGridUpdate> grid_update_;
   std::unique_ptr<nav2_msgs::msg::Costmap> costmap_raw_;
+  std::unique_ptr<nav2_msgs::msg::CostmapUpdate> costmap_raw_update_;
+  std::unique_ptr<nav_msgs::msg::OccupancyGrid> downsampled_grid_;
+  std::vector<unsigned char> downsampled_;
+  std::unique_ptr<nav2_msgs::msg::CompressedCostmap> costmap_compressed_;
+
+  // Asynchronous publishing: the costmap is copied to spare_costmap_ by publishCostmap,
+  // swapped with pending_costmap_ under publish_mutex_ and swapped again with
+  // working_costmap_ by the publishing thread. A pending costmap that wasn't picked up
+  // is replaced, its bounds merged into those of the next. publish_thread_running_ is only
+  // cleared once the thread is joined, so publishCostmap never publishes alongside it.
+  bool asynchronous_;
+  std::thread publish_thread_;
+  std::atomic<bool> publish_thread_running_{false};
+  std::mutex publish_mutex_;
+  std::condition_variable publish_cv_;
+  bool publish_thread_shutdown_{false};
+  bool pending_{false};
+  std::unique_ptr<Costmap2D> spare_costmap_;
+  std::unique_ptr<Costmap2D> pending_costmap_;
+  std::unique_ptr<Costmap2D> working_costmap_;
+  unsigned int pending_x0_, pending_xn_, pending_y0_, pending_yn_;
+  rclcpp::Time pending_stamp_;
+  std::chrono::steady_clock::time_point pending_time_;
+  PublishStats stats_;  // Guarded by publish_mutex_
+
   // Translate from 0-255 values in costmap to -1 to 100 values in message.
   static char * cost_translation_table_;
 };
@@ -49,6 +49,7 @@
 #include "nav2_costmap_2d/clear_costmap_service.hpp"
 #include "nav2_costmap_2d/layered_costmap.hpp"
 #include "nav2_costmap_2d/layer.hpp"
+#include "nav2_costmap_2d/shared_costmap.hpp"
 #include "nav2_util/lifecycle_node.hpp"
 #include "pluginlib/class_loader.hpp"
 #include "tf2/convert.h"
@@ -197,6 +198,14 @@ public:
     return layered_costmap_->getCostmap();
   }
 
+  /**
+   * @brief Get the latest snapshot of the "master" costmap, copied after each update
+   * when the costmap is double buffered. Snapshots are read without locking, so readers
+   * don't hold up updates, and stay valid for as long as they are held.
+   * @return Snapshot, or nullptr if not double buffered or not updated yet
+   */
+  std::shared_ptr<const Costmap2D> getCostmapSnapshot();
+
   /**
    * @brief  Returns the global frame of the costmap
    * @return The global frame of the costmap
@@ -302,6 +311,9 @@ protected:
     footprint_pub_;
   std::unique_ptr<Costmap2DPublisher> costmap_publisher_{nullptr};
 
+  // Snapshots of the costmap for the consumers in this process
+  std::shared_ptr<SharedCostmap> shared_costmap_;
+
   rclcpp::Subscription<geometry_msgs::msg::Polygon>::SharedPtr footprint_sub_;
   rclcpp::Subscription<rcl_interfaces::msg::ParameterEvent>::SharedPtr parameter_sub_;
 
@@ -331,11 +343,15 @@ protected:
    */
   void getParameters();
   bool always_send_full_costmap_{false};
+  bool asynchronous_publishing_{true};  ///< Whether to publish from a dedicated thread
+  bool double_buffered_{false};
   std::string footprint_;
   float footprint_padding_{0};
   std::string global_frame_;       ///< The global frame for the costmap
   int map_height_meters_{0};
   double map_publish_frequency_{0};
+  int publish_downsample_factor_{0};  ///< Max pooling factor of the downsampled costmap, 0 for none
+  std::string publish_compression_format_;  ///< png or zlib, empty for no compressed costmap
   double map_update_frequency_{0};
   int map_width_meters_{0};
   double origin_x_{0};
@@ -346,12 +362,15 @@ protected:
   std::vector<std::string> plugin_types_;
   std::vector<std::string> filter_names_;
   std::vector<std::string> filter_types_;
+  int raw_update_keyframe_period_{20};  ///< Raw costmap updates between keyframes, 0 for none
   double resolution_{0};
   std::string robot_base_frame_;   ///< The frame_id of the robot base
   double robot_radius_;
   bool rolling_window_{false};     ///< Whether to use a rolling window version of the costmap
   bool track_unknown_space_{false};
   double transform_tolerance_{0};  ///< The timeout before transform errors
+  int update_threads_{1};          ///< Threads updating the layers, 0 or less for all cores
+  int update_tile_size_{128};      ///< Width in cells of the tiles updated in parallel
 
   // Derived parameters
   bool use_radius_{false};
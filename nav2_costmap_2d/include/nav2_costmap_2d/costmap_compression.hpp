@@ -0,0 +1,74 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#ifndef NAV2_COSTMAP_2D__COSTMAP_COMPRESSION_HPP_
+#define NAV2_COSTMAP_2D__COSTMAP_COMPRESSION_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nav2_msgs/msg/compressed_costmap.hpp"
+
+namespace nav2_costmap_2d
+{
+
+/**
+ * @brief Downsample a costmap by max pooling square blocks of cells, so no obstacle is
+ * lost. Unknown cells only make a block unknown if all of its cells are unknown.
+ * @param costmap Cost data of size_x * size_y cells
+ * @param size_x Width of the costmap in cells
+ * @param size_y Height of the costmap in cells
+ * @param factor Width of the blocks in cells, partial blocks are kept at the far edges
+ * @param downsampled Cost data of the downsampled costmap, resized to fit
+ * @param downsampled_x Width of the downsampled costmap, the ceiling of size_x / factor
+ * @param downsampled_y Height of the downsampled costmap, the ceiling of size_y / factor
+ */
+void downsampleCostmap(
+  const unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  unsigned int factor, std::vector<unsigned char> & downsampled,
+  unsigned int & downsampled_x, unsigned int & downsampled_y);
+
+/**
+ * @brief Check whether a compression format is supported
+ * @param format Format of the compressed costmap message
+ * @return True for "png" and "zlib"
+ */
+bool isCompressionFormatSupported(const std::string & format);
+
+/**
+ * @brief Compress the costs of a costmap into the data of a compressed costmap message
+ * @param costmap Cost data of size_x * size_y cells
+ * @param size_x Width of the costmap in cells
+ * @param size_y Height of the costmap in cells
+ * @param format Format to compress in, "png" or "zlib"
+ * @param data Compressed data, reusing its capacity
+ * @return Whether the costmap could be compressed
+ */
+bool compressCostmap(
+  const unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  const std::string & format, std::vector<uint8_t> & data);
+
+/**
+ * @brief Decompress the costs of a compressed costmap message
+ * @param msg Compressed costmap, of a supported format
+ * @param costmap Cost data of the size of the metadata of the message
+ * @return Whether the costmap could be decompressed, false for malformed messages
+ */
+bool decompressCostmap(
+  const nav2_msgs::msg::CompressedCostmap & msg, std::vector<unsigned char> & costmap);
+
+}  // namespace nav2_costmap_2d
+
+#endif  // NAV2_COSTMAP_2D__COSTMAP_COMPRESSION_HPP_
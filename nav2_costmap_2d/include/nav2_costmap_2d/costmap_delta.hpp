@@ -0,0 +1,88 @@
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NAV2_COSTMAP_2D__COSTMAP_DELTA_HPP_
+#define NAV2_COSTMAP_2D__COSTMAP_DELTA_HPP_
+
+#include <vector>
+
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_msgs/msg/costmap_update.hpp"
+
+namespace nav2_costmap_2d
+{
+
+/**
+ * @brief Encode a whole costmap as a keyframe update, a single run over all of the cells
+ * @param costmap Cost data of size_x * size_y cells
+ * @param size_x Width of the costmap in cells
+ * @param size_y Height of the costmap in cells
+ * @param last Copy of the costmap as last encoded, set to the cost data
+ * @param update Update to fill, apart from its header, sequence number and metadata
+ */
+void encodeCostmapKeyframe(
+  const unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  std::vector<unsigned char> & last, nav2_msgs::msg::CostmapUpdate & update);
+
+/**
+ * @brief Encode the cells of a costmap that differ from its last encoded copy as runs,
+ * without a shift
+ * @param costmap Cost data of size_x * size_y cells
+ * @param size_x Width of the costmap in cells
+ * @param size_y Height of the costmap in cells
+ * @param last Copy of the costmap as last encoded, of the same size, brought up to date
+ * @param update Update to fill, apart from its header, sequence number and metadata
+ */
+void encodeCostmapDelta(
+  const unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  std::vector<unsigned char> & last, nav2_msgs::msg::CostmapUpdate & update);
+
+/**
+ * @brief Get the whole cells a costmap moved by, as Costmap2D::updateOrigin moves it
+ * @param old_origin_x, old_origin_y Origin of the costmap before it moved
+ * @param new_origin_x, new_origin_y Origin of the costmap after it moved
+ * @param resolution Resolution of the costmap
+ * @param shift_x, shift_y Cells the costmap moved by
+ * @return Whether it moved by whole cells
+ */
+bool getCostmapShift(
+  double old_origin_x, double old_origin_y, double new_origin_x, double new_origin_y,
+  double resolution, int & shift_x, int & shift_y);
+
+/**
+ * @brief Move the cost data of a costmap to its new origin in place, like
+ * Costmap2D::updateOrigin. Cell (i, j) takes the cost of cell (i + shift_x, j + shift_y).
+ * @param costmap Cost data of size_x * size_y cells
+ * @param size_x Width of the costmap in cells
+ * @param size_y Height of the costmap in cells
+ * @param shift_x, shift_y Cells the origin moved by
+ * @param fill Cost of the cells no longer covered by the old costmap
+ */
+void shiftCostmapData(
+  unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  int shift_x, int shift_y, unsigned char fill);
+
+/**
+ * @brief Write the runs of an update into a costmap. Keyframes first resize the costmap
+ * to their metadata, while other updates must match the size of the costmap and are
+ * applied after shifting it by their shift_x and shift_y.
+ * @param update Update to apply
+ * @param costmap Costmap to apply it to, unchanged if the update is malformed
+ * @return Whether the update was applied
+ */
+bool applyCostmapUpdate(const nav2_msgs::msg::CostmapUpdate & update, Costmap2D & costmap);
+
+}  // namespace nav2_costmap_2d
+
+#endif  // NAV2_COSTMAP_2D__COSTMAP_DELTA_HPP_
@@ -106,6 +106,20 @@ public:
     nav2_costmap_2d::Costmap2D & master_grid,
     int min_i, int min_j, int max_i, int max_j) final;
 
+  /**
+   * @brief Update the costs in the master costmap in the window, tile by tile
+   * @param master_grid The master costmap grid to update
+   * @param min_x X min map coord of the window to update
+   * @param min_y Y min map coord of the window to update
+   * @param max_x X max map coord of the window to update
+   * @param max_y Y max map coord of the window to update
+   * @param executor Executor to run the tiles with
+   */
+  virtual void updateCostsTiled(
+    nav2_costmap_2d::Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j,
+    TileExecutor & executor) final;
+
   /**
    * @brief Activate the layer
    */
@@ -147,6 +161,27 @@ public:
     int min_i, int min_j, int max_i, int max_j,
     const geometry_msgs::msg::Pose2D & pose) = 0;
 
+  /**
+   * @brief: Same as process(), splitting the costmap work into tiles run by the executor.
+   *         Filters that can fill the master costmap tile by tile override this,
+   *         by default process() is called over the whole window.
+   * @param: Reference to a master costmap2d
+   * @param: Low window map boundary OX
+   * @param: Low window map boundary OY
+   * @param: High window map boundary OX
+   * @param: High window map boundary OY
+   * @param: Robot 2D-pose
+   * @param: Executor to run the tiles with
+   */
+  virtual void processTiled(
+    nav2_costmap_2d::Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j,
+    const geometry_msgs::msg::Pose2D & pose,
+    TileExecutor & /*executor*/)
+  {
+    process(master_grid, min_i, min_j, max_i, max_j, pose);
+  }
+
   /**
    * @brief: Resets costmap filter. Stops all subscriptions
    */
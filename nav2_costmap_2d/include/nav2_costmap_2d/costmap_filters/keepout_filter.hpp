@@ -46,6 +46,7 @@
 #include "rclcpp/rclcpp.hpp"
 #include "nav_msgs/msg/occupancy_grid.hpp"
 #include "nav2_msgs/msg/costmap_filter_info.hpp"
+#include "tf2/LinearMath/Transform.h"
 
 namespace nav2_costmap_2d
 {
@@ -77,6 +78,15 @@ public:
     int min_i, int min_j, int max_i, int max_j,
     const geometry_msgs::msg::Pose2D & pose);
 
+  /**
+   * @brief Process the keepout layer at the current pose / bounds / grid, tile by tile
+   */
+  void processTiled(
+    nav2_costmap_2d::Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j,
+    const geometry_msgs::msg::Pose2D & pose,
+    TileExecutor & executor) override;
+
   /**
    * @brief Reset the costmap filter / topic / info
    */
@@ -96,6 +106,13 @@ private:
    * @brief Callback for the filter mask
    */
   void maskCallback(const nav_msgs::msg::OccupancyGrid::SharedPtr msg);
+  /**
+   * @brief Mark the keepout regions of the mask in a window of the master grid
+   */
+  void applyMask(
+    nav2_costmap_2d::Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j,
+    const tf2::Transform & tf2_transform);
 
   rclcpp::Subscription<nav2_msgs::msg::CostmapFilterInfo>::SharedPtr filter_info_sub_;
   rclcpp::Subscription<nav_msgs::msg::OccupancyGrid>::SharedPtr mask_sub_;
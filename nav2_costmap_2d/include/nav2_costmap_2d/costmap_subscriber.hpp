@@ -17,34 +17,47 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "rclcpp/rclcpp.hpp"
 #include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/shared_costmap.hpp"
 #include "nav2_msgs/msg/costmap.hpp"
+#include "nav2_msgs/msg/costmap_update.hpp"
 #include "nav2_util/lifecycle_node.hpp"
+#include "std_msgs/msg/empty.hpp"
 
 namespace nav2_costmap_2d
 {
 /**
  * @class CostmapSubscriber
- * @brief Subscribes to the costmap via a ros topic
+ * @brief Subscribes to the costmap via a ros topic, either to the full costmap or to
+ * its incremental updates on <topic>_updates. If the costmap is produced in the same
+ * process, the snapshots it shares are used instead of the topic.
  */
 class CostmapSubscriber
 {
 public:
   /**
    * @brief A constructor
+   * @param use_updates Whether to follow the incremental updates of the costmap, only
+   * requesting the full costmap again when an update was missed
    */
   CostmapSubscriber(
     const nav2_util::LifecycleNode::WeakPtr & parent,
-    const std::string & topic_name);
+    const std::string & topic_name,
+    bool use_updates = false);
 
   /**
    * @brief A constructor
+   * @param use_updates Whether to follow the incremental updates of the costmap, only
+   * requesting the full costmap again when an update was missed
    */
   CostmapSubscriber(
     const rclcpp::Node::WeakPtr & parent,
-    const std::string & topic_name);
+    const std::string & topic_name,
+    bool use_updates = false);
 
   /**
    * @brief A destructor
@@ -53,24 +66,46 @@ public:
 
   /**
    * @brief A Get the costmap from topic
+   * @return Costmap, which may be a snapshot shared with other consumers in the
+   * process
    */
-  std::shared_ptr<Costmap2D> getCostmap();
+  std::shared_ptr<const Costmap2D> getCostmap();
 
 protected:
   /**
    * @brief Convert an occ grid message into a costmap object
    */
   void toCostmap2D();
+  /**
+   * @brief Apply the updates received since the last call into the costmap object
+   */
+  void applyUpdates();
   /**
    * @brief Callback for the costmap topic
    */
   void costmapCallback(const nav2_msgs::msg::Costmap::SharedPtr msg);
+  /**
+   * @brief Callback for the costmap updates topic
+   */
+  void costmapUpdateCallback(const nav2_msgs::msg::CostmapUpdate::SharedPtr update);
 
   std::shared_ptr<Costmap2D> costmap_;
   nav2_msgs::msg::Costmap::SharedPtr costmap_msg_;
   std::string topic_name_;
   bool costmap_received_{false};
   rclcpp::Subscription<nav2_msgs::msg::Costmap>::SharedPtr costmap_sub_;
+
+  // Updates are queued by the callback and applied on the next getCostmap()
+  bool use_updates_;
+  bool synced_{false};  // Whether no update was missed since the last keyframe
+  uint32_t last_seq_{0};
+  std::vector<nav2_msgs::msg::CostmapUpdate::SharedPtr> pending_updates_;
+  rclcpp::Subscription<nav2_msgs::msg::CostmapUpdate>::SharedPtr costmap_update_sub_;
+  rclcpp::Publisher<std_msgs::msg::Empty>::SharedPtr resync_pub_;
+
+  // Costmap produced in this process, if any
+  std::shared_ptr<SharedCostmap> shared_costmap_;
+  std::mutex mutex_;
 };
 
 }  // namespace nav2_costmap_2d
@@ -52,6 +52,13 @@ public:
    * @brief Find the footprint cost in oriented footprint
    */
   double footprintCost(const Footprint footprint);
+  /**
+   * @brief Get the indices of the cells on the outline of an oriented footprint
+   * @param footprint Oriented footprint
+   * @param cells Vector to fill with the cell indices, may contain duplicates
+   * @return Whether the footprint is within the costmap
+   */
+  bool footprintCells(const Footprint & footprint, std::vector<unsigned int> & cells);
   /**
    * @brief Find the footprint cost a a post with an unoriented footprint
    */
@@ -75,6 +82,8 @@ public:
 
 protected:
   CostmapT costmap_;
+  // Buffer of footprint cells to look up the costs of at once
+  std::vector<unsigned int> footprint_cells_;
 };
 
 }  // namespace nav2_costmap_2d
@@ -38,7 +38,10 @@
 #ifndef NAV2_COSTMAP_2D__INFLATION_LAYER_HPP_
 #define NAV2_COSTMAP_2D__INFLATION_LAYER_HPP_
 
+#include <functional>
 #include <map>
+#include <queue>
+#include <utility>
 #include <vector>
 #include <mutex>
 
@@ -123,6 +126,21 @@ public:
     nav2_costmap_2d::Costmap2D & master_grid,
     int min_i, int min_j, int max_i, int max_j) override;
 
+  /**
+   * @brief Update the costs in the master costmap in the window, tile by tile. Each tile
+   * is inflated from the obstacles within the inflation radius around it.
+   * @param master_grid The master costmap grid to update
+   * @param min_x X min map coord of the window to update
+   * @param min_y Y min map coord of the window to update
+   * @param max_x X max map coord of the window to update
+   * @param max_y Y max map coord of the window to update
+   * @param executor Executor to run the tiles with
+   */
+  void updateCostsTiled(
+    nav2_costmap_2d::Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j,
+    TileExecutor & executor) override;
+
   /**
    * @brief Match the size of the master costmap
    */
@@ -238,6 +256,102 @@ private:
     unsigned int index, unsigned int mx, unsigned int my,
     unsigned int src_x, unsigned int src_y);
 
+  /**
+   * @struct TileScratch
+   * @brief Inflation state of a worker of a tiled update
+   */
+  struct TileScratch
+  {
+    std::vector<bool> seen;
+    std::vector<std::vector<CellData>> inflation_cells;
+  };
+
+  /**
+   * @brief Inflate the sources marked around a tile into the costs of the tile
+   * @param master_grid The master costmap grid to update
+   * @param min_i X min map coord of the tile
+   * @param min_j Y min map coord of the tile
+   * @param max_i X max map coord of the tile
+   * @param max_j Y max map coord of the tile
+   * @param scratch Inflation state of the worker running the tile
+   */
+  void inflateTile(
+    nav2_costmap_2d::Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j,
+    TileScratch & scratch);
+
+  /**
+   * @brief Update the persistent distance field with the inflation sources that changed
+   * in the window, then write the costs of the window into the master grid
+   * @param master_grid The master costmap grid to update
+   * @param min_i X min map coord of the window to update
+   * @param min_j Y min map coord of the window to update
+   * @param max_i X max map coord of the window to update
+   * @param max_j Y max map coord of the window to update
+   */
+  void updateCostsIncrementally(
+    nav2_costmap_2d::Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j);
+
+  /**
+   * @brief Whether a cell cost makes the cell an inflation source
+   * @param cost Cost of the cell in the master grid
+   */
+  inline bool isInflationSource(unsigned char cost) const
+  {
+    return cost == LETHAL_OBSTACLE || (inflate_around_unknown_ && cost == NO_INFORMATION);
+  }
+
+  /**
+   * @brief Squared distance in cells between a cell and an inflation source
+   * @param index Index of the cell
+   * @param source Index of the inflation source
+   */
+  inline unsigned int fieldDistanceSq(unsigned int index, unsigned int source) const
+  {
+    const int dx =
+      static_cast<int>(index % field_size_x_) - static_cast<int>(source % field_size_x_);
+    const int dy =
+      static_cast<int>(index / field_size_x_) - static_cast<int>(source / field_size_x_);
+    return dx * dx + dy * dy;
+  }
+
+  /**
+   * @brief Move the distance field along with a rolling window, by whole cells
+   * @param master_array Cost data of the master grid, already moved to its new origin
+   * @param shift_x, shift_y Cells the origin moved by
+   */
+  void shiftField(const unsigned char * master_array, int shift_x, int shift_y);
+
+  /**
+   * @brief Make a cell an inflation source of the distance field
+   * @param index Index of the cell
+   */
+  void insertFieldSource(unsigned int index);
+
+  /**
+   * @brief Remove an inflation source from the distance field
+   * @param index Index of the cell
+   */
+  void removeFieldSource(unsigned int index);
+
+  /**
+   * @brief Process the raise and lower wavefronts of the distance field until it is consistent
+   */
+  void propagateField();
+
+  /**
+   * @brief Invalidate the cells whose nearest source was removed around a raised cell
+   * @param index Index of the raised cell
+   */
+  void raiseFieldCell(unsigned int index);
+
+  /**
+   * @brief Offer the nearest source of a cell to its neighbors
+   * @param index Index of the cell
+   */
+  void lowerFieldCell(unsigned int index);
+
   double inflation_radius_, inscribed_radius_, cost_scaling_factor_;
   bool inflate_unknown_, inflate_around_unknown_;
   unsigned int cell_inflation_radius_;
@@ -256,6 +370,27 @@ private:
 
   // Indicates that the entire costmap should be reinflated next time around.
   bool need_reinflation_;
+
+  // Incremental inflation: the nearest inflation source of every cell within the inflation
+  // radius is kept across updates and repaired with a dynamic brushfire where sources change.
+  // Sources are only passed between 8-connected neighbors, so where wavefronts meet a cell can
+  // keep a source slightly farther than its nearest one, as in the batch mode.
+  static constexpr unsigned char FIELD_SOURCE = 1;
+  static constexpr unsigned char FIELD_RAISE = 2;
+  typedef std::pair<unsigned int, unsigned int> FieldEntry;
+  bool incremental_inflation_;
+  bool need_field_reset_;
+  std::vector<int> field_source_;
+  std::vector<unsigned char> field_flags_;
+  std::priority_queue<FieldEntry, std::vector<FieldEntry>, std::greater<FieldEntry>> field_queue_;
+  unsigned int field_size_x_, field_size_y_;
+  double field_origin_x_, field_origin_y_;
+
+  // Tiled inflation: the inflation sources of the window grown by the inflation radius
+  // are marked before any tile is inflated, so tiles don't read the costs others write
+  std::vector<unsigned char> tile_sources_;
+  int tile_sources_min_i_, tile_sources_min_j_, tile_sources_max_i_, tile_sources_max_j_;
+  std::vector<TileScratch> tile_scratch_;
   mutex_t * access_;
 };
 
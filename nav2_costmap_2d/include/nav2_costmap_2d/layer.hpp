@@ -45,6 +45,7 @@
 #include "rclcpp/rclcpp.hpp"
 #include "nav2_costmap_2d/costmap_2d.hpp"
 #include "nav2_costmap_2d/layered_costmap.hpp"
+#include "nav2_costmap_2d/tile_executor.hpp"
 #include "nav2_util/lifecycle_node.hpp"
 
 namespace nav2_costmap_2d
@@ -112,6 +113,22 @@ public:
     Costmap2D & master_grid,
     int min_i, int min_j, int max_i, int max_j) = 0;
 
+  /**
+   * @brief Update the underlying costmap like updateCosts(), splitting the work into
+   *        tiles run by the executor, possibly in parallel.
+   *
+   * Layers whose costs can be computed tile by tile override this: the per-cycle
+   * work is done once and the per-cell work is run over the tiles of the executor.
+   * By default, updateCosts() is run over the whole bounds on the calling thread.
+   */
+  virtual void updateCostsTiled(
+    Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j,
+    TileExecutor & /*executor*/)
+  {
+    updateCosts(master_grid, min_i, min_j, max_i, max_j);
+  }
+
   /** @brief Implement this to make this layer match the size of the parent costmap. */
   virtual void matchSize() {}
 
@@ -45,11 +45,25 @@
 #include "nav2_costmap_2d/cost_values.hpp"
 #include "nav2_costmap_2d/layer.hpp"
 #include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/tile_executor.hpp"
 
 namespace nav2_costmap_2d
 {
 class Layer;
 
+/**
+ * @struct LayerUpdateTiming
+ * @brief Time a plugin or filter took to update its costs in the last update cycle
+ */
+struct LayerUpdateTiming
+{
+  std::string name;
+  // Wall time of the whole update, in seconds
+  double duration;
+  // Time of each tile of a tiled update, in seconds, empty if not tiled
+  std::vector<double> tile_durations;
+};
+
 /**
  * @class LayeredCostmap
  * @brief Instantiates different layer plugins and aggregates them into one score
@@ -212,7 +226,39 @@ public:
   * of poorly configured setups. */
   bool isOutofBounds(double robot_x, double robot_y);
 
+  /**
+   * @brief Set how the costs of the layers are updated. With more than one thread,
+   * the bounds are split into tiles and layers that support it update their tiles
+   * in parallel, the other layers still update the whole bounds at once.
+   * @param tile_size Width of the tiles in cells
+   * @param num_threads Number of threads, 1 to update serially, 0 or less for all cores
+   */
+  void setTiling(unsigned int tile_size, int num_threads);
+
+  /**
+   * @brief Get the time each plugin and filter took to update its costs in the
+   * last update cycle, in the order they were run
+   */
+  const std::vector<LayerUpdateTiming> & getUpdateTimings() const
+  {
+    return update_timings_;
+  }
+
+  /**
+   * @brief Get the time the last update cycle waited for readers to release the
+   * lock of the costmap, in seconds
+   */
+  double getUpdateLockWait() const
+  {
+    return update_lock_wait_;
+  }
+
 private:
+  /**
+   * @brief Update the costs of a plugin or filter and record the time it took
+   */
+  void updateLayerCosts(Layer & layer, Costmap2D & costmap, int x0, int y0, int xn, int yn);
+
   // primary_costmap_ is a bottom costmap used by plugins when costmap filters were enabled.
   // combined_costmap_ is a final costmap where all results produced by plugins and filters (if any)
   // to be merged.
@@ -234,6 +280,11 @@ private:
   bool size_locked_;
   double circumscribed_radius_, inscribed_radius_;
   std::vector<geometry_msgs::msg::Point> footprint_;
+
+  bool tiled_;
+  TileExecutor tile_executor_;
+  std::vector<LayerUpdateTiming> update_timings_;
+  double update_lock_wait_;
 };
 
 }  // namespace nav2_costmap_2d
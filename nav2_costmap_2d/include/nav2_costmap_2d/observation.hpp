@@ -32,16 +32,21 @@
 #ifndef NAV2_COSTMAP_2D__OBSERVATION_HPP_
 #define NAV2_COSTMAP_2D__OBSERVATION_HPP_
 
+#include <memory>
+#include <vector>
+
+#include <builtin_interfaces/msg/time.hpp>
 #include <geometry_msgs/msg/point.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
+#include <sensor_msgs/point_cloud2_iterator.hpp>
 
 namespace nav2_costmap_2d
 {
 
 /**
- * @brief Stores an observation in terms of a point cloud and the origin of the source
- * @note Tried to make members and constructor arguments const but the compiler would not accept the default
- * assignment operator for vector insertion!
+ * @brief Stores an observation in terms of the points hit and the origin of the source.
+ * Points are packed x, y, z floats in the global frame, in a buffer shared between the
+ * copies of the observation, so observations are cheap to copy.
  */
 class Observation
 {
@@ -50,7 +55,7 @@ public:
    * @brief  Creates an empty observation
    */
   Observation()
-  : cloud_(new sensor_msgs::msg::PointCloud2()), obstacle_max_range_(0.0), obstacle_min_range_(0.0),
+  : num_points_(0), obstacle_max_range_(0.0), obstacle_min_range_(0.0),
     raytrace_max_range_(0.0),
     raytrace_min_range_(0.0)
   {
@@ -58,14 +63,9 @@ public:
   /**
    * @brief A destructor
    */
-  virtual ~Observation()
-  {
-    delete cloud_;
-  }
+  virtual ~Observation() = default;
 
-  /**
-    * @brief  Explicitly define copy assignment operator for Observation as it has a user-declared destructor
-    */
+  Observation(const Observation &) = default;
   Observation & operator=(const Observation &) = default;
 
   /**
@@ -81,23 +81,12 @@ public:
     geometry_msgs::msg::Point & origin, const sensor_msgs::msg::PointCloud2 & cloud,
     double obstacle_max_range, double obstacle_min_range, double raytrace_max_range,
     double raytrace_min_range)
-  : origin_(origin), cloud_(new sensor_msgs::msg::PointCloud2(cloud)),
+  : origin_(origin),
     obstacle_max_range_(obstacle_max_range), obstacle_min_range_(obstacle_min_range),
     raytrace_max_range_(raytrace_max_range), raytrace_min_range_(
       raytrace_min_range)
   {
-  }
-
-  /**
-   * @brief  Copy constructor
-   * @param obs The observation to copy
-   */
-  Observation(const Observation & obs)
-  : origin_(obs.origin_), cloud_(new sensor_msgs::msg::PointCloud2(*(obs.cloud_))),
-    obstacle_max_range_(obs.obstacle_max_range_), obstacle_min_range_(obs.obstacle_min_range_),
-    raytrace_max_range_(obs.raytrace_max_range_),
-    raytrace_min_range_(obs.raytrace_min_range_)
-  {
+    setPoints(cloud);
   }
 
   /**
@@ -109,15 +98,60 @@ public:
   Observation(
     const sensor_msgs::msg::PointCloud2 & cloud, double obstacle_max_range,
     double obstacle_min_range)
-  : cloud_(new sensor_msgs::msg::PointCloud2(cloud)), obstacle_max_range_(obstacle_max_range),
+  : obstacle_max_range_(obstacle_max_range),
     obstacle_min_range_(obstacle_min_range),
     raytrace_max_range_(0.0), raytrace_min_range_(0.0)
   {
+    setPoints(cloud);
+  }
+
+  /**
+   * @brief  Get the points of the observation
+   * @return Packed x, y, z floats of getNumPoints() points
+   */
+  const float * getPoints() const
+  {
+    return points_ ? points_->data() : nullptr;
+  }
+
+  /**
+   * @brief  Get the number of points of the observation
+   * @return Number of points
+   */
+  unsigned int getNumPoints() const
+  {
+    return num_points_;
   }
 
   geometry_msgs::msg::Point origin_;
-  sensor_msgs::msg::PointCloud2 * cloud_;
+  builtin_interfaces::msg::Time stamp_;
+  std::shared_ptr<const std::vector<float>> points_;  ///< @brief May hold more than num_points_
+  unsigned int num_points_;
   double obstacle_max_range_, obstacle_min_range_, raytrace_max_range_, raytrace_min_range_;
+
+private:
+  /**
+   * @brief  Copy the x, y, z fields of a cloud already in the global frame
+   * @param cloud The point cloud of the observation
+   */
+  void setPoints(const sensor_msgs::msg::PointCloud2 & cloud)
+  {
+    stamp_ = cloud.header.stamp;
+    num_points_ = cloud.width * cloud.height;
+    auto points = std::make_shared<std::vector<float>>();
+    points->reserve(3 * num_points_);
+    if (num_points_ != 0) {
+      sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud, "x");
+      sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud, "y");
+      sensor_msgs::PointCloud2ConstIterator<float> iter_z(cloud, "z");
+      for (; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z) {
+        points->push_back(*iter_x);
+        points->push_back(*iter_y);
+        points->push_back(*iter_z);
+      }
+    }
+    points_ = points;
+  }
 };
 
 }  // namespace nav2_costmap_2d
@@ -37,9 +37,9 @@
 #ifndef NAV2_COSTMAP_2D__OBSERVATION_BUFFER_HPP_
 #define NAV2_COSTMAP_2D__OBSERVATION_BUFFER_HPP_
 
-#include <vector>
-#include <list>
+#include <deque>
 #include <string>
+#include <vector>
 
 #include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
 #include "rclcpp/time.hpp"
@@ -47,6 +47,7 @@
 #include "tf2_sensor_msgs/tf2_sensor_msgs.hpp"
 #include "sensor_msgs/msg/point_cloud2.hpp"
 #include "nav2_costmap_2d/observation.hpp"
+#include "nav2_costmap_2d/point_arena.hpp"
 #include "nav2_util/lifecycle_node.hpp"
 
 
@@ -93,9 +94,11 @@ public:
   ~ObservationBuffer();
 
   /**
-   * @brief  Transforms a PointCloud to the global frame and buffers it
+   * @brief  Transforms a PointCloud to the global frame and buffers its points within the
+   * height bounds and the minimum ranges, in a single pass over the cloud. Points are
+   * packed into buffers of an arena reused across observations.
    * <b>Note: The burden is on the user to make sure the transform is available... ie they should use a MessageNotifier</b>
-   * @param  cloud The cloud to be buffered
+   * @param  cloud The cloud to be buffered, with float x, y and z fields
    */
   void bufferCloud(const sensor_msgs::msg::PointCloud2 & cloud);
 
@@ -132,6 +135,15 @@ public:
    */
   void resetLastUpdated();
 
+  /**
+   * @brief Get the arena holding the points of the observations
+   * @return Arena of the buffer
+   */
+  const PointArena & getPointArena() const
+  {
+    return point_arena_;
+  }
+
 private:
   /**
    * @brief  Removes any stale observations from the buffer list
@@ -146,7 +158,8 @@ private:
   rclcpp::Time last_updated_;
   std::string global_frame_;
   std::string sensor_frame_;
-  std::list<Observation> observation_list_;
+  std::deque<Observation> observation_list_;
+  PointArena point_arena_;
   std::string topic_name_;
   double min_obstacle_height_, max_obstacle_height_;
   std::recursive_mutex lock_;  ///< @brief A lock for accessing data in callbacks safely
@@ -38,6 +38,7 @@
 #ifndef NAV2_COSTMAP_2D__OBSTACLE_LAYER_HPP_
 #define NAV2_COSTMAP_2D__OBSTACLE_LAYER_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -111,6 +112,20 @@ public:
     nav2_costmap_2d::Costmap2D & master_grid,
     int min_i, int min_j, int max_i, int max_j);
 
+  /**
+   * @brief Update the costs in the master costmap in the window, tile by tile
+   * @param master_grid The master costmap grid to update
+   * @param min_x X min map coord of the window to update
+   * @param min_y Y min map coord of the window to update
+   * @param max_x X max map coord of the window to update
+   * @param max_y Y max map coord of the window to update
+   * @param executor Executor to run the tiles with
+   */
+  void updateCostsTiled(
+    nav2_costmap_2d::Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j,
+    TileExecutor & executor) override;
+
   /**
    * @brief Deactivate the layer
    */
@@ -241,6 +256,15 @@ protected:
   bool rolling_window_;
   bool was_reset_;
   int combination_method_;
+
+  /// @brief Threads tracing the rays of an observation, in parallel if more than 1
+  int raytrace_threads_{1};
+  /// @brief Whether to trace the rays ending in the same cell only once
+  bool deduplicate_rays_{true};
+  /// @brief Cells the rays of the observation being cleared end in, reused across calls
+  std::vector<unsigned int> raytrace_endpoints_;
+  /// @brief Bitset of the cells cleared by each thread, kept zeroed between calls
+  std::vector<std::vector<uint64_t>> raytrace_bits_;
 };
 
 }  // namespace nav2_costmap_2d
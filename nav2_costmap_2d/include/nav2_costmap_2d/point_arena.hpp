@@ -0,0 +1,83 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#ifndef NAV2_COSTMAP_2D__POINT_ARENA_HPP_
+#define NAV2_COSTMAP_2D__POINT_ARENA_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace nav2_costmap_2d
+{
+
+/**
+ * @class PointArena
+ * @brief A ring of point buffers reused across observations, so buffering a cloud
+ * doesn't allocate points once the ring has grown to the number of observations alive
+ * at a time. Buffers are ref-counted: one is only handed out again once no observation
+ * holds it anymore, which observations may release from any thread. Not thread safe
+ * otherwise, buffers are acquired under the lock of the owner.
+ */
+class PointArena
+{
+public:
+  typedef std::vector<float> Buffer;
+
+  /**
+   * @brief Get a buffer for a number of points, reusing the next free buffer of the ring
+   * or adding one to the ring if they are all held
+   * @param num_points Number of points to hold, as packed x, y, z floats
+   * @return Buffer holding at least 3 * num_points floats, of unspecified contents
+   */
+  std::shared_ptr<Buffer> acquire(std::size_t num_points);
+
+  /**
+   * @brief Get the number of buffers of the ring
+   * @return Number of buffers, held or free
+   */
+  std::size_t size() const
+  {
+    return buffers_.size();
+  }
+
+  /**
+   * @brief Get the number of times a buffer had to be grown or added
+   * @return Number of allocations
+   */
+  std::size_t getAllocations() const
+  {
+    return allocations_;
+  }
+
+private:
+  /**
+   * @struct Slot
+   * @brief A buffer of the ring, flagged in use while an observation holds it
+   */
+  struct Slot
+  {
+    Buffer points;
+    std::atomic<bool> in_use{false};
+  };
+
+  std::vector<std::shared_ptr<Slot>> buffers_;
+  std::size_t next_{0};
+  std::size_t allocations_{0};
+};
+
+}  // namespace nav2_costmap_2d
+
+#endif  // NAV2_COSTMAP_2D__POINT_ARENA_HPP_
@@ -0,0 +1,109 @@
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NAV2_COSTMAP_2D__SHARED_COSTMAP_HPP_
+#define NAV2_COSTMAP_2D__SHARED_COSTMAP_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "rclcpp/time.hpp"
+#include "nav2_costmap_2d/costmap_2d.hpp"
+
+namespace nav2_costmap_2d
+{
+
+/**
+ * @struct CostmapSnapshot
+ * @brief A copy of a costmap as of one update, never modified once published
+ */
+struct CostmapSnapshot
+{
+  uint64_t version{0};
+  std::string frame_id;
+  rclcpp::Time stamp;
+  Costmap2D costmap;
+};
+
+/**
+ * @class SharedCostmap
+ * @brief Shares the snapshots of a costmap with the consumers in the same process by
+ * reference, so they don't each need a copy from the costmap topic. Costmaps are
+ * looked up by the fully qualified name of their raw costmap topic. Snapshots are
+ * published by a single thread and read without locking.
+ */
+class SharedCostmap
+{
+public:
+  /**
+   * @brief Get the shared costmap to publish snapshots of a costmap to, creating it if
+   * it doesn't exist yet
+   * @param name Fully qualified name of the raw costmap topic
+   * @return Shared costmap, kept for as long as it is held by the producer or consumers
+   */
+  static std::shared_ptr<SharedCostmap> advertise(const std::string & name);
+
+  /**
+   * @brief Find the shared costmap of a producer in this process
+   * @param name Fully qualified name of the raw costmap topic
+   * @return Shared costmap, or nullptr if the costmap isn't produced in this process
+   */
+  static std::shared_ptr<SharedCostmap> find(const std::string & name);
+
+  /**
+   * @brief Publish a snapshot of a costmap, reusing the buffer of the snapshot
+   * before last if no consumer still holds it
+   * @param costmap Costmap to copy, locked while copied
+   * @param frame_id Frame of the costmap
+   * @param stamp Time of the update of the costmap
+   * @return Time waited for the lock of the costmap, in seconds
+   */
+  double publish(Costmap2D & costmap, const std::string & frame_id, const rclcpp::Time & stamp);
+
+  /**
+   * @brief Get the latest snapshot
+   * @return Snapshot, or nullptr if none was published yet
+   */
+  std::shared_ptr<const CostmapSnapshot> getSnapshot() const;
+
+  /**
+   * @brief Get the version of the latest snapshot
+   * @return Version, incremented with each snapshot, 0 if none was published yet
+   */
+  uint64_t getVersion() const;
+
+private:
+  /**
+   * @struct Buffer
+   * @brief The storage of a snapshot, flagged in use while consumers may hold it
+   */
+  struct Buffer
+  {
+    CostmapSnapshot snapshot;
+    std::atomic<bool> in_use{false};
+  };
+
+  std::atomic<uint64_t> version_{0};
+  // Only accessed through the atomic shared_ptr functions
+  std::shared_ptr<CostmapSnapshot> latest_;
+  // Only accessed by the publishing thread
+  std::shared_ptr<Buffer> latest_buffer_;
+  std::shared_ptr<Buffer> spare_;
+};
+
+}  // namespace nav2_costmap_2d
+
+#endif  // NAV2_COSTMAP_2D__SHARED_COSTMAP_HPP_
@@ -117,6 +117,20 @@ public:
     nav2_costmap_2d::Costmap2D & master_grid,
     int min_i, int min_j, int max_i, int max_j);
 
+  /**
+   * @brief Update the costs in the master costmap in the window, tile by tile
+   * @param master_grid The master costmap grid to update
+   * @param min_x X min map coord of the window to update
+   * @param min_y Y min map coord of the window to update
+   * @param max_x X max map coord of the window to update
+   * @param max_y Y max map coord of the window to update
+   * @param executor Executor to run the tiles with
+   */
+  void updateCostsTiled(
+    nav2_costmap_2d::Costmap2D & master_grid,
+    int min_i, int min_j, int max_i, int max_j,
+    TileExecutor & executor) override;
+
   /**
    * @brief Match the size of the master costmap
    */
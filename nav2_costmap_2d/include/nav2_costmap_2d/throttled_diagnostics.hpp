@@ -0,0 +1,89 @@
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NAV2_COSTMAP_2D__THROTTLED_DIAGNOSTICS_HPP_
+#define NAV2_COSTMAP_2D__THROTTLED_DIAGNOSTICS_HPP_
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+#include "rclcpp_lifecycle/lifecycle_publisher.hpp"
+
+namespace nav2_costmap_2d
+{
+
+/**
+ * @class ThrottledDiagnostics
+ * @brief Publishes the status of a costmap component to /diagnostics, at most once per
+ * period however often it is updated. Several components of a node can each have one,
+ * unlike diagnostic_updater::Updater, which declares parameters on the node.
+ */
+class ThrottledDiagnostics
+{
+public:
+  /**
+   * @brief A constructor for nav2_costmap_2d::ThrottledDiagnostics
+   * @param node Node to publish from
+   * @param name Name of the status
+   * @param period Minimum time between two statuses
+   */
+  ThrottledDiagnostics(
+    const rclcpp_lifecycle::LifecycleNode::SharedPtr & node, const std::string & name,
+    std::chrono::steady_clock::duration period = std::chrono::seconds(1));
+
+  /** @brief Activate the publisher, statuses are dropped until then */
+  void activate();
+
+  /** @brief Deactivate the publisher */
+  void deactivate();
+
+  /**
+   * @brief Publish a status, if none was published for a period
+   * @param fill Called with the status, named and at level OK, to fill in only if
+   * it is published
+   * @return Whether the status was published
+   */
+  bool publish(const std::function<void(diagnostic_msgs::msg::DiagnosticStatus &)> & fill);
+
+  /**
+   * @brief Add a value to a status
+   * @param status Status to add to
+   * @param key Name of the value
+   * @param value Value
+   */
+  static void add(
+    diagnostic_msgs::msg::DiagnosticStatus & status, const std::string & key,
+    const std::string & value);
+
+  template<typename T>
+  static void add(
+    diagnostic_msgs::msg::DiagnosticStatus & status, const std::string & key, const T & value)
+  {
+    add(status, key, std::to_string(value));
+  }
+
+private:
+  std::string name_;
+  std::chrono::steady_clock::duration period_;
+  std::chrono::steady_clock::time_point last_time_;
+  rclcpp::Clock::SharedPtr clock_;
+  rclcpp_lifecycle::LifecyclePublisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr pub_;
+};
+
+}  // namespace nav2_costmap_2d
+
+#endif  // NAV2_COSTMAP_2D__THROTTLED_DIAGNOSTICS_HPP_
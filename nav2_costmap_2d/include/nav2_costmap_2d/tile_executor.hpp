@@ -0,0 +1,116 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#ifndef NAV2_COSTMAP_2D__TILE_EXECUTOR_HPP_
+#define NAV2_COSTMAP_2D__TILE_EXECUTOR_HPP_
+
+#include <functional>
+#include <vector>
+
+namespace nav2_costmap_2d
+{
+
+/**
+ * @class TileExecutor
+ * @brief Splits a window of the costmap into square tiles and runs a function over
+ * them on a pool of threads. Tiles are handed out to the threads one at a time as
+ * they become free, so threads that finish cheap tiles take over the remaining ones.
+ */
+class TileExecutor
+{
+public:
+  /**
+   * @brief Function run over a tile: the tile bounds in map cells, [min, max), and
+   * the index of the worker thread running it, in [0, getNumWorkers())
+   */
+  typedef std::function<void (int min_i, int min_j, int max_i, int max_j,
+    unsigned int worker)> TileFunction;
+
+  /**
+   * @brief A constructor, by default the whole window is a single tile run on the
+   * calling thread
+   * @param tile_size Width of the tiles in cells, 0 for a single tile
+   * @param num_threads Number of worker threads, 0 or less for all cores
+   */
+  explicit TileExecutor(unsigned int tile_size = 0, int num_threads = 1);
+
+  /**
+   * @brief Set the width of the tiles
+   * @param tile_size Width of the tiles in cells, 0 for a single tile
+   */
+  void setTileSize(unsigned int tile_size);
+
+  /**
+   * @brief Set the number of worker threads
+   * @param num_threads Number of worker threads, 0 or less for all cores
+   */
+  void setNumThreads(int num_threads);
+
+  /**
+   * @brief Get the width of the tiles
+   * @return Width in cells, 0 for a single tile
+   */
+  unsigned int getTileSize() const
+  {
+    return tile_size_;
+  }
+
+  /**
+   * @brief Get the number of worker threads, the bound of the worker indices
+   * @return Number of workers
+   */
+  unsigned int getNumWorkers() const
+  {
+    return num_threads_;
+  }
+
+  /**
+   * @brief Run a function over every tile of a window, returning once all tiles are done.
+   * Tiles may run concurrently: the function may only write to cells within its tile
+   * and must not read cells that other tiles write to. If tiles throw, the exception of
+   * the first of them in row-major order is rethrown.
+   * @param min_i X min map coord of the window
+   * @param min_j Y min map coord of the window
+   * @param max_i X max map coord of the window
+   * @param max_j Y max map coord of the window
+   * @param function Function to run over each tile
+   */
+  void run(int min_i, int min_j, int max_i, int max_j, const TileFunction & function);
+
+  /**
+   * @brief Get the durations of the tiles run since the last resetTimings()
+   * @return Durations in seconds, in the order tiles were laid out
+   */
+  const std::vector<double> & getTileDurations() const
+  {
+    return tile_durations_;
+  }
+
+  /**
+   * @brief Clear the recorded tile durations
+   */
+  void resetTimings()
+  {
+    tile_durations_.clear();
+  }
+
+private:
+  unsigned int tile_size_;
+  unsigned int num_threads_;
+  std::vector<double> tile_durations_;
+};
+
+}  // namespace nav2_costmap_2d
+
+#endif  // NAV2_COSTMAP_2D__TILE_EXECUTOR_HPP_
@@ -38,6 +38,10 @@
 #ifndef NAV2_COSTMAP_2D__VOXEL_LAYER_HPP_
 #define NAV2_COSTMAP_2D__VOXEL_LAYER_HPP_
 
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+
 #include <rclcpp/rclcpp.hpp>
 #include <nav2_costmap_2d/layer.hpp>
 #include <nav2_costmap_2d/layered_costmap.hpp>
@@ -50,22 +54,41 @@
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <message_filters/subscriber.h>
 #include <nav2_costmap_2d/obstacle_layer.hpp>
+#include <nav2_costmap_2d/throttled_diagnostics.hpp>
 #include <nav2_voxel_grid/voxel_grid.hpp>
 
 namespace nav2_costmap_2d
 {
 
 /**
- * @class VoxelLayer
- * @brief Takes laser and pointcloud data to populate a 3D voxel representation of the environment
+ * @class BasicVoxelLayer
+ * @brief Takes laser and pointcloud data to populate a 3D voxel representation of the environment.
+ * The column word of the voxel grid bounds its height: VoxelLayer holds up to 16 z voxels,
+ * VoxelLayer32 up to 32 and VoxelLayer64 up to 64, at 2, 4 and 8 times the memory per cell.
  */
-class VoxelLayer : public ObstacleLayer
+template<typename ColumnT>
+class BasicVoxelLayer : public ObstacleLayer
 {
 public:
+  typedef nav2_voxel_grid::ColumnTraits<ColumnT> Traits;
+
+  /**
+   * @struct ClearingStats
+   * @brief Counts of the rays cleared through the voxel grid over the last update, also sent
+   * to /diagnostics about once per second, summed over the updates since the last message
+   */
+  struct ClearingStats
+  {
+    unsigned int raw_rays{0};  ///< @brief Rays of the clearing observations ending in the map
+    unsigned int unique_rays{0};  ///< @brief Rays traced, one per voxel when prefiltering
+    double trace_time{0.0};  ///< @brief Time spent tracing the rays, in seconds
+    double saved_time{0.0};  ///< @brief Estimated time the rays skipped would have taken
+  };
+
   /**
    * @brief Voxel Layer constructor
    */
-  VoxelLayer()
+  BasicVoxelLayer()
   : voxel_grid_(0, 0, 0)
   {
     costmap_ = NULL;  // this is the unsigned char* member of parent class's parent class Costmap2D
@@ -74,7 +97,7 @@ public:
   /**
    * @brief Voxel Layer destructor
    */
-  virtual ~VoxelLayer();
+  virtual ~BasicVoxelLayer();
 
   /**
    * @brief Initialization process of layer on startup
@@ -125,6 +148,24 @@ public:
    */
   virtual bool isClearable() {return true;}
 
+  /**
+   * @brief Get the counts of the rays cleared over the last update
+   * @return Clearing stats
+   */
+  const ClearingStats & getClearingStats() const
+  {
+    return clearing_stats_;
+  }
+
+  /**
+   * @brief Get the voxel columns
+   * @return size_x * size_y columns, indexed like the costmap
+   */
+  const ColumnT * getVoxelData()
+  {
+    return voxel_grid_.getData();
+  }
+
 protected:
   /**
    * @brief Reset internal maps
@@ -145,14 +186,29 @@ private:
     double * max_x,
     double * max_y);
 
+  /**
+   * @brief Send the clearing stats summed since the last message to /diagnostics, if they
+   * weren't sent for a second
+   */
+  void publishDiagnostics();
+
   bool publish_voxel_;
   rclcpp_lifecycle::LifecyclePublisher<nav2_msgs::msg::VoxelGrid>::SharedPtr voxel_pub_;
-  nav2_voxel_grid::VoxelGrid voxel_grid_;
+  nav2_voxel_grid::BasicVoxelGrid<ColumnT> voxel_grid_;
   double z_resolution_, origin_z_;
   int unknown_threshold_, mark_threshold_, size_z_;
   rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::PointCloud2>::SharedPtr
     clearing_endpoints_pub_;
 
+  /// @brief Whether to trace only one ray per voxel the rays of an observation end in
+  bool prefilter_clearing_rays_{false};
+  /// @brief Voxels already traced to for the observation being cleared, reused across calls
+  std::unordered_set<uint64_t> traced_voxels_;
+  ClearingStats clearing_stats_;
+  /// @brief Clearing stats summed over the updates since the last diagnostics message
+  ClearingStats diagnostics_stats_;
+  std::unique_ptr<ThrottledDiagnostics> diagnostics_;
+
   /**
    * @brief Covert world coordinates into map coordinates
    */
@@ -226,6 +282,14 @@ private:
   }
 };
 
+typedef BasicVoxelLayer<uint32_t> VoxelLayer;
+typedef BasicVoxelLayer<uint64_t> VoxelLayer32;
+typedef BasicVoxelLayer<nav2_voxel_grid::Column128> VoxelLayer64;
+
+extern template class BasicVoxelLayer<uint32_t>;
+extern template class BasicVoxelLayer<uint64_t>;
+extern template class BasicVoxelLayer<nav2_voxel_grid::Column128>;
+
 }  // namespace nav2_costmap_2d
 
 #endif  // NAV2_COSTMAP_2D__VOXEL_LAYER_HPP_
@@ -120,4 +120,17 @@ void CostmapFilter::updateCosts(
   current_ = true;
 }
 
+void CostmapFilter::updateCostsTiled(
+  nav2_costmap_2d::Costmap2D & master_grid,
+  int min_i, int min_j, int max_i, int max_j,
+  TileExecutor & executor)
+{
+  if (!enabled_) {
+    return;
+  }
+
+  processTiled(master_grid, min_i, min_j, max_i, max_j, latest_pose_, executor);
+  current_ = true;
+}
+
 }  // namespace nav2_costmap_2d
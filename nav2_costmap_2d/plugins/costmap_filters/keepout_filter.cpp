@@ -150,7 +150,17 @@ void KeepoutFilter::maskCallback(
 void KeepoutFilter::process(
   nav2_costmap_2d::Costmap2D & master_grid,
   int min_i, int min_j, int max_i, int max_j,
-  const geometry_msgs::msg::Pose2D & /*pose*/)
+  const geometry_msgs::msg::Pose2D & pose)
+{
+  TileExecutor executor;
+  processTiled(master_grid, min_i, min_j, max_i, max_j, pose, executor);
+}
+
+void KeepoutFilter::processTiled(
+  nav2_costmap_2d::Costmap2D & master_grid,
+  int min_i, int min_j, int max_i, int max_j,
+  const geometry_msgs::msg::Pose2D & /*pose*/,
+  TileExecutor & executor)
 {
   std::lock_guard<CostmapFilter::mutex_t> guard(*getMutex());
 
@@ -164,8 +174,6 @@ void KeepoutFilter::process(
 
   tf2::Transform tf2_transform;
   tf2_transform.setIdentity();  // initialize by identical transform
-  int mg_min_x, mg_min_y;  // masger_grid indexes of bottom-left window corner
-  int mg_max_x, mg_max_y;  // masger_grid indexes of top-right window corner
 
   if (mask_frame_ != global_frame_) {
     // Filter mask and current layer are in different frames:
@@ -184,7 +192,24 @@ void KeepoutFilter::process(
       return;
     }
     tf2::fromMsg(transform.transform, tf2_transform);
+  }
 
+  executor.run(
+    min_i, min_j, max_i, max_j,
+    [&](int tile_min_i, int tile_min_j, int tile_max_i, int tile_max_j, unsigned int) {
+      applyMask(master_grid, tile_min_i, tile_min_j, tile_max_i, tile_max_j, tf2_transform);
+    });
+}
+
+void KeepoutFilter::applyMask(
+  nav2_costmap_2d::Costmap2D & master_grid,
+  int min_i, int min_j, int max_i, int max_j,
+  const tf2::Transform & tf2_transform)
+{
+  int mg_min_x, mg_min_y;  // masger_grid indexes of bottom-left window corner
+  int mg_max_x, mg_max_y;  // masger_grid indexes of top-right window corner
+
+  if (mask_frame_ != global_frame_) {
     mg_min_x = min_i;
     mg_min_y = min_j;
     mg_max_x = max_i;
@@ -37,12 +37,14 @@
  *********************************************************************/
 #include "nav2_costmap_2d/inflation_layer.hpp"
 
+#include <cstdlib>
 #include <limits>
 #include <map>
 #include <vector>
 #include <algorithm>
 #include <utility>
 
+#include "nav2_costmap_2d/costmap_delta.hpp"
 #include "nav2_costmap_2d/costmap_math.hpp"
 #include "nav2_costmap_2d/footprint.hpp"
 #include "pluginlib/class_list_macros.hpp"
@@ -70,7 +72,17 @@ InflationLayer::InflationLayer()
   last_min_x_(std::numeric_limits<double>::lowest()),
   last_min_y_(std::numeric_limits<double>::lowest()),
   last_max_x_(std::numeric_limits<double>::max()),
-  last_max_y_(std::numeric_limits<double>::max())
+  last_max_y_(std::numeric_limits<double>::max()),
+  incremental_inflation_(false),
+  need_field_reset_(true),
+  field_size_x_(0),
+  field_size_y_(0),
+  field_origin_x_(0.0),
+  field_origin_y_(0.0),
+  tile_sources_min_i_(0),
+  tile_sources_min_j_(0),
+  tile_sources_max_i_(0),
+  tile_sources_max_j_(0)
 {
   access_ = new mutex_t();
 }
@@ -88,6 +100,7 @@ InflationLayer::onInitialize()
   declareParameter("cost_scaling_factor", rclcpp::ParameterValue(10.0));
   declareParameter("inflate_unknown", rclcpp::ParameterValue(false));
   declareParameter("inflate_around_unknown", rclcpp::ParameterValue(false));
+  declareParameter("incremental_inflation", rclcpp::ParameterValue(false));
 
   {
     auto node = node_.lock();
@@ -99,6 +112,7 @@ InflationLayer::onInitialize()
     node->get_parameter(name_ + "." + "cost_scaling_factor", cost_scaling_factor_);
     node->get_parameter(name_ + "." + "inflate_unknown", inflate_unknown_);
     node->get_parameter(name_ + "." + "inflate_around_unknown", inflate_around_unknown_);
+    node->get_parameter(name_ + "." + "incremental_inflation", incremental_inflation_);
   }
 
   current_ = true;
@@ -117,7 +131,12 @@ InflationLayer::matchSize()
   resolution_ = costmap->getResolution();
   cell_inflation_radius_ = cellDistance(inflation_radius_);
   computeCaches();
-  seen_ = std::vector<bool>(costmap->getSizeInCellsX() * costmap->getSizeInCellsY(), false);
+  if (incremental_inflation_) {
+    seen_.clear();
+  } else {
+    seen_ = std::vector<bool>(costmap->getSizeInCellsX() * costmap->getSizeInCellsY(), false);
+  }
+  need_field_reset_ = true;
 }
 
 void
@@ -184,6 +203,12 @@ InflationLayer::updateCosts(
       !dist.empty(), "The inflation list must be empty at the beginning of inflation");
   }
 
+  if (incremental_inflation_) {
+    updateCostsIncrementally(master_grid, min_i, min_j, max_i, max_j);
+    current_ = true;
+    return;
+  }
+
   unsigned char * master_array = master_grid.getCharMap();
   unsigned int size_x = master_grid.getSizeInCellsX(), size_y = master_grid.getSizeInCellsY();
 
@@ -296,6 +321,160 @@ InflationLayer::updateCosts(
   current_ = true;
 }
 
+void
+InflationLayer::updateCostsTiled(
+  nav2_costmap_2d::Costmap2D & master_grid, int min_i, int min_j,
+  int max_i, int max_j,
+  TileExecutor & executor)
+{
+  if (incremental_inflation_) {
+    // The distance field spans the whole map, so it is repaired in one go
+    updateCosts(master_grid, min_i, min_j, max_i, max_j);
+    return;
+  }
+
+  std::lock_guard<Costmap2D::mutex_t> guard(*getMutex());
+  if (!enabled_ || (cell_inflation_radius_ == 0)) {
+    return;
+  }
+
+  const unsigned char * master_array = master_grid.getCharMap();
+  const int size_x = static_cast<int>(master_grid.getSizeInCellsX());
+  const int size_y = static_cast<int>(master_grid.getSizeInCellsY());
+  const int radius = static_cast<int>(cell_inflation_radius_);
+
+  // Obstacles up to the inflation radius outside of a tile inflate cells in it, so the
+  // sources are marked over the window grown by the radius before any cost is written:
+  // each tile then sees the same sources around it whatever order the tiles run in
+  tile_sources_min_i_ = std::max(0, min_i - radius);
+  tile_sources_min_j_ = std::max(0, min_j - radius);
+  tile_sources_max_i_ = std::min(size_x, max_i + radius);
+  tile_sources_max_j_ = std::min(size_y, max_j + radius);
+  const int sources_size_x = tile_sources_max_i_ - tile_sources_min_i_;
+  tile_sources_.resize(sources_size_x * (tile_sources_max_j_ - tile_sources_min_j_));
+
+  executor.run(
+    tile_sources_min_i_, tile_sources_min_j_, tile_sources_max_i_, tile_sources_max_j_,
+    [&](int tile_min_i, int tile_min_j, int tile_max_i, int tile_max_j, unsigned int) {
+      for (int j = tile_min_j; j < tile_max_j; j++) {
+        unsigned int index = master_grid.getIndex(tile_min_i, j);
+        unsigned int source_index =
+          (j - tile_sources_min_j_) * sources_size_x + tile_min_i - tile_sources_min_i_;
+        for (int i = tile_min_i; i < tile_max_i; i++) {
+          tile_sources_[source_index++] = isInflationSource(master_array[index++]);
+        }
+      }
+    });
+
+  tile_scratch_.resize(executor.getNumWorkers());
+  executor.run(
+    min_i, min_j, max_i, max_j,
+    [&](int tile_min_i, int tile_min_j, int tile_max_i, int tile_max_j, unsigned int worker) {
+      inflateTile(
+        master_grid, tile_min_i, tile_min_j, tile_max_i, tile_max_j, tile_scratch_[worker]);
+    });
+
+  current_ = true;
+}
+
+void
+InflationLayer::inflateTile(
+  nav2_costmap_2d::Costmap2D & master_grid, int min_i, int min_j,
+  int max_i, int max_j,
+  TileScratch & scratch)
+{
+  unsigned char * master_array = master_grid.getCharMap();
+  const unsigned int size_x = master_grid.getSizeInCellsX();
+  const int radius = static_cast<int>(cell_inflation_radius_);
+
+  // Same as the batch inflation, limited to the tile grown by the inflation radius,
+  // which holds all the sources of the tile and the cells in between
+  const int halo_min_i = std::max(tile_sources_min_i_, min_i - radius);
+  const int halo_min_j = std::max(tile_sources_min_j_, min_j - radius);
+  const int halo_max_i = std::min(tile_sources_max_i_, max_i + radius);
+  const int halo_max_j = std::min(tile_sources_max_j_, max_j + radius);
+  const unsigned int halo_size_x = halo_max_i - halo_min_i;
+  const unsigned int sources_size_x = tile_sources_max_i_ - tile_sources_min_i_;
+
+  scratch.seen.assign(halo_size_x * (halo_max_j - halo_min_j), false);
+  if (scratch.inflation_cells.size() != inflation_cells_.size()) {
+    scratch.inflation_cells.resize(inflation_cells_.size());
+  }
+
+  auto & obs_bin = scratch.inflation_cells[0];
+  for (int j = halo_min_j; j < halo_max_j; j++) {
+    unsigned int source_index =
+      (j - tile_sources_min_j_) * sources_size_x + halo_min_i - tile_sources_min_i_;
+    for (int i = halo_min_i; i < halo_max_i; i++) {
+      if (tile_sources_[source_index++]) {
+        obs_bin.emplace_back(master_grid.getIndex(i, j), i, j, i, j);
+      }
+    }
+  }
+
+  auto enqueue_cell = [&](unsigned int index, unsigned int mx, unsigned int my,
+      unsigned int src_x, unsigned int src_y) {
+      if (scratch.seen[(my - halo_min_j) * halo_size_x + mx - halo_min_i]) {
+        return;
+      }
+      if (distanceLookup(mx, my, src_x, src_y) > cell_inflation_radius_) {
+        return;
+      }
+      const unsigned int r = cell_inflation_radius_ + 2;
+      scratch.inflation_cells[distance_matrix_[mx - src_x + r][my - src_y + r]].emplace_back(
+        index, mx, my, src_x, src_y);
+    };
+
+  for (const auto & dist_bin : scratch.inflation_cells) {
+    for (std::size_t n = 0; n < dist_bin.size(); ++n) {
+      // Copy out, enqueueing may grow this bin
+      const unsigned int index = dist_bin[n].index_;
+      const unsigned int mx = dist_bin[n].x_;
+      const unsigned int my = dist_bin[n].y_;
+      const unsigned int sx = dist_bin[n].src_x_;
+      const unsigned int sy = dist_bin[n].src_y_;
+
+      const unsigned int seen_index = (my - halo_min_j) * halo_size_x + mx - halo_min_i;
+      if (scratch.seen[seen_index]) {
+        continue;
+      }
+      scratch.seen[seen_index] = true;
+
+      // Only the cells of the tile are written, the halo belongs to other tiles
+      if (static_cast<int>(mx) >= min_i && static_cast<int>(my) >= min_j &&
+        static_cast<int>(mx) < max_i && static_cast<int>(my) < max_j)
+      {
+        const unsigned char cost = costLookup(mx, my, sx, sy);
+        const unsigned char old_cost = master_array[index];
+        if (old_cost == NO_INFORMATION &&
+          (inflate_unknown_ ? (cost > FREE_SPACE) : (cost >= INSCRIBED_INFLATED_OBSTACLE)))
+        {
+          master_array[index] = cost;
+        } else {
+          master_array[index] = std::max(old_cost, cost);
+        }
+      }
+
+      if (static_cast<int>(mx) > halo_min_i) {
+        enqueue_cell(index - 1, mx - 1, my, sx, sy);
+      }
+      if (static_cast<int>(my) > halo_min_j) {
+        enqueue_cell(index - size_x, mx, my - 1, sx, sy);
+      }
+      if (static_cast<int>(mx) < halo_max_i - 1) {
+        enqueue_cell(index + 1, mx + 1, my, sx, sy);
+      }
+      if (static_cast<int>(my) < halo_max_j - 1) {
+        enqueue_cell(index + size_x, mx, my + 1, sx, sy);
+      }
+    }
+  }
+
+  for (auto & dist : scratch.inflation_cells) {
+    dist.clear();
+  }
+}
+
 /**
  * @brief  Given an index of a cell in the costmap, place it into a list pending for obstacle inflation
  * @param  grid The costmap
@@ -329,6 +508,238 @@ InflationLayer::enqueue(
   }
 }
 
+void
+InflationLayer::updateCostsIncrementally(
+  nav2_costmap_2d::Costmap2D & master_grid, int min_i, int min_j,
+  int max_i, int max_j)
+{
+  unsigned char * master_array = master_grid.getCharMap();
+  const unsigned int size_x = master_grid.getSizeInCellsX();
+  const unsigned int size_y = master_grid.getSizeInCellsY();
+
+  // A rolling window moves the map under the field by whole cells, so the field is moved
+  // along with it. Any other change of geometry rebuilds it.
+  int shift_x = 0, shift_y = 0;
+  if (field_source_.size() != size_x * size_y || field_size_x_ != size_x ||
+    !getCostmapShift(
+      field_origin_x_, field_origin_y_, master_grid.getOriginX(), master_grid.getOriginY(),
+      master_grid.getResolution(), shift_x, shift_y) ||
+    std::abs(shift_x) >= static_cast<int>(size_x) || std::abs(shift_y) >= static_cast<int>(size_y))
+  {
+    need_field_reset_ = true;
+  }
+
+  if (need_field_reset_) {
+    field_size_x_ = size_x;
+    field_size_y_ = size_y;
+    field_origin_x_ = master_grid.getOriginX();
+    field_origin_y_ = master_grid.getOriginY();
+    field_source_.assign(size_x * size_y, -1);
+    field_flags_.assign(size_x * size_y, 0);
+    field_queue_ = decltype(field_queue_)();
+    for (unsigned int index = 0; index < size_x * size_y; index++) {
+      if (isInflationSource(master_array[index])) {
+        insertFieldSource(index);
+      }
+    }
+    need_field_reset_ = false;
+  } else {
+    if (shift_x != 0 || shift_y != 0) {
+      shiftField(master_array, shift_x, shift_y);
+      field_origin_x_ = master_grid.getOriginX();
+      field_origin_y_ = master_grid.getOriginY();
+    }
+
+    // The layers below only change the master grid within the window, so only there
+    // can sources appear or disappear
+    for (int j = min_j; j < max_j; j++) {
+      unsigned int index = master_grid.getIndex(min_i, j);
+      for (int i = min_i; i < max_i; i++, index++) {
+        const bool source = isInflationSource(master_array[index]);
+        if (source != ((field_flags_[index] & FIELD_SOURCE) != 0)) {
+          if (source) {
+            insertFieldSource(index);
+          } else {
+            removeFieldSource(index);
+          }
+        }
+      }
+    }
+  }
+
+  propagateField();
+
+  for (int j = min_j; j < max_j; j++) {
+    unsigned int index = master_grid.getIndex(min_i, j);
+    for (int i = min_i; i < max_i; i++, index++) {
+      const int source = field_source_[index];
+      if (source < 0) {
+        continue;
+      }
+
+      const unsigned int sx = source % size_x;
+      const unsigned int sy = source / size_x;
+      const unsigned char cost = costLookup(i, j, sx, sy);
+      const unsigned char old_cost = master_array[index];
+      if (old_cost == NO_INFORMATION &&
+        (inflate_unknown_ ? (cost > FREE_SPACE) : (cost >= INSCRIBED_INFLATED_OBSTACLE)))
+      {
+        master_array[index] = cost;
+      } else {
+        master_array[index] = std::max(old_cost, cost);
+      }
+    }
+  }
+}
+
+void
+InflationLayer::shiftField(const unsigned char * master_array, int shift_x, int shift_y)
+{
+  const int width = static_cast<int>(field_size_x_);
+  const int height = static_cast<int>(field_size_y_);
+
+  // Cell (i, j) takes the field of cell (i + shift_x, j + shift_y). Cells are visited in the
+  // order that reads each one before it is overwritten.
+  for (int n = 0; n < height; n++) {
+    const int j = shift_y > 0 ? n : height - 1 - n;
+    const int from_j = j + shift_y;
+    for (int m = 0; m < width; m++) {
+      const int i = shift_x > 0 ? m : width - 1 - m;
+      const int from_i = i + shift_x;
+      const unsigned int index = j * width + i;
+
+      if (from_i < 0 || from_i >= width || from_j < 0 || from_j >= height) {
+        // Newly exposed: its sources are found here, and the raise pulls in the
+        // sources of its neighbors
+        if (isInflationSource(master_array[index])) {
+          insertFieldSource(index);
+        } else {
+          removeFieldSource(index);
+        }
+        continue;
+      }
+
+      const unsigned int from = from_j * width + from_i;
+      field_flags_[index] = field_flags_[from];
+      field_source_[index] = field_source_[from];
+      if (field_source_[index] < 0) {
+        continue;
+      }
+
+      const int source_x = field_source_[index] % width - shift_x;
+      const int source_y = field_source_[index] / width - shift_y;
+      if (source_x < 0 || source_x >= width || source_y < 0 || source_y >= height) {
+        // Its source left the map
+        removeFieldSource(index);
+      } else {
+        field_source_[index] = source_y * width + source_x;
+      }
+    }
+  }
+}
+
+void
+InflationLayer::insertFieldSource(unsigned int index)
+{
+  field_flags_[index] = FIELD_SOURCE;
+  field_source_[index] = static_cast<int>(index);
+  field_queue_.emplace(0, index);
+}
+
+void
+InflationLayer::removeFieldSource(unsigned int index)
+{
+  field_flags_[index] = FIELD_RAISE;
+  field_source_[index] = -1;
+  field_queue_.emplace(0, index);
+}
+
+void
+InflationLayer::propagateField()
+{
+  // Cells are processed by increasing distance to their (former) source, so a raise
+  // wavefront clears the cells of a removed source before a lower wavefront refills them
+  while (!field_queue_.empty()) {
+    const unsigned int index = field_queue_.top().second;
+    field_queue_.pop();
+    if (field_flags_[index] & FIELD_RAISE) {
+      raiseFieldCell(index);
+    } else if (field_source_[index] >= 0) {
+      lowerFieldCell(index);
+    }
+  }
+}
+
+void
+InflationLayer::raiseFieldCell(unsigned int index)
+{
+  const unsigned int mx = index % field_size_x_;
+  const unsigned int my = index / field_size_x_;
+  const unsigned int min_x = mx > 0 ? mx - 1 : mx, max_x = std::min(mx + 1, field_size_x_ - 1);
+  const unsigned int min_y = my > 0 ? my - 1 : my, max_y = std::min(my + 1, field_size_y_ - 1);
+
+  for (unsigned int y = min_y; y <= max_y; y++) {
+    for (unsigned int x = min_x; x <= max_x; x++) {
+      const unsigned int neighbor = y * field_size_x_ + x;
+      const int source = field_source_[neighbor];
+      if (source < 0 || (field_flags_[neighbor] & FIELD_RAISE)) {
+        continue;
+      }
+
+      field_queue_.emplace(fieldDistanceSq(neighbor, source), neighbor);
+      if (!(field_flags_[source] & FIELD_SOURCE)) {
+        // Its source is gone: clear it and keep raising
+        field_source_[neighbor] = -1;
+        field_flags_[neighbor] |= FIELD_RAISE;
+      }
+    }
+  }
+
+  field_flags_[index] &= ~FIELD_RAISE;
+}
+
+void
+InflationLayer::lowerFieldCell(unsigned int index)
+{
+  const int source = field_source_[index];
+  if (!(field_flags_[source] & FIELD_SOURCE)) {
+    // Stale: the raise wavefront of the removed source will reach this cell
+    return;
+  }
+
+  const unsigned int r_sq = cell_inflation_radius_ * cell_inflation_radius_;
+  const unsigned int mx = index % field_size_x_;
+  const unsigned int my = index / field_size_x_;
+  const unsigned int min_x = mx > 0 ? mx - 1 : mx, max_x = std::min(mx + 1, field_size_x_ - 1);
+  const unsigned int min_y = my > 0 ? my - 1 : my, max_y = std::min(my + 1, field_size_y_ - 1);
+
+  for (unsigned int y = min_y; y <= max_y; y++) {
+    for (unsigned int x = min_x; x <= max_x; x++) {
+      const unsigned int neighbor = y * field_size_x_ + x;
+      if (field_flags_[neighbor] & FIELD_RAISE) {
+        continue;
+      }
+
+      const unsigned int distance_sq = fieldDistanceSq(neighbor, source);
+      if (distance_sq > r_sq) {
+        continue;
+      }
+
+      // Ties go to the lower source index, so the field doesn't depend on the update order
+      const int current = field_source_[neighbor];
+      if (current >= 0) {
+        const unsigned int current_sq = fieldDistanceSq(neighbor, current);
+        if (distance_sq > current_sq || (distance_sq == current_sq && source >= current)) {
+          continue;
+        }
+      }
+
+      field_source_[neighbor] = source;
+      field_queue_.emplace(distance_sq, neighbor);
+    }
+  }
+}
+
 void
 InflationLayer::computeCaches()
 {
@@ -359,6 +770,8 @@ InflationLayer::computeCaches()
     }
   }
 
+  need_field_reset_ = true;
+
   int max_dist = generateIntegerDistances();
   inflation_cells_.clear();
   inflation_cells_.resize(max_dist + 1);
@@ -38,7 +38,10 @@
  *********************************************************************/
 #include "nav2_costmap_2d/obstacle_layer.hpp"
 
+#include <omp.h>
+
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -59,6 +62,30 @@ using nav2_costmap_2d::Observation;
 namespace nav2_costmap_2d
 {
 
+namespace
+{
+
+/**
+ * @brief Raytrace action setting the bits of the cells traced through, so threads
+ * tracing into their own bitsets don't write to the costmap concurrently
+ */
+class MarkBit
+{
+public:
+  explicit MarkBit(uint64_t * bits)
+  : bits_(bits) {}
+
+  inline void operator()(unsigned int offset)
+  {
+    bits_[offset >> 6] |= uint64_t{1} << (offset & 63);
+  }
+
+private:
+  uint64_t * bits_;
+};
+
+}  // namespace
+
 ObstacleLayer::~ObstacleLayer()
 {
   for (auto & notifier : observation_notifiers_) {
@@ -80,6 +107,8 @@ void ObstacleLayer::onInitialize()
   declareParameter("max_obstacle_height", rclcpp::ParameterValue(2.0));
   declareParameter("combination_method", rclcpp::ParameterValue(1));
   declareParameter("observation_sources", rclcpp::ParameterValue(std::string("")));
+  declareParameter("raytrace_threads", rclcpp::ParameterValue(1));
+  declareParameter("deduplicate_rays", rclcpp::ParameterValue(true));
 
   auto node = node_.lock();
   if (!node) {
@@ -93,6 +122,11 @@ void ObstacleLayer::onInitialize()
   node->get_parameter("track_unknown_space", track_unknown_space);
   node->get_parameter("transform_tolerance", transform_tolerance);
   node->get_parameter(name_ + "." + "observation_sources", topics_string);
+  node->get_parameter(name_ + "." + "raytrace_threads", raytrace_threads_);
+  node->get_parameter(name_ + "." + "deduplicate_rays", deduplicate_rays_);
+  if (raytrace_threads_ <= 0) {
+    raytrace_threads_ = omp_get_max_threads();
+  }
 
   RCLCPP_INFO(
     logger_,
@@ -382,17 +416,12 @@ ObstacleLayer::updateBounds(
   {
     const Observation & obs = *it;
 
-    const sensor_msgs::msg::PointCloud2 & cloud = *(obs.cloud_);
-
     double sq_obstacle_max_range = obs.obstacle_max_range_ * obs.obstacle_max_range_;
     double sq_obstacle_min_range = obs.obstacle_min_range_ * obs.obstacle_min_range_;
 
-    sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud, "x");
-    sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud, "y");
-    sensor_msgs::PointCloud2ConstIterator<float> iter_z(cloud, "z");
-
-    for (; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z) {
-      double px = *iter_x, py = *iter_y, pz = *iter_z;
+    const float * points = obs.getPoints();
+    for (unsigned int i = 0; i != obs.getNumPoints(); i++) {
+      double px = points[3 * i], py = points[3 * i + 1], pz = points[3 * i + 2];
 
       // if the obstacle is too high or too far away from the robot we won't add it
       if (pz > max_obstacle_height_) {
@@ -454,6 +483,16 @@ ObstacleLayer::updateCosts(
   nav2_costmap_2d::Costmap2D & master_grid, int min_i, int min_j,
   int max_i,
   int max_j)
+{
+  TileExecutor executor;
+  updateCostsTiled(master_grid, min_i, min_j, max_i, max_j, executor);
+}
+
+void
+ObstacleLayer::updateCostsTiled(
+  nav2_costmap_2d::Costmap2D & master_grid, int min_i, int min_j,
+  int max_i, int max_j,
+  TileExecutor & executor)
 {
   if (!enabled_) {
     return;
@@ -469,16 +508,20 @@ ObstacleLayer::updateCosts(
     setConvexPolygonCost(transformed_footprint_, nav2_costmap_2d::FREE_SPACE);
   }
 
-  switch (combination_method_) {
-    case 0:  // Overwrite
-      updateWithOverwrite(master_grid, min_i, min_j, max_i, max_j);
-      break;
-    case 1:  // Maximum
-      updateWithMax(master_grid, min_i, min_j, max_i, max_j);
-      break;
-    default:  // Nothing
-      break;
-  }
+  executor.run(
+    min_i, min_j, max_i, max_j,
+    [&](int tile_min_i, int tile_min_j, int tile_max_i, int tile_max_j, unsigned int) {
+      switch (combination_method_) {
+        case 0:  // Overwrite
+          updateWithOverwrite(master_grid, tile_min_i, tile_min_j, tile_max_i, tile_max_j);
+          break;
+        case 1:  // Maximum
+          updateWithMax(master_grid, tile_min_i, tile_min_j, tile_max_i, tile_max_j);
+          break;
+        default:  // Nothing
+          break;
+      }
+    });
 }
 
 void
@@ -548,7 +591,6 @@ ObstacleLayer::raytraceFreespace(
 {
   double ox = clearing_observation.origin_.x;
   double oy = clearing_observation.origin_.y;
-  const sensor_msgs::msg::PointCloud2 & cloud = *(clearing_observation.cloud_);
 
   // get the map coordinates of the origin of the sensor
   unsigned int x0, y0;
@@ -569,13 +611,13 @@ ObstacleLayer::raytraceFreespace(
   touch(ox, oy, min_x, min_y, max_x, max_y);
 
   // for each point in the cloud, we want to trace a line from the origin
-  // and clear obstacles along it
-  sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud, "x");
-  sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud, "y");
-
-  for (; iter_x != iter_x.end(); ++iter_x, ++iter_y) {
-    double wx = *iter_x;
-    double wy = *iter_y;
+  // and clear obstacles along it. First find the cells the rays end in
+  std::vector<unsigned int> & endpoints = raytrace_endpoints_;
+  endpoints.clear();
+  const float * points = clearing_observation.getPoints();
+  for (unsigned int i = 0; i != clearing_observation.getNumPoints(); i++) {
+    double wx = points[3 * i];
+    double wy = points[3 * i + 1];
 
     // now we also need to make sure that the enpoint we're raytracing
     // to isn't off the costmap and scale if necessary
@@ -613,18 +655,75 @@ ObstacleLayer::raytraceFreespace(
     if (!worldToMap(wx, wy, x1, y1)) {
       continue;
     }
-
-    unsigned int cell_raytrace_max_range = cellDistance(clearing_observation.raytrace_max_range_);
-    unsigned int cell_raytrace_min_range = cellDistance(clearing_observation.raytrace_min_range_);
-    MarkCell marker(costmap_, FREE_SPACE);
-    // and finally... we can execute our trace to clear obstacles along that line
-    raytraceLine(marker, x0, y0, x1, y1, cell_raytrace_max_range, cell_raytrace_min_range);
+    endpoints.push_back(getIndex(x1, y1));
 
     updateRaytraceBounds(
       ox, oy, wx, wy, clearing_observation.raytrace_max_range_,
       clearing_observation.raytrace_min_range_, min_x, min_y, max_x,
       max_y);
   }
+
+  // Rays from the same origin to the same cell clear the same cells
+  if (deduplicate_rays_) {
+    std::sort(endpoints.begin(), endpoints.end());
+    endpoints.erase(std::unique(endpoints.begin(), endpoints.end()), endpoints.end());
+  }
+
+  unsigned int cell_raytrace_max_range = cellDistance(clearing_observation.raytrace_max_range_);
+  unsigned int cell_raytrace_min_range = cellDistance(clearing_observation.raytrace_min_range_);
+  const int num_rays = static_cast<int>(endpoints.size());
+
+  if (raytrace_threads_ == 1 || num_rays < 2) {
+    MarkCell marker(costmap_, FREE_SPACE);
+    for (const auto & endpoint : endpoints) {
+      unsigned int x1, y1;
+      indexToCells(endpoint, x1, y1);
+      // and finally... we can execute our trace to clear obstacles along that line
+      raytraceLine(marker, x0, y0, x1, y1, cell_raytrace_max_range, cell_raytrace_min_range);
+    }
+    return;
+  }
+
+  // Otherwise the rays are shared out among threads, each tracing into its own bitset
+  // of the cells to clear. Bitsets are kept cleared between calls.
+  const unsigned int num_threads = static_cast<unsigned int>(raytrace_threads_);
+  const size_t num_words = (static_cast<size_t>(size_x_) * size_y_ + 63) / 64;
+  raytrace_bits_.resize(num_threads);
+  for (auto & bits : raytrace_bits_) {
+    if (bits.size() != num_words) {
+      bits.assign(num_words, 0);
+    }
+  }
+
+  #pragma omp parallel num_threads(num_threads)
+  {
+    const unsigned int thread = static_cast<unsigned int>(omp_get_thread_num());
+    MarkBit marker(raytrace_bits_[thread].data());
+    #pragma omp for schedule(dynamic, 64)
+    for (int i = 0; i < num_rays; i++) {
+      unsigned int x1, y1;
+      indexToCells(endpoints[i], x1, y1);
+      raytraceLine(marker, x0, y0, x1, y1, cell_raytrace_max_range, cell_raytrace_min_range);
+    }
+  }
+
+  // Union the bitsets, clearing them as we go. Rays stay within the rows between the
+  // origin and their end, so only the words of those rows can be set.
+  const auto bounds = std::minmax_element(endpoints.begin(), endpoints.end());
+  const size_t first_row = std::min<size_t>(y0, *bounds.first / size_x_);
+  const size_t last_row = std::max<size_t>(y0, *bounds.second / size_x_);
+  const size_t last_word = ((last_row + 1) * size_x_ - 1) / 64;
+  for (size_t word = first_row * size_x_ / 64; word <= last_word; word++) {
+    uint64_t cleared = 0;
+    for (auto & bits : raytrace_bits_) {
+      cleared |= bits[word];
+      bits[word] = 0;
+    }
+    while (cleared) {
+      costmap_[64 * word + __builtin_ctzll(cleared)] = FREE_SPACE;
+      cleared &= cleared - 1;
+    }
+  }
 }
 
 void
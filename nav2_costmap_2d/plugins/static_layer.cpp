@@ -371,6 +371,16 @@ void
 StaticLayer::updateCosts(
   nav2_costmap_2d::Costmap2D & master_grid,
   int min_i, int min_j, int max_i, int max_j)
+{
+  TileExecutor executor;
+  updateCostsTiled(master_grid, min_i, min_j, max_i, max_j, executor);
+}
+
+void
+StaticLayer::updateCostsTiled(
+  nav2_costmap_2d::Costmap2D & master_grid,
+  int min_i, int min_j, int max_i, int max_j,
+  TileExecutor & executor)
 {
   if (!enabled_) {
     update_in_progress_.store(false);
@@ -389,15 +399,17 @@ StaticLayer::updateCosts(
 
   if (!layered_costmap_->isRolling()) {
     // if not rolling, the layered costmap (master_grid) has same coordinates as this layer
-    if (!use_maximum_) {
-      updateWithTrueOverwrite(master_grid, min_i, min_j, max_i, max_j);
-    } else {
-      updateWithMax(master_grid, min_i, min_j, max_i, max_j);
-    }
+    executor.run(
+      min_i, min_j, max_i, max_j,
+      [&](int tile_min_i, int tile_min_j, int tile_max_i, int tile_max_j, unsigned int) {
+        if (!use_maximum_) {
+          updateWithTrueOverwrite(master_grid, tile_min_i, tile_min_j, tile_max_i, tile_max_j);
+        } else {
+          updateWithMax(master_grid, tile_min_i, tile_min_j, tile_max_i, tile_max_j);
+        }
+      });
   } else {
     // If rolling window, the master_grid is unlikely to have same coordinates as this layer
-    unsigned int mx, my;
-    double wx, wy;
     // Might even be in a different frame
     geometry_msgs::msg::TransformStamped transform;
     try {
@@ -413,23 +425,29 @@ StaticLayer::updateCosts(
     tf2::Transform tf2_transform;
     tf2::fromMsg(transform.transform, tf2_transform);
 
-    for (int i = min_i; i < max_i; ++i) {
-      for (int j = min_j; j < max_j; ++j) {
-        // Convert master_grid coordinates (i,j) into global_frame_(wx,wy) coordinates
-        layered_costmap_->getCostmap()->mapToWorld(i, j, wx, wy);
-        // Transform from global_frame_ to map_frame_
-        tf2::Vector3 p(wx, wy, 0);
-        p = tf2_transform * p;
-        // Set master_grid with cell from map
-        if (worldToMap(p.x(), p.y(), mx, my)) {
-          if (!use_maximum_) {
-            master_grid.setCost(i, j, getCost(mx, my));
-          } else {
-            master_grid.setCost(i, j, std::max(getCost(mx, my), master_grid.getCost(i, j)));
+    executor.run(
+      min_i, min_j, max_i, max_j,
+      [&](int tile_min_i, int tile_min_j, int tile_max_i, int tile_max_j, unsigned int) {
+        unsigned int mx, my;
+        double wx, wy;
+        for (int i = tile_min_i; i < tile_max_i; ++i) {
+          for (int j = tile_min_j; j < tile_max_j; ++j) {
+            // Convert master_grid coordinates (i,j) into global_frame_(wx,wy) coordinates
+            layered_costmap_->getCostmap()->mapToWorld(i, j, wx, wy);
+            // Transform from global_frame_ to map_frame_
+            tf2::Vector3 p(wx, wy, 0);
+            p = tf2_transform * p;
+            // Set master_grid with cell from map
+            if (worldToMap(p.x(), p.y(), mx, my)) {
+              if (!use_maximum_) {
+                master_grid.setCost(i, j, getCost(mx, my));
+              } else {
+                master_grid.setCost(i, j, std::max(getCost(mx, my), master_grid.getCost(i, j)));
+              }
+            }
           }
         }
-      }
-    }
+      });
   }
   update_in_progress_.store(false);
   current_ = true;
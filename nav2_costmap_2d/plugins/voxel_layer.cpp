@@ -40,15 +40,20 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <string>
+#include <type_traits>
 #include <utility>
 
 #include "pluginlib/class_list_macros.hpp"
 #include "sensor_msgs/point_cloud2_iterator.hpp"
 
-#define VOXEL_BITS 16
 PLUGINLIB_EXPORT_CLASS(nav2_costmap_2d::VoxelLayer, nav2_costmap_2d::Layer)
+PLUGINLIB_EXPORT_CLASS(nav2_costmap_2d::VoxelLayer32, nav2_costmap_2d::Layer)
+PLUGINLIB_EXPORT_CLASS(nav2_costmap_2d::VoxelLayer64, nav2_costmap_2d::Layer)
 
 using nav2_costmap_2d::NO_INFORMATION;
 using nav2_costmap_2d::LETHAL_OBSTACLE;
@@ -57,7 +62,8 @@ using nav2_costmap_2d::FREE_SPACE;
 namespace nav2_costmap_2d
 {
 
-void VoxelLayer::onInitialize()
+template<typename ColumnT>
+void BasicVoxelLayer<ColumnT>::onInitialize()
 {
   ObstacleLayer::onInitialize();
 
@@ -71,6 +77,7 @@ void VoxelLayer::onInitialize()
   declareParameter("mark_threshold", rclcpp::ParameterValue(0));
   declareParameter("combination_method", rclcpp::ParameterValue(1));
   declareParameter("publish_voxel_map", rclcpp::ParameterValue(false));
+  declareParameter("prefilter_clearing_rays", rclcpp::ParameterValue(false));
 
   auto node = node_.lock();
   if (!node) {
@@ -87,6 +94,25 @@ void VoxelLayer::onInitialize()
   node->get_parameter(name_ + "." + "mark_threshold", mark_threshold_);
   node->get_parameter(name_ + "." + "combination_method", combination_method_);
   node->get_parameter(name_ + "." + "publish_voxel_map", publish_voxel_);
+  node->get_parameter(name_ + "." + "prefilter_clearing_rays", prefilter_clearing_rays_);
+
+  if (size_z_ > static_cast<int>(Traits::levels)) {
+    RCLCPP_ERROR(
+      logger_,
+      "%s: z_voxels of %d is more than the %u levels of the columns of this voxel layer, "
+      "use a layer of wider columns. Capping to %u.",
+      name_.c_str(), size_z_, Traits::levels, Traits::levels);
+    size_z_ = Traits::levels;
+  }
+
+  // The voxel grid message holds 32 bit columns
+  if (publish_voxel_ && !std::is_same<ColumnT, uint32_t>::value) {
+    RCLCPP_WARN(
+      logger_,
+      "%s: publish_voxel_map is only supported for up to 16 z voxels, not publishing the voxel map",
+      name_.c_str());
+    publish_voxel_ = false;
+  }
 
   auto custom_qos = rclcpp::QoS(rclcpp::KeepLast(1)).transient_local().reliable();
 
@@ -100,29 +126,36 @@ void VoxelLayer::onInitialize()
     "clearing_endpoints", custom_qos);
   clearing_endpoints_pub_->on_activate();
 
-  unknown_threshold_ += (VOXEL_BITS - size_z_);
+  diagnostics_ = std::make_unique<ThrottledDiagnostics>(node, name_ + " clearing");
+  diagnostics_->activate();
+
+  unknown_threshold_ += (static_cast<int>(Traits::levels) - size_z_);
   matchSize();
 }
 
-VoxelLayer::~VoxelLayer()
+template<typename ColumnT>
+BasicVoxelLayer<ColumnT>::~BasicVoxelLayer()
 {
 }
 
-void VoxelLayer::matchSize()
+template<typename ColumnT>
+void BasicVoxelLayer<ColumnT>::matchSize()
 {
   ObstacleLayer::matchSize();
   voxel_grid_.resize(size_x_, size_y_, size_z_);
   assert(voxel_grid_.sizeX() == size_x_ && voxel_grid_.sizeY() == size_y_);
 }
 
-void VoxelLayer::reset()
+template<typename ColumnT>
+void BasicVoxelLayer<ColumnT>::reset()
 {
   // Call the base class method before adding our own functionality
   ObstacleLayer::reset();
   resetMaps();
 }
 
-void VoxelLayer::resetMaps()
+template<typename ColumnT>
+void BasicVoxelLayer<ColumnT>::resetMaps()
 {
   // Call the base class method before adding our own functionality
   // Note: at the time this was written, ObstacleLayer doesn't implement
@@ -132,7 +165,8 @@ void VoxelLayer::resetMaps()
   voxel_grid_.reset();
 }
 
-void VoxelLayer::updateBounds(
+template<typename ColumnT>
+void BasicVoxelLayer<ColumnT>::updateBounds(
   double robot_x, double robot_y, double robot_yaw, double * min_x,
   double * min_y, double * max_x, double * max_y)
 {
@@ -157,9 +191,18 @@ void VoxelLayer::updateBounds(
   current_ = current;
 
   // raytrace freespace
+  clearing_stats_ = ClearingStats();
   for (unsigned int i = 0; i < clearing_observations.size(); ++i) {
     raytraceFreespace(clearing_observations[i], min_x, min_y, max_x, max_y);
   }
+  if (clearing_stats_.raw_rays != 0) {
+    RCLCPP_DEBUG(
+      logger_,
+      "%s cleared %u rays, %u traced in %.6f s, %.6f s saved by the prefilter",
+      name_.c_str(), clearing_stats_.raw_rays, clearing_stats_.unique_rays,
+      clearing_stats_.trace_time, clearing_stats_.saved_time);
+  }
+  publishDiagnostics();
 
   // place the new obstacles into a priority queue... each with a priority of zero to begin with
   for (std::vector<Observation>::const_iterator it = observations.begin(); it != observations.end();
@@ -167,25 +210,22 @@ void VoxelLayer::updateBounds(
   {
     const Observation & obs = *it;
 
-    const sensor_msgs::msg::PointCloud2 & cloud = *(obs.cloud_);
-
     double sq_obstacle_max_range = obs.obstacle_max_range_ * obs.obstacle_max_range_;
     double sq_obstacle_min_range = obs.obstacle_min_range_ * obs.obstacle_min_range_;
 
-    sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud, "x");
-    sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud, "y");
-    sensor_msgs::PointCloud2ConstIterator<float> iter_z(cloud, "z");
+    const float * points = obs.getPoints();
+    for (unsigned int i = 0; i != obs.getNumPoints(); i++) {
+      const float px = points[3 * i], py = points[3 * i + 1], pz = points[3 * i + 2];
 
-    for (; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z) {
       // if the obstacle is too high or too far away from the robot we won't add it
-      if (*iter_z > max_obstacle_height_) {
+      if (pz > max_obstacle_height_) {
         continue;
       }
 
       // compute the squared distance from the hitpoint to the pointcloud's origin
-      double sq_dist = (*iter_x - obs.origin_.x) * (*iter_x - obs.origin_.x) +
-        (*iter_y - obs.origin_.y) * (*iter_y - obs.origin_.y) +
-        (*iter_z - obs.origin_.z) * (*iter_z - obs.origin_.z);
+      double sq_dist = (px - obs.origin_.x) * (px - obs.origin_.x) +
+        (py - obs.origin_.y) * (py - obs.origin_.y) +
+        (pz - obs.origin_.z) * (pz - obs.origin_.z);
 
       // if the point is far enough away... we won't consider it
       if (sq_dist >= sq_obstacle_max_range) {
@@ -199,11 +239,11 @@ void VoxelLayer::updateBounds(
 
       // now we need to compute the map coordinates for the observation
       unsigned int mx, my, mz;
-      if (*iter_z < origin_z_) {
-        if (!worldToMap3D(*iter_x, *iter_y, origin_z_, mx, my, mz)) {
+      if (pz < origin_z_) {
+        if (!worldToMap3D(px, py, origin_z_, mx, my, mz)) {
           continue;
         }
-      } else if (!worldToMap3D(*iter_x, *iter_y, *iter_z, mx, my, mz)) {
+      } else if (!worldToMap3D(px, py, pz, mx, my, mz)) {
         continue;
       }
 
@@ -213,7 +253,7 @@ void VoxelLayer::updateBounds(
 
         costmap_[index] = LETHAL_OBSTACLE;
         touch(
-          static_cast<double>(*iter_x), static_cast<double>(*iter_y),
+          static_cast<double>(px), static_cast<double>(py),
           min_x, min_y, max_x, max_y);
       }
     }
@@ -244,7 +284,8 @@ void VoxelLayer::updateBounds(
   updateFootprint(robot_x, robot_y, robot_yaw, min_x, min_y, max_x, max_y);
 }
 
-void VoxelLayer::clearNonLethal(
+template<typename ColumnT>
+void BasicVoxelLayer<ColumnT>::clearNonLethal(
   double wx, double wy, double w_size_x, double w_size_y,
   bool clear_no_info)
 {
@@ -277,27 +318,31 @@ void VoxelLayer::clearNonLethal(
 
   // we know that we want to clear all non-lethal obstacles in this
   // window to get it ready for inflation
+  // The voxel columns are cleared a run of consecutive cleared cells at a time
   unsigned int index = getIndex(map_sx, map_sy);
   unsigned char * current = &costmap_[index];
   for (unsigned int j = map_sy; j <= map_ey; ++j) {
+    unsigned int run_start = index;
     for (unsigned int i = map_sx; i <= map_ex; ++i) {
       // if the cell is a lethal obstacle... we'll keep it and queue it,
       // otherwise... we'll clear it
-      if (*current != LETHAL_OBSTACLE) {
-        if (clear_no_info || *current != NO_INFORMATION) {
-          *current = FREE_SPACE;
-          voxel_grid_.clearVoxelColumn(index);
-        }
+      if (*current != LETHAL_OBSTACLE && (clear_no_info || *current != NO_INFORMATION)) {
+        *current = FREE_SPACE;
+      } else {
+        voxel_grid_.clearVoxelColumns(run_start, index - run_start);
+        run_start = index + 1;
       }
       current++;
       index++;
     }
+    voxel_grid_.clearVoxelColumns(run_start, index - run_start);
     current += size_x_ - (map_ex - map_sx) - 1;
     index += size_x_ - (map_ex - map_sx) - 1;
   }
 }
 
-void VoxelLayer::raytraceFreespace(
+template<typename ColumnT>
+void BasicVoxelLayer<ColumnT>::raytraceFreespace(
   const Observation & clearing_observation, double * min_x,
   double * min_y,
   double * max_x,
@@ -305,7 +350,7 @@ void VoxelLayer::raytraceFreespace(
 {
   auto clearing_endpoints_ = std::make_unique<sensor_msgs::msg::PointCloud2>();
 
-  if (clearing_observation.cloud_->height == 0 || clearing_observation.cloud_->width == 0) {
+  if (clearing_observation.getNumPoints() == 0) {
     return;
   }
 
@@ -334,8 +379,8 @@ void VoxelLayer::raytraceFreespace(
 
   if (publish_clearing_points) {
     clearing_endpoints_->data.clear();
-    clearing_endpoints_->width = clearing_observation.cloud_->width;
-    clearing_endpoints_->height = clearing_observation.cloud_->height;
+    clearing_endpoints_->width = clearing_observation.getNumPoints();
+    clearing_endpoints_->height = 1;
     clearing_endpoints_->is_dense = true;
     clearing_endpoints_->is_bigendian = false;
   }
@@ -355,14 +400,16 @@ void VoxelLayer::raytraceFreespace(
   double map_end_y = origin_y_ + getSizeInMetersY();
   double map_end_z = origin_z_ + getSizeInMetersZ();
 
-  sensor_msgs::PointCloud2ConstIterator<float> iter_x(*(clearing_observation.cloud_), "x");
-  sensor_msgs::PointCloud2ConstIterator<float> iter_y(*(clearing_observation.cloud_), "y");
-  sensor_msgs::PointCloud2ConstIterator<float> iter_z(*(clearing_observation.cloud_), "z");
+  // Rays ending in a voxel already traced to only update the bounds when prefiltering
+  traced_voxels_.clear();
+  unsigned int raw_rays = 0, unique_rays = 0;
+  std::chrono::steady_clock::duration trace_duration{0};
 
-  for (; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z) {
-    double wpx = *iter_x;
-    double wpy = *iter_y;
-    double wpz = *iter_z;
+  const float * points = clearing_observation.getPoints();
+  for (unsigned int i = 0; i != clearing_observation.getNumPoints(); i++) {
+    double wpx = points[3 * i];
+    double wpy = points[3 * i + 1];
+    double wpz = points[3 * i + 2];
 
     double distance = dist(ox, oy, oz, wpx, wpy, wpz);
     double scaling_fact = 1.0;
@@ -411,13 +458,29 @@ void VoxelLayer::raytraceFreespace(
       unsigned int cell_raytrace_max_range = cellDistance(clearing_observation.raytrace_max_range_);
       unsigned int cell_raytrace_min_range = cellDistance(clearing_observation.raytrace_min_range_);
 
+      raw_rays++;
+      if (prefilter_clearing_rays_) {
+        const uint64_t voxel = (static_cast<uint64_t>(point_z) * size_y_ +
+          static_cast<unsigned int>(point_y)) * size_x_ + static_cast<unsigned int>(point_x);
+        if (!traced_voxels_.insert(voxel).second) {
+          updateRaytraceBounds(
+            ox, oy, wpx, wpy, clearing_observation.raytrace_max_range_,
+            clearing_observation.raytrace_min_range_, min_x, min_y,
+            max_x,
+            max_y);
+          continue;
+        }
+      }
+      unique_rays++;
 
       // voxel_grid_.markVoxelLine(sensor_x, sensor_y, sensor_z, point_x, point_y, point_z);
+      const auto trace_start = std::chrono::steady_clock::now();
       voxel_grid_.clearVoxelLineInMap(
         sensor_x, sensor_y, sensor_z, point_x, point_y, point_z,
         costmap_,
         unknown_threshold_, mark_threshold_, FREE_SPACE, NO_INFORMATION,
         cell_raytrace_max_range, cell_raytrace_min_range);
+      trace_duration += std::chrono::steady_clock::now() - trace_start;
 
       updateRaytraceBounds(
         ox, oy, wpx, wpy, clearing_observation.raytrace_max_range_,
@@ -437,15 +500,45 @@ void VoxelLayer::raytraceFreespace(
     }
   }
 
+  // The rays skipped would have taken about as long to trace as those traced
+  const double trace_time = std::chrono::duration<double>(trace_duration).count();
+  clearing_stats_.raw_rays += raw_rays;
+  clearing_stats_.unique_rays += unique_rays;
+  clearing_stats_.trace_time += trace_time;
+  if (unique_rays != 0) {
+    clearing_stats_.saved_time += trace_time / unique_rays * (raw_rays - unique_rays);
+  }
+
   if (publish_clearing_points) {
     clearing_endpoints_->header.frame_id = global_frame_;
-    clearing_endpoints_->header.stamp = clearing_observation.cloud_->header.stamp;
+    clearing_endpoints_->header.stamp = clearing_observation.stamp_;
 
     clearing_endpoints_pub_->publish(std::move(clearing_endpoints_));
   }
 }
 
-void VoxelLayer::updateOrigin(double new_origin_x, double new_origin_y)
+template<typename ColumnT>
+void BasicVoxelLayer<ColumnT>::publishDiagnostics()
+{
+  diagnostics_stats_.raw_rays += clearing_stats_.raw_rays;
+  diagnostics_stats_.unique_rays += clearing_stats_.unique_rays;
+  diagnostics_stats_.trace_time += clearing_stats_.trace_time;
+  diagnostics_stats_.saved_time += clearing_stats_.saved_time;
+
+  diagnostics_->publish(
+    [this](diagnostic_msgs::msg::DiagnosticStatus & status) {
+      status.message = prefilter_clearing_rays_ ?
+        "Prefiltering clearing rays" : "Not prefiltering clearing rays";
+      ThrottledDiagnostics::add(status, "Raw rays", diagnostics_stats_.raw_rays);
+      ThrottledDiagnostics::add(status, "Unique rays", diagnostics_stats_.unique_rays);
+      ThrottledDiagnostics::add(status, "Trace time (s)", diagnostics_stats_.trace_time);
+      ThrottledDiagnostics::add(status, "Time saved (s)", diagnostics_stats_.saved_time);
+      diagnostics_stats_ = ClearingStats();
+    });
+}
+
+template<typename ColumnT>
+void BasicVoxelLayer<ColumnT>::updateOrigin(double new_origin_x, double new_origin_y)
 {
   // project the new origin into the grid
   int cell_ox, cell_oy;
@@ -474,8 +567,8 @@ void VoxelLayer::updateOrigin(double new_origin_x, double new_origin_y)
 
   // we need a map to store the obstacles in the window temporarily
   unsigned char * local_map = new unsigned char[cell_size_x * cell_size_y];
-  unsigned int * local_voxel_map = new unsigned int[cell_size_x * cell_size_y];
-  unsigned int * voxel_map = voxel_grid_.getData();
+  ColumnT * local_voxel_map = new ColumnT[cell_size_x * cell_size_y];
+  ColumnT * voxel_map = voxel_grid_.getData();
 
   // copy the local window in the costmap to the local map
   copyMapRegion(
@@ -512,4 +605,8 @@ void VoxelLayer::updateOrigin(double new_origin_x, double new_origin_y)
   delete[] local_voxel_map;
 }
 
+template class BasicVoxelLayer<uint32_t>;
+template class BasicVoxelLayer<uint64_t>;
+template class BasicVoxelLayer<nav2_voxel_grid::Column128>;
+
 }  // namespace nav2_costmap_2d
@@ -39,13 +39,215 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <vector>
 #include "nav2_costmap_2d/cost_values.hpp"
 #include "nav2_util/occ_grid_values.hpp"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NAV2_COSTMAP_2D_X86_SIMD
+#endif
+
 namespace nav2_costmap_2d
 {
+
+namespace
+{
+
+// Kernels for batch cost lookups. All take the costmap, its size in cells
+// and the cell indices to look up, which must be within the costmap.
+
+void gatherCostsScalar(
+  const unsigned char * map, unsigned int, const unsigned int * indices, unsigned int n,
+  unsigned char * costs)
+{
+  for (unsigned int i = 0; i != n; ++i) {
+    costs[i] = map[indices[i]];
+  }
+}
+
+unsigned char gatherMaxScalar(
+  const unsigned char * map, unsigned int, const unsigned int * indices, unsigned int n)
+{
+  unsigned char max_cost = 0;
+  for (unsigned int i = 0; i != n; ++i) {
+    max_cost = std::max(max_cost, map[indices[i]]);
+  }
+  return max_cost;
+}
+
+bool gatherAnyScalar(
+  const unsigned char * map, unsigned int, const unsigned int * indices, unsigned int n,
+  unsigned char cost)
+{
+  for (unsigned int i = 0; i != n; ++i) {
+    if (map[indices[i]] == cost) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#ifdef NAV2_COSTMAP_2D_X86_SIMD
+
+// SSE has no gather, so lanes are loaded one by one and reduced 16 at a time
+
+__attribute__((target("sse4.1")))
+unsigned char gatherMaxSse41(
+  const unsigned char * map, unsigned int map_size, const unsigned int * indices, unsigned int n)
+{
+  alignas(16) unsigned char lanes[16];
+  __m128i max_cost = _mm_setzero_si128();
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    for (unsigned int j = 0; j != 16; ++j) {
+      lanes[j] = map[indices[i + j]];
+    }
+    max_cost = _mm_max_epu8(max_cost, _mm_load_si128(reinterpret_cast<const __m128i *>(lanes)));
+  }
+
+  // Horizontal max as the min of the inverted costs, widened to 16 bits
+  const __m128i inverted = _mm_xor_si128(max_cost, _mm_set1_epi8(-1));
+  const __m128i low = _mm_cvtepu8_epi16(inverted);
+  const __m128i high = _mm_cvtepu8_epi16(_mm_srli_si128(inverted, 8));
+  const unsigned char vector_max =
+    255 - static_cast<unsigned char>(_mm_cvtsi128_si32(_mm_minpos_epu16(_mm_min_epu16(low, high))));
+  return std::max(vector_max, gatherMaxScalar(map, map_size, indices + i, n - i));
+}
+
+__attribute__((target("sse4.1")))
+bool gatherAnySse41(
+  const unsigned char * map, unsigned int map_size, const unsigned int * indices, unsigned int n,
+  unsigned char cost)
+{
+  alignas(16) unsigned char lanes[16];
+  const __m128i target = _mm_set1_epi8(static_cast<char>(cost));
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    for (unsigned int j = 0; j != 16; ++j) {
+      lanes[j] = map[indices[i + j]];
+    }
+    const __m128i matches =
+      _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(lanes)), target);
+    if (!_mm_testz_si128(matches, matches)) {
+      return true;
+    }
+  }
+  return gatherAnyScalar(map, map_size, indices + i, n - i, cost);
+}
+
+// AVX2 gathers 32 bit words, so to never read outside of the costmap each
+// lane loads the word ending at its cell (or starting at the map's start, for
+// the first 3 cells) and shifts the cell's byte down. Needs map_size >= 4.
+__attribute__((target("avx2")))
+inline __m256i gather8(const unsigned char * map, const unsigned int * indices)
+{
+  const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices));
+  const __m256i back = _mm256_min_epu32(index, _mm256_set1_epi32(3));
+  const __m256i words = _mm256_i32gather_epi32(
+    reinterpret_cast<const int *>(map), _mm256_sub_epi32(index, back), 1);
+  return _mm256_and_si256(
+    _mm256_srlv_epi32(words, _mm256_slli_epi32(back, 3)), _mm256_set1_epi32(0xFF));
+}
+
+__attribute__((target("avx2")))
+void gatherCostsAvx2(
+  const unsigned char * map, unsigned int map_size, const unsigned int * indices, unsigned int n,
+  unsigned char * costs)
+{
+  unsigned int i = 0;
+  if (map_size >= 4) {
+    // Collect the low byte of each 32 bit lane, per 128 bit half
+    const __m256i shuffle = _mm256_setr_epi8(
+      0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    for (; i + 8 <= n; i += 8) {
+      const __m256i packed = _mm256_shuffle_epi8(gather8(map, indices + i), shuffle);
+      const int low = _mm256_extract_epi32(packed, 0);
+      const int high = _mm256_extract_epi32(packed, 4);
+      std::memcpy(costs + i, &low, 4);
+      std::memcpy(costs + i + 4, &high, 4);
+    }
+  }
+  gatherCostsScalar(map, map_size, indices + i, n - i, costs + i);
+}
+
+__attribute__((target("avx2")))
+unsigned char gatherMaxAvx2(
+  const unsigned char * map, unsigned int map_size, const unsigned int * indices, unsigned int n)
+{
+  unsigned int i = 0;
+  unsigned char max_cost = 0;
+  if (map_size >= 4 && n >= 8) {
+    __m256i max_lanes = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+      max_lanes = _mm256_max_epu32(max_lanes, gather8(map, indices + i));
+    }
+    __m128i max_half = _mm_max_epu32(
+      _mm256_castsi256_si128(max_lanes), _mm256_extracti128_si256(max_lanes, 1));
+    max_half = _mm_max_epu32(max_half, _mm_shuffle_epi32(max_half, _MM_SHUFFLE(1, 0, 3, 2)));
+    max_half = _mm_max_epu32(max_half, _mm_shuffle_epi32(max_half, _MM_SHUFFLE(2, 3, 0, 1)));
+    max_cost = static_cast<unsigned char>(_mm_cvtsi128_si32(max_half));
+  }
+  return std::max(max_cost, gatherMaxScalar(map, map_size, indices + i, n - i));
+}
+
+__attribute__((target("avx2")))
+bool gatherAnyAvx2(
+  const unsigned char * map, unsigned int map_size, const unsigned int * indices, unsigned int n,
+  unsigned char cost)
+{
+  unsigned int i = 0;
+  if (map_size >= 4) {
+    const __m256i target = _mm256_set1_epi32(cost);
+    for (; i + 8 <= n; i += 8) {
+      if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(gather8(map, indices + i), target))) {
+        return true;
+      }
+    }
+  }
+  return gatherAnyScalar(map, map_size, indices + i, n - i, cost);
+}
+
+#endif  // NAV2_COSTMAP_2D_X86_SIMD
+
+struct BatchKernels
+{
+  void (* gather)(
+    const unsigned char *, unsigned int, const unsigned int *, unsigned int, unsigned char *);
+  unsigned char (* max)(const unsigned char *, unsigned int, const unsigned int *, unsigned int);
+  bool (* any)(
+    const unsigned char *, unsigned int, const unsigned int *, unsigned int, unsigned char);
+};
+
+BatchKernels selectBatchKernels()
+{
+#ifdef NAV2_COSTMAP_2D_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {gatherCostsAvx2, gatherMaxAvx2, gatherAnyAvx2};
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return {gatherCostsScalar, gatherMaxSse41, gatherAnySse41};
+  }
+#endif
+  return {gatherCostsScalar, gatherMaxScalar, gatherAnyScalar};
+}
+
+// Selected once, for the CPU we are running on
+const BatchKernels & batchKernels()
+{
+  static const BatchKernels kernels = selectBatchKernels();
+  return kernels;
+}
+
+// Coordinates are converted to indices in blocks of this many cells
+constexpr unsigned int batch_block_size = 256;
+
+}  // namespace
+
 Costmap2D::Costmap2D(
   unsigned int cells_size_x, unsigned int cells_size_y, double resolution,
   double origin_x, double origin_y, unsigned char default_value)
@@ -273,6 +475,50 @@ unsigned char Costmap2D::getCost(unsigned int undex) const
   return costmap_[undex];
 }
 
+void Costmap2D::getCosts(const unsigned int * indices, unsigned int n, unsigned char * costs) const
+{
+  batchKernels().gather(costmap_, size_x_ * size_y_, indices, n, costs);
+}
+
+void Costmap2D::getCosts(
+  const unsigned int * mx, const unsigned int * my, unsigned int n,
+  unsigned char * costs) const
+{
+  unsigned int indices[batch_block_size];
+  for (unsigned int i = 0; i < n; i += batch_block_size) {
+    const unsigned int block = std::min(batch_block_size, n - i);
+    for (unsigned int j = 0; j != block; ++j) {
+      indices[j] = my[i + j] * size_x_ + mx[i + j];
+    }
+    getCosts(indices, block, costs + i);
+  }
+}
+
+unsigned char Costmap2D::getMaxCost(const unsigned int * indices, unsigned int n) const
+{
+  return batchKernels().max(costmap_, size_x_ * size_y_, indices, n);
+}
+
+unsigned char Costmap2D::getMaxCost(
+  const unsigned int * mx, const unsigned int * my, unsigned int n) const
+{
+  unsigned int indices[batch_block_size];
+  unsigned char max_cost = 0;
+  for (unsigned int i = 0; i < n; i += batch_block_size) {
+    const unsigned int block = std::min(batch_block_size, n - i);
+    for (unsigned int j = 0; j != block; ++j) {
+      indices[j] = my[i + j] * size_x_ + mx[i + j];
+    }
+    max_cost = std::max(max_cost, getMaxCost(indices, block));
+  }
+  return max_cost;
+}
+
+bool Costmap2D::hasCost(const unsigned int * indices, unsigned int n, unsigned char cost) const
+{
+  return batchKernels().any(costmap_, size_x_ * size_y_, indices, n, cost);
+}
+
 void Costmap2D::setCost(unsigned int mx, unsigned int my, unsigned char cost)
 {
   costmap_[getIndex(mx, my)] = cost;
@@ -38,15 +38,42 @@
  *********************************************************************/
 #include "nav2_costmap_2d/costmap_2d_publisher.hpp"
 
+#include <cstring>
 #include <string>
 #include <memory>
 #include <utility>
 
 #include "nav2_costmap_2d/cost_values.hpp"
+#include "nav2_costmap_2d/costmap_compression.hpp"
+#include "nav2_costmap_2d/costmap_delta.hpp"
 
 namespace nav2_costmap_2d
 {
 
+namespace
+{
+
+// Copy a costmap, only reallocating the copy when the geometry changed
+void copyCostmap(Costmap2D & costmap, Costmap2D & copy)
+{
+  std::unique_lock<Costmap2D::mutex_t> lock(*(costmap.getMutex()));
+  if (copy.getSizeInCellsX() != costmap.getSizeInCellsX() ||
+    copy.getSizeInCellsY() != costmap.getSizeInCellsY() ||
+    copy.getResolution() != costmap.getResolution() ||
+    copy.getOriginX() != costmap.getOriginX() ||
+    copy.getOriginY() != costmap.getOriginY())
+  {
+    copy.resizeMap(
+      costmap.getSizeInCellsX(), costmap.getSizeInCellsY(), costmap.getResolution(),
+      costmap.getOriginX(), costmap.getOriginY());
+  }
+  std::memcpy(
+    copy.getCharMap(), costmap.getCharMap(),
+    costmap.getSizeInCellsX() * costmap.getSizeInCellsY() * sizeof(unsigned char));
+}
+
+}  // namespace
+
 char * Costmap2DPublisher::cost_translation_table_ = NULL;
 
 Costmap2DPublisher::Costmap2DPublisher(
@@ -54,12 +81,35 @@ Costmap2DPublisher::Costmap2DPublisher(
   Costmap2D * costmap,
   std::string global_frame,
   std::string topic_name,
-  bool always_send_full_costmap)
+  bool always_send_full_costmap,
+  unsigned int update_keyframe_period,
+  bool asynchronous,
+  unsigned int downsample_factor,
+  std::string compression_format)
 : costmap_(costmap),
   global_frame_(global_frame),
   topic_name_(topic_name),
   active_(false),
-  always_send_full_costmap_(always_send_full_costmap)
+  always_send_full_costmap_(always_send_full_costmap),
+  update_keyframe_period_(update_keyframe_period),
+  updates_since_keyframe_(0),
+  update_seq_(0),
+  keyframe_requested_(false),
+  last_raw_resolution_(0.0),
+  last_raw_origin_x_(0.0),
+  last_raw_origin_y_(0.0),
+  downsample_factor_(downsample_factor),
+  compression_format_(compression_format),
+  grid_(std::make_unique<nav_msgs::msg::OccupancyGrid>()),
+  grid_update_(std::make_unique<map_msgs::msg::OccupancyGridUpdate>()),
+  costmap_raw_(std::make_unique<nav2_msgs::msg::Costmap>()),
+  costmap_raw_update_(std::make_unique<nav2_msgs::msg::CostmapUpdate>()),
+  downsampled_grid_(std::make_unique<nav_msgs::msg::OccupancyGrid>()),
+  costmap_compressed_(std::make_unique<nav2_msgs::msg::CompressedCostmap>()),
+  asynchronous_(asynchronous),
+  spare_costmap_(std::make_unique<Costmap2D>()),
+  pending_costmap_(std::make_unique<Costmap2D>()),
+  working_costmap_(std::make_unique<Costmap2D>())
 {
   auto node = parent.lock();
   clock_ = node->get_clock();
@@ -77,6 +127,35 @@ Costmap2DPublisher::Costmap2DPublisher(
   costmap_update_pub_ = node->create_publisher<map_msgs::msg::OccupancyGridUpdate>(
     topic_name + "_updates", custom_qos);
 
+  // Updates only make sense in sequence, so late subscribers are not sent the last
+  // one and request a keyframe instead
+  costmap_raw_update_pub_ = node->create_publisher<nav2_msgs::msg::CostmapUpdate>(
+    topic_name + "_raw_updates",
+    rclcpp::QoS(rclcpp::KeepLast(10)).reliable());
+  resync_sub_ = node->create_subscription<std_msgs::msg::Empty>(
+    topic_name + "_raw_resync",
+    rclcpp::SystemDefaultsQoS(),
+    std::bind(&Costmap2DPublisher::resyncCallback, this, std::placeholders::_1));
+
+  diagnostics_ = std::make_unique<ThrottledDiagnostics>(
+    node, std::string(node->get_fully_qualified_name()) + ": " + topic_name + " publisher");
+
+  if (downsample_factor_ > 1) {
+    costmap_downsampled_pub_ = node->create_publisher<nav_msgs::msg::OccupancyGrid>(
+      topic_name + "_downsampled", custom_qos);
+  }
+
+  if (!compression_format_.empty()) {
+    if (isCompressionFormatSupported(compression_format_)) {
+      costmap_compressed_pub_ = node->create_publisher<nav2_msgs::msg::CompressedCostmap>(
+        topic_name + "_compressed", custom_qos);
+    } else {
+      RCLCPP_WARN(
+        logger_, "Unsupported costmap compression format \"%s\", expected png or zlib. "
+        "Not publishing the compressed costmap.", compression_format_.c_str());
+    }
+  }
+
   // Create a service that will use the callback function to handle requests.
   costmap_service_ = node->create_service<nav2_msgs::srv::GetCostmap>(
     "get_costmap", std::bind(
@@ -105,7 +184,10 @@ Costmap2DPublisher::Costmap2DPublisher(
   y0_ = costmap_->getSizeInCellsY();
 }
 
-Costmap2DPublisher::~Costmap2DPublisher() {}
+Costmap2DPublisher::~Costmap2DPublisher()
+{
+  stopPublishThread();
+}
 
 // TODO(bpwilcox): find equivalent/workaround to ros::SingleSubscriberPublishr
 /*
@@ -116,14 +198,12 @@ void Costmap2DPublisher::onNewSubscription(const ros::SingleSubscriberPublisher&
 } */
 
 // prepare grid_ message for publication.
-void Costmap2DPublisher::prepareGrid()
+void Costmap2DPublisher::prepareGrid(Costmap2D & costmap)
 {
-  std::unique_lock<Costmap2D::mutex_t> lock(*(costmap_->getMutex()));
-  grid_resolution = costmap_->getResolution();
-  grid_width = costmap_->getSizeInCellsX();
-  grid_height = costmap_->getSizeInCellsY();
-
-  grid_ = std::make_unique<nav_msgs::msg::OccupancyGrid>();
+  std::unique_lock<Costmap2D::mutex_t> lock(*(costmap.getMutex()));
+  grid_resolution = costmap.getResolution();
+  grid_width = costmap.getSizeInCellsX();
+  grid_height = costmap.getSizeInCellsY();
 
   grid_->header.frame_id = global_frame_;
   grid_->header.stamp = rclcpp::Time();
@@ -134,97 +214,342 @@ void Costmap2DPublisher::prepareGrid()
   grid_->info.height = grid_height;
 
   double wx, wy;
-  costmap_->mapToWorld(0, 0, wx, wy);
+  costmap.mapToWorld(0, 0, wx, wy);
   grid_->info.origin.position.x = wx - grid_resolution / 2;
   grid_->info.origin.position.y = wy - grid_resolution / 2;
   grid_->info.origin.position.z = 0.0;
   grid_->info.origin.orientation.w = 1.0;
-  saved_origin_x_ = costmap_->getOriginX();
-  saved_origin_y_ = costmap_->getOriginY();
+  saved_origin_x_ = costmap.getOriginX();
+  saved_origin_y_ = costmap.getOriginY();
 
   grid_->data.resize(grid_->info.width * grid_->info.height);
 
-  unsigned char * data = costmap_->getCharMap();
+  unsigned char * data = costmap.getCharMap();
   for (unsigned int i = 0; i < grid_->data.size(); i++) {
     grid_->data[i] = cost_translation_table_[data[i]];
   }
 }
 
-void Costmap2DPublisher::prepareCostmap()
+void Costmap2DPublisher::prepareCostmap(Costmap2D & costmap, const rclcpp::Time & stamp)
 {
-  std::unique_lock<Costmap2D::mutex_t> lock(*(costmap_->getMutex()));
-  double resolution = costmap_->getResolution();
-
-  costmap_raw_ = std::make_unique<nav2_msgs::msg::Costmap>();
+  std::unique_lock<Costmap2D::mutex_t> lock(*(costmap.getMutex()));
+  double resolution = costmap.getResolution();
 
   costmap_raw_->header.frame_id = global_frame_;
-  costmap_raw_->header.stamp = clock_->now();
+  costmap_raw_->header.stamp = stamp;
 
   costmap_raw_->metadata.layer = "master";
   costmap_raw_->metadata.resolution = resolution;
 
-  costmap_raw_->metadata.size_x = costmap_->getSizeInCellsX();
-  costmap_raw_->metadata.size_y = costmap_->getSizeInCellsY();
+  costmap_raw_->metadata.size_x = costmap.getSizeInCellsX();
+  costmap_raw_->metadata.size_y = costmap.getSizeInCellsY();
 
   double wx, wy;
-  costmap_->mapToWorld(0, 0, wx, wy);
+  costmap.mapToWorld(0, 0, wx, wy);
   costmap_raw_->metadata.origin.position.x = wx - resolution / 2;
   costmap_raw_->metadata.origin.position.y = wy - resolution / 2;
   costmap_raw_->metadata.origin.position.z = 0.0;
   costmap_raw_->metadata.origin.orientation.w = 1.0;
 
-  costmap_raw_->data.resize(costmap_raw_->metadata.size_x * costmap_raw_->metadata.size_y);
+  unsigned char * data = costmap.getCharMap();
+  costmap_raw_->data.assign(
+    data, data + costmap_raw_->metadata.size_x * costmap_raw_->metadata.size_y);
+}
 
-  unsigned char * data = costmap_->getCharMap();
-  for (unsigned int i = 0; i < costmap_raw_->data.size(); i++) {
-    costmap_raw_->data[i] = data[i];
+void Costmap2DPublisher::prepareCostmapUpdate(Costmap2D & costmap, const rclcpp::Time & stamp)
+{
+  std::unique_lock<Costmap2D::mutex_t> lock(*(costmap.getMutex()));
+  double resolution = costmap.getResolution();
+  unsigned int size_x = costmap.getSizeInCellsX();
+  unsigned int size_y = costmap.getSizeInCellsY();
+
+  costmap_raw_update_->header.frame_id = global_frame_;
+  costmap_raw_update_->header.stamp = stamp;
+  costmap_raw_update_->seq = update_seq_++;
+
+  costmap_raw_update_->metadata.layer = "master";
+  costmap_raw_update_->metadata.resolution = resolution;
+
+  costmap_raw_update_->metadata.size_x = size_x;
+  costmap_raw_update_->metadata.size_y = size_y;
+
+  double wx, wy;
+  costmap.mapToWorld(0, 0, wx, wy);
+  costmap_raw_update_->metadata.origin.position.x = wx - resolution / 2;
+  costmap_raw_update_->metadata.origin.position.y = wy - resolution / 2;
+  costmap_raw_update_->metadata.origin.position.z = 0.0;
+  costmap_raw_update_->metadata.origin.orientation.w = 1.0;
+
+  // Changes can only be sent against a costmap of the same size and resolution. A
+  // rolling window costmap moves by whole cells, which is sent as a shift.
+  int shift_x = 0, shift_y = 0;
+  const bool keyframe = keyframe_requested_.exchange(false) ||
+    last_raw_.size() != static_cast<size_t>(size_x) * size_y ||
+    last_raw_resolution_ != resolution ||
+    !getCostmapShift(
+    last_raw_origin_x_, last_raw_origin_y_, costmap.getOriginX(), costmap.getOriginY(),
+    resolution, shift_x, shift_y) ||
+    (update_keyframe_period_ != 0 && updates_since_keyframe_ >= update_keyframe_period_);
+
+  unsigned char * data = costmap.getCharMap();
+  if (keyframe) {
+    encodeCostmapKeyframe(data, size_x, size_y, last_raw_, *costmap_raw_update_);
+    last_raw_resolution_ = resolution;
+    last_raw_origin_x_ = costmap.getOriginX();
+    last_raw_origin_y_ = costmap.getOriginY();
+    updates_since_keyframe_ = 0;
+  } else {
+    shiftCostmapData(last_raw_.data(), size_x, size_y, shift_x, shift_y, NO_INFORMATION);
+    encodeCostmapDelta(data, size_x, size_y, last_raw_, *costmap_raw_update_);
+    costmap_raw_update_->shift_x = shift_x;
+    costmap_raw_update_->shift_y = shift_y;
+    last_raw_origin_x_ = costmap.getOriginX();
+    last_raw_origin_y_ = costmap.getOriginY();
+    updates_since_keyframe_++;
+  }
+}
+
+void Costmap2DPublisher::prepareDownsampledGrid(
+  Costmap2D & costmap, const rclcpp::Time & stamp)
+{
+  std::unique_lock<Costmap2D::mutex_t> lock(*(costmap.getMutex()));
+  unsigned int size_x, size_y;
+  downsampleCostmap(
+    costmap.getCharMap(), costmap.getSizeInCellsX(), costmap.getSizeInCellsY(),
+    downsample_factor_, downsampled_, size_x, size_y);
+
+  downsampled_grid_->header.frame_id = global_frame_;
+  downsampled_grid_->header.stamp = stamp;
+
+  downsampled_grid_->info.resolution = costmap.getResolution() * downsample_factor_;
+  downsampled_grid_->info.width = size_x;
+  downsampled_grid_->info.height = size_y;
+  downsampled_grid_->info.origin.position.x = costmap.getOriginX();
+  downsampled_grid_->info.origin.position.y = costmap.getOriginY();
+  downsampled_grid_->info.origin.position.z = 0.0;
+  downsampled_grid_->info.origin.orientation.w = 1.0;
+
+  downsampled_grid_->data.resize(downsampled_.size());
+  for (unsigned int i = 0; i < downsampled_.size(); i++) {
+    downsampled_grid_->data[i] = cost_translation_table_[downsampled_[i]];
   }
 }
 
+bool Costmap2DPublisher::prepareCompressedCostmap(
+  Costmap2D & costmap, const rclcpp::Time & stamp)
+{
+  std::unique_lock<Costmap2D::mutex_t> lock(*(costmap.getMutex()));
+  double resolution = costmap.getResolution();
+
+  costmap_compressed_->header.frame_id = global_frame_;
+  costmap_compressed_->header.stamp = stamp;
+
+  costmap_compressed_->metadata.layer = "master";
+  costmap_compressed_->metadata.resolution = resolution;
+
+  costmap_compressed_->metadata.size_x = costmap.getSizeInCellsX();
+  costmap_compressed_->metadata.size_y = costmap.getSizeInCellsY();
+
+  double wx, wy;
+  costmap.mapToWorld(0, 0, wx, wy);
+  costmap_compressed_->metadata.origin.position.x = wx - resolution / 2;
+  costmap_compressed_->metadata.origin.position.y = wy - resolution / 2;
+  costmap_compressed_->metadata.origin.position.z = 0.0;
+  costmap_compressed_->metadata.origin.orientation.w = 1.0;
+
+  costmap_compressed_->format = compression_format_;
+  return compressCostmap(
+    costmap.getCharMap(), costmap.getSizeInCellsX(), costmap.getSizeInCellsY(),
+    compression_format_, costmap_compressed_->data);
+}
+
+void Costmap2DPublisher::resyncCallback(const std_msgs::msg::Empty::SharedPtr /*msg*/)
+{
+  keyframe_requested_ = true;
+}
+
 void Costmap2DPublisher::publishCostmap()
+{
+  if (!publish_thread_running_) {
+    const auto start = std::chrono::steady_clock::now();
+    publish(*costmap_, x0_, xn_, y0_, yn_, clock_->now());
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    recordPublish(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  } else {
+    // Only the copy delays the caller, the messages are built by the publishing thread
+    copyCostmap(*costmap_, *spare_costmap_);
+    {
+      std::lock_guard<std::mutex> lock(publish_mutex_);
+      if (pending_) {
+        // The publishing thread fell behind, the pending costmap is replaced by this one
+        // and its changes are sent along with those of this one
+        stats_.dropped++;
+        pending_x0_ = std::min(x0_, pending_x0_);
+        pending_xn_ = std::max(xn_, pending_xn_);
+        pending_y0_ = std::min(y0_, pending_y0_);
+        pending_yn_ = std::max(yn_, pending_yn_);
+      } else {
+        pending_x0_ = x0_;
+        pending_xn_ = xn_;
+        pending_y0_ = y0_;
+        pending_yn_ = yn_;
+      }
+      std::swap(spare_costmap_, pending_costmap_);
+      pending_stamp_ = clock_->now();
+      pending_time_ = std::chrono::steady_clock::now();
+      pending_ = true;
+    }
+    publish_cv_.notify_one();
+  }
+
+  xn_ = yn_ = 0;
+  x0_ = costmap_->getSizeInCellsX();
+  y0_ = costmap_->getSizeInCellsY();
+
+  publishDiagnostics();
+}
+
+Costmap2DPublisher::PublishStats Costmap2DPublisher::getPublishStats()
+{
+  std::lock_guard<std::mutex> lock(publish_mutex_);
+  return stats_;
+}
+
+void Costmap2DPublisher::recordPublish(double latency)
+{
+  stats_.published++;
+  stats_.last_latency = latency;
+  stats_.max_latency = std::max(stats_.max_latency, latency);
+}
+
+void Costmap2DPublisher::publishDiagnostics()
+{
+  diagnostics_->publish(
+    [this](diagnostic_msgs::msg::DiagnosticStatus & status) {
+      const PublishStats stats = getPublishStats();
+      status.message = asynchronous_ ? "Publishing asynchronously" : "Publishing synchronously";
+      ThrottledDiagnostics::add(status, "Costmaps published", stats.published);
+      ThrottledDiagnostics::add(status, "Costmaps dropped", stats.dropped);
+      ThrottledDiagnostics::add(status, "Last latency (s)", stats.last_latency);
+      ThrottledDiagnostics::add(status, "Max latency (s)", stats.max_latency);
+    });
+}
+
+void Costmap2DPublisher::startPublishThread()
+{
+  if (publish_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    publish_thread_shutdown_ = false;
+    pending_ = false;
+  }
+  publish_thread_ = std::thread(&Costmap2DPublisher::publishLoop, this);
+  publish_thread_running_ = true;
+}
+
+void Costmap2DPublisher::stopPublishThread()
+{
+  if (!publish_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    publish_thread_shutdown_ = true;
+  }
+  publish_cv_.notify_one();
+  publish_thread_.join();
+  // Costmaps handed off meanwhile are dropped, publishCostmap only publishes itself from
+  // here on
+  publish_thread_running_ = false;
+}
+
+void Costmap2DPublisher::publishLoop()
+{
+  std::unique_lock<std::mutex> lock(publish_mutex_);
+  while (true) {
+    publish_cv_.wait(lock, [this] {return pending_ || publish_thread_shutdown_;});
+    if (publish_thread_shutdown_) {
+      return;
+    }
+
+    std::swap(working_costmap_, pending_costmap_);
+    pending_ = false;
+    const unsigned int x0 = pending_x0_, xn = pending_xn_, y0 = pending_y0_, yn = pending_yn_;
+    const rclcpp::Time stamp = pending_stamp_;
+    const auto handed_off = pending_time_;
+
+    lock.unlock();
+    publish(*working_costmap_, x0, xn, y0, yn, stamp);
+    lock.lock();
+
+    recordPublish(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - handed_off).count());
+  }
+}
+
+void Costmap2DPublisher::publish(
+  Costmap2D & costmap, unsigned int x0, unsigned int xn, unsigned int y0,
+  unsigned int yn, const rclcpp::Time & stamp)
 {
   if (costmap_raw_pub_->get_subscription_count() > 0) {
-    prepareCostmap();
-    costmap_raw_pub_->publish(std::move(costmap_raw_));
+    prepareCostmap(costmap, stamp);
+    costmap_raw_pub_->publish(*costmap_raw_);
   }
-  float resolution = costmap_->getResolution();
+
+  if (costmap_raw_update_pub_->get_subscription_count() > 0) {
+    prepareCostmapUpdate(costmap, stamp);
+    costmap_raw_update_pub_->publish(*costmap_raw_update_);
+  } else {
+    // Start over with a keyframe once there are subscribers again
+    last_raw_.clear();
+  }
+  if (costmap_downsampled_pub_ && costmap_downsampled_pub_->get_subscription_count() > 0) {
+    prepareDownsampledGrid(costmap, stamp);
+    costmap_downsampled_pub_->publish(*downsampled_grid_);
+  }
+
+  if (costmap_compressed_pub_ && costmap_compressed_pub_->get_subscription_count() > 0 &&
+    prepareCompressedCostmap(costmap, stamp))
+  {
+    costmap_compressed_pub_->publish(*costmap_compressed_);
+  }
+
+  float resolution = costmap.getResolution();
 
   if (always_send_full_costmap_ || grid_resolution != resolution ||
-    grid_width != costmap_->getSizeInCellsX() ||
-    grid_height != costmap_->getSizeInCellsY() ||
-    saved_origin_x_ != costmap_->getOriginX() ||
-    saved_origin_y_ != costmap_->getOriginY())
+    grid_width != costmap.getSizeInCellsX() ||
+    grid_height != costmap.getSizeInCellsY() ||
+    saved_origin_x_ != costmap.getOriginX() ||
+    saved_origin_y_ != costmap.getOriginY())
   {
     if (costmap_pub_->get_subscription_count() > 0) {
-      prepareGrid();
-      costmap_pub_->publish(std::move(grid_));
+      prepareGrid(costmap);
+      costmap_pub_->publish(*grid_);
     }
-  } else if (x0_ < xn_) {
+  } else if (x0 < xn) {
     if (costmap_update_pub_->get_subscription_count() > 0) {
-      std::unique_lock<Costmap2D::mutex_t> lock(*(costmap_->getMutex()));
+      std::unique_lock<Costmap2D::mutex_t> lock(*(costmap.getMutex()));
       // Publish Just an Update
-      auto update = std::make_unique<map_msgs::msg::OccupancyGridUpdate>();
-      update->header.stamp = rclcpp::Time();
-      update->header.frame_id = global_frame_;
-      update->x = x0_;
-      update->y = y0_;
-      update->width = xn_ - x0_;
-      update->height = yn_ - y0_;
-      update->data.resize(update->width * update->height);
+      grid_update_->header.stamp = rclcpp::Time();
+      grid_update_->header.frame_id = global_frame_;
+      grid_update_->x = x0;
+      grid_update_->y = y0;
+      grid_update_->width = xn - x0;
+      grid_update_->height = yn - y0;
+      grid_update_->data.resize(grid_update_->width * grid_update_->height);
       unsigned int i = 0;
-      for (unsigned int y = y0_; y < yn_; y++) {
-        for (unsigned int x = x0_; x < xn_; x++) {
-          unsigned char cost = costmap_->getCost(x, y);
-          update->data[i++] = cost_translation_table_[cost];
+      for (unsigned int y = y0; y < yn; y++) {
+        for (unsigned int x = x0; x < xn; x++) {
+          unsigned char cost = costmap.getCost(x, y);
+          grid_update_->data[i++] = cost_translation_table_[cost];
         }
       }
-      costmap_update_pub_->publish(std::move(update));
+      costmap_update_pub_->publish(*grid_update_);
     }
   }
-
-  xn_ = yn_ = 0;
-  x0_ = costmap_->getSizeInCellsX();
-  y0_ = costmap_->getSizeInCellsY();
 }
 
 void
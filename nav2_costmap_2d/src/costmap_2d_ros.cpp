@@ -38,6 +38,8 @@
 
 #include "nav2_costmap_2d/costmap_2d_ros.hpp"
 
+#include <algorithm>
+#include <cinttypes>
 #include <memory>
 #include <chrono>
 #include <string>
@@ -50,6 +52,7 @@
 #include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
 #include "tf2_ros/create_timer_ros.h"
 #include "nav2_util/robot_utils.hpp"
+#include "rclcpp/expand_topic_or_service_name.hpp"
 
 using namespace std::chrono_literals;
 
@@ -88,6 +91,8 @@ Costmap2DROS::Costmap2DROS(
   std::vector<std::string> clearable_layers{"obstacle_layer", "voxel_layer", "range_layer"};
 
   declare_parameter("always_send_full_costmap", rclcpp::ParameterValue(false));
+  declare_parameter("asynchronous_publishing", rclcpp::ParameterValue(true));
+  declare_parameter("double_buffered", rclcpp::ParameterValue(false));
   declare_parameter("footprint_padding", rclcpp::ParameterValue(0.01f));
   declare_parameter("footprint", rclcpp::ParameterValue(std::string("[]")));
   declare_parameter("global_frame", rclcpp::ParameterValue(std::string("map")));
@@ -103,6 +108,9 @@ Costmap2DROS::Costmap2DROS(
   declare_parameter("plugins", rclcpp::ParameterValue(default_plugins_));
   declare_parameter("filters", rclcpp::ParameterValue(std::vector<std::string>()));
   declare_parameter("publish_frequency", rclcpp::ParameterValue(1.0));
+  declare_parameter("publish_downsample_factor", rclcpp::ParameterValue(0));
+  declare_parameter("publish_compression_format", rclcpp::ParameterValue(std::string("")));
+  declare_parameter("raw_update_keyframe_period", rclcpp::ParameterValue(20));
   declare_parameter("resolution", rclcpp::ParameterValue(0.1));
   declare_parameter("robot_base_frame", rclcpp::ParameterValue(std::string("base_link")));
   declare_parameter("robot_radius", rclcpp::ParameterValue(0.1));
@@ -112,6 +120,8 @@ Costmap2DROS::Costmap2DROS(
   declare_parameter("trinary_costmap", rclcpp::ParameterValue(true));
   declare_parameter("unknown_cost_value", rclcpp::ParameterValue(static_cast<unsigned char>(0xff)));
   declare_parameter("update_frequency", rclcpp::ParameterValue(5.0));
+  declare_parameter("update_threads", rclcpp::ParameterValue(1));
+  declare_parameter("update_tile_size", rclcpp::ParameterValue(128));
   declare_parameter("use_maximum", rclcpp::ParameterValue(false));
   declare_parameter("clearable_layers", rclcpp::ParameterValue(clearable_layers));
 }
@@ -129,6 +139,8 @@ Costmap2DROS::on_configure(const rclcpp_lifecycle::State & /*state*/)
   // Create the costmap itself
   layered_costmap_ = std::make_unique<LayeredCostmap>(
     global_frame_, rolling_window_, track_unknown_space_);
+  layered_costmap_->setTiling(
+    static_cast<unsigned int>(std::max(update_tile_size_, 0)), update_threads_);
 
   if (!layered_costmap_->isSizeLocked()) {
     layered_costmap_->resizeMap(
@@ -184,7 +196,13 @@ Costmap2DROS::on_configure(const rclcpp_lifecycle::State & /*state*/)
   costmap_publisher_ = std::make_unique<Costmap2DPublisher>(
     shared_from_this(),
     layered_costmap_->getCostmap(), global_frame_,
-    "costmap", always_send_full_costmap_);
+    "costmap", always_send_full_costmap_,
+    static_cast<unsigned int>(std::max(raw_update_keyframe_period_, 0)),
+    asynchronous_publishing_,
+    static_cast<unsigned int>(std::max(publish_downsample_factor_, 0)),
+    publish_compression_format_);
+  shared_costmap_ = SharedCostmap::advertise(
+    rclcpp::expand_topic_or_service_name("costmap_raw", get_name(), get_namespace()));
 
   // Set the footprint
   if (use_radius_) {
@@ -279,6 +297,7 @@ Costmap2DROS::on_cleanup(const rclcpp_lifecycle::State & /*state*/)
   footprint_pub_.reset();
 
   costmap_publisher_.reset();
+  shared_costmap_.reset();
   clear_costmap_service_.reset();
 
   return nav2_util::CallbackReturn::SUCCESS;
@@ -298,6 +317,8 @@ Costmap2DROS::getParameters()
 
   // Get all of the required parameters
   get_parameter("always_send_full_costmap", always_send_full_costmap_);
+  get_parameter("asynchronous_publishing", asynchronous_publishing_);
+  get_parameter("double_buffered", double_buffered_);
   get_parameter("footprint", footprint_);
   get_parameter("footprint_padding", footprint_padding_);
   get_parameter("global_frame", global_frame_);
@@ -305,6 +326,9 @@ Costmap2DROS::getParameters()
   get_parameter("origin_x", origin_x_);
   get_parameter("origin_y", origin_y_);
   get_parameter("publish_frequency", map_publish_frequency_);
+  get_parameter("publish_downsample_factor", publish_downsample_factor_);
+  get_parameter("publish_compression_format", publish_compression_format_);
+  get_parameter("raw_update_keyframe_period", raw_update_keyframe_period_);
   get_parameter("resolution", resolution_);
   get_parameter("robot_base_frame", robot_base_frame_);
   get_parameter("robot_radius", robot_radius_);
@@ -312,6 +336,8 @@ Costmap2DROS::getParameters()
   get_parameter("track_unknown_space", track_unknown_space_);
   get_parameter("transform_tolerance", transform_tolerance_);
   get_parameter("update_frequency", map_update_frequency_);
+  get_parameter("update_threads", update_threads_);
+  get_parameter("update_tile_size", update_tile_size_);
   get_parameter("width", map_width_meters_);
   get_parameter("plugins", plugin_names_);
   get_parameter("filters", filter_names_);
@@ -413,6 +439,15 @@ Costmap2DROS::mapUpdateLoop(double frequency)
     timer.end();
 
     RCLCPP_DEBUG(get_logger(), "Map update time: %.9f", timer.elapsed_time_in_seconds());
+    RCLCPP_DEBUG(
+      get_logger(), "  waited %.9f for the costmap lock", layered_costmap_->getUpdateLockWait());
+    for (const auto & timing : layered_costmap_->getUpdateTimings()) {
+      const auto & tiles = timing.tile_durations;
+      RCLCPP_DEBUG(
+        get_logger(), "  %s update time: %.9f over %zu tiles (slowest %.9f)",
+        timing.name.c_str(), timing.duration, tiles.size(),
+        tiles.empty() ? 0.0 : *std::max_element(tiles.begin(), tiles.end()));
+    }
     if (publish_cycle_ > rclcpp::Duration(0s) && layered_costmap_->isInitialized()) {
       unsigned int x0, y0, xn, yn;
       layered_costmap_->getBounds(&x0, &xn, &y0, &yn);
@@ -425,6 +460,12 @@ Costmap2DROS::mapUpdateLoop(double frequency)
         RCLCPP_DEBUG(get_logger(), "Publish costmap at %s", name_.c_str());
         costmap_publisher_->publishCostmap();
         last_publish_ = current_time;
+
+        const auto stats = costmap_publisher_->getPublishStats();
+        RCLCPP_DEBUG(
+          get_logger(),
+          "Costmaps published: %" PRIu64 ", dropped: %" PRIu64 ", last latency: %.9f (max %.9f)",
+          stats.published, stats.dropped, stats.last_latency, stats.max_latency);
       }
     }
 
@@ -457,6 +498,14 @@ Costmap2DROS::updateMap()
       const double yaw = tf2::getYaw(pose.pose.orientation);
       layered_costmap_->updateMap(x, y, yaw);
 
+      // Only copy the costmap if double buffered or a consumer in this process
+      // holds the shared costmap
+      if (double_buffered_ || shared_costmap_.use_count() > 1) {
+        double lock_wait =
+          shared_costmap_->publish(*layered_costmap_->getCostmap(), global_frame_, now());
+        RCLCPP_DEBUG(get_logger(), "Snapshot waited %.9f for the costmap lock", lock_wait);
+      }
+
       auto footprint = std::make_unique<geometry_msgs::msg::PolygonStamped>();
       footprint->header.frame_id = global_frame_;
       footprint->header.stamp = now();
@@ -469,6 +518,21 @@ Costmap2DROS::updateMap()
   }
 }
 
+std::shared_ptr<const Costmap2D>
+Costmap2DROS::getCostmapSnapshot()
+{
+  if (!double_buffered_ || !shared_costmap_) {
+    return nullptr;
+  }
+
+  auto snapshot = shared_costmap_->getSnapshot();
+  if (!snapshot) {
+    return nullptr;
+  }
+  // The costmap keeps the whole snapshot alive
+  return std::shared_ptr<const Costmap2D>(snapshot, &snapshot->costmap);
+}
+
 void
 Costmap2DROS::start()
 {
@@ -0,0 +1,304 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include "nav2_costmap_2d/costmap_compression.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace nav2_costmap_2d
+{
+
+namespace
+{
+
+const uint8_t png_signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+void appendUint32(std::vector<uint8_t> & data, uint32_t value)
+{
+  data.push_back(static_cast<uint8_t>(value >> 24));
+  data.push_back(static_cast<uint8_t>(value >> 16));
+  data.push_back(static_cast<uint8_t>(value >> 8));
+  data.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t readUint32(const uint8_t * data)
+{
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+// Append a PNG chunk: its length, type, payload and the CRC of its type and payload
+void appendChunk(
+  std::vector<uint8_t> & data, const char * type, const uint8_t * payload, uint32_t length)
+{
+  appendUint32(data, length);
+  const std::size_t start = data.size();
+  data.insert(data.end(), type, type + 4);
+  data.insert(data.end(), payload, payload + length);
+  appendUint32(data, crc32(0, data.data() + start, 4 + length));
+}
+
+bool compressPng(
+  const unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  std::vector<uint8_t> & data)
+{
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+    return false;
+  }
+
+  data.assign(png_signature, png_signature + 8);
+
+  // 8 bit grayscale, no interlacing
+  uint8_t header[13];
+  const uint32_t dimensions[2] = {size_x, size_y};
+  for (unsigned int i = 0; i != 2; i++) {
+    header[4 * i] = static_cast<uint8_t>(dimensions[i] >> 24);
+    header[4 * i + 1] = static_cast<uint8_t>(dimensions[i] >> 16);
+    header[4 * i + 2] = static_cast<uint8_t>(dimensions[i] >> 8);
+    header[4 * i + 3] = static_cast<uint8_t>(dimensions[i]);
+  }
+  header[8] = 8;
+  header[9] = 0;
+  header[10] = 0;
+  header[11] = 0;
+  header[12] = 0;
+  appendChunk(data, "IHDR", header, sizeof(header));
+
+  // The image data is deflated straight into a single IDAT chunk, sized for the worst
+  // case, a row at a time behind its filter type byte so no scratch copy is needed
+  const std::size_t chunk = data.size();
+  const uLong bound = deflateBound(&stream, static_cast<uLong>(size_x + 1) * size_y);
+  data.resize(chunk + 8 + bound);
+  std::memcpy(&data[chunk + 4], "IDAT", 4);
+  stream.next_out = &data[chunk + 8];
+  stream.avail_out = static_cast<uInt>(bound);
+
+  // Filter type none: costmaps are mostly runs, which deflate handles well already
+  Bytef filter = 0;
+  bool ok = true;
+  for (unsigned int j = 0; j < size_y && ok; j++) {
+    stream.next_in = &filter;
+    stream.avail_in = 1;
+    ok = deflate(&stream, Z_NO_FLUSH) == Z_OK;
+    stream.next_in = const_cast<Bytef *>(costmap + static_cast<std::size_t>(j) * size_x);
+    stream.avail_in = size_x;
+    ok = ok && deflate(&stream, Z_NO_FLUSH) == Z_OK;
+  }
+  ok = ok && deflate(&stream, Z_FINISH) == Z_STREAM_END;
+  const uint32_t length = static_cast<uint32_t>(stream.total_out);
+  deflateEnd(&stream);
+  if (!ok) {
+    return false;
+  }
+
+  data.resize(chunk + 8 + length);
+  data[chunk] = static_cast<uint8_t>(length >> 24);
+  data[chunk + 1] = static_cast<uint8_t>(length >> 16);
+  data[chunk + 2] = static_cast<uint8_t>(length >> 8);
+  data[chunk + 3] = static_cast<uint8_t>(length);
+  appendUint32(data, crc32(0, &data[chunk + 4], 4 + length));
+
+  appendChunk(data, "IEND", nullptr, 0);
+  return true;
+}
+
+// Undo the filter of a PNG row in place, given the row before it, already unfiltered
+bool unfilterRow(uint8_t filter, uint8_t * row, const uint8_t * previous, unsigned int size)
+{
+  switch (filter) {
+    case 0:
+      return true;
+    case 1:
+      for (unsigned int i = 1; i < size; i++) {
+        row[i] += row[i - 1];
+      }
+      return true;
+    case 2:
+      for (unsigned int i = 0; i < size; i++) {
+        row[i] += previous[i];
+      }
+      return true;
+    case 3:
+      for (unsigned int i = 0; i < size; i++) {
+        const int left = i > 0 ? row[i - 1] : 0;
+        row[i] += static_cast<uint8_t>((left + previous[i]) / 2);
+      }
+      return true;
+    case 4:
+      for (unsigned int i = 0; i < size; i++) {
+        const int a = i > 0 ? row[i - 1] : 0;
+        const int b = previous[i];
+        const int c = i > 0 ? previous[i - 1] : 0;
+        const int p = a + b - c;
+        const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        row[i] += static_cast<uint8_t>(pa <= pb && pa <= pc ? a : (pb <= pc ? b : c));
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool decompressPng(
+  const std::vector<uint8_t> & data, unsigned int size_x, unsigned int size_y,
+  std::vector<unsigned char> & costmap)
+{
+  if (data.size() < 8 || std::memcmp(data.data(), png_signature, 8) != 0) {
+    return false;
+  }
+
+  // Gather the image data of the IDAT chunks
+  std::vector<uint8_t> deflated;
+  bool header_ok = false;
+  std::size_t offset = 8;
+  while (offset + 12 <= data.size()) {
+    const uint32_t length = readUint32(&data[offset]);
+    if (length > data.size() - offset - 12) {
+      return false;
+    }
+    const uint8_t * type = &data[offset + 4];
+    const uint8_t * payload = &data[offset + 8];
+    if (std::memcmp(type, "IHDR", 4) == 0) {
+      header_ok = length == 13 && readUint32(payload) == size_x &&
+        readUint32(payload + 4) == size_y && payload[8] == 8 && payload[9] == 0 &&
+        payload[12] == 0;
+    } else if (std::memcmp(type, "IDAT", 4) == 0) {
+      deflated.insert(deflated.end(), payload, payload + length);
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      break;
+    }
+    offset += 12 + length;
+  }
+  if (!header_ok) {
+    return false;
+  }
+
+  const std::size_t row_size = static_cast<std::size_t>(size_x) + 1;
+  std::vector<uint8_t> rows(row_size * size_y);
+  uLongf rows_length = static_cast<uLongf>(rows.size());
+  if (uncompress(rows.data(), &rows_length, deflated.data(), deflated.size()) != Z_OK ||
+    rows_length != rows.size())
+  {
+    return false;
+  }
+
+  costmap.resize(static_cast<std::size_t>(size_x) * size_y);
+  std::vector<uint8_t> zeros(size_x, 0);
+  const uint8_t * previous = zeros.data();
+  for (unsigned int j = 0; j < size_y; j++) {
+    uint8_t * row = &rows[j * row_size];
+    if (!unfilterRow(row[0], row + 1, previous, size_x)) {
+      return false;
+    }
+    std::memcpy(&costmap[static_cast<std::size_t>(j) * size_x], row + 1, size_x);
+    previous = row + 1;
+  }
+  return true;
+}
+
+}  // namespace
+
+void downsampleCostmap(
+  const unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  unsigned int factor, std::vector<unsigned char> & downsampled,
+  unsigned int & downsampled_x, unsigned int & downsampled_y)
+{
+  factor = std::max(factor, 1u);
+  downsampled_x = (size_x + factor - 1) / factor;
+  downsampled_y = (size_y + factor - 1) / factor;
+
+  // Costs are pooled shifted up by one, so unknown wraps around to the lowest value
+  // and a plain maximum prefers any known cost over it
+  downsampled.assign(static_cast<std::size_t>(downsampled_x) * downsampled_y, 0);
+  for (unsigned int j = 0; j < size_y; j++) {
+    const unsigned char * row = costmap + static_cast<std::size_t>(j) * size_x;
+    unsigned char * pooled = &downsampled[static_cast<std::size_t>(j / factor) * downsampled_x];
+    for (unsigned int i = 0; i < downsampled_x; i++) {
+      const unsigned int end = std::min((i + 1) * factor, size_x);
+      unsigned char key = pooled[i];
+      for (unsigned int k = i * factor; k < end; k++) {
+        key = std::max(key, static_cast<unsigned char>(row[k] + 1));
+      }
+      pooled[i] = key;
+    }
+  }
+  for (unsigned char & cost : downsampled) {
+    cost = static_cast<unsigned char>(cost - 1);
+  }
+}
+
+bool isCompressionFormatSupported(const std::string & format)
+{
+  return format == "png" || format == "zlib";
+}
+
+bool compressCostmap(
+  const unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  const std::string & format, std::vector<uint8_t> & data)
+{
+  if (size_x == 0 || size_y == 0) {
+    return false;
+  }
+
+  if (format == "png") {
+    return compressPng(costmap, size_x, size_y, data);
+  }
+
+  if (format == "zlib") {
+    const uLong size = static_cast<uLong>(size_x) * size_y;
+    uLongf length = compressBound(size);
+    data.resize(length);
+    if (compress2(data.data(), &length, costmap, size, Z_DEFAULT_COMPRESSION) != Z_OK) {
+      return false;
+    }
+    data.resize(length);
+    return true;
+  }
+
+  return false;
+}
+
+bool decompressCostmap(
+  const nav2_msgs::msg::CompressedCostmap & msg, std::vector<unsigned char> & costmap)
+{
+  const unsigned int size_x = msg.metadata.size_x;
+  const unsigned int size_y = msg.metadata.size_y;
+  if (size_x == 0 || size_y == 0) {
+    return false;
+  }
+
+  if (msg.format == "png") {
+    return decompressPng(msg.data, size_x, size_y, costmap);
+  }
+
+  if (msg.format == "zlib") {
+    costmap.resize(static_cast<std::size_t>(size_x) * size_y);
+    uLongf length = static_cast<uLongf>(costmap.size());
+    return uncompress(costmap.data(), &length, msg.data.data(), msg.data.size()) == Z_OK &&
+           length == costmap.size();
+  }
+
+  return false;
+}
+
+}  // namespace nav2_costmap_2d
@@ -0,0 +1,196 @@
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "nav2_costmap_2d/costmap_delta.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "nav2_costmap_2d/cost_values.hpp"
+
+namespace nav2_costmap_2d
+{
+
+// Runs separated by fewer unchanged cells than this are merged, since the start
+// and length of a run take as many bytes as the cells in between
+static constexpr unsigned int merge_gap = 8;
+
+void encodeCostmapKeyframe(
+  const unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  std::vector<unsigned char> & last, nav2_msgs::msg::CostmapUpdate & update)
+{
+  const unsigned int size = size_x * size_y;
+  last.assign(costmap, costmap + size);
+
+  update.keyframe = true;
+  update.shift_x = 0;
+  update.shift_y = 0;
+  update.run_starts.assign(1, 0);
+  update.run_lengths.assign(1, size);
+  update.data.assign(costmap, costmap + size);
+}
+
+void encodeCostmapDelta(
+  const unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  std::vector<unsigned char> & last, nav2_msgs::msg::CostmapUpdate & update)
+{
+  update.keyframe = false;
+  update.shift_x = 0;
+  update.shift_y = 0;
+  update.run_starts.clear();
+  update.run_lengths.clear();
+  update.data.clear();
+
+  for (unsigned int j = 0; j < size_y; j++) {
+    const unsigned char * row = costmap + j * size_x;
+    unsigned char * last_row = last.data() + j * size_x;
+    if (std::memcmp(row, last_row, size_x) == 0) {
+      continue;
+    }
+
+    unsigned int i = 0;
+    while (i < size_x) {
+      if (row[i] == last_row[i]) {
+        i++;
+        continue;
+      }
+
+      // Extend the run until merge_gap unchanged cells in a row, or the end of the row
+      const unsigned int start = i;
+      unsigned int end = i + 1;
+      for (unsigned int k = end; k < size_x && k < end + merge_gap; k++) {
+        if (row[k] != last_row[k]) {
+          end = k + 1;
+        }
+      }
+
+      update.run_starts.push_back(j * size_x + start);
+      update.run_lengths.push_back(end - start);
+      update.data.insert(update.data.end(), row + start, row + end);
+      std::copy(row + start, row + end, last_row + start);
+      i = end;
+    }
+  }
+}
+
+bool getCostmapShift(
+  double old_origin_x, double old_origin_y, double new_origin_x, double new_origin_y,
+  double resolution, int & shift_x, int & shift_y)
+{
+  const double cells_x = (new_origin_x - old_origin_x) / resolution;
+  const double cells_y = (new_origin_y - old_origin_y) / resolution;
+  if (!(std::fabs(cells_x) < 1e9 && std::fabs(cells_y) < 1e9)) {
+    return false;
+  }
+  shift_x = static_cast<int>(std::lround(cells_x));
+  shift_y = static_cast<int>(std::lround(cells_y));
+  // updateOrigin keeps the costmap aligned with its grid, up to rounding
+  return std::fabs(cells_x - shift_x) < 1e-3 && std::fabs(cells_y - shift_y) < 1e-3;
+}
+
+void shiftCostmapData(
+  unsigned char * costmap, unsigned int size_x, unsigned int size_y,
+  int shift_x, int shift_y, unsigned char fill)
+{
+  const int width = static_cast<int>(size_x);
+  const int height = static_cast<int>(size_y);
+  if (std::abs(shift_x) >= width || std::abs(shift_y) >= height) {
+    std::memset(costmap, fill, size_x * size_y);
+    return;
+  }
+
+  // Columns kept, where they come from and where they go
+  const int kept = width - std::abs(shift_x);
+  const int from_x = std::max(shift_x, 0);
+  const int to_x = std::max(-shift_x, 0);
+  for (int n = 0; n < height; n++) {
+    // Rows are read before they are overwritten
+    const int j = shift_y > 0 ? n : height - 1 - n;
+    unsigned char * row = costmap + j * size_x;
+    const int from_j = j + shift_y;
+    if (from_j < 0 || from_j >= height) {
+      std::memset(row, fill, size_x);
+      continue;
+    }
+    std::memmove(row + to_x, costmap + from_j * size_x + from_x, kept);
+    std::memset(row, fill, to_x);
+    std::memset(row + to_x + kept, fill, width - to_x - kept);
+  }
+}
+
+bool applyCostmapUpdate(const nav2_msgs::msg::CostmapUpdate & update, Costmap2D & costmap)
+{
+  const auto & metadata = update.metadata;
+  if (!update.keyframe &&
+    (costmap.getSizeInCellsX() != metadata.size_x ||
+    costmap.getSizeInCellsY() != metadata.size_y))
+  {
+    return false;
+  }
+
+  // Check every run before writing any, so a malformed update leaves the costmap as is
+  const uint64_t size = static_cast<uint64_t>(metadata.size_x) * metadata.size_y;
+  if (update.run_starts.size() != update.run_lengths.size()) {
+    return false;
+  }
+  uint64_t total = 0;
+  for (unsigned int r = 0; r < update.run_starts.size(); r++) {
+    if (static_cast<uint64_t>(update.run_starts[r]) + update.run_lengths[r] > size) {
+      return false;
+    }
+    total += update.run_lengths[r];
+  }
+  if (total != update.data.size() || (update.keyframe && total != size)) {
+    return false;
+  }
+
+  if (update.keyframe &&
+    (costmap.getSizeInCellsX() != metadata.size_x ||
+    costmap.getSizeInCellsY() != metadata.size_y ||
+    costmap.getResolution() != metadata.resolution ||
+    costmap.getOriginX() != metadata.origin.position.x ||
+    costmap.getOriginY() != metadata.origin.position.y))
+  {
+    costmap.resizeMap(
+      metadata.size_x, metadata.size_y, metadata.resolution,
+      metadata.origin.position.x, metadata.origin.position.y);
+  }
+
+  if (!update.keyframe && (update.shift_x != 0 || update.shift_y != 0)) {
+    // The costmap is moved rather than resent, only the newly exposed cells and the
+    // changes are in the runs
+    std::vector<unsigned char> shifted(costmap.getCharMap(), costmap.getCharMap() + size);
+    shiftCostmapData(
+      shifted.data(), metadata.size_x, metadata.size_y, update.shift_x, update.shift_y,
+      NO_INFORMATION);
+    costmap.resizeMap(
+      metadata.size_x, metadata.size_y, metadata.resolution,
+      metadata.origin.position.x, metadata.origin.position.y);
+    std::memcpy(costmap.getCharMap(), shifted.data(), size);
+  }
+
+  unsigned char * master = costmap.getCharMap();
+  const unsigned char * data = update.data.data();
+  for (unsigned int r = 0; r < update.run_starts.size(); r++) {
+    std::memcpy(master + update.run_starts[r], data, update.run_lengths[r]);
+    data += update.run_lengths[r];
+  }
+  return true;
+}
+
+}  // namespace nav2_costmap_2d
@@ -39,10 +39,204 @@
 #include <nav2_costmap_2d/costmap_layer.hpp>
 #include <stdexcept>
 #include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NAV2_COSTMAP_2D_X86_SIMD
+#endif
 
 namespace nav2_costmap_2d
 {
 
+namespace
+{
+
+// Kernels combining a row of n layer cells into the master grid, as in the
+// update modes of the same name
+
+void overwriteScalar(const unsigned char * layer, unsigned char * master, unsigned int n)
+{
+  for (unsigned int i = 0; i != n; ++i) {
+    if (layer[i] != NO_INFORMATION) {
+      master[i] = layer[i];
+    }
+  }
+}
+
+void maxScalar(const unsigned char * layer, unsigned char * master, unsigned int n)
+{
+  for (unsigned int i = 0; i != n; ++i) {
+    if (layer[i] == NO_INFORMATION) {
+      continue;
+    }
+    if (master[i] == NO_INFORMATION || master[i] < layer[i]) {
+      master[i] = layer[i];
+    }
+  }
+}
+
+void additionScalar(const unsigned char * layer, unsigned char * master, unsigned int n)
+{
+  for (unsigned int i = 0; i != n; ++i) {
+    if (layer[i] == NO_INFORMATION) {
+      continue;
+    }
+    if (master[i] == NO_INFORMATION) {
+      master[i] = layer[i];
+    } else {
+      int sum = master[i] + layer[i];
+      if (sum >= INSCRIBED_INFLATED_OBSTACLE) {
+        master[i] = INSCRIBED_INFLATED_OBSTACLE - 1;
+      } else {
+        master[i] = sum;
+      }
+    }
+  }
+}
+
+#ifdef NAV2_COSTMAP_2D_X86_SIMD
+
+// The modes are branch free as masks of the NO_INFORMATION cells of either grid:
+// unknown layer cells keep the master cell, unknown master cells take the layer cell.
+// Sums saturate at 255 and are then clamped below INSCRIBED_INFLATED_OBSTACLE.
+
+__attribute__((target("sse2")))
+inline __m128i select128(__m128i mask, __m128i if_set, __m128i if_clear)
+{
+  return _mm_or_si128(_mm_and_si128(mask, if_set), _mm_andnot_si128(mask, if_clear));
+}
+
+__attribute__((target("sse2")))
+void overwriteSse2(const unsigned char * layer, unsigned char * master, unsigned int n)
+{
+  const __m128i unknown = _mm_set1_epi8(static_cast<char>(NO_INFORMATION));
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(layer + i));
+    const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(master + i));
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i *>(master + i), select128(_mm_cmpeq_epi8(l, unknown), m, l));
+  }
+  overwriteScalar(layer + i, master + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void maxSse2(const unsigned char * layer, unsigned char * master, unsigned int n)
+{
+  const __m128i unknown = _mm_set1_epi8(static_cast<char>(NO_INFORMATION));
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(layer + i));
+    const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(master + i));
+    const __m128i combined = select128(_mm_cmpeq_epi8(m, unknown), l, _mm_max_epu8(l, m));
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i *>(master + i),
+      select128(_mm_cmpeq_epi8(l, unknown), m, combined));
+  }
+  maxScalar(layer + i, master + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void additionSse2(const unsigned char * layer, unsigned char * master, unsigned int n)
+{
+  const __m128i unknown = _mm_set1_epi8(static_cast<char>(NO_INFORMATION));
+  const __m128i ceiling = _mm_set1_epi8(static_cast<char>(INSCRIBED_INFLATED_OBSTACLE - 1));
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(layer + i));
+    const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(master + i));
+    const __m128i sum = _mm_min_epu8(_mm_adds_epu8(l, m), ceiling);
+    const __m128i combined = select128(_mm_cmpeq_epi8(m, unknown), l, sum);
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i *>(master + i),
+      select128(_mm_cmpeq_epi8(l, unknown), m, combined));
+  }
+  additionScalar(layer + i, master + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void overwriteAvx2(const unsigned char * layer, unsigned char * master, unsigned int n)
+{
+  const __m256i unknown = _mm256_set1_epi8(static_cast<char>(NO_INFORMATION));
+  unsigned int i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(layer + i));
+    const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(master + i));
+    _mm256_storeu_si256(
+      reinterpret_cast<__m256i *>(master + i),
+      _mm256_blendv_epi8(l, m, _mm256_cmpeq_epi8(l, unknown)));
+  }
+  overwriteScalar(layer + i, master + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void maxAvx2(const unsigned char * layer, unsigned char * master, unsigned int n)
+{
+  const __m256i unknown = _mm256_set1_epi8(static_cast<char>(NO_INFORMATION));
+  unsigned int i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(layer + i));
+    const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(master + i));
+    const __m256i combined =
+      _mm256_blendv_epi8(_mm256_max_epu8(l, m), l, _mm256_cmpeq_epi8(m, unknown));
+    _mm256_storeu_si256(
+      reinterpret_cast<__m256i *>(master + i),
+      _mm256_blendv_epi8(combined, m, _mm256_cmpeq_epi8(l, unknown)));
+  }
+  maxScalar(layer + i, master + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void additionAvx2(const unsigned char * layer, unsigned char * master, unsigned int n)
+{
+  const __m256i unknown = _mm256_set1_epi8(static_cast<char>(NO_INFORMATION));
+  const __m256i ceiling = _mm256_set1_epi8(static_cast<char>(INSCRIBED_INFLATED_OBSTACLE - 1));
+  unsigned int i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(layer + i));
+    const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(master + i));
+    const __m256i sum = _mm256_min_epu8(_mm256_adds_epu8(l, m), ceiling);
+    const __m256i combined = _mm256_blendv_epi8(sum, l, _mm256_cmpeq_epi8(m, unknown));
+    _mm256_storeu_si256(
+      reinterpret_cast<__m256i *>(master + i),
+      _mm256_blendv_epi8(combined, m, _mm256_cmpeq_epi8(l, unknown)));
+  }
+  additionScalar(layer + i, master + i, n - i);
+}
+
+#endif  // NAV2_COSTMAP_2D_X86_SIMD
+
+struct CombineKernels
+{
+  void (* overwrite)(const unsigned char *, unsigned char *, unsigned int);
+  void (* max)(const unsigned char *, unsigned char *, unsigned int);
+  void (* addition)(const unsigned char *, unsigned char *, unsigned int);
+};
+
+CombineKernels selectCombineKernels()
+{
+#ifdef NAV2_COSTMAP_2D_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {overwriteAvx2, maxAvx2, additionAvx2};
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return {overwriteSse2, maxSse2, additionSse2};
+  }
+#endif
+  return {overwriteScalar, maxScalar, additionScalar};
+}
+
+// Selected once, for the CPU we are running on
+const CombineKernels & combineKernels()
+{
+  static const CombineKernels kernels = selectCombineKernels();
+  return kernels;
+}
+
+}  // namespace
+
 void CostmapLayer::touch(
   double x, double y, double * min_x, double * min_y, double * max_x,
   double * max_y)
@@ -115,23 +309,17 @@ void CostmapLayer::updateWithMax(
     return;
   }
 
+  if (max_i <= min_i) {
+    return;
+  }
+
   unsigned char * master_array = master_grid.getCharMap();
   unsigned int span = master_grid.getSizeInCellsX();
+  const auto & kernels = combineKernels();
 
   for (int j = min_j; j < max_j; j++) {
     unsigned int it = j * span + min_i;
-    for (int i = min_i; i < max_i; i++) {
-      if (costmap_[it] == NO_INFORMATION) {
-        it++;
-        continue;
-      }
-
-      unsigned char old_cost = master_array[it];
-      if (old_cost == NO_INFORMATION || old_cost < costmap_[it]) {
-        master_array[it] = costmap_[it];
-      }
-      it++;
-    }
+    kernels.max(costmap_ + it, master_array + it, max_i - min_i);
   }
 }
 
@@ -149,15 +337,16 @@ void CostmapLayer::updateWithTrueOverwrite(
     throw std::runtime_error("Can't update costmap layer: It has't been initialized yet!");
   }
 
+  if (max_i <= min_i) {
+    return;
+  }
+
   unsigned char * master = master_grid.getCharMap();
   unsigned int span = master_grid.getSizeInCellsX();
 
   for (int j = min_j; j < max_j; j++) {
     unsigned int it = span * j + min_i;
-    for (int i = min_i; i < max_i; i++) {
-      master[it] = costmap_[it];
-      it++;
-    }
+    std::memcpy(master + it, costmap_ + it, max_i - min_i);
   }
 }
 
@@ -168,17 +357,17 @@ void CostmapLayer::updateWithOverwrite(
   if (!enabled_) {
     return;
   }
+  if (max_i <= min_i) {
+    return;
+  }
+
   unsigned char * master = master_grid.getCharMap();
   unsigned int span = master_grid.getSizeInCellsX();
+  const auto & kernels = combineKernels();
 
   for (int j = min_j; j < max_j; j++) {
     unsigned int it = span * j + min_i;
-    for (int i = min_i; i < max_i; i++) {
-      if (costmap_[it] != NO_INFORMATION) {
-        master[it] = costmap_[it];
-      }
-      it++;
-    }
+    kernels.overwrite(costmap_ + it, master + it, max_i - min_i);
   }
 }
 
@@ -189,30 +378,17 @@ void CostmapLayer::updateWithAddition(
   if (!enabled_) {
     return;
   }
+  if (max_i <= min_i) {
+    return;
+  }
+
   unsigned char * master_array = master_grid.getCharMap();
   unsigned int span = master_grid.getSizeInCellsX();
+  const auto & kernels = combineKernels();
 
   for (int j = min_j; j < max_j; j++) {
     unsigned int it = j * span + min_i;
-    for (int i = min_i; i < max_i; i++) {
-      if (costmap_[it] == NO_INFORMATION) {
-        it++;
-        continue;
-      }
-
-      unsigned char old_cost = master_array[it];
-      if (old_cost == NO_INFORMATION) {
-        master_array[it] = costmap_[it];
-      } else {
-        int sum = old_cost + costmap_[it];
-        if (sum >= nav2_costmap_2d::INSCRIBED_INFLATED_OBSTACLE) {
-          master_array[it] = nav2_costmap_2d::INSCRIBED_INFLATED_OBSTACLE - 1;
-        } else {
-          master_array[it] = sum;
-        }
-      }
-      it++;
-    }
+    kernels.addition(costmap_ + it, master_array + it, max_i - min_i);
   }
 }
 }  // namespace nav2_costmap_2d
@@ -12,44 +12,97 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <string>
 #include <memory>
+#include <mutex>
 
 #include "nav2_costmap_2d/costmap_subscriber.hpp"
+#include "nav2_costmap_2d/costmap_delta.hpp"
+#include "rclcpp/expand_topic_or_service_name.hpp"
 
 namespace nav2_costmap_2d
 {
 
 CostmapSubscriber::CostmapSubscriber(
   const nav2_util::LifecycleNode::WeakPtr & parent,
-  const std::string & topic_name)
-: topic_name_(topic_name)
+  const std::string & topic_name,
+  bool use_updates)
+: topic_name_(topic_name),
+  use_updates_(use_updates)
 {
   auto node = parent.lock();
-  costmap_sub_ = node->create_subscription<nav2_msgs::msg::Costmap>(
-    topic_name_,
-    rclcpp::QoS(rclcpp::KeepLast(1)).transient_local().reliable(),
-    std::bind(&CostmapSubscriber::costmapCallback, this, std::placeholders::_1));
+  shared_costmap_ = SharedCostmap::find(
+    rclcpp::expand_topic_or_service_name(topic_name_, node->get_name(), node->get_namespace()));
+  if (shared_costmap_) {
+    RCLCPP_INFO(
+      node->get_logger(), "Sharing costmap %s within the process", topic_name_.c_str());
+  } else if (use_updates_) {
+    costmap_update_sub_ = node->create_subscription<nav2_msgs::msg::CostmapUpdate>(
+      topic_name_ + "_updates",
+      rclcpp::QoS(rclcpp::KeepLast(10)).reliable(),
+      std::bind(&CostmapSubscriber::costmapUpdateCallback, this, std::placeholders::_1));
+    // Resync requests may be needed before the node is activated
+    auto resync_pub = node->create_publisher<std_msgs::msg::Empty>(
+      topic_name_ + "_resync", rclcpp::SystemDefaultsQoS());
+    resync_pub->on_activate();
+    resync_pub_ = resync_pub;
+  } else {
+    costmap_sub_ = node->create_subscription<nav2_msgs::msg::Costmap>(
+      topic_name_,
+      rclcpp::QoS(rclcpp::KeepLast(1)).transient_local().reliable(),
+      std::bind(&CostmapSubscriber::costmapCallback, this, std::placeholders::_1));
+  }
 }
 
 CostmapSubscriber::CostmapSubscriber(
   const rclcpp::Node::WeakPtr & parent,
-  const std::string & topic_name)
-: topic_name_(topic_name)
+  const std::string & topic_name,
+  bool use_updates)
+: topic_name_(topic_name),
+  use_updates_(use_updates)
 {
   auto node = parent.lock();
-  costmap_sub_ = node->create_subscription<nav2_msgs::msg::Costmap>(
-    topic_name_,
-    rclcpp::QoS(rclcpp::KeepLast(1)).transient_local().reliable(),
-    std::bind(&CostmapSubscriber::costmapCallback, this, std::placeholders::_1));
+  shared_costmap_ = SharedCostmap::find(
+    rclcpp::expand_topic_or_service_name(topic_name_, node->get_name(), node->get_namespace()));
+  if (shared_costmap_) {
+    RCLCPP_INFO(
+      node->get_logger(), "Sharing costmap %s within the process", topic_name_.c_str());
+  } else if (use_updates_) {
+    costmap_update_sub_ = node->create_subscription<nav2_msgs::msg::CostmapUpdate>(
+      topic_name_ + "_updates",
+      rclcpp::QoS(rclcpp::KeepLast(10)).reliable(),
+      std::bind(&CostmapSubscriber::costmapUpdateCallback, this, std::placeholders::_1));
+    resync_pub_ = node->create_publisher<std_msgs::msg::Empty>(
+      topic_name_ + "_resync", rclcpp::SystemDefaultsQoS());
+  } else {
+    costmap_sub_ = node->create_subscription<nav2_msgs::msg::Costmap>(
+      topic_name_,
+      rclcpp::QoS(rclcpp::KeepLast(1)).transient_local().reliable(),
+      std::bind(&CostmapSubscriber::costmapCallback, this, std::placeholders::_1));
+  }
 }
 
-std::shared_ptr<Costmap2D> CostmapSubscriber::getCostmap()
+std::shared_ptr<const Costmap2D> CostmapSubscriber::getCostmap()
 {
+  if (shared_costmap_) {
+    auto snapshot = shared_costmap_->getSnapshot();
+    if (!snapshot) {
+      throw std::runtime_error("Costmap is not available");
+    }
+    // The costmap keeps the whole snapshot alive
+    return std::shared_ptr<const Costmap2D>(snapshot, &snapshot->costmap);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
   if (!costmap_received_) {
     throw std::runtime_error("Costmap is not available");
   }
-  toCostmap2D();
+  if (use_updates_) {
+    applyUpdates();
+  } else {
+    toCostmap2D();
+  }
   return costmap_;
 }
 
@@ -74,22 +127,59 @@ void CostmapSubscriber::toCostmap2D()
       costmap_msg_->metadata.origin.position.y);
   }
 
-  unsigned char * master_array = costmap_->getCharMap();
-  unsigned int index = 0;
-  for (unsigned int i = 0; i < costmap_msg_->metadata.size_x; ++i) {
-    for (unsigned int j = 0; j < costmap_msg_->metadata.size_y; ++j) {
-      master_array[index] = costmap_msg_->data[index];
-      ++index;
+  std::copy(
+    costmap_msg_->data.begin(),
+    costmap_msg_->data.begin() + costmap_msg_->metadata.size_x * costmap_msg_->metadata.size_y,
+    costmap_->getCharMap());
+}
+
+void CostmapSubscriber::applyUpdates()
+{
+  if (costmap_ == nullptr) {
+    costmap_ = std::make_shared<Costmap2D>();
+  }
+
+  for (const auto & update : pending_updates_) {
+    if (!applyCostmapUpdate(*update, *costmap_)) {
+      // Drop the rest, they build on this one
+      RCLCPP_WARN(
+        rclcpp::get_logger("nav2_costmap_2d"),
+        "Received a malformed update of costmap %s, requesting a keyframe", topic_name_.c_str());
+      synced_ = false;
+      resync_pub_->publish(std_msgs::msg::Empty());
+      break;
     }
   }
+  pending_updates_.clear();
 }
 
 void CostmapSubscriber::costmapCallback(const nav2_msgs::msg::Costmap::SharedPtr msg)
 {
+  std::lock_guard<std::mutex> lock(mutex_);
   costmap_msg_ = msg;
   if (!costmap_received_) {
     costmap_received_ = true;
   }
 }
 
+void CostmapSubscriber::costmapUpdateCallback(
+  const nav2_msgs::msg::CostmapUpdate::SharedPtr update)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (update->keyframe) {
+    // Keyframes replace the whole costmap, so nothing queued before them matters
+    pending_updates_.clear();
+    synced_ = true;
+  } else if (!synced_ || update->seq != last_seq_ + 1) {
+    // An update was missed, the following ones are useless until the next keyframe
+    synced_ = false;
+    resync_pub_->publish(std_msgs::msg::Empty());
+    return;
+  }
+
+  last_seq_ = update->seq;
+  pending_updates_.push_back(update);
+  costmap_received_ = true;
+}
+
 }  // namespace nav2_costmap_2d
@@ -48,39 +48,45 @@ template<typename CostmapT>
 double FootprintCollisionChecker<CostmapT>::footprintCost(const Footprint footprint)
 {
   // now we really have to lay down the footprint in the costmap_ grid
-  unsigned int x0, x1, y0, y1;
-  double footprint_cost = 0.0;
-
-  // we need to rasterize each line in the footprint
-  for (unsigned int i = 0; i < footprint.size() - 1; ++i) {
-    // get the cell coord of the first point
-    if (!worldToMap(footprint[i].x, footprint[i].y, x0, y0)) {
-      return static_cast<double>(LETHAL_OBSTACLE);
-    }
+  if (!footprintCells(footprint, footprint_cells_)) {
+    return static_cast<double>(LETHAL_OBSTACLE);
+  }
 
-    // get the cell coord of the second point
-    if (!worldToMap(footprint[i + 1].x, footprint[i + 1].y, x1, y1)) {
-      return static_cast<double>(LETHAL_OBSTACLE);
-    }
+  // if all line costs are legal... then we can return that the footprint is legal
+  return static_cast<double>(
+    costmap_->getMaxCost(footprint_cells_.data(), footprint_cells_.size()));
+}
 
-    footprint_cost = std::max(lineCost(x0, x1, y0, y1), footprint_cost);
+template<typename CostmapT>
+bool FootprintCollisionChecker<CostmapT>::footprintCells(
+  const Footprint & footprint, std::vector<unsigned int> & cells)
+{
+  cells.clear();
+  if (footprint.empty()) {
+    return true;
   }
 
-  // we also need to connect the first point in the footprint to the last point
-  // get the cell coord of the last point
+  // we need to rasterize each line in the footprint, including the one
+  // connecting the last point in the footprint to the first
+  unsigned int x0, x1, y0, y1;
   if (!worldToMap(footprint.back().x, footprint.back().y, x0, y0)) {
-    return static_cast<double>(LETHAL_OBSTACLE);
+    return false;
   }
 
-  // get the cell coord of the first point
-  if (!worldToMap(footprint.front().x, footprint.front().y, x1, y1)) {
-    return static_cast<double>(LETHAL_OBSTACLE);
-  }
+  for (unsigned int i = 0; i < footprint.size(); ++i) {
+    if (!worldToMap(footprint[i].x, footprint[i].y, x1, y1)) {
+      return false;
+    }
 
-  footprint_cost = std::max(lineCost(x0, x1, y0, y1), footprint_cost);
+    for (nav2_util::LineIterator line(x0, y0, x1, y1); line.isValid(); line.advance()) {
+      cells.push_back(costmap_->getIndex(line.getX(), line.getY()));
+    }
 
-  // if all line costs are legal... then we can return that the footprint is legal
-  return footprint_cost;
+    x0 = x1;
+    y0 = y1;
+  }
+
+  return true;
 }
 
 template<typename CostmapT>
@@ -138,6 +144,8 @@ double FootprintCollisionChecker<CostmapT>::footprintCostAtPose(
 
 // declare our valid template parameters
 template class FootprintCollisionChecker<std::shared_ptr<nav2_costmap_2d::Costmap2D>>;
+template class FootprintCollisionChecker<std::shared_ptr<const nav2_costmap_2d::Costmap2D>>;
 template class FootprintCollisionChecker<nav2_costmap_2d::Costmap2D *>;
+template class FootprintCollisionChecker<const nav2_costmap_2d::Costmap2D *>;
 
 }  // namespace nav2_costmap_2d
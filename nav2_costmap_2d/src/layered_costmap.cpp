@@ -38,9 +38,11 @@
 #include "nav2_costmap_2d/layered_costmap.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <limits>
 
@@ -68,7 +70,9 @@ LayeredCostmap::LayeredCostmap(std::string global_frame, bool rolling_window, bo
   initialized_(false),
   size_locked_(false),
   circumscribed_radius_(1.0),
-  inscribed_radius_(0.1)
+  inscribed_radius_(0.1),
+  tiled_(false),
+  update_lock_wait_(0.0)
 {
   if (track_unknown) {
     primary_costmap_.setDefaultValue(255);
@@ -121,7 +125,11 @@ void LayeredCostmap::updateMap(double robot_x, double robot_y, double robot_yaw)
 {
   // Lock for the remainder of this function, some plugins (e.g. VoxelLayer)
   // implement thread unsafe updateBounds() functions.
+  const auto lock_start = std::chrono::steady_clock::now();
   std::unique_lock<Costmap2D::mutex_t> lock(*(combined_costmap_.getMutex()));
+  update_lock_wait_ =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - lock_start).count();
+  update_timings_.clear();
 
   // if we're using a rolling buffer costmap...
   // we need to update the origin using the robot's position
@@ -205,7 +213,7 @@ void LayeredCostmap::updateMap(double robot_x, double robot_y, double robot_yaw)
     for (vector<std::shared_ptr<Layer>>::iterator plugin = plugins_.begin();
       plugin != plugins_.end(); ++plugin)
     {
-      (*plugin)->updateCosts(combined_costmap_, x0, y0, xn, yn);
+      updateLayerCosts(**plugin, combined_costmap_, x0, y0, xn, yn);
     }
   } else {
     // Costmap Filters enabled
@@ -214,7 +222,7 @@ void LayeredCostmap::updateMap(double robot_x, double robot_y, double robot_yaw)
     for (vector<std::shared_ptr<Layer>>::iterator plugin = plugins_.begin();
       plugin != plugins_.end(); ++plugin)
     {
-      (*plugin)->updateCosts(primary_costmap_, x0, y0, xn, yn);
+      updateLayerCosts(**plugin, primary_costmap_, x0, y0, xn, yn);
     }
 
     // 2. Copy processed costmap window to a final costmap.
@@ -232,7 +240,7 @@ void LayeredCostmap::updateMap(double robot_x, double robot_y, double robot_yaw)
     for (vector<std::shared_ptr<Layer>>::iterator filter = filters_.begin();
       filter != filters_.end(); ++filter)
     {
-      (*filter)->updateCosts(combined_costmap_, x0, y0, xn, yn);
+      updateLayerCosts(**filter, combined_costmap_, x0, y0, xn, yn);
     }
   }
 
@@ -244,6 +252,34 @@ void LayeredCostmap::updateMap(double robot_x, double robot_y, double robot_yaw)
   initialized_ = true;
 }
 
+void LayeredCostmap::updateLayerCosts(
+  Layer & layer, Costmap2D & costmap, int x0, int y0, int xn, int yn)
+{
+  LayerUpdateTiming timing;
+  timing.name = layer.getName();
+  const auto start = std::chrono::steady_clock::now();
+
+  if (tiled_) {
+    tile_executor_.resetTimings();
+    layer.updateCostsTiled(costmap, x0, y0, xn, yn, tile_executor_);
+    timing.tile_durations = tile_executor_.getTileDurations();
+  } else {
+    layer.updateCosts(costmap, x0, y0, xn, yn);
+  }
+
+  timing.duration =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  update_timings_.push_back(std::move(timing));
+}
+
+void LayeredCostmap::setTiling(unsigned int tile_size, int num_threads)
+{
+  std::unique_lock<Costmap2D::mutex_t> lock(*(combined_costmap_.getMutex()));
+  tile_executor_.setTileSize(tile_size);
+  tile_executor_.setNumThreads(num_threads);
+  tiled_ = tile_size > 0 && tile_executor_.getNumWorkers() > 1;
+}
+
 bool LayeredCostmap::isCurrent()
 {
   current_ = true;
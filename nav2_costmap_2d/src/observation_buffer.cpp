@@ -37,7 +37,9 @@
 #include "nav2_costmap_2d/observation_buffer.hpp"
 
 #include <algorithm>
-#include <list>
+#include <cstring>
+#include <deque>
+#include <limits>
 #include <string>
 #include <vector>
 #include <chrono>
@@ -48,6 +50,66 @@ using namespace std::chrono_literals;
 
 namespace nav2_costmap_2d
 {
+
+namespace
+{
+
+// Points are transformed and filtered this many at a time
+constexpr unsigned int point_block_size = 256;
+
+/**
+ * @brief Transform the points of a cloud and pack those within bounds, in a single pass.
+ * Each block of points is gathered into x, y, z arrays, transformed as vectors,
+ * then compacted into the output without branching.
+ * @return Number of points kept
+ */
+unsigned int transformPoints(
+  const sensor_msgs::msg::PointCloud2 & cloud, const unsigned int offsets[3],
+  const float transform[12], const float origin[3],
+  float min_z, float max_z, float sq_min_range, float * output)
+{
+  const unsigned int num_points = cloud.width * cloud.height;
+  const unsigned int step = cloud.point_step;
+  const float sq_max_range = std::numeric_limits<float>::max();
+  float x[point_block_size], y[point_block_size], z[point_block_size];
+  float * out = output;
+
+  for (unsigned int first = 0; first < num_points; first += point_block_size) {
+    const unsigned int n = std::min(point_block_size, num_points - first);
+    const unsigned char * point = cloud.data.data() + static_cast<size_t>(first) * step;
+    for (unsigned int i = 0; i != n; i++, point += step) {
+      std::memcpy(&x[i], point + offsets[0], sizeof(float));
+      std::memcpy(&y[i], point + offsets[1], sizeof(float));
+      std::memcpy(&z[i], point + offsets[2], sizeof(float));
+    }
+
+    #pragma omp simd
+    for (unsigned int i = 0; i < n; i++) {
+      const float px = x[i], py = y[i], pz = z[i];
+      x[i] = transform[0] * px + transform[1] * py + transform[2] * pz + transform[3];
+      y[i] = transform[4] * px + transform[5] * py + transform[6] * pz + transform[7];
+      z[i] = transform[8] * px + transform[9] * py + transform[10] * pz + transform[11];
+    }
+
+    // Every point is written, but only those kept advance the output. Comparisons
+    // with NaN are false, so points with non-finite coordinates are dropped.
+    for (unsigned int i = 0; i != n; i++) {
+      const float dx = x[i] - origin[0], dy = y[i] - origin[1], dz = z[i] - origin[2];
+      const float sq_range = dx * dx + dy * dy + dz * dz;
+      out[0] = x[i];
+      out[1] = y[i];
+      out[2] = z[i];
+      const bool keep = (z[i] <= max_z) & (z[i] >= min_z) &
+        (sq_range >= sq_min_range) & (sq_range < sq_max_range);
+      out += 3 * keep;
+    }
+  }
+
+  return static_cast<unsigned int>((out - output) / 3);
+}
+
+}  // namespace
+
 ObservationBuffer::ObservationBuffer(
   const nav2_util::LifecycleNode::WeakPtr & parent,
   std::string topic_name,
@@ -83,14 +145,40 @@ ObservationBuffer::~ObservationBuffer()
 void ObservationBuffer::bufferCloud(const sensor_msgs::msg::PointCloud2 & cloud)
 {
   geometry_msgs::msg::PointStamped global_origin;
+  Observation observation;
 
-  // create a new observation on the list to be populated
-  observation_list_.push_front(Observation());
+  // find the fields of the coordinates, which we read as floats
+  unsigned int offsets[3];
+  const char * names[3] = {"x", "y", "z"};
+  for (unsigned int i = 0; i != 3; i++) {
+    auto field = std::find_if(
+      cloud.fields.begin(), cloud.fields.end(),
+      [&](const sensor_msgs::msg::PointField & f) {return f.name == names[i];});
+    if (field == cloud.fields.end() ||
+      field->datatype != sensor_msgs::msg::PointField::FLOAT32 ||
+      field->offset + sizeof(float) > cloud.point_step)
+    {
+      RCLCPP_ERROR(
+        logger_,
+        "The %s observation buffer can't use a cloud without a float %s field, dropping it",
+        topic_name_.c_str(), names[i]);
+      return;
+    }
+    offsets[i] = field->offset;
+  }
+  if (cloud.data.size() < static_cast<size_t>(cloud.width) * cloud.height * cloud.point_step) {
+    RCLCPP_ERROR(
+      logger_,
+      "The %s observation buffer got a cloud with less data than points, dropping it",
+      topic_name_.c_str());
+    return;
+  }
 
   // check whether the origin frame has been set explicitly
   // or whether we should get it from the cloud
   std::string origin_frame = sensor_frame_ == "" ? cloud.header.frame_id : sensor_frame_;
 
+  geometry_msgs::msg::TransformStamped global_transform;
   try {
     // given these observations come from sensors...
     // we'll need to store the origin pt of the sensor
@@ -101,61 +189,12 @@ void ObservationBuffer::bufferCloud(const sensor_msgs::msg::PointCloud2 & cloud)
     local_origin.point.y = 0;
     local_origin.point.z = 0;
     tf2_buffer_.transform(local_origin, global_origin, global_frame_, tf_tolerance_);
-    tf2::convert(global_origin.point, observation_list_.front().origin_);
-
-    // make sure to pass on the raytrace/obstacle range
-    // of the observation buffer to the observations
-    observation_list_.front().raytrace_max_range_ = raytrace_max_range_;
-    observation_list_.front().raytrace_min_range_ = raytrace_min_range_;
-    observation_list_.front().obstacle_max_range_ = obstacle_max_range_;
-    observation_list_.front().obstacle_min_range_ = obstacle_min_range_;
-
-    sensor_msgs::msg::PointCloud2 global_frame_cloud;
-
-    // transform the point cloud
-    tf2_buffer_.transform(cloud, global_frame_cloud, global_frame_, tf_tolerance_);
-    global_frame_cloud.header.stamp = cloud.header.stamp;
-
-    // now we need to remove observations from the cloud that are below
-    // or above our height thresholds
-    sensor_msgs::msg::PointCloud2 & observation_cloud = *(observation_list_.front().cloud_);
-    observation_cloud.height = global_frame_cloud.height;
-    observation_cloud.width = global_frame_cloud.width;
-    observation_cloud.fields = global_frame_cloud.fields;
-    observation_cloud.is_bigendian = global_frame_cloud.is_bigendian;
-    observation_cloud.point_step = global_frame_cloud.point_step;
-    observation_cloud.row_step = global_frame_cloud.row_step;
-    observation_cloud.is_dense = global_frame_cloud.is_dense;
-
-    unsigned int cloud_size = global_frame_cloud.height * global_frame_cloud.width;
-    sensor_msgs::PointCloud2Modifier modifier(observation_cloud);
-    modifier.resize(cloud_size);
-    unsigned int point_count = 0;
-
-    // copy over the points that are within our height bounds
-    sensor_msgs::PointCloud2Iterator<float> iter_z(global_frame_cloud, "z");
-    std::vector<unsigned char>::const_iterator iter_global = global_frame_cloud.data.begin(),
-      iter_global_end = global_frame_cloud.data.end();
-    std::vector<unsigned char>::iterator iter_obs = observation_cloud.data.begin();
-    for (; iter_global != iter_global_end; ++iter_z, iter_global +=
-      global_frame_cloud.point_step)
-    {
-      if ((*iter_z) <= max_obstacle_height_ &&
-        (*iter_z) >= min_obstacle_height_)
-      {
-        std::copy(iter_global, iter_global + global_frame_cloud.point_step, iter_obs);
-        iter_obs += global_frame_cloud.point_step;
-        ++point_count;
-      }
-    }
+    tf2::convert(global_origin.point, observation.origin_);
 
-    // resize the cloud for the number of legal points
-    modifier.resize(point_count);
-    observation_cloud.header.stamp = cloud.header.stamp;
-    observation_cloud.header.frame_id = global_frame_cloud.header.frame_id;
+    // the transform of the cloud, looked up once for all of its points
+    global_transform = tf2_buffer_.lookupTransform(
+      global_frame_, tf2::getFrameId(cloud), tf2::getTimestamp(cloud), tf_tolerance_);
   } catch (tf2::TransformException & ex) {
-    // if an exception occurs, we need to remove the empty observation from the list
-    observation_list_.pop_front();
     RCLCPP_ERROR(
       logger_,
       "TF Exception that should never happen for sensor frame: %s, cloud frame: %s, %s",
@@ -164,6 +203,43 @@ void ObservationBuffer::bufferCloud(const sensor_msgs::msg::PointCloud2 & cloud)
     return;
   }
 
+  // make sure to pass on the raytrace/obstacle range
+  // of the observation buffer to the observations
+  observation.raytrace_max_range_ = raytrace_max_range_;
+  observation.raytrace_min_range_ = raytrace_min_range_;
+  observation.obstacle_max_range_ = obstacle_max_range_;
+  observation.obstacle_min_range_ = obstacle_min_range_;
+  observation.stamp_ = cloud.header.stamp;
+
+  tf2::Transform tf;
+  tf2::fromMsg(global_transform.transform, tf);
+  const tf2::Matrix3x3 & basis = tf.getBasis();
+  const tf2::Vector3 & translation = tf.getOrigin();
+  float transform[12];
+  for (unsigned int row = 0; row != 3; row++) {
+    transform[4 * row] = basis[row].x();
+    transform[4 * row + 1] = basis[row].y();
+    transform[4 * row + 2] = basis[row].z();
+    transform[4 * row + 3] = translation[row];
+  }
+  const float origin[3] = {
+    static_cast<float>(observation.origin_.x),
+    static_cast<float>(observation.origin_.y),
+    static_cast<float>(observation.origin_.z)};
+
+  // Points closer than both minimum ranges can neither mark nor clear anything
+  const float min_range = std::min(obstacle_min_range_, raytrace_min_range_);
+
+  // transform the points, removing those that are below or above our height thresholds
+  // or too close to the sensor, straight into a buffer of the arena
+  auto points = point_arena_.acquire(cloud.width * cloud.height);
+  observation.num_points_ = transformPoints(
+    cloud, offsets, transform, origin, min_obstacle_height_, max_obstacle_height_,
+    min_range * min_range, points->data());
+  observation.points_ = std::move(points);
+
+  observation_list_.push_front(std::move(observation));
+
   // if the update was successful, we want to update the last updated time
   last_updated_ = clock_->now();
 
@@ -178,16 +254,13 @@ void ObservationBuffer::getObservations(std::vector<Observation> & observations)
   purgeStaleObservations();
 
   // now we'll just copy the observations for the caller
-  std::list<Observation>::iterator obs_it;
-  for (obs_it = observation_list_.begin(); obs_it != observation_list_.end(); ++obs_it) {
-    observations.push_back(*obs_it);
-  }
+  observations.insert(observations.end(), observation_list_.begin(), observation_list_.end());
 }
 
 void ObservationBuffer::purgeStaleObservations()
 {
   if (!observation_list_.empty()) {
-    std::list<Observation>::iterator obs_it = observation_list_.begin();
+    auto obs_it = observation_list_.begin();
     // if we're keeping observations for no time... then we'll only keep one observation
     if (observation_keep_time_ == rclcpp::Duration(0.0s)) {
       observation_list_.erase(++obs_it, observation_list_.end());
@@ -199,7 +272,7 @@ void ObservationBuffer::purgeStaleObservations()
       Observation & obs = *obs_it;
       // check if the observation is out of date... and if it is,
       // remove it and those that follow from the list
-      if ((clock_->now() - obs.cloud_->header.stamp) >
+      if ((clock_->now() - obs.stamp_) >
         observation_keep_time_)
       {
         observation_list_.erase(obs_it, observation_list_.end());
@@ -0,0 +1,62 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include "nav2_costmap_2d/point_arena.hpp"
+
+#include <memory>
+
+namespace nav2_costmap_2d
+{
+
+std::shared_ptr<PointArena::Buffer> PointArena::acquire(std::size_t num_points)
+{
+  const std::size_t num_floats = 3 * num_points;
+
+  // Observations are released about in the order they were buffered, so the buffer
+  // after the last one handed out is the likeliest to be free. The release of the
+  // flag orders the last accesses of the observation before the acquire here.
+  std::shared_ptr<Slot> slot;
+  for (std::size_t i = 0; i != buffers_.size(); i++) {
+    const std::size_t index = (next_ + i) % buffers_.size();
+    if (!buffers_[index]->in_use.load(std::memory_order_acquire)) {
+      slot = buffers_[index];
+      next_ = (index + 1) % buffers_.size();
+      break;
+    }
+  }
+
+  if (!slot) {
+    slot = std::make_shared<Slot>();
+    buffers_.insert(buffers_.begin() + next_, slot);
+    next_ = (next_ + 1) % buffers_.size();
+  }
+
+  // Only ever grown, a buffer keeps the capacity of the largest cloud it held
+  Buffer & points = slot->points;
+  if (points.size() < num_floats) {
+    if (points.capacity() < num_floats) {
+      allocations_++;
+    }
+    points.resize(num_floats);
+  }
+
+  // The holders of the buffer share a handle, the last of them to release it frees the slot
+  slot->in_use.store(true, std::memory_order_relaxed);
+  return std::shared_ptr<Buffer>(
+    &points, [slot](Buffer *) {
+      slot->in_use.store(false, std::memory_order_release);
+    });
+}
+
+}  // namespace nav2_costmap_2d
@@ -0,0 +1,120 @@
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "nav2_costmap_2d/shared_costmap.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace nav2_costmap_2d
+{
+
+namespace
+{
+
+// The registry doesn't keep the costmaps alive, their producers and consumers do
+std::mutex registry_mutex;
+std::map<std::string, std::weak_ptr<SharedCostmap>> registry;
+
+}  // namespace
+
+std::shared_ptr<SharedCostmap> SharedCostmap::advertise(const std::string & name)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  // Consumers may still hold the costmap of a producer that was cleaned up and configured again
+  auto shared_costmap = registry[name].lock();
+  if (!shared_costmap) {
+    shared_costmap = std::make_shared<SharedCostmap>();
+    registry[name] = shared_costmap;
+  }
+  return shared_costmap;
+}
+
+std::shared_ptr<SharedCostmap> SharedCostmap::find(const std::string & name)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto it = registry.find(name);
+  if (it == registry.end()) {
+    return nullptr;
+  }
+  return it->second.lock();
+}
+
+double SharedCostmap::publish(
+  Costmap2D & costmap, const std::string & frame_id, const rclcpp::Time & stamp)
+{
+  std::shared_ptr<Buffer> buffer = std::move(spare_);
+
+  // Only the latest snapshot is handed out, so once consumers release an older one
+  // no one can get it back. The release of the flag orders their last reads before
+  // the acquire here, so it is then safe to overwrite
+  if (!buffer || buffer->in_use.load(std::memory_order_acquire)) {
+    buffer = std::make_shared<Buffer>();
+  }
+  CostmapSnapshot * snapshot = &buffer->snapshot;
+
+  double lock_wait;
+  {
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_lock<Costmap2D::mutex_t> lock(*(costmap.getMutex()));
+    lock_wait = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Costmap2D & copy = snapshot->costmap;
+    if (copy.getSizeInCellsX() != costmap.getSizeInCellsX() ||
+      copy.getSizeInCellsY() != costmap.getSizeInCellsY() ||
+      copy.getResolution() != costmap.getResolution() ||
+      copy.getOriginX() != costmap.getOriginX() ||
+      copy.getOriginY() != costmap.getOriginY())
+    {
+      copy.resizeMap(
+        costmap.getSizeInCellsX(), costmap.getSizeInCellsY(), costmap.getResolution(),
+        costmap.getOriginX(), costmap.getOriginY());
+    }
+    std::memcpy(
+      copy.getCharMap(), costmap.getCharMap(),
+      costmap.getSizeInCellsX() * costmap.getSizeInCellsY() * sizeof(unsigned char));
+  }
+  snapshot->frame_id = frame_id;
+  snapshot->stamp = stamp;
+
+  snapshot->version = version_ + 1;
+
+  // Consumers share a handle to the buffer, the last of them to release it frees the buffer
+  buffer->in_use.store(true, std::memory_order_relaxed);
+  std::shared_ptr<CostmapSnapshot> handle(
+    snapshot, [buffer](CostmapSnapshot *) {
+      buffer->in_use.store(false, std::memory_order_release);
+    });
+  std::atomic_exchange(&latest_, std::move(handle));
+  spare_ = std::move(latest_buffer_);
+  latest_buffer_ = std::move(buffer);
+  version_++;
+  return lock_wait;
+}
+
+std::shared_ptr<const CostmapSnapshot> SharedCostmap::getSnapshot() const
+{
+  return std::atomic_load(&latest_);
+}
+
+uint64_t SharedCostmap::getVersion() const
+{
+  return version_;
+}
+
+}  // namespace nav2_costmap_2d
@@ -0,0 +1,70 @@
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "nav2_costmap_2d/throttled_diagnostics.hpp"
+
+#include <string>
+
+namespace nav2_costmap_2d
+{
+
+ThrottledDiagnostics::ThrottledDiagnostics(
+  const rclcpp_lifecycle::LifecycleNode::SharedPtr & node, const std::string & name,
+  std::chrono::steady_clock::duration period)
+: name_(name), period_(period), clock_(node->get_clock())
+{
+  pub_ = node->create_publisher<diagnostic_msgs::msg::DiagnosticArray>(
+    "/diagnostics", rclcpp::QoS(rclcpp::KeepLast(10)));
+}
+
+void ThrottledDiagnostics::activate()
+{
+  pub_->on_activate();
+}
+
+void ThrottledDiagnostics::deactivate()
+{
+  pub_->on_deactivate();
+}
+
+bool ThrottledDiagnostics::publish(
+  const std::function<void(diagnostic_msgs::msg::DiagnosticStatus &)> & fill)
+{
+  const auto now = std::chrono::steady_clock::now();
+  if (now - last_time_ < period_ || !pub_->is_activated()) {
+    return false;
+  }
+  last_time_ = now;
+
+  diagnostic_msgs::msg::DiagnosticArray array;
+  array.header.stamp = clock_->now();
+  array.status.resize(1);
+  array.status[0].level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  array.status[0].name = name_;
+  fill(array.status[0]);
+  pub_->publish(array);
+  return true;
+}
+
+void ThrottledDiagnostics::add(
+  diagnostic_msgs::msg::DiagnosticStatus & status, const std::string & key,
+  const std::string & value)
+{
+  diagnostic_msgs::msg::KeyValue key_value;
+  key_value.key = key;
+  key_value.value = value;
+  status.values.push_back(key_value);
+}
+
+}  // namespace nav2_costmap_2d
@@ -0,0 +1,96 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include "nav2_costmap_2d/tile_executor.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <vector>
+
+namespace nav2_costmap_2d
+{
+
+TileExecutor::TileExecutor(unsigned int tile_size, int num_threads)
+: tile_size_(tile_size),
+  num_threads_(1)
+{
+  setNumThreads(num_threads);
+}
+
+void TileExecutor::setTileSize(unsigned int tile_size)
+{
+  tile_size_ = tile_size;
+}
+
+void TileExecutor::setNumThreads(int num_threads)
+{
+  num_threads_ = num_threads <= 0 ?
+    static_cast<unsigned int>(omp_get_max_threads()) : static_cast<unsigned int>(num_threads);
+}
+
+void TileExecutor::run(
+  int min_i, int min_j, int max_i, int max_j,
+  const TileFunction & function)
+{
+  if (max_i <= min_i || max_j <= min_j) {
+    return;
+  }
+
+  const int tile_size = tile_size_ == 0 ?
+    std::max(max_i - min_i, max_j - min_j) : static_cast<int>(tile_size_);
+  const int tiles_x = (max_i - min_i + tile_size - 1) / tile_size;
+  const int tiles_y = (max_j - min_j + tile_size - 1) / tile_size;
+  const int num_tiles = tiles_x * tiles_y;
+
+  const std::size_t first = tile_durations_.size();
+  tile_durations_.resize(first + num_tiles);
+  std::vector<std::exception_ptr> errors(num_tiles);
+
+  auto run_tile = [&](int tile, unsigned int worker) {
+      const int ti = min_i + (tile % tiles_x) * tile_size;
+      const int tj = min_j + (tile / tiles_x) * tile_size;
+      const auto start = std::chrono::steady_clock::now();
+      try {
+        function(ti, tj, std::min(ti + tile_size, max_i), std::min(tj + tile_size, max_j), worker);
+      } catch (...) {
+        errors[tile] = std::current_exception();
+      }
+      tile_durations_[first + tile] =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+  if (num_threads_ == 1 || num_tiles == 1) {
+    for (int tile = 0; tile < num_tiles; tile++) {
+      run_tile(tile, 0);
+    }
+  } else {
+    // Tiles are handed out one at a time, so the threads that get the cheap,
+    // empty tiles pick up the rest of the work
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads_)
+    for (int tile = 0; tile < num_tiles; tile++) {
+      run_tile(tile, static_cast<unsigned int>(omp_get_thread_num()));
+    }
+  }
+
+  for (const auto & error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+}  // namespace nav2_costmap_2d
@@ -0,0 +1,152 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+// Measures the throughput, in cells per second, of combining a layer into the master
+// costmap with each of the CostmapLayer update modes, across map sizes, next to a
+// plain per-cell loop of the same mode.
+// Usage: benchmark_combination [runs]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/costmap_layer.hpp"
+#include "nav2_costmap_2d/cost_values.hpp"
+
+using namespace std::chrono;  // NOLINT
+using nav2_costmap_2d::NO_INFORMATION;
+using nav2_costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+
+class BenchmarkLayer : public nav2_costmap_2d::CostmapLayer
+{
+public:
+  explicit BenchmarkLayer(unsigned int size)
+  {
+    enabled_ = true;
+    resizeMap(size, size, 0.05, 0.0, 0.0);
+  }
+
+  void reset() override {}
+  bool isClearable() override {return false;}
+  void updateBounds(double, double, double, double *, double *, double *, double *) override {}
+  void updateCosts(nav2_costmap_2d::Costmap2D &, int, int, int, int) override {}
+
+  void combine(unsigned int mode, nav2_costmap_2d::Costmap2D & master, int size)
+  {
+    switch (mode) {
+      case 0:
+        updateWithTrueOverwrite(master, 0, 0, size, size);
+        break;
+      case 1:
+        updateWithOverwrite(master, 0, 0, size, size);
+        break;
+      case 2:
+        updateWithMax(master, 0, 0, size, size);
+        break;
+      default:
+        updateWithAddition(master, 0, 0, size, size);
+    }
+  }
+
+  // The same modes, one cell at a time
+  void combinePerCell(unsigned int mode, nav2_costmap_2d::Costmap2D & master, int size)
+  {
+    unsigned char * master_array = master.getCharMap();
+    const unsigned int cells = static_cast<unsigned int>(size * size);
+    switch (mode) {
+      case 0:
+        for (unsigned int it = 0; it != cells; it++) {
+          master_array[it] = costmap_[it];
+        }
+        break;
+      case 1:
+        for (unsigned int it = 0; it != cells; it++) {
+          if (costmap_[it] != NO_INFORMATION) {
+            master_array[it] = costmap_[it];
+          }
+        }
+        break;
+      case 2:
+        for (unsigned int it = 0; it != cells; it++) {
+          if (costmap_[it] != NO_INFORMATION &&
+            (master_array[it] == NO_INFORMATION || master_array[it] < costmap_[it]))
+          {
+            master_array[it] = costmap_[it];
+          }
+        }
+        break;
+      default:
+        for (unsigned int it = 0; it != cells; it++) {
+          if (costmap_[it] == NO_INFORMATION) {
+            continue;
+          }
+          if (master_array[it] == NO_INFORMATION) {
+            master_array[it] = costmap_[it];
+          } else {
+            const int sum = master_array[it] + costmap_[it];
+            master_array[it] = sum >= INSCRIBED_INFLATED_OBSTACLE ?
+              INSCRIBED_INFLATED_OBSTACLE - 1 : sum;
+          }
+        }
+    }
+  }
+};
+
+int main(int argc, char ** argv)
+{
+  const int runs = argc > 1 ? std::atoi(argv[1]) : 50;
+  const std::vector<std::string> modes = {"true_overwrite", "overwrite", "max", "addition"};
+  std::srand(42);
+
+  for (unsigned int size : {100u, 400u, 1000u, 4000u}) {
+    // A partially observed layer over a partially known master
+    BenchmarkLayer layer(size);
+    nav2_costmap_2d::Costmap2D master(size, size, 0.05, 0.0, 0.0, 0);
+    for (unsigned int j = 0; j != size; j++) {
+      for (unsigned int i = 0; i != size; i++) {
+        layer.setCost(i, j, std::rand() % 4 == 0 ? NO_INFORMATION : std::rand() % 254);
+        master.setCost(i, j, std::rand() % 8 == 0 ? NO_INFORMATION : std::rand() % 254);
+      }
+    }
+    const nav2_costmap_2d::Costmap2D initial(master);
+
+    for (unsigned int mode = 0; mode != modes.size(); mode++) {
+      for (bool per_cell : {true, false}) {
+        std::vector<double> rates;
+        for (int run = 0; run != runs; run++) {
+          master = initial;
+          steady_clock::time_point a = steady_clock::now();
+          if (per_cell) {
+            layer.combinePerCell(mode, master, size);
+          } else {
+            layer.combine(mode, master, size);
+          }
+          steady_clock::time_point b = steady_clock::now();
+          rates.push_back(
+            static_cast<double>(size) * size / duration_cast<duration<double>>(b - a).count());
+        }
+        std::sort(rates.begin(), rates.end());
+        std::cout << size << "x" << size << " " << modes[mode] <<
+          (per_cell ? ", per cell: " : ": ") <<
+          rates[rates.size() / 2] / 1e6 << " Mcells/s median" << std::endl;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -33,7 +33,9 @@
  */
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <map>
 #include <memory>
 #include <string>
@@ -600,3 +602,179 @@ TEST_F(TestNode, testInflation3)
   ASSERT_EQ(countValues(*costmap, nav2_costmap_2d::LETHAL_OBSTACLE), 1u);
   ASSERT_EQ(countValues(*costmap, nav2_costmap_2d::INSCRIBED_INFLATED_OBSTACLE), 4u);
 }
+
+/**
+ * Check the cost of every cell against the distance to its nearest lethal obstacle
+ */
+void validateDistanceCosts(
+  nav2_costmap_2d::Costmap2D & costmap, nav2_costmap_2d::InflationLayer & ilayer,
+  double inflation_radius)
+{
+  for (unsigned int y = 0; y < costmap.getSizeInCellsY(); y++) {
+    for (unsigned int x = 0; x < costmap.getSizeInCellsX(); x++) {
+      double min_dist = std::numeric_limits<double>::max();
+      for (unsigned int oy = 0; oy < costmap.getSizeInCellsY(); oy++) {
+        for (unsigned int ox = 0; ox < costmap.getSizeInCellsX(); ox++) {
+          if (costmap.getCost(ox, oy) == nav2_costmap_2d::LETHAL_OBSTACLE) {
+            min_dist = std::min(
+              min_dist, std::hypot(static_cast<double>(x) - ox, static_cast<double>(y) - oy));
+          }
+        }
+      }
+      unsigned char expected_cost = min_dist <= inflation_radius ?
+        ilayer.computeCost(min_dist) : nav2_costmap_2d::FREE_SPACE;
+      EXPECT_EQ(costmap.getCost(x, y), expected_cost) << "at " << x << ", " << y;
+    }
+  }
+}
+
+/**
+ * Test that incremental inflation follows obstacle insertions and removals, with costs
+ * from the distance to the nearest obstacle
+ */
+TEST_F(TestNode, testIncrementalInflation)
+{
+  std::vector<rclcpp::Parameter> parameters;
+  parameters.push_back(rclcpp::Parameter("inflation.cost_scaling_factor", 1.0));
+  parameters.push_back(rclcpp::Parameter("inflation.inflation_radius", 3.0));
+  parameters.push_back(rclcpp::Parameter("inflation.incremental_inflation", true));
+  initNode(parameters);
+
+  tf2_ros::Buffer tf(node_->get_clock());
+  nav2_costmap_2d::LayeredCostmap layers("frame", false, false);
+  layers.resizeMap(10, 10, 1, 0, 0);
+  std::vector<Point> polygon = setRadii(layers, 1, 1.75);
+
+  std::shared_ptr<nav2_costmap_2d::ObstacleLayer> olayer = nullptr;
+  addObstacleLayer(layers, tf, node_, olayer);
+
+  std::shared_ptr<nav2_costmap_2d::InflationLayer> ilayer = nullptr;
+  addInflationLayer(layers, tf, node_, ilayer);
+
+  layers.setFootprint(polygon);
+  nav2_costmap_2d::Costmap2D * costmap = layers.getCostmap();
+
+  addObservation(olayer, 5, 5, MAX_Z);
+  addObservation(olayer, 2, 7, MAX_Z);
+  layers.updateMap(0, 0, 0);
+  ASSERT_EQ(countValues(*costmap, nav2_costmap_2d::LETHAL_OBSTACLE), 2u);
+  validateDistanceCosts(*costmap, *ilayer, 3.0);
+
+  // The ray to <8, 8> clears the obstacle at <5, 5>
+  olayer->clearStaticObservations(true, true);
+  addObservation(olayer, 8, 8, MAX_Z);
+  layers.updateMap(0, 0, 0);
+  ASSERT_EQ(costmap->getCost(5, 5), nav2_costmap_2d::FREE_SPACE);
+  ASSERT_EQ(countValues(*costmap, nav2_costmap_2d::LETHAL_OBSTACLE), 2u);
+  validateDistanceCosts(*costmap, *ilayer, 3.0);
+
+  // Update again - should see no change
+  layers.updateMap(0, 0, 0);
+  validateDistanceCosts(*costmap, *ilayer, 3.0);
+}
+
+/**
+ * Test that incremental inflation follows a rolling window, as obstacles enter and
+ * leave the map
+ */
+TEST_F(TestNode, testIncrementalInflationRollingWindow)
+{
+  std::vector<rclcpp::Parameter> parameters;
+  parameters.push_back(rclcpp::Parameter("inflation.cost_scaling_factor", 1.0));
+  parameters.push_back(rclcpp::Parameter("inflation.inflation_radius", 3.0));
+  parameters.push_back(rclcpp::Parameter("inflation.incremental_inflation", true));
+  initNode(parameters);
+
+  tf2_ros::Buffer tf(node_->get_clock());
+  nav2_costmap_2d::LayeredCostmap layers("frame", true, false);
+  layers.resizeMap(10, 10, 1, 0, 0);
+  std::vector<Point> polygon = setRadii(layers, 1, 1.75);
+
+  std::shared_ptr<nav2_costmap_2d::ObstacleLayer> olayer = nullptr;
+  addObstacleLayer(layers, tf, node_, olayer);
+
+  std::shared_ptr<nav2_costmap_2d::InflationLayer> ilayer = nullptr;
+  addInflationLayer(layers, tf, node_, ilayer);
+
+  layers.setFootprint(polygon);
+  nav2_costmap_2d::Costmap2D * costmap = layers.getCostmap();
+
+  addObservation(olayer, 2, 7, MAX_Z);
+  addObservation(olayer, 6, 2, MAX_Z);
+  addObservation(olayer, 8, 8, MAX_Z);
+  addObservation(olayer, 12, 3, MAX_Z);
+
+  // Origin at <0, 0>: the obstacle at <12, 3> is off the map
+  layers.updateMap(5, 5, 0);
+  ASSERT_EQ(countValues(*costmap, nav2_costmap_2d::LETHAL_OBSTACLE), 3u);
+  validateDistanceCosts(*costmap, *ilayer, 3.0);
+
+  // Origin at <3, 1>: the obstacle at <2, 7> leaves the map and the one at <12, 3> enters it
+  layers.updateMap(8, 6, 0);
+  ASSERT_EQ(costmap->getCost(9, 2), nav2_costmap_2d::LETHAL_OBSTACLE);
+  ASSERT_EQ(countValues(*costmap, nav2_costmap_2d::LETHAL_OBSTACLE), 3u);
+  validateDistanceCosts(*costmap, *ilayer, 3.0);
+
+  // And back
+  layers.updateMap(5, 5, 0);
+  ASSERT_EQ(costmap->getCost(2, 7), nav2_costmap_2d::LETHAL_OBSTACLE);
+  ASSERT_EQ(countValues(*costmap, nav2_costmap_2d::LETHAL_OBSTACLE), 3u);
+  validateDistanceCosts(*costmap, *ilayer, 3.0);
+}
+
+/**
+ * Test that updating the layers tile by tile in parallel gives the same costs as
+ * updating them serially, with obstacles inflated across tile edges
+ */
+TEST_F(TestNode, testTiledUpdate)
+{
+  initNode(3);
+  tf2_ros::Buffer tf(node_->get_clock());
+  nav2_costmap_2d::LayeredCostmap serial_layers("frame", false, false);
+  nav2_costmap_2d::LayeredCostmap tiled_layers("frame", false, false);
+  tiled_layers.setTiling(7, 4);
+
+  for (auto layers : {&serial_layers, &tiled_layers}) {
+    layers->resizeMap(40, 40, 1, 0, 0);
+    std::vector<Point> polygon = setRadii(*layers, 1, 1.75);
+
+    std::shared_ptr<nav2_costmap_2d::ObstacleLayer> olayer = nullptr;
+    addObstacleLayer(*layers, tf, node_, olayer);
+
+    std::shared_ptr<nav2_costmap_2d::InflationLayer> ilayer = nullptr;
+    addInflationLayer(*layers, tf, node_, ilayer);
+
+    layers->setFootprint(polygon);
+
+    // Obstacles on and next to the edges of the tiles, far enough apart
+    // for every cell to have a single nearest one
+    addObservation(olayer, 3, 3, MAX_Z);
+    addObservation(olayer, 13, 6, MAX_Z);
+    addObservation(olayer, 7, 14, MAX_Z);
+    addObservation(olayer, 20, 21, MAX_Z);
+    addObservation(olayer, 27, 34, MAX_Z);
+    addObservation(olayer, 35, 6, MAX_Z);
+    addObservation(olayer, 34, 20, MAX_Z);
+    layers->updateMap(0, 0, 0);
+  }
+
+  nav2_costmap_2d::Costmap2D * serial_costmap = serial_layers.getCostmap();
+  nav2_costmap_2d::Costmap2D * tiled_costmap = tiled_layers.getCostmap();
+  ASSERT_EQ(countValues(*tiled_costmap, nav2_costmap_2d::LETHAL_OBSTACLE), 7u);
+  for (unsigned int y = 0; y < serial_costmap->getSizeInCellsY(); y++) {
+    for (unsigned int x = 0; x < serial_costmap->getSizeInCellsX(); x++) {
+      EXPECT_EQ(serial_costmap->getCost(x, y), tiled_costmap->getCost(x, y)) <<
+        "at (" << x << ", " << y << ")";
+    }
+  }
+
+  // Both layers report their time, and the tiles they were split in when tiled
+  ASSERT_EQ(serial_layers.getUpdateTimings().size(), 2u);
+  ASSERT_EQ(tiled_layers.getUpdateTimings().size(), 2u);
+  for (unsigned int i = 0; i < 2; i++) {
+    EXPECT_TRUE(serial_layers.getUpdateTimings()[i].tile_durations.empty());
+    EXPECT_GT(tiled_layers.getUpdateTimings()[i].tile_durations.size(), 1u);
+    EXPECT_EQ(
+      serial_layers.getUpdateTimings()[i].name, tiled_layers.getUpdateTimings()[i].name);
+  }
+}
@@ -36,11 +36,13 @@
 #include <string>
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "nav2_costmap_2d/costmap_2d.hpp"
 #include "nav2_costmap_2d/layered_costmap.hpp"
 #include "nav2_costmap_2d/observation_buffer.hpp"
+#include "nav2_costmap_2d/voxel_layer.hpp"
 #include "../testing_helper.hpp"
 
 using std::begin;
@@ -407,3 +409,151 @@ TEST_F(TestNode, testRaytracing) {
   ASSERT_EQ(lethal_count, 1);
 
 }
+
+/**
+ * Test that clearing with parallel, deduplicated rays matches serial raytracing
+ */
+TEST_F(TestNode, testParallelRaytracing) {
+  tf2_ros::Buffer tf(node_->get_clock());
+
+  // A dense cloud of points around the sensor, many of them in the same cells
+  sensor_msgs::msg::PointCloud2 cloud;
+  sensor_msgs::PointCloud2Modifier modifier(cloud);
+  modifier.setPointCloud2FieldsByString(1, "xyz");
+  modifier.resize(20000);
+  sensor_msgs::PointCloud2Iterator<float> iter_x(cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> iter_y(cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> iter_z(cloud, "z");
+  for (unsigned int i = 0; i != 20000; ++i, ++iter_x, ++iter_y, ++iter_z) {
+    const double angle = 0.0003 * i;
+    const double range = 1.0 + 0.00025 * (i % 7919);
+    *iter_x = 5.0 + range * cos(angle);
+    *iter_y = 5.0 + range * sin(angle);
+    *iter_z = MAX_Z / 2;
+  }
+  geometry_msgs::msg::Point origin;
+  origin.x = 5.0;
+  origin.y = 5.0;
+  origin.z = MAX_Z / 2;
+  nav2_costmap_2d::Observation obs(origin, cloud, 100.0, 0.0, 100.0, 0.0);
+
+  node_->declare_parameter("obstacles.raytrace_threads", rclcpp::ParameterValue(1));
+  node_->declare_parameter("obstacles.deduplicate_rays", rclcpp::ParameterValue(false));
+
+  std::vector<std::vector<unsigned char>> results;
+  for (int threads : {1, 4}) {
+    node_->set_parameter(rclcpp::Parameter("obstacles.raytrace_threads", threads));
+    node_->set_parameter(rclcpp::Parameter("obstacles.deduplicate_rays", threads != 1));
+
+    nav2_costmap_2d::LayeredCostmap layers("frame", false, false);
+    layers.resizeMap(200, 200, 0.05, 0, 0);
+    std::shared_ptr<nav2_costmap_2d::ObstacleLayer> olayer = nullptr;
+    addObstacleLayer(layers, tf, node_, olayer);
+
+    for (unsigned int j = 0; j < olayer->getSizeInCellsY(); ++j) {
+      for (unsigned int i = 0; i < olayer->getSizeInCellsX(); ++i) {
+        olayer->setCost(i, j, nav2_costmap_2d::LETHAL_OBSTACLE);
+      }
+    }
+    olayer->addStaticObservation(obs, false, true);
+    layers.updateMap(5, 5, 0);
+
+    const unsigned char * costs = olayer->getCharMap();
+    results.emplace_back(costs, costs + olayer->getSizeInCellsX() * olayer->getSizeInCellsY());
+  }
+
+  ASSERT_EQ(results[0].size(), results[1].size());
+  EXPECT_TRUE(results[0] == results[1]);
+  EXPECT_GT(
+    std::count(results[0].begin(), results[0].end(), nav2_costmap_2d::FREE_SPACE), 1000);
+}
+
+/**
+ * Test that prefiltering the clearing rays of a voxel layer matches tracing them all
+ * when rays repeat the same endpoints
+ */
+TEST_F(TestNode, testVoxelClearingPrefilter) {
+  tf2_ros::Buffer tf(node_->get_clock());
+
+  geometry_msgs::msg::Point origin;
+  origin.x = 5.0;
+  origin.y = 5.0;
+  origin.z = 0.5;
+
+  // Obstacles all around the sensor, at a few heights
+  sensor_msgs::msg::PointCloud2 marking_cloud;
+  sensor_msgs::PointCloud2Modifier marking_modifier(marking_cloud);
+  marking_modifier.setPointCloud2FieldsByString(1, "xyz");
+  marking_modifier.resize(3 * 40 * 40);
+  sensor_msgs::PointCloud2Iterator<float> marking_x(marking_cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> marking_y(marking_cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> marking_z(marking_cloud, "z");
+  for (int k = 0; k != 3; ++k) {
+    for (int j = 0; j != 40; ++j) {
+      for (int i = 0; i != 40; ++i, ++marking_x, ++marking_y, ++marking_z) {
+        *marking_x = 3.0 + 0.1 * i;
+        *marking_y = 3.0 + 0.1 * j;
+        *marking_z = 0.3 + 0.2 * k;
+      }
+    }
+  }
+  nav2_costmap_2d::Observation marking_obs(origin, marking_cloud, 100.0, 0.0, 100.0, 0.0);
+
+  // 100 endpoints in distinct voxels, each seen 5 times
+  const unsigned int endpoints = 100, repeats = 5;
+  sensor_msgs::msg::PointCloud2 clearing_cloud;
+  sensor_msgs::PointCloud2Modifier clearing_modifier(clearing_cloud);
+  clearing_modifier.setPointCloud2FieldsByString(1, "xyz");
+  clearing_modifier.resize(endpoints * repeats);
+  sensor_msgs::PointCloud2Iterator<float> clearing_x(clearing_cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> clearing_y(clearing_cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> clearing_z(clearing_cloud, "z");
+  for (unsigned int r = 0; r != repeats; ++r) {
+    for (unsigned int i = 0; i != endpoints; ++i, ++clearing_x, ++clearing_y, ++clearing_z) {
+      const double angle = 2.0 * M_PI * i / endpoints;
+      *clearing_x = 5.0 + 3.0 * cos(angle);
+      *clearing_y = 5.0 + 3.0 * sin(angle);
+      *clearing_z = 0.2 + 0.1 * (i % 7);
+    }
+  }
+  nav2_costmap_2d::Observation clearing_obs(origin, clearing_cloud, 100.0, 0.0, 100.0, 0.0);
+
+  node_->declare_parameter("voxel.prefilter_clearing_rays", rclcpp::ParameterValue(false));
+
+  std::vector<std::vector<unsigned char>> costs;
+  std::vector<std::vector<uint32_t>> voxels;
+  for (bool prefilter : {false, true}) {
+    node_->set_parameter(rclcpp::Parameter("voxel.prefilter_clearing_rays", prefilter));
+
+    nav2_costmap_2d::LayeredCostmap layers("frame", false, false);
+    layers.resizeMap(200, 200, 0.05, 0, 0);
+    auto vlayer = std::make_shared<nav2_costmap_2d::VoxelLayer>();
+    vlayer->initialize(&layers, "voxel", &tf, node_, nullptr, nullptr);
+    layers.addPlugin(std::shared_ptr<nav2_costmap_2d::Layer>(vlayer));
+
+    vlayer->addStaticObservation(marking_obs, true, false);
+    layers.updateMap(5, 5, 0);
+    const unsigned int marked = countValues(*vlayer, nav2_costmap_2d::LETHAL_OBSTACLE);
+    ASSERT_GT(marked, 0u);
+
+    vlayer->clearStaticObservations(true, false);
+    vlayer->addStaticObservation(clearing_obs, false, true);
+    layers.updateMap(5, 5, 0);
+    EXPECT_LT(countValues(*vlayer, nav2_costmap_2d::LETHAL_OBSTACLE), marked);
+
+    const auto & stats = vlayer->getClearingStats();
+    EXPECT_EQ(stats.raw_rays, endpoints * repeats);
+    EXPECT_EQ(stats.unique_rays, prefilter ? endpoints : endpoints * repeats);
+    EXPECT_GE(stats.trace_time, 0.0);
+    if (!prefilter) {
+      EXPECT_EQ(stats.saved_time, 0.0);
+    }
+
+    const unsigned int size = vlayer->getSizeInCellsX() * vlayer->getSizeInCellsY();
+    costs.emplace_back(vlayer->getCharMap(), vlayer->getCharMap() + size);
+    voxels.emplace_back(vlayer->getVoxelData(), vlayer->getVoxelData() + size);
+  }
+
+  EXPECT_TRUE(costs[0] == costs[1]);
+  EXPECT_TRUE(voxels[0] == voxels[1]);
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/cost_values.hpp"
+#include "nav2_costmap_2d/footprint_collision_checker.hpp"
+
+TEST(BatchCost, test_get_costs)
+{
+  nav2_costmap_2d::Costmap2D costmap(37, 23, 0.1, 0.0, 0.0, 0);
+  std::srand(42);
+  for (unsigned int i = 0; i != 37; i++) {
+    for (unsigned int j = 0; j != 23; j++) {
+      costmap.setCost(i, j, std::rand() % 253);
+    }
+  }
+
+  // Include the first and last cells of the map, which may not be read past
+  const unsigned int max_index = 37 * 23 - 1;
+  std::vector<unsigned int> indices = {0, 1, 2, 3, max_index, max_index - 1};
+  for (unsigned int i = 0; i != 1000; i++) {
+    indices.push_back(std::rand() % (max_index + 1));
+  }
+
+  // Every batch size, to cover the vector bodies and scalar remainders
+  for (unsigned int n = 0; n <= indices.size(); n += (n < 40 ? 1 : 97)) {
+    std::vector<unsigned char> costs(n);
+    costmap.getCosts(indices.data(), n, costs.data());
+    unsigned char max_cost = 0;
+    for (unsigned int i = 0; i != n; i++) {
+      EXPECT_EQ(costs[i], costmap.getCost(indices[i]));
+      max_cost = std::max(max_cost, costs[i]);
+    }
+    EXPECT_EQ(costmap.getMaxCost(indices.data(), n), max_cost);
+    EXPECT_FALSE(costmap.hasCost(indices.data(), n, nav2_costmap_2d::LETHAL_OBSTACLE));
+  }
+
+  // Same with coordinates
+  std::vector<unsigned int> mx, my;
+  for (const auto & index : indices) {
+    unsigned int x, y;
+    costmap.indexToCells(index, x, y);
+    mx.push_back(x);
+    my.push_back(y);
+  }
+  std::vector<unsigned char> costs(indices.size());
+  costmap.getCosts(mx.data(), my.data(), mx.size(), costs.data());
+  for (unsigned int i = 0; i != indices.size(); i++) {
+    EXPECT_EQ(costs[i], costmap.getCost(mx[i], my[i]));
+  }
+  EXPECT_EQ(
+    costmap.getMaxCost(mx.data(), my.data(), mx.size()),
+    *std::max_element(costs.begin(), costs.end()));
+
+  // Any-cost reductions find a single cell, wherever it is in the batch
+  for (unsigned int i = 0; i != 40; i++) {
+    costmap.setCost(mx[i], my[i], nav2_costmap_2d::LETHAL_OBSTACLE);
+    EXPECT_TRUE(costmap.hasCost(indices.data(), 40, nav2_costmap_2d::LETHAL_OBSTACLE));
+    EXPECT_EQ(costmap.getMaxCost(indices.data(), 40), nav2_costmap_2d::LETHAL_OBSTACLE);
+    EXPECT_FALSE(costmap.hasCost(indices.data(), 40, nav2_costmap_2d::NO_INFORMATION));
+    costmap.setCost(mx[i], my[i], 0);
+  }
+}
+
+TEST(BatchCost, test_footprint_cells)
+{
+  nav2_costmap_2d::Costmap2D * costmap = new nav2_costmap_2d::Costmap2D(100, 100, 0.1, 0, 0, 0);
+  nav2_costmap_2d::FootprintCollisionChecker<nav2_costmap_2d::Costmap2D *> checker(costmap);
+
+  geometry_msgs::msg::Point p1, p2, p3;
+  p1.x = 2.0;
+  p1.y = 2.0;
+  p2.x = 4.0;
+  p2.y = 2.0;
+  p3.x = 4.0;
+  p3.y = 3.0;
+  nav2_costmap_2d::Footprint footprint = {p1, p2, p3};
+
+  std::vector<unsigned int> cells;
+  EXPECT_TRUE(checker.footprintCells(footprint, cells));
+  EXPECT_FALSE(cells.empty());
+  EXPECT_NE(std::find(cells.begin(), cells.end(), costmap->getIndex(30, 20)), cells.end());
+  EXPECT_NE(std::find(cells.begin(), cells.end(), costmap->getIndex(40, 25)), cells.end());
+
+  // Only the outline is checked
+  costmap->setCost(35, 21, nav2_costmap_2d::LETHAL_OBSTACLE);
+  EXPECT_NEAR(checker.footprintCost(footprint), 0.0, 0.001);
+  costmap->setCost(40, 25, 200);
+  EXPECT_NEAR(checker.footprintCost(footprint), 200.0, 0.001);
+
+  // Off of the map
+  p3.x = 40.0;
+  footprint = {p1, p2, p3};
+  EXPECT_FALSE(checker.footprintCells(footprint, cells));
+  EXPECT_NEAR(checker.footprintCost(footprint), nav2_costmap_2d::LETHAL_OBSTACLE, 0.001);
+  delete costmap;
+}
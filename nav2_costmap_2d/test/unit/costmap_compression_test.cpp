@@ -0,0 +1,158 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include <gtest/gtest.h>
+
+#include <zlib.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "nav2_costmap_2d/cost_values.hpp"
+#include "nav2_costmap_2d/costmap_compression.hpp"
+
+using nav2_costmap_2d::NO_INFORMATION;
+using nav2_costmap_2d::LETHAL_OBSTACLE;
+using nav2_costmap_2d::FREE_SPACE;
+
+// A costmap of runs of costs, like obstacles and their inflation over free space
+std::vector<unsigned char> makeCostmap(unsigned int size_x, unsigned int size_y)
+{
+  std::vector<unsigned char> costmap(size_x * size_y, FREE_SPACE);
+  for (unsigned int j = 0; j < size_y; j++) {
+    for (unsigned int i = 0; i < size_x; i++) {
+      if (i < 5) {
+        costmap[j * size_x + i] = NO_INFORMATION;
+      } else if ((i / 7 + j / 5) % 4 == 0) {
+        costmap[j * size_x + i] = static_cast<unsigned char>(std::rand() % 256);
+      }
+    }
+  }
+  return costmap;
+}
+
+TEST(CostmapCompression, test_downsample_max_pools)
+{
+  const unsigned int size_x = 7, size_y = 5;
+  std::vector<unsigned char> costmap(size_x * size_y, NO_INFORMATION);
+  costmap[0] = FREE_SPACE;
+  costmap[1 * size_x + 2] = 100;
+  costmap[1 * size_x + 3] = LETHAL_OBSTACLE;
+  costmap[4 * size_x + 6] = 50;
+
+  std::vector<unsigned char> downsampled;
+  unsigned int downsampled_x, downsampled_y;
+  nav2_costmap_2d::downsampleCostmap(
+    costmap.data(), size_x, size_y, 3, downsampled, downsampled_x, downsampled_y);
+
+  // Partial blocks are kept at the far edges
+  ASSERT_EQ(downsampled_x, 3u);
+  ASSERT_EQ(downsampled_y, 2u);
+  ASSERT_EQ(downsampled.size(), 6u);
+
+  // Known costs win over unknown ones, the highest of them over the others
+  EXPECT_EQ(downsampled[0], 100);
+  EXPECT_EQ(downsampled[1], LETHAL_OBSTACLE);
+  EXPECT_EQ(downsampled[2], NO_INFORMATION);
+  EXPECT_EQ(downsampled[3], NO_INFORMATION);
+  EXPECT_EQ(downsampled[4], NO_INFORMATION);
+  EXPECT_EQ(downsampled[5], 50);
+
+  // A factor of 1 keeps the costmap as is
+  nav2_costmap_2d::downsampleCostmap(
+    costmap.data(), size_x, size_y, 1, downsampled, downsampled_x, downsampled_y);
+  EXPECT_EQ(downsampled, costmap);
+}
+
+TEST(CostmapCompression, test_round_trip)
+{
+  std::srand(42);
+  for (const std::string format : {"png", "zlib"}) {
+    for (unsigned int size : {1u, 13u, 200u}) {
+      const std::vector<unsigned char> costmap = makeCostmap(size, size + 3);
+
+      nav2_msgs::msg::CompressedCostmap msg;
+      msg.format = format;
+      msg.metadata.size_x = size;
+      msg.metadata.size_y = size + 3;
+      ASSERT_TRUE(
+        nav2_costmap_2d::compressCostmap(costmap.data(), size, size + 3, format, msg.data));
+      if (size == 200) {
+        EXPECT_LT(msg.data.size(), costmap.size() / 2);
+      }
+
+      std::vector<unsigned char> decompressed;
+      ASSERT_TRUE(nav2_costmap_2d::decompressCostmap(msg, decompressed));
+      EXPECT_EQ(decompressed, costmap);
+
+      // Truncated data is rejected
+      msg.data.resize(msg.data.size() / 2);
+      EXPECT_FALSE(nav2_costmap_2d::decompressCostmap(msg, decompressed));
+    }
+  }
+}
+
+TEST(CostmapCompression, test_png_layout)
+{
+  const unsigned int size_x = 30, size_y = 20;
+  const std::vector<unsigned char> costmap = makeCostmap(size_x, size_y);
+  std::vector<uint8_t> png;
+  ASSERT_TRUE(nav2_costmap_2d::compressCostmap(costmap.data(), size_x, size_y, "png", png));
+
+  // Signature, then an 8 bit grayscale header
+  const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  ASSERT_GT(png.size(), 33u);
+  EXPECT_EQ(std::memcmp(png.data(), signature, 8), 0);
+  EXPECT_EQ(std::memcmp(&png[12], "IHDR", 4), 0);
+  EXPECT_EQ(png[19], size_x);
+  EXPECT_EQ(png[23], size_y);
+  EXPECT_EQ(png[24], 8);
+  EXPECT_EQ(png[25], 0);
+  EXPECT_EQ(crc32(0, &png[12], 17), (static_cast<uint32_t>(png[29]) << 24 |
+    static_cast<uint32_t>(png[30]) << 16 | static_cast<uint32_t>(png[31]) << 8 | png[32]));
+  EXPECT_EQ(std::memcmp(&png[png.size() - 8], "IEND", 4), 0);
+
+  // Other filters than the none written are undone too: filter the rows with Up
+  std::vector<uint8_t> rows;
+  for (unsigned int j = 0; j < size_y; j++) {
+    rows.push_back(2);
+    for (unsigned int i = 0; i < size_x; i++) {
+      const uint8_t above = j > 0 ? costmap[(j - 1) * size_x + i] : 0;
+      rows.push_back(static_cast<uint8_t>(costmap[j * size_x + i] - above));
+    }
+  }
+  std::vector<uint8_t> deflated(compressBound(rows.size()));
+  uLongf length = deflated.size();
+  ASSERT_EQ(compress2(deflated.data(), &length, rows.data(), rows.size(), 9), Z_OK);
+
+  nav2_msgs::msg::CompressedCostmap msg;
+  msg.format = "png";
+  msg.metadata.size_x = size_x;
+  msg.metadata.size_y = size_y;
+  msg.data.assign(png.begin(), png.begin() + 33);
+  const uint8_t idat_length[4] = {
+    static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16),
+    static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)};
+  msg.data.insert(msg.data.end(), idat_length, idat_length + 4);
+  msg.data.insert(msg.data.end(), {'I', 'D', 'A', 'T'});
+  msg.data.insert(msg.data.end(), deflated.begin(), deflated.begin() + length);
+  msg.data.insert(msg.data.end(), {0, 0, 0, 0});
+  msg.data.insert(msg.data.end(), png.end() - 12, png.end());
+
+  std::vector<unsigned char> decompressed;
+  ASSERT_TRUE(nav2_costmap_2d::decompressCostmap(msg, decompressed));
+  EXPECT_EQ(decompressed, costmap);
+}
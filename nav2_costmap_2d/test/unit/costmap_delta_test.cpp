@@ -0,0 +1,229 @@
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "nav2_costmap_2d/cost_values.hpp"
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/costmap_delta.hpp"
+
+void expectEqualCostmaps(nav2_costmap_2d::Costmap2D & a, nav2_costmap_2d::Costmap2D & b)
+{
+  ASSERT_EQ(a.getSizeInCellsX(), b.getSizeInCellsX());
+  ASSERT_EQ(a.getSizeInCellsY(), b.getSizeInCellsY());
+  for (unsigned int j = 0; j < a.getSizeInCellsY(); j++) {
+    for (unsigned int i = 0; i < a.getSizeInCellsX(); i++) {
+      EXPECT_EQ(a.getCost(i, j), b.getCost(i, j));
+    }
+  }
+}
+
+nav2_msgs::msg::CostmapUpdate makeUpdate(nav2_costmap_2d::Costmap2D & costmap)
+{
+  nav2_msgs::msg::CostmapUpdate update;
+  update.metadata.size_x = costmap.getSizeInCellsX();
+  update.metadata.size_y = costmap.getSizeInCellsY();
+  update.metadata.resolution = costmap.getResolution();
+  update.metadata.origin.position.x = costmap.getOriginX();
+  update.metadata.origin.position.y = costmap.getOriginY();
+  return update;
+}
+
+TEST(CostmapDelta, test_round_trip)
+{
+  nav2_costmap_2d::Costmap2D source(41, 27, 0.05, 1.0, -2.0, 0);
+  nav2_costmap_2d::Costmap2D target;
+  std::vector<unsigned char> last;
+  std::srand(42);
+
+  auto update = makeUpdate(source);
+  nav2_costmap_2d::encodeCostmapKeyframe(source.getCharMap(), 41, 27, last, update);
+  EXPECT_TRUE(update.keyframe);
+  ASSERT_TRUE(nav2_costmap_2d::applyCostmapUpdate(update, target));
+  EXPECT_NEAR(target.getResolution(), 0.05, 1e-6);
+  EXPECT_EQ(target.getOriginX(), 1.0);
+  EXPECT_EQ(target.getOriginY(), -2.0);
+  expectEqualCostmaps(source, target);
+
+  for (unsigned int cycle = 0; cycle != 20; cycle++) {
+    const unsigned int changes = std::rand() % 50;
+    for (unsigned int c = 0; c != changes; c++) {
+      source.setCost(std::rand() % 41, std::rand() % 27, std::rand() % 256);
+    }
+
+    update = makeUpdate(source);
+    nav2_costmap_2d::encodeCostmapDelta(source.getCharMap(), 41, 27, last, update);
+    EXPECT_FALSE(update.keyframe);
+    EXPECT_LE(update.data.size(), 41u * 27u);
+    ASSERT_TRUE(nav2_costmap_2d::applyCostmapUpdate(update, target));
+    expectEqualCostmaps(source, target);
+  }
+
+  // Nothing changed
+  update = makeUpdate(source);
+  nav2_costmap_2d::encodeCostmapDelta(source.getCharMap(), 41, 27, last, update);
+  EXPECT_TRUE(update.run_starts.empty());
+  EXPECT_TRUE(update.data.empty());
+}
+
+TEST(CostmapDelta, test_runs)
+{
+  nav2_costmap_2d::Costmap2D source(100, 3, 0.1, 0.0, 0.0, 0);
+  std::vector<unsigned char> last;
+  auto update = makeUpdate(source);
+  nav2_costmap_2d::encodeCostmapKeyframe(source.getCharMap(), 100, 3, last, update);
+
+  // Close changes are merged into a run, far apart ones are not
+  source.setCost(10, 1, 254);
+  source.setCost(13, 1, 254);
+  source.setCost(50, 1, 254);
+  nav2_costmap_2d::encodeCostmapDelta(source.getCharMap(), 100, 3, last, update);
+  ASSERT_EQ(update.run_starts.size(), 2u);
+  EXPECT_EQ(update.run_starts[0], 110u);
+  EXPECT_EQ(update.run_lengths[0], 4u);
+  EXPECT_EQ(update.run_starts[1], 150u);
+  EXPECT_EQ(update.run_lengths[1], 1u);
+  EXPECT_EQ(update.data.size(), 5u);
+}
+
+TEST(CostmapDelta, test_malformed)
+{
+  nav2_costmap_2d::Costmap2D source(10, 10, 0.1, 0.0, 0.0, 0);
+  nav2_costmap_2d::Costmap2D target(10, 10, 0.1, 0.0, 0.0, 7);
+  std::vector<unsigned char> last;
+  auto update = makeUpdate(source);
+  nav2_costmap_2d::encodeCostmapKeyframe(source.getCharMap(), 10, 10, last, update);
+
+  source.setCost(5, 5, 254);
+  nav2_costmap_2d::encodeCostmapDelta(source.getCharMap(), 10, 10, last, update);
+
+  // Out of bounds run
+  auto bad = update;
+  bad.run_starts[0] = 100;
+  EXPECT_FALSE(nav2_costmap_2d::applyCostmapUpdate(bad, target));
+
+  // Data not matching the runs
+  bad = update;
+  bad.data.push_back(0);
+  EXPECT_FALSE(nav2_costmap_2d::applyCostmapUpdate(bad, target));
+
+  // Changes of a costmap of another size
+  bad = update;
+  bad.metadata.size_x = 11;
+  EXPECT_FALSE(nav2_costmap_2d::applyCostmapUpdate(bad, target));
+
+  // Keyframe not covering the costmap
+  bad = update;
+  bad.keyframe = true;
+  EXPECT_FALSE(nav2_costmap_2d::applyCostmapUpdate(bad, target));
+
+  for (unsigned int j = 0; j < 10; j++) {
+    for (unsigned int i = 0; i < 10; i++) {
+      EXPECT_EQ(target.getCost(i, j), 7);
+    }
+  }
+
+  EXPECT_TRUE(nav2_costmap_2d::applyCostmapUpdate(update, target));
+  EXPECT_EQ(target.getCost(5, 5), 254);
+}
+
+TEST(CostmapDelta, test_shift_matches_update_origin)
+{
+  std::srand(7);
+  const int shifts[][2] = {{0, 0}, {3, 0}, {0, -2}, {-5, 4}, {7, 7}, {-39, 1}, {40, 0}, {2, -30}};
+  for (const auto & shift : shifts) {
+    nav2_costmap_2d::Costmap2D costmap(40, 30, 0.05, 1.0, -2.0, nav2_costmap_2d::NO_INFORMATION);
+    for (unsigned int i = 0; i < 40 * 30; i++) {
+      costmap.getCharMap()[i] = std::rand() % 256;
+    }
+    std::vector<unsigned char> shifted(costmap.getCharMap(), costmap.getCharMap() + 40 * 30);
+
+    // Aim at the middle of the cell, updateOrigin rounds toward zero
+    const double old_x = costmap.getOriginX(), old_y = costmap.getOriginY();
+    auto offset = [](int cells) {return (cells + (cells > 0) * 0.5 - (cells < 0) * 0.5) * 0.05;};
+    costmap.updateOrigin(old_x + offset(shift[0]), old_y + offset(shift[1]));
+
+    int shift_x, shift_y;
+    ASSERT_TRUE(
+      nav2_costmap_2d::getCostmapShift(
+        old_x, old_y, costmap.getOriginX(), costmap.getOriginY(), 0.05, shift_x, shift_y));
+    EXPECT_EQ(shift_x, shift[0]);
+    EXPECT_EQ(shift_y, shift[1]);
+
+    nav2_costmap_2d::shiftCostmapData(
+      shifted.data(), 40, 30, shift_x, shift_y, nav2_costmap_2d::NO_INFORMATION);
+    for (unsigned int j = 0; j < 30; j++) {
+      for (unsigned int i = 0; i < 40; i++) {
+        EXPECT_EQ(shifted[j * 40 + i], costmap.getCost(i, j)) << i << ", " << j;
+      }
+    }
+  }
+
+  // Half a cell isn't a shift
+  int shift_x, shift_y;
+  EXPECT_FALSE(
+    nav2_costmap_2d::getCostmapShift(0.0, 0.0, 0.025, 0.0, 0.05, shift_x, shift_y));
+}
+
+TEST(CostmapDelta, test_rolling_window)
+{
+  // A robot driving along x with a rolling window costmap, which starts out free
+  nav2_costmap_2d::Costmap2D source(60, 40, 0.05, 0.0, 0.0, 0);
+  nav2_costmap_2d::Costmap2D target;
+  std::vector<unsigned char> last;
+  double last_origin_x = source.getOriginX(), last_origin_y = source.getOriginY();
+  std::srand(42);
+
+  auto update = makeUpdate(source);
+  nav2_costmap_2d::encodeCostmapKeyframe(source.getCharMap(), 60, 40, last, update);
+  ASSERT_TRUE(nav2_costmap_2d::applyCostmapUpdate(update, target));
+
+  for (unsigned int cycle = 0; cycle != 30; cycle++) {
+    source.updateOrigin(
+      source.getOriginX() + 0.05 * (std::rand() % 4) + 0.01,
+      source.getOriginY() + 0.05 * (std::rand() % 3 - 1) + (std::rand() % 2 ? 0.01 : -0.01));
+    for (unsigned int c = 0; c != 10; c++) {
+      source.setCost(std::rand() % 60, std::rand() % 40, 254);
+    }
+
+    // As Costmap2DPublisher::prepareCostmapUpdate does
+    int shift_x, shift_y;
+    ASSERT_TRUE(
+      nav2_costmap_2d::getCostmapShift(
+        last_origin_x, last_origin_y, source.getOriginX(), source.getOriginY(),
+        source.getResolution(), shift_x, shift_y));
+    nav2_costmap_2d::shiftCostmapData(
+      last.data(), 60, 40, shift_x, shift_y, nav2_costmap_2d::NO_INFORMATION);
+    update = makeUpdate(source);
+    nav2_costmap_2d::encodeCostmapDelta(source.getCharMap(), 60, 40, last, update);
+    update.shift_x = shift_x;
+    update.shift_y = shift_y;
+    last_origin_x = source.getOriginX();
+    last_origin_y = source.getOriginY();
+
+    // Only the exposed strips and the changes are sent
+    EXPECT_FALSE(update.keyframe);
+    EXPECT_LE(
+      update.data.size(),
+      std::abs(shift_x) * 40u + std::abs(shift_y) * 60u + 10u * (1 + 8));
+
+    ASSERT_TRUE(nav2_costmap_2d::applyCostmapUpdate(update, target));
+    EXPECT_EQ(target.getOriginX(), source.getOriginX());
+    EXPECT_EQ(target.getOriginY(), source.getOriginY());
+    expectEqualCostmaps(source, target);
+  }
+}
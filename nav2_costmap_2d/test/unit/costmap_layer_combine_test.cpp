@@ -0,0 +1,133 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/costmap_layer.hpp"
+#include "nav2_costmap_2d/cost_values.hpp"
+
+using nav2_costmap_2d::NO_INFORMATION;
+using nav2_costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+
+class CombineLayer : public nav2_costmap_2d::CostmapLayer
+{
+public:
+  CombineLayer(unsigned int size_x, unsigned int size_y)
+  {
+    enabled_ = true;
+    resizeMap(size_x, size_y, 0.1, 0.0, 0.0);
+  }
+
+  void reset() override {}
+  bool isClearable() override {return false;}
+  void updateBounds(double, double, double, double *, double *, double *, double *) override {}
+  void updateCosts(nav2_costmap_2d::Costmap2D &, int, int, int, int) override {}
+
+  using nav2_costmap_2d::CostmapLayer::updateWithTrueOverwrite;
+  using nav2_costmap_2d::CostmapLayer::updateWithOverwrite;
+  using nav2_costmap_2d::CostmapLayer::updateWithMax;
+  using nav2_costmap_2d::CostmapLayer::updateWithAddition;
+};
+
+// Costs biased towards the values the modes treat specially
+unsigned char randomCost()
+{
+  switch (std::rand() % 4) {
+    case 0:
+      return NO_INFORMATION;
+    case 1:
+      return INSCRIBED_INFLATED_OBSTACLE - 1 - std::rand() % 3;
+    default:
+      return std::rand() % 256;
+  }
+}
+
+unsigned char referenceCombine(unsigned int mode, unsigned char master, unsigned char layer)
+{
+  switch (mode) {
+    case 0:
+      return layer;
+    case 1:
+      return layer == NO_INFORMATION ? master : layer;
+    case 2:
+      if (layer == NO_INFORMATION) {
+        return master;
+      }
+      return master == NO_INFORMATION || master < layer ? layer : master;
+    default:
+      if (layer == NO_INFORMATION) {
+        return master;
+      }
+      if (master == NO_INFORMATION) {
+        return layer;
+      }
+      return master + layer >= INSCRIBED_INFLATED_OBSTACLE ?
+             INSCRIBED_INFLATED_OBSTACLE - 1 : master + layer;
+  }
+}
+
+TEST(CostmapLayerCombine, test_modes_match_reference)
+{
+  const unsigned int size_x = 157;
+  const unsigned int size_y = 9;
+  CombineLayer layer(size_x, size_y);
+  nav2_costmap_2d::Costmap2D master(size_x, size_y, 0.1, 0.0, 0.0, 0);
+  std::srand(42);
+
+  // Window widths covering the vector bodies and scalar remainders of the kernels
+  const std::vector<std::vector<int>> windows = {
+    {0, 0, 157, 9}, {1, 2, 32, 5}, {3, 0, 50, 9}, {5, 1, 6, 2}, {17, 3, 17, 8}, {100, 4, 157, 7}};
+
+  for (unsigned int mode = 0; mode != 4; mode++) {
+    for (const auto & window : windows) {
+      for (unsigned int j = 0; j != size_y; j++) {
+        for (unsigned int i = 0; i != size_x; i++) {
+          layer.setCost(i, j, randomCost());
+          master.setCost(i, j, randomCost());
+        }
+      }
+      nav2_costmap_2d::Costmap2D before(master);
+
+      switch (mode) {
+        case 0:
+          layer.updateWithTrueOverwrite(master, window[0], window[1], window[2], window[3]);
+          break;
+        case 1:
+          layer.updateWithOverwrite(master, window[0], window[1], window[2], window[3]);
+          break;
+        case 2:
+          layer.updateWithMax(master, window[0], window[1], window[2], window[3]);
+          break;
+        default:
+          layer.updateWithAddition(master, window[0], window[1], window[2], window[3]);
+      }
+
+      for (unsigned int j = 0; j != size_y; j++) {
+        for (unsigned int i = 0; i != size_x; i++) {
+          const bool inside = static_cast<int>(i) >= window[0] &&
+            static_cast<int>(i) < window[2] &&
+            static_cast<int>(j) >= window[1] && static_cast<int>(j) < window[3];
+          const unsigned char expected = inside ?
+            referenceCombine(mode, before.getCost(i, j), layer.getCost(i, j)) :
+            before.getCost(i, j);
+          EXPECT_EQ(master.getCost(i, j), expected);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,196 @@
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/costmap_2d_publisher.hpp"
+#include "nav2_util/lifecycle_node.hpp"
+
+class RclCppFixture
+{
+public:
+  RclCppFixture() {rclcpp::init(0, nullptr);}
+  ~RclCppFixture() {rclcpp::shutdown();}
+};
+RclCppFixture g_rclcppfixture;
+
+// Records the costmaps published instead of publishing them, and can hold the
+// publishing thread inside publish() to make it fall behind
+class RecordingPublisher : public nav2_costmap_2d::Costmap2DPublisher
+{
+public:
+  struct Record
+  {
+    unsigned int x0, xn, y0, yn;
+    unsigned char cost;
+    std::thread::id thread;
+  };
+
+  RecordingPublisher(
+    const nav2_util::LifecycleNode::WeakPtr & parent, nav2_costmap_2d::Costmap2D * costmap)
+  : Costmap2DPublisher(parent, costmap, "map", "costmap", false, 20, true)
+  {
+  }
+
+  ~RecordingPublisher()
+  {
+    release();
+    on_deactivate();
+  }
+
+  void hold()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    held_ = true;
+  }
+
+  void release()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      held_ = false;
+    }
+    cv_.notify_all();
+  }
+
+  // Wait until the given number of costmaps were published or entered publish()
+  bool waitForRecords(size_t count)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(
+      lock, std::chrono::seconds(5), [this, count] {return records_.size() >= count;});
+  }
+
+  std::vector<Record> getRecords()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_;
+  }
+
+protected:
+  void publish(
+    nav2_costmap_2d::Costmap2D & costmap, unsigned int x0, unsigned int xn, unsigned int y0,
+    unsigned int yn, const rclcpp::Time &) override
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    records_.push_back({x0, xn, y0, yn, costmap.getCost(0, 0), std::this_thread::get_id()});
+    cv_.notify_all();
+    cv_.wait(lock, [this] {return !held_;});
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool held_{false};
+  std::vector<Record> records_;
+};
+
+class CostmapPublisherTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    node_ = std::make_shared<nav2_util::LifecycleNode>("costmap_publisher_test");
+    costmap_ = std::make_unique<nav2_costmap_2d::Costmap2D>(10, 10, 0.05, 0.0, 0.0, 0);
+    publisher_ = std::make_unique<RecordingPublisher>(node_, costmap_.get());
+  }
+
+  void publish(unsigned char cost, unsigned int x0, unsigned int xn)
+  {
+    costmap_->setCost(0, 0, cost);
+    publisher_->updateBounds(x0, xn, x0, xn);
+    publisher_->publishCostmap();
+  }
+
+  nav2_util::LifecycleNode::SharedPtr node_;
+  std::unique_ptr<nav2_costmap_2d::Costmap2D> costmap_;
+  std::unique_ptr<RecordingPublisher> publisher_;
+};
+
+TEST_F(CostmapPublisherTest, test_coalescing)
+{
+  publisher_->on_activate();
+  publisher_->hold();
+
+  // The publishing thread picks up the first costmap and is held publishing it
+  publish(1, 1, 2);
+  ASSERT_TRUE(publisher_->waitForRecords(1));
+
+  // The second is pending when the third replaces it
+  publish(2, 3, 4);
+  publish(3, 5, 6);
+  publisher_->release();
+  ASSERT_TRUE(publisher_->waitForRecords(2));
+  publisher_->on_deactivate();
+
+  auto records = publisher_->getRecords();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].cost, 1);
+  EXPECT_EQ(records[0].x0, 1u);
+  EXPECT_EQ(records[0].xn, 2u);
+
+  // The latest costmap wins, with the changes of the one it replaced
+  EXPECT_EQ(records[1].cost, 3);
+  EXPECT_EQ(records[1].x0, 3u);
+  EXPECT_EQ(records[1].xn, 6u);
+  EXPECT_EQ(records[1].y0, 3u);
+  EXPECT_EQ(records[1].yn, 6u);
+
+  const auto stats = publisher_->getPublishStats();
+  EXPECT_EQ(stats.published, 2u);
+  EXPECT_EQ(stats.dropped, 1u);
+  EXPECT_GE(stats.max_latency, stats.last_latency);
+  EXPECT_GT(stats.max_latency, 0.0);
+}
+
+TEST_F(CostmapPublisherTest, test_start_stop)
+{
+  // Inactive, costmaps are published by the caller
+  publish(1, 1, 2);
+  ASSERT_EQ(publisher_->getRecords().size(), 1u);
+  EXPECT_EQ(publisher_->getRecords()[0].thread, std::this_thread::get_id());
+
+  // Active, by the publishing thread
+  publisher_->on_activate();
+  publish(2, 2, 3);
+  ASSERT_TRUE(publisher_->waitForRecords(2));
+  EXPECT_NE(publisher_->getRecords()[1].thread, std::this_thread::get_id());
+
+  // Once stopped, by the caller again, right away
+  publisher_->on_deactivate();
+  publish(3, 3, 4);
+  ASSERT_EQ(publisher_->getRecords().size(), 3u);
+  EXPECT_EQ(publisher_->getRecords()[2].thread, std::this_thread::get_id());
+  EXPECT_EQ(publisher_->getRecords()[2].cost, 3);
+
+  // And restarted
+  publisher_->on_activate();
+  publish(4, 4, 5);
+  ASSERT_TRUE(publisher_->waitForRecords(4));
+  EXPECT_NE(publisher_->getRecords()[3].thread, std::this_thread::get_id());
+  EXPECT_EQ(publisher_->getRecords()[3].cost, 4);
+  publisher_->on_deactivate();
+
+  const auto stats = publisher_->getPublishStats();
+  EXPECT_EQ(stats.published, 4u);
+  EXPECT_EQ(stats.dropped, 0u);
+}
@@ -0,0 +1,209 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "nav2_costmap_2d/observation_buffer.hpp"
+#include "nav2_util/lifecycle_node.hpp"
+#include "sensor_msgs/point_cloud2_iterator.hpp"
+#include "tf2/LinearMath/Quaternion.h"
+#include "tf2_ros/buffer.h"
+
+class RclCppFixture
+{
+public:
+  RclCppFixture() {rclcpp::init(0, nullptr);}
+  ~RclCppFixture() {rclcpp::shutdown();}
+};
+RclCppFixture g_rclcppfixture;
+
+namespace
+{
+
+const double min_obstacle_height = 0.0;
+const double max_obstacle_height = 1.5;
+const double obstacle_max_range = 2.5;
+const double obstacle_min_range = 0.3;
+const double raytrace_max_range = 3.0;
+const double raytrace_min_range = 0.2;
+
+sensor_msgs::msg::PointCloud2 makeCloud(
+  const std::vector<float> & points, const rclcpp::Time & stamp)
+{
+  sensor_msgs::msg::PointCloud2 cloud;
+  cloud.header.frame_id = "laser";
+  cloud.header.stamp = stamp;
+  sensor_msgs::PointCloud2Modifier modifier(cloud);
+  modifier.setPointCloud2FieldsByString(1, "xyz");
+  modifier.resize(points.size() / 3);
+  sensor_msgs::PointCloud2Iterator<float> iter_x(cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> iter_y(cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> iter_z(cloud, "z");
+  for (size_t i = 0; i < points.size(); i += 3, ++iter_x, ++iter_y, ++iter_z) {
+    *iter_x = points[i];
+    *iter_y = points[i + 1];
+    *iter_z = points[i + 2];
+  }
+  return cloud;
+}
+
+}  // namespace
+
+TEST(ObservationBuffer, test_matches_transform_then_filter)
+{
+  auto node = std::make_shared<nav2_util::LifecycleNode>("observation_buffer_test");
+  tf2_ros::Buffer tf(node->get_clock());
+
+  // The laser is tilted, so the height filter applies to rotated points
+  geometry_msgs::msg::TransformStamped laser_transform;
+  laser_transform.header.frame_id = "map";
+  laser_transform.header.stamp = node->now();
+  laser_transform.child_frame_id = "laser";
+  laser_transform.transform.translation.x = 1.0;
+  laser_transform.transform.translation.y = -2.0;
+  laser_transform.transform.translation.z = 0.5;
+  tf2::Quaternion rotation;
+  rotation.setRPY(0.1, -0.2, 0.7);
+  laser_transform.transform.rotation = tf2::toMsg(rotation);
+  tf.setTransform(laser_transform, "observation_buffer_test", true);
+
+  nav2_costmap_2d::ObservationBuffer buffer(
+    node, "cloud", 0.0, 0.0, min_obstacle_height, max_obstacle_height,
+    obstacle_max_range, obstacle_min_range, raytrace_max_range, raytrace_min_range, tf,
+    "map", "", tf2::durationFromSec(0.3));
+
+  // Over several blocks of points: points spread around the laser, a few beyond the
+  // obstacle range, a few within the minimum ranges, and non-finite ones
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float inf = std::numeric_limits<float>::infinity();
+  std::mt19937 rng(21);
+  std::uniform_real_distribution<float> xy_dist(-4.0f, 4.0f);
+  std::uniform_real_distribution<float> z_dist(-1.5f, 1.5f);
+  std::uniform_real_distribution<float> near_dist(-0.1f, 0.1f);
+  std::vector<float> points;
+  for (int i = 0; i < 700; i++) {
+    points.insert(points.end(), {xy_dist(rng), xy_dist(rng), z_dist(rng)});
+  }
+  for (int i = 0; i < 20; i++) {
+    points.insert(points.end(), {near_dist(rng), near_dist(rng), near_dist(rng)});
+    points.insert(points.end(), {10.0f + xy_dist(rng), xy_dist(rng), 0.0f});
+  }
+  points.insert(points.end(), {nan, 1.0f, 0.0f});
+  points.insert(points.end(), {1.0f, nan, 0.0f});
+  points.insert(points.end(), {1.0f, 1.0f, nan});
+  points.insert(points.end(), {inf, 1.0f, 0.0f});
+  points.insert(points.end(), {1.0f, -inf, 0.0f});
+  const sensor_msgs::msg::PointCloud2 cloud = makeCloud(points, node->now());
+
+  buffer.bufferCloud(cloud);
+  std::vector<nav2_costmap_2d::Observation> observations;
+  buffer.getObservations(observations);
+  ASSERT_EQ(observations.size(), 1u);
+  const nav2_costmap_2d::Observation & observation = observations[0];
+  EXPECT_NEAR(observation.origin_.x, 1.0, 1e-9);
+  EXPECT_NEAR(observation.origin_.y, -2.0, 1e-9);
+  EXPECT_NEAR(observation.origin_.z, 0.5, 1e-9);
+  EXPECT_EQ(observation.obstacle_max_range_, obstacle_max_range);
+  EXPECT_EQ(observation.obstacle_min_range_, obstacle_min_range);
+  EXPECT_EQ(observation.raytrace_max_range_, raytrace_max_range);
+  EXPECT_EQ(observation.raytrace_min_range_, raytrace_min_range);
+
+  // The cloud transformed as a whole, then the points within the height bounds and beyond
+  // the smaller minimum range kept, dropping the non-finite ones
+  sensor_msgs::msg::PointCloud2 global_cloud;
+  tf.transform(cloud, global_cloud, "map", tf2::durationFromSec(0.3));
+  const double min_range = std::min(obstacle_min_range, raytrace_min_range);
+  std::vector<float> expected;
+  unsigned int too_close = 0, beyond_obstacle_range = 0;
+  sensor_msgs::PointCloud2ConstIterator<float> iter_x(global_cloud, "x");
+  sensor_msgs::PointCloud2ConstIterator<float> iter_y(global_cloud, "y");
+  sensor_msgs::PointCloud2ConstIterator<float> iter_z(global_cloud, "z");
+  for (; iter_x != iter_x.end(); ++iter_x, ++iter_y, ++iter_z) {
+    if (!std::isfinite(*iter_x) || !std::isfinite(*iter_y) || !std::isfinite(*iter_z) ||
+      *iter_z < min_obstacle_height || *iter_z > max_obstacle_height)
+    {
+      continue;
+    }
+    const double dx = *iter_x - 1.0, dy = *iter_y + 2.0, dz = *iter_z - 0.5;
+    const double range = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (range < min_range) {
+      too_close++;
+      continue;
+    }
+    beyond_obstacle_range += range > obstacle_max_range;
+    expected.insert(expected.end(), {*iter_x, *iter_y, *iter_z});
+  }
+  EXPECT_GT(too_close, 0u);
+  // Those are left to the layers to filter
+  EXPECT_GT(beyond_obstacle_range, 0u);
+
+  ASSERT_EQ(observation.getNumPoints(), expected.size() / 3);
+  const float * kept = observation.getPoints();
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_NEAR(kept[i], expected[i], 1e-4) << "point " << i / 3;
+  }
+}
+
+TEST(ObservationBuffer, test_unusable_clouds_are_dropped)
+{
+  auto node = std::make_shared<nav2_util::LifecycleNode>("observation_buffer_test");
+  tf2_ros::Buffer tf(node->get_clock());
+
+  geometry_msgs::msg::TransformStamped laser_transform;
+  laser_transform.header.frame_id = "map";
+  laser_transform.header.stamp = node->now();
+  laser_transform.child_frame_id = "laser";
+  laser_transform.transform.rotation.w = 1.0;
+  tf.setTransform(laser_transform, "observation_buffer_test", true);
+
+  nav2_costmap_2d::ObservationBuffer buffer(
+    node, "cloud", 0.0, 0.0, min_obstacle_height, max_obstacle_height,
+    obstacle_max_range, obstacle_min_range, raytrace_max_range, raytrace_min_range, tf,
+    "map", "", tf2::durationFromSec(0.3));
+  std::vector<nav2_costmap_2d::Observation> observations;
+
+  // Unknown frame
+  sensor_msgs::msg::PointCloud2 cloud = makeCloud({1.0f, 0.0f, 0.5f}, node->now());
+  cloud.header.frame_id = "unknown";
+  buffer.bufferCloud(cloud);
+  buffer.getObservations(observations);
+  EXPECT_TRUE(observations.empty());
+
+  // Less data than points
+  cloud = makeCloud({1.0f, 0.0f, 0.5f}, node->now());
+  cloud.width = 2;
+  buffer.bufferCloud(cloud);
+  buffer.getObservations(observations);
+  EXPECT_TRUE(observations.empty());
+
+  // No z field
+  cloud = makeCloud({1.0f, 0.0f, 0.5f}, node->now());
+  cloud.fields[2].name = "intensity";
+  buffer.bufferCloud(cloud);
+  buffer.getObservations(observations);
+  EXPECT_TRUE(observations.empty());
+
+  cloud = makeCloud({1.0f, 0.0f, 0.5f}, node->now());
+  buffer.bufferCloud(cloud);
+  buffer.getObservations(observations);
+  ASSERT_EQ(observations.size(), 1u);
+  EXPECT_EQ(observations[0].getNumPoints(), 1u);
+}
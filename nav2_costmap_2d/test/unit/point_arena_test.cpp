@@ -0,0 +1,69 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "nav2_costmap_2d/point_arena.hpp"
+
+TEST(PointArena, test_reuse)
+{
+  nav2_costmap_2d::PointArena arena;
+
+  auto first = arena.acquire(100);
+  auto second = arena.acquire(50);
+  EXPECT_EQ(arena.size(), 2u);
+  EXPECT_NE(first, second);
+  EXPECT_GE(first->size(), 300u);
+  EXPECT_GE(second->size(), 150u);
+
+  // The oldest buffer is reused once released, without allocating
+  const float * data = first->data();
+  first.reset();
+  const auto allocations = arena.getAllocations();
+  auto third = arena.acquire(80);
+  EXPECT_EQ(third->data(), data);
+  EXPECT_EQ(arena.size(), 2u);
+  EXPECT_EQ(arena.getAllocations(), allocations);
+
+  // Buffers still held are never handed out again
+  auto fourth = arena.acquire(10);
+  EXPECT_NE(fourth, second);
+  EXPECT_NE(fourth, third);
+  EXPECT_EQ(arena.size(), 3u);
+
+  // A buffer grows for a larger cloud
+  fourth.reset();
+  auto fifth = arena.acquire(1000);
+  EXPECT_GE(fifth->size(), 3000u);
+  EXPECT_EQ(arena.size(), 3u);
+}
+
+TEST(PointArena, test_steady_state)
+{
+  nav2_costmap_2d::PointArena arena;
+  std::vector<std::shared_ptr<nav2_costmap_2d::PointArena::Buffer>> held;
+
+  // Keeping the last 5 observations, the ring settles at the buffers alive at a time
+  for (unsigned int i = 0; i != 100; i++) {
+    held.push_back(arena.acquire(1000));
+    if (held.size() > 5) {
+      held.erase(held.begin());
+    }
+  }
+  EXPECT_EQ(arena.size(), 6u);
+  EXPECT_EQ(arena.getAllocations(), 6u);
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2019 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/shared_costmap.hpp"
+
+using nav2_costmap_2d::SharedCostmap;
+
+TEST(SharedCostmap, test_registry)
+{
+  EXPECT_EQ(SharedCostmap::find("/test_registry/costmap_raw"), nullptr);
+
+  auto producer = SharedCostmap::advertise("/test_registry/costmap_raw");
+  auto consumer = SharedCostmap::find("/test_registry/costmap_raw");
+  EXPECT_EQ(producer, consumer);
+  EXPECT_EQ(SharedCostmap::find("/other/costmap_raw"), nullptr);
+
+  // Advertising again while consumers hold the costmap reuses it
+  producer.reset();
+  EXPECT_EQ(SharedCostmap::advertise("/test_registry/costmap_raw"), consumer);
+
+  // Nobody holds it anymore
+  consumer.reset();
+  EXPECT_EQ(SharedCostmap::find("/test_registry/costmap_raw"), nullptr);
+}
+
+TEST(SharedCostmap, test_snapshots)
+{
+  auto shared_costmap = SharedCostmap::advertise("/test_snapshots/costmap_raw");
+  EXPECT_EQ(shared_costmap->getSnapshot(), nullptr);
+  EXPECT_EQ(shared_costmap->getVersion(), 0u);
+
+  nav2_costmap_2d::Costmap2D costmap(20, 10, 0.05, 1.0, 2.0, 0);
+  costmap.setCost(3, 4, 254);
+  shared_costmap->publish(costmap, "map", rclcpp::Time(1, 0));
+
+  auto first = shared_costmap->getSnapshot();
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first->version, 1u);
+  EXPECT_EQ(first->frame_id, "map");
+  EXPECT_EQ(first->costmap.getSizeInCellsX(), 20u);
+  EXPECT_EQ(first->costmap.getSizeInCellsY(), 10u);
+  EXPECT_EQ(first->costmap.getOriginX(), 1.0);
+  EXPECT_EQ(first->costmap.getCost(3, 4), 254);
+
+  // Snapshots held by consumers are never modified
+  costmap.setCost(3, 4, 0);
+  costmap.setCost(5, 5, 100);
+  shared_costmap->publish(costmap, "map", rclcpp::Time(2, 0));
+  shared_costmap->publish(costmap, "map", rclcpp::Time(3, 0));
+  EXPECT_EQ(first->version, 1u);
+  EXPECT_EQ(first->costmap.getCost(3, 4), 254);
+  EXPECT_EQ(first->costmap.getCost(5, 5), 0);
+
+  auto third = shared_costmap->getSnapshot();
+  EXPECT_EQ(third->version, 3u);
+  EXPECT_EQ(shared_costmap->getVersion(), 3u);
+  EXPECT_EQ(third->costmap.getCost(3, 4), 0);
+  EXPECT_EQ(third->costmap.getCost(5, 5), 100);
+  EXPECT_NE(first.get(), third.get());
+
+  // Once released, the buffer of the snapshot before last is reused
+  const nav2_costmap_2d::CostmapSnapshot * second = nullptr;
+  {
+    shared_costmap->publish(costmap, "map", rclcpp::Time(4, 0));
+    second = shared_costmap->getSnapshot().get();
+  }
+  third.reset();
+  shared_costmap->publish(costmap, "map", rclcpp::Time(5, 0));
+  shared_costmap->publish(costmap, "map", rclcpp::Time(6, 0));
+  EXPECT_EQ(shared_costmap->getSnapshot().get(), second);
+  EXPECT_EQ(shared_costmap->getSnapshot()->version, 6u);
+
+  // Resizing
+  costmap.resizeMap(5, 6, 0.1, -1.0, -2.0);
+  shared_costmap->publish(costmap, "map", rclcpp::Time(7, 0));
+  auto resized = shared_costmap->getSnapshot();
+  EXPECT_EQ(resized->costmap.getSizeInCellsX(), 5u);
+  EXPECT_EQ(resized->costmap.getSizeInCellsY(), 6u);
+  EXPECT_EQ(resized->costmap.getResolution(), 0.1);
+  EXPECT_EQ(resized->costmap.getOriginY(), -2.0);
+}
+
+TEST(SharedCostmap, test_concurrent_readers)
+{
+  auto shared_costmap = SharedCostmap::advertise("/test_concurrent_readers/costmap_raw");
+  nav2_costmap_2d::Costmap2D costmap(64, 64, 0.05, 0.0, 0.0, 0);
+
+  // Every cell of a snapshot holds its version, readers check they never see a
+  // snapshot being overwritten
+  std::atomic<bool> done{false};
+  std::atomic<unsigned int> torn{0};
+  std::vector<std::thread> readers;
+  for (unsigned int r = 0; r != 4; r++) {
+    readers.emplace_back(
+      [&]() {
+        while (!done) {
+          auto snapshot = shared_costmap->getSnapshot();
+          if (!snapshot) {
+            continue;
+          }
+          const unsigned char expected = snapshot->version % 256;
+          for (unsigned int i = 0; i < 64 * 64; i++) {
+            if (snapshot->costmap.getCost(i) != expected) {
+              torn++;
+              break;
+            }
+          }
+        }
+      });
+  }
+
+  for (unsigned int version = 1; version != 2000; version++) {
+    std::fill(costmap.getCharMap(), costmap.getCharMap() + 64 * 64, version % 256);
+    shared_costmap->publish(costmap, "map", rclcpp::Time(0, 0));
+  }
+  done = true;
+  for (auto & reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(torn, 0u);
+  EXPECT_EQ(shared_costmap->getVersion(), 1999u);
+}
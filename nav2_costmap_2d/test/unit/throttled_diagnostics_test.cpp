@@ -0,0 +1,72 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "nav2_costmap_2d/throttled_diagnostics.hpp"
+#include "nav2_util/lifecycle_node.hpp"
+
+class RclCppFixture
+{
+public:
+  RclCppFixture() {rclcpp::init(0, nullptr);}
+  ~RclCppFixture() {rclcpp::shutdown();}
+};
+RclCppFixture g_rclcppfixture;
+
+TEST(ThrottledDiagnostics, test_publishes_once_per_period)
+{
+  auto node = std::make_shared<nav2_util::LifecycleNode>("throttled_diagnostics_test");
+  nav2_costmap_2d::ThrottledDiagnostics diagnostics(
+    node, "test status", std::chrono::milliseconds(200));
+
+  int filled = 0;
+  auto fill = [&filled](diagnostic_msgs::msg::DiagnosticStatus & status) {
+      EXPECT_EQ(status.name, "test status");
+      EXPECT_EQ(status.level, diagnostic_msgs::msg::DiagnosticStatus::OK);
+      EXPECT_TRUE(status.values.empty());
+      nav2_costmap_2d::ThrottledDiagnostics::add(status, "Count", 3u);
+      nav2_costmap_2d::ThrottledDiagnostics::add(status, "Name", std::string("value"));
+      ASSERT_EQ(status.values.size(), 2u);
+      EXPECT_EQ(status.values[0].key, "Count");
+      EXPECT_EQ(status.values[0].value, "3");
+      EXPECT_EQ(status.values[1].value, "value");
+      filled++;
+    };
+
+  // Nothing is built or sent until activated
+  EXPECT_FALSE(diagnostics.publish(fill));
+  EXPECT_EQ(filled, 0);
+
+  diagnostics.activate();
+  EXPECT_TRUE(diagnostics.publish(fill));
+  EXPECT_EQ(filled, 1);
+
+  // Updates within the period are dropped without building a status
+  EXPECT_FALSE(diagnostics.publish(fill));
+  EXPECT_EQ(filled, 1);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  EXPECT_TRUE(diagnostics.publish(fill));
+  EXPECT_EQ(filled, 2);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  diagnostics.deactivate();
+  EXPECT_FALSE(diagnostics.publish(fill));
+  EXPECT_EQ(filled, 2);
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2020 Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "nav2_costmap_2d/tile_executor.hpp"
+
+using nav2_costmap_2d::TileExecutor;
+
+TEST(TileExecutor, CoversWindowOnce)
+{
+  const int size_x = 50, size_y = 37;
+  for (unsigned int tile_size : {0u, 1u, 8u, 16u, 64u}) {
+    for (int threads : {1, 4}) {
+      TileExecutor executor(tile_size, threads);
+      std::vector<std::atomic<int>> visits(size_x * size_y);
+      for (auto & visit : visits) {
+        visit = 0;
+      }
+      std::atomic<bool> bad_worker{false};
+
+      executor.run(
+        3, 5, size_x, size_y,
+        [&](int min_i, int min_j, int max_i, int max_j, unsigned int worker) {
+          if (worker >= executor.getNumWorkers()) {
+            bad_worker = true;
+          }
+          for (int j = min_j; j < max_j; j++) {
+            for (int i = min_i; i < max_i; i++) {
+              visits[j * size_x + i]++;
+            }
+          }
+        });
+
+      EXPECT_FALSE(bad_worker);
+      for (int j = 0; j < size_y; j++) {
+        for (int i = 0; i < size_x; i++) {
+          EXPECT_EQ(visits[j * size_x + i], (i >= 3 && j >= 5) ? 1 : 0);
+        }
+      }
+
+      const unsigned int expected_tiles = tile_size == 0 ?
+        1u : ((size_x - 3 + tile_size - 1) / tile_size) * ((size_y - 5 + tile_size - 1) / tile_size);
+      EXPECT_EQ(executor.getTileDurations().size(), expected_tiles);
+    }
+  }
+}
+
+TEST(TileExecutor, Timings)
+{
+  TileExecutor executor(10, 2);
+  auto noop = [](int, int, int, int, unsigned int) {};
+
+  executor.run(0, 0, 20, 20, noop);
+  executor.run(0, 0, 10, 10, noop);
+  EXPECT_EQ(executor.getTileDurations().size(), 5u);
+
+  // Empty windows have no tiles
+  executor.run(5, 5, 5, 10, noop);
+  EXPECT_EQ(executor.getTileDurations().size(), 5u);
+
+  executor.resetTimings();
+  EXPECT_TRUE(executor.getTileDurations().empty());
+}
+
+TEST(TileExecutor, RethrowsExceptions)
+{
+  for (int threads : {1, 3}) {
+    TileExecutor executor(4, threads);
+    std::atomic<int> tiles{0};
+    EXPECT_THROW(
+      executor.run(
+        0, 0, 16, 16,
+        [&](int min_i, int min_j, int, int, unsigned int) {
+          tiles++;
+          if (min_i == 4 && min_j == 8) {
+            throw std::runtime_error("tile failed");
+          }
+        }),
+      std::runtime_error);
+    // The other tiles still ran
+    EXPECT_EQ(tiles, 16);
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
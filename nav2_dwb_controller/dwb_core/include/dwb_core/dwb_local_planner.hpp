@@ -35,6 +35,8 @@
 #ifndef DWB_CORE__DWB_LOCAL_PLANNER_HPP_
 #define DWB_CORE__DWB_LOCAL_PLANNER_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -161,12 +163,51 @@ protected:
 
   /**
    * @brief Iterate through all the twists and find the best one
+   *
+   * If scoring_threads_ is more than one and all critics are thread-safe, the twists are
+   * scored in parallel. The best trajectory is the same as with serial scoring. With
+   * short_circuit_trajectory_evaluation_, each thread only short circuits against the best
+   * of its own block of twists, so the partial totals of the other trajectories in results,
+   * and the worst index, can differ from serial scoring.
    */
   virtual dwb_msgs::msg::TrajectoryScore coreScoringAlgorithm(
     const geometry_msgs::msg::Pose2D & pose,
     const nav_2d_msgs::msg::Twist2D velocity,
     std::shared_ptr<dwb_msgs::msg::LocalPlanEvaluation> & results);
 
+  /**
+   * @brief Score a trajectory with branch-and-bound pruning
+   *
+   * Critics are evaluated in the order of critic_order_. Before each critic, the score so far
+   * plus the lower bounds of the remaining critics is compared against best_score, and
+   * scoring stops once the trajectory can no longer be the best.
+   *
+   * @param traj Trajectory to check
+   * @param best_score If positive, the threshold for early termination
+   * @return The scoring of the input trajectory, with the critics in their configured order
+   */
+  dwb_msgs::msg::TrajectoryScore scoreTrajectoryWithPruning(
+    const dwb_msgs::msg::Trajectory2D & traj,
+    double best_score);
+
+  /**
+   * @brief Record a trajectory whose scoring was cut short
+   * @param step Position in the evaluation order of the first critic skipped
+   * @param ordered Whether critics were evaluated in the order of critic_order_
+   */
+  void recordPruning(unsigned int step, bool ordered);
+
+  /**
+   * @brief Sort the critics by their measured score per unit of time, most useful first
+   */
+  void updateCriticOrder();
+
+  /**
+   * @brief Whether every critic with a non-zero scale may score trajectories concurrently
+   * @return If trajectories may be scored in parallel
+   */
+  bool canScoreInParallel() const;
+
   /**
    * @brief Transforms global plan into same frame as pose, clips far away poses and possibly prunes passed poses
    *
@@ -225,6 +266,31 @@ protected:
   std::string dwb_plugin_name_;
 
   bool short_circuit_trajectory_evaluation_;
+  int scoring_threads_{1};
+
+  /**
+   * @struct CriticStats
+   * @brief Sampled cost and benefit of a critic, used to order critics for pruning
+   */
+  struct CriticStats
+  {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> time_ns{0};
+    std::atomic<uint64_t> micro_score{0};
+    std::atomic<uint64_t> rejections{0};
+  };
+
+  bool critic_pruning_{false};
+  std::vector<CriticStats> critic_stats_;
+  std::vector<unsigned int> critic_order_;
+  std::vector<double> mean_time_ns_;
+  // Weighted lower bounds of the critics, scratch space of each scoring thread
+  std::vector<std::vector<double>> lower_bounds_;
+  std::atomic<unsigned int> stats_sample_counter_{0};
+  double last_best_total_{1.0};
+  std::atomic<uint64_t> pruned_trajectories_{0};
+  std::atomic<uint64_t> skipped_evaluations_{0};
+  std::atomic<uint64_t> skipped_time_ns_{0};
 };
 
 }  // namespace dwb_core
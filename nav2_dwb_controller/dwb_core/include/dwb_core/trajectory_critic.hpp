@@ -146,6 +146,24 @@ public:
    */
   virtual double scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj) = 0;
 
+  /**
+   * @brief Return a lower bound of the raw score of the given trajectory
+   *
+   * Used to stop scoring a trajectory early once it can no longer be the best. It must never
+   * exceed the result of scoreTrajectory and should be much cheaper to compute.
+   */
+  virtual double getLowerBound(const dwb_msgs::msg::Trajectory2D &) {return 0.0;}
+
+  /**
+   * @brief Whether scoreTrajectory may be called concurrently from several threads
+   *
+   * Between prepare and debrief, the planner may score trajectories in parallel if every
+   * critic with a non-zero scale is thread-safe. Critics that only read the state set up
+   * in prepare may override this to return true. Derived critics inherit the claim, so
+   * critics meant to be extended should leave it to their concrete subclasses.
+   */
+  virtual bool isThreadSafe() const {return false;}
+
   /**
    * @brief debrief informs the critic what the chosen cmd_vel was (if it cares)
    */
@@ -124,6 +124,13 @@ public:
     const nav_2d_msgs::msg::Twist2D & start_vel,
     const nav_2d_msgs::msg::Twist2D & cmd_vel) = 0;
 
+  /**
+   * @brief Whether generateTrajectory may be called concurrently from several threads
+   *
+   * If not, the planner generates all trajectories before scoring them in parallel.
+   */
+  virtual bool isThreadSafe() const {return false;}
+
   /**
    * @brief Limits the maximum linear speed of the robot.
    * @param speed_limit expressed in absolute value (in m/s)
@@ -32,7 +32,12 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <omp.h>
+
 #include <algorithm>
+#include <chrono>
+#include <exception>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
@@ -53,6 +58,7 @@
 #include "geometry_msgs/msg/twist_stamped.hpp"
 
 using nav2_util::declare_parameter_if_not_declared;
+using std::chrono::steady_clock;
 
 namespace dwb_core
 {
@@ -103,6 +109,12 @@ void DWBLocalPlanner::configure(
   declare_parameter_if_not_declared(
     node, dwb_plugin_name_ + ".short_circuit_trajectory_evaluation",
     rclcpp::ParameterValue(true));
+  declare_parameter_if_not_declared(
+    node, dwb_plugin_name_ + ".scoring_threads",
+    rclcpp::ParameterValue(1));
+  declare_parameter_if_not_declared(
+    node, dwb_plugin_name_ + ".critic_pruning",
+    rclcpp::ParameterValue(false));
 
   std::string traj_generator_name;
 
@@ -119,6 +131,11 @@ void DWBLocalPlanner::configure(
     dwb_plugin_name_ + ".short_circuit_trajectory_evaluation",
     short_circuit_trajectory_evaluation_);
   node->get_parameter(dwb_plugin_name_ + ".shorten_transformed_plan", shorten_transformed_plan_);
+  node->get_parameter(dwb_plugin_name_ + ".scoring_threads", scoring_threads_);
+  node->get_parameter(dwb_plugin_name_ + ".critic_pruning", critic_pruning_);
+  if (scoring_threads_ <= 0) {
+    scoring_threads_ = omp_get_max_threads();
+  }
 
   pub_ = std::make_unique<DWBPublisher>(node, dwb_plugin_name_);
   pub_->on_configure();
@@ -133,6 +150,12 @@ void DWBLocalPlanner::configure(
     RCLCPP_ERROR(logger_, "Couldn't load critics! Caught exception: %s", e.what());
     throw;
   }
+
+  if (scoring_threads_ > 1 && !canScoreInParallel()) {
+    RCLCPP_WARN(
+      logger_, "scoring_threads is %i, but not all critics with non-zero scale are "
+      "thread-safe. Trajectories will be scored serially.", scoring_threads_);
+  }
 }
 
 void
@@ -291,7 +314,11 @@ DWBLocalPlanner::computeVelocityCommands(
   prepareGlobalPlan(pose, transformed_plan, goal_pose);
 
   nav2_costmap_2d::Costmap2D * costmap = costmap_ros_->getCostmap();
+  const auto lock_start = std::chrono::steady_clock::now();
   std::unique_lock<nav2_costmap_2d::Costmap2D::mutex_t> lock(*(costmap->getMutex()));
+  RCLCPP_DEBUG(
+    logger_, "Waited %f seconds for the costmap lock",
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - lock_start).count());
 
   for (TrajectoryCritic::Ptr & critic : critics_) {
     if (!critic->prepare(pose.pose, velocity, goal_pose.pose, transformed_plan)) {
@@ -348,13 +375,7 @@ DWBLocalPlanner::coreScoringAlgorithm(
   worst.total = -1;
   IllegalTrajectoryTracker tracker;
 
-  traj_generator_->startNewIteration(velocity);
-  while (traj_generator_->hasMoreTwists()) {
-    twist = traj_generator_->nextTwist();
-    traj = traj_generator_->generateTrajectory(pose, velocity, twist);
-
-    try {
-      dwb_msgs::msg::TrajectoryScore score = scoreTrajectory(traj, best.total);
+  auto add_legal_trajectory = [&](const dwb_msgs::msg::TrajectoryScore & score) {
       tracker.addLegalTrajectory();
       if (results) {
         results->twists.push_back(score);
@@ -371,10 +392,14 @@ DWBLocalPlanner::coreScoringAlgorithm(
           results->worst_index = results->twists.size() - 1;
         }
       }
-    } catch (const dwb_core::IllegalTrajectoryException & e) {
+    };
+
+  auto add_illegal_trajectory = [&](
+    const dwb_msgs::msg::Trajectory2D & illegal_traj,
+    const dwb_core::IllegalTrajectoryException & e) {
       if (results) {
         dwb_msgs::msg::TrajectoryScore failed_score;
-        failed_score.traj = traj;
+        failed_score.traj = illegal_traj;
 
         dwb_msgs::msg::CriticScore cs;
         cs.name = e.getCriticName();
@@ -384,9 +409,92 @@ DWBLocalPlanner::coreScoringAlgorithm(
         results->twists.push_back(failed_score);
       }
       tracker.addIllegalTrajectory(e);
+    };
+
+  pruned_trajectories_ = 0;
+  skipped_evaluations_ = 0;
+  skipped_time_ns_ = 0;
+  if (critic_pruning_) {
+    updateCriticOrder();
+  }
+
+  traj_generator_->startNewIteration(velocity);
+
+  if (scoring_threads_ > 1 && canScoreInParallel()) {
+    std::vector<nav_2d_msgs::msg::Twist2D> twists;
+    while (traj_generator_->hasMoreTwists()) {
+      twists.push_back(traj_generator_->nextTwist());
+    }
+
+    const int num_twists = static_cast<int>(twists.size());
+    const bool parallel_generation = traj_generator_->isThreadSafe();
+    std::vector<dwb_msgs::msg::Trajectory2D> trajs(num_twists);
+    std::vector<dwb_msgs::msg::TrajectoryScore> scores(num_twists);
+    std::vector<std::exception_ptr> errors(num_twists);
+    if (!parallel_generation) {
+      for (int i = 0; i < num_twists; i++) {
+        trajs[i] = traj_generator_->generateTrajectory(pose, velocity, twists[i]);
+      }
+    }
+
+    #pragma omp parallel num_threads(scoring_threads_)
+    {
+      // Each thread scores one contiguous block in order and short circuits against the
+      // best of its own block, so the scores don't depend on the timing of other threads.
+      // That best is never below the overall best, so the best trajectory is still scored
+      // in full, but the others may be cut short at other critics than in serial scoring.
+      double thread_best = -1;
+      #pragma omp for schedule(static)
+      for (int i = 0; i < num_twists; i++) {
+        try {
+          if (parallel_generation) {
+            trajs[i] = traj_generator_->generateTrajectory(pose, velocity, twists[i]);
+          }
+          scores[i] = scoreTrajectory(trajs[i], thread_best);
+          if (thread_best < 0 || scores[i].total < thread_best) {
+            thread_best = scores[i].total;
+          }
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      }
+    }
+
+    // Reduce in sample order, so ties resolve to the same trajectory as serial scoring
+    for (int i = 0; i < num_twists; i++) {
+      if (!errors[i]) {
+        add_legal_trajectory(scores[i]);
+        continue;
+      }
+      try {
+        std::rethrow_exception(errors[i]);
+      } catch (const dwb_core::IllegalTrajectoryException & e) {
+        add_illegal_trajectory(trajs[i], e);
+      }
+    }
+  } else {
+    while (traj_generator_->hasMoreTwists()) {
+      twist = traj_generator_->nextTwist();
+      traj = traj_generator_->generateTrajectory(pose, velocity, twist);
+
+      try {
+        add_legal_trajectory(scoreTrajectory(traj, best.total));
+      } catch (const dwb_core::IllegalTrajectoryException & e) {
+        add_illegal_trajectory(traj, e);
+      }
     }
   }
 
+  if (results) {
+    results->pruned_count = pruned_trajectories_;
+    results->skipped_critic_evaluations = skipped_evaluations_;
+    results->pruning_time_saved = rclcpp::Duration::from_nanoseconds(skipped_time_ns_);
+  }
+
+  if (best.total > 0) {
+    last_best_total_ = best.total;
+  }
+
   if (best.total < 0) {
     if (debug_trajectory_details_) {
       RCLCPP_ERROR(rclcpp::get_logger("DWBLocalPlanner"), "%s", tracker.getMessage().c_str());
@@ -408,10 +516,15 @@ DWBLocalPlanner::scoreTrajectory(
   const dwb_msgs::msg::Trajectory2D & traj,
   double best_score)
 {
+  if (critic_pruning_ && critic_order_.size() == critics_.size()) {
+    return scoreTrajectoryWithPruning(traj, best_score);
+  }
+
   dwb_msgs::msg::TrajectoryScore score;
   score.traj = traj;
 
-  for (TrajectoryCritic::Ptr & critic : critics_) {
+  for (unsigned int i = 0; i < critics_.size(); i++) {
+    TrajectoryCritic::Ptr & critic = critics_[i];
     dwb_msgs::msg::CriticScore cs;
     cs.name = critic->getName();
     cs.scale = critic->getScale();
@@ -427,13 +540,172 @@ DWBLocalPlanner::scoreTrajectory(
     score.total += critic_score * cs.scale;
     if (short_circuit_trajectory_evaluation_ && best_score > 0 && score.total > best_score) {
       // since we keep adding positives, once we are worse than the best, we will stay worse
+      recordPruning(i + 1, false);
+      break;
+    }
+  }
+
+  return score;
+}
+
+dwb_msgs::msg::TrajectoryScore
+DWBLocalPlanner::scoreTrajectoryWithPruning(
+  const dwb_msgs::msg::Trajectory2D & traj,
+  double best_score)
+{
+  // Only time a fraction of the critic calls, to keep the bookkeeping cheap
+  static constexpr unsigned int stats_sample_period = 8;
+  const bool sample =
+    stats_sample_counter_.fetch_add(1, std::memory_order_relaxed) % stats_sample_period == 0;
+
+  dwb_msgs::msg::TrajectoryScore score;
+  score.traj = traj;
+  score.scores.resize(critics_.size());
+
+  // Weighted lower bounds of the critics not yet evaluated
+  std::vector<double> & lower_bounds = lower_bounds_[omp_get_thread_num()];
+  double remaining_bound = 0.0;
+  for (unsigned int i = 0; i < critics_.size(); i++) {
+    dwb_msgs::msg::CriticScore & cs = score.scores[i];
+    cs.name = critics_[i]->getName();
+    cs.scale = critics_[i]->getScale();
+    lower_bounds[i] = cs.scale == 0.0 ? 0.0 : cs.scale * critics_[i]->getLowerBound(traj);
+    remaining_bound += lower_bounds[i];
+  }
+
+  for (unsigned int k = 0; k < critic_order_.size(); k++) {
+    const unsigned int i = critic_order_[k];
+    dwb_msgs::msg::CriticScore & cs = score.scores[i];
+    if (cs.scale == 0.0) {
+      continue;
+    }
+
+    // The final score is at least the bound, so this trajectory can no longer be the best.
+    // Report the bound as its total, which is worse than the best.
+    if (best_score > 0 && score.total + remaining_bound > best_score) {
+      score.total += remaining_bound;
+      recordPruning(k, true);
       break;
     }
+    remaining_bound -= lower_bounds[i];
+
+    CriticStats & stats = critic_stats_[i];
+    steady_clock::time_point start;
+    if (sample) {
+      start = steady_clock::now();
+    }
+
+    double critic_score;
+    try {
+      critic_score = critics_[i]->scoreTrajectory(traj);
+    } catch (const dwb_core::IllegalTrajectoryException &) {
+      if (sample) {
+        stats.calls++;
+        stats.rejections++;
+        stats.time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+          steady_clock::now() - start).count();
+      }
+      throw;
+    }
+
+    cs.raw_score = critic_score;
+    score.total += critic_score * cs.scale;
+
+    if (sample) {
+      stats.calls++;
+      stats.time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        steady_clock::now() - start).count();
+      stats.micro_score += static_cast<uint64_t>(std::max(0.0, critic_score * cs.scale) * 1e6);
+    }
   }
 
   return score;
 }
 
+void
+DWBLocalPlanner::recordPruning(unsigned int step, bool ordered)
+{
+  uint64_t skipped = 0;
+  double skipped_time_ns = 0.0;
+  for (unsigned int k = step; k < critics_.size(); k++) {
+    const unsigned int i = ordered ? critic_order_[k] : k;
+    if (critics_[i]->getScale() != 0.0) {
+      skipped++;
+      if (i < mean_time_ns_.size()) {
+        skipped_time_ns += mean_time_ns_[i];
+      }
+    }
+  }
+
+  pruned_trajectories_++;
+  skipped_evaluations_ += skipped;
+  skipped_time_ns_ += static_cast<uint64_t>(skipped_time_ns);
+}
+
+void
+DWBLocalPlanner::updateCriticOrder()
+{
+  const unsigned int num_critics = critics_.size();
+  if (critic_stats_.size() != num_critics) {
+    critic_stats_ = std::vector<CriticStats>(num_critics);
+    critic_order_.clear();
+  }
+  if (critic_order_.size() != num_critics) {
+    critic_order_.resize(num_critics);
+    for (unsigned int i = 0; i < num_critics; i++) {
+      critic_order_[i] = i;
+    }
+  }
+  lower_bounds_.resize(std::max(scoring_threads_, 1));
+  for (std::vector<double> & lower_bounds : lower_bounds_) {
+    lower_bounds.resize(num_critics);
+  }
+
+  // Benefit per nanosecond of each critic: its mean weighted score, where rejecting a
+  // trajectory is worth as much as the last best score. Critics without samples yet go
+  // first, so they are measured.
+  std::vector<double> ratios(num_critics, std::numeric_limits<double>::max());
+  mean_time_ns_.assign(num_critics, 0.0);
+  for (unsigned int i = 0; i < num_critics; i++) {
+    CriticStats & stats = critic_stats_[i];
+    const uint64_t calls = stats.calls;
+    if (calls == 0) {
+      continue;
+    }
+
+    const uint64_t time_ns = stats.time_ns;
+    const uint64_t micro_score = stats.micro_score;
+    const uint64_t rejections = stats.rejections;
+    mean_time_ns_[i] = static_cast<double>(time_ns) / calls;
+    const double benefit =
+      (micro_score * 1e-6 + rejections * std::max(last_best_total_, 1.0)) / calls;
+    ratios[i] = benefit / std::max(mean_time_ns_[i], 1.0);
+
+    // Decay, so the order follows changes of the scene
+    stats.calls = calls / 2;
+    stats.time_ns = time_ns / 2;
+    stats.micro_score = micro_score / 2;
+    stats.rejections = rejections / 2;
+  }
+
+  std::stable_sort(
+    critic_order_.begin(), critic_order_.end(),
+    [&ratios](const unsigned int & a, const unsigned int & b) {
+      return ratios[a] > ratios[b];
+    });
+}
+
+bool
+DWBLocalPlanner::canScoreInParallel() const
+{
+  for (const TrajectoryCritic::Ptr & critic : critics_) {
+    if (critic->getScale() != 0.0 && !critic->isThreadSafe()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 double
 getSquareDistance(
   const geometry_msgs::msg::Pose2D & pose_a,
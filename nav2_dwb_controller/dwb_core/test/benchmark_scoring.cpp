@@ -0,0 +1,288 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2021, Locus Robotics
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Measures the latency of scoring all velocity samples of one control cycle, serially and
+// with several scoring threads, with and without critic pruning, with costmap,
+// path-following and rotation critics.
+// Usage: benchmark_scoring [runs]
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dwb_core/dwb_local_planner.hpp"
+#include "dwb_core/exceptions.hpp"
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_costmap_2d/cost_values.hpp"
+
+using namespace std::chrono;  // NOLINT
+using dwb_core::TrajectoryCritic;
+using dwb_core::TrajectoryGenerator;
+
+class GridGenerator : public TrajectoryGenerator
+{
+public:
+  GridGenerator(unsigned int num_x, unsigned int num_theta)
+  : num_x_(num_x), num_theta_(num_theta), index_(0) {}
+
+  void initialize(const nav2_util::LifecycleNode::SharedPtr &, const std::string &) override {}
+  void startNewIteration(const nav_2d_msgs::msg::Twist2D &) override {index_ = 0;}
+  bool hasMoreTwists() override {return index_ < num_x_ * num_theta_;}
+
+  nav_2d_msgs::msg::Twist2D nextTwist() override
+  {
+    nav_2d_msgs::msg::Twist2D twist;
+    twist.x = 0.5 * (index_ / num_theta_ + 1) / num_x_;
+    twist.theta = -1.0 + 2.0 * (index_ % num_theta_) / num_theta_;
+    index_++;
+    return twist;
+  }
+
+  dwb_msgs::msg::Trajectory2D generateTrajectory(
+    const geometry_msgs::msg::Pose2D & start_pose,
+    const nav_2d_msgs::msg::Twist2D &,
+    const nav_2d_msgs::msg::Twist2D & cmd_vel) override
+  {
+    dwb_msgs::msg::Trajectory2D traj;
+    traj.velocity = cmd_vel;
+    geometry_msgs::msg::Pose2D pose = start_pose;
+    traj.poses.push_back(pose);
+    for (int i = 0; i < 34; i++) {
+      pose.x += 0.05 * cmd_vel.x * cos(pose.theta);
+      pose.y += 0.05 * cmd_vel.x * sin(pose.theta);
+      pose.theta += 0.05 * cmd_vel.theta;
+      traj.poses.push_back(pose);
+    }
+    return traj;
+  }
+
+  bool isThreadSafe() const override {return true;}
+  void setSpeedLimit(const double &, const bool &) override {}
+
+protected:
+  unsigned int num_x_, num_theta_, index_;
+};
+
+// Sums the costs under the trajectory, rejecting trajectories through lethal cells
+class CostCritic : public TrajectoryCritic
+{
+public:
+  explicit CostCritic(nav2_costmap_2d::Costmap2D * costmap)
+  : costmap_(costmap)
+  {
+    name_ = "Cost";
+    scale_ = 0.02;
+  }
+
+  double scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj) override
+  {
+    double score = 0.0;
+    unsigned int mx, my;
+    for (const auto & pose : traj.poses) {
+      if (!costmap_->worldToMap(pose.x, pose.y, mx, my)) {
+        throw dwb_core::IllegalTrajectoryException(name_, "Trajectory Goes Off Grid.");
+      }
+      const unsigned char cost = costmap_->getCost(mx, my);
+      if (cost >= nav2_costmap_2d::INSCRIBED_INFLATED_OBSTACLE) {
+        throw dwb_core::IllegalTrajectoryException(name_, "Trajectory Hits Obstacle.");
+      }
+      score += cost;
+    }
+    return score;
+  }
+
+  bool isThreadSafe() const override {return true;}
+
+protected:
+  nav2_costmap_2d::Costmap2D * costmap_;
+};
+
+// Distance from every trajectory pose to the nearest pose of a reference path
+class PathCritic : public TrajectoryCritic
+{
+public:
+  PathCritic()
+  {
+    name_ = "Path";
+    scale_ = 1.0;
+    for (int i = 0; i < 200; i++) {
+      geometry_msgs::msg::Pose2D pose;
+      pose.x = 2.0 + 0.02 * i;
+      pose.y = 2.0 + 0.3 * sin(0.02 * i);
+      path_.push_back(pose);
+    }
+  }
+
+  double scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj) override
+  {
+    double score = 0.0;
+    for (const auto & pose : traj.poses) {
+      double min_sq = std::numeric_limits<double>::max();
+      for (const auto & path_pose : path_) {
+        const double dx = pose.x - path_pose.x;
+        const double dy = pose.y - path_pose.y;
+        min_sq = std::min(min_sq, dx * dx + dy * dy);
+      }
+      score += sqrt(min_sq);
+    }
+    return score;
+  }
+
+  bool isThreadSafe() const override {return true;}
+
+protected:
+  std::vector<geometry_msgs::msg::Pose2D> path_;
+};
+
+class RotationCritic : public TrajectoryCritic
+{
+public:
+  RotationCritic()
+  {
+    name_ = "Rotation";
+    scale_ = 2.0;
+  }
+
+  double scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj) override
+  {
+    return fabs(traj.velocity.theta);
+  }
+
+  double getLowerBound(const dwb_msgs::msg::Trajectory2D & traj) override
+  {
+    return scoreTrajectory(traj);
+  }
+
+  bool isThreadSafe() const override {return true;}
+};
+
+class BenchmarkPlanner : public dwb_core::DWBLocalPlanner
+{
+public:
+  BenchmarkPlanner(
+    unsigned int num_samples, int scoring_threads, bool critic_pruning,
+    nav2_costmap_2d::Costmap2D * costmap)
+  {
+    const unsigned int num_x = std::max(1u, static_cast<unsigned int>(sqrt(num_samples / 4.0)));
+    traj_generator_ = std::make_shared<GridGenerator>(num_x, num_samples / num_x);
+    critics_ = {std::make_shared<PathCritic>(), std::make_shared<CostCritic>(costmap),
+      std::make_shared<RotationCritic>()};
+    scoring_threads_ = scoring_threads;
+    critic_pruning_ = critic_pruning;
+    short_circuit_trajectory_evaluation_ = true;
+    debug_trajectory_details_ = false;
+  }
+
+  dwb_msgs::msg::TrajectoryScore score()
+  {
+    geometry_msgs::msg::Pose2D pose;
+    pose.x = 2.0;
+    pose.y = 2.0;
+    nav_2d_msgs::msg::Twist2D velocity;
+    std::shared_ptr<dwb_msgs::msg::LocalPlanEvaluation> results;
+    return coreScoringAlgorithm(pose, velocity, results);
+  }
+
+  uint64_t getSkippedEvaluations() const
+  {
+    return skipped_evaluations_;
+  }
+};
+
+int main(int argc, char ** argv)
+{
+  const int runs = argc > 1 ? std::atoi(argv[1]) : 50;
+
+  // 5x5 m local costmap with scattered obstacles and a cost gradient around them
+  nav2_costmap_2d::Costmap2D costmap(100, 100, 0.05, 0.0, 0.0, 0);
+  std::srand(42);
+  for (unsigned int i = 0; i != 60; i++) {
+    const int ox = std::rand() % 100;
+    const int oy = std::rand() % 100;
+    for (int y = std::max(0, oy - 4); y < std::min(100, oy + 5); y++) {
+      for (int x = std::max(0, ox - 4); x < std::min(100, ox + 5); x++) {
+        const double d = hypot(x - ox, y - oy);
+        const unsigned char cost = d < 1.5 ? nav2_costmap_2d::LETHAL_OBSTACLE :
+          static_cast<unsigned char>(std::max(0.0, 200.0 - 40.0 * d));
+        costmap.setCost(x, y, std::max(costmap.getCost(x, y), cost));
+      }
+    }
+  }
+  // Keep the start pose free
+  for (unsigned int y = 36; y != 44; y++) {
+    for (unsigned int x = 36; x != 44; x++) {
+      costmap.setCost(x, y, 0);
+    }
+  }
+
+  std::vector<int> thread_counts = {1, 2, 4};
+  if (omp_get_max_threads() > 4) {
+    thread_counts.push_back(omp_get_max_threads());
+  }
+
+  for (unsigned int num_samples : {100u, 400u, 1600u, 6400u}) {
+    for (int threads : thread_counts) {
+      for (bool pruning : {false, true}) {
+        BenchmarkPlanner planner(num_samples, threads, pruning, &costmap);
+        std::vector<double> latencies;
+        dwb_msgs::msg::TrajectoryScore best;
+        for (int run = 0; run != runs; run++) {
+          steady_clock::time_point a = steady_clock::now();
+          best = planner.score();
+          steady_clock::time_point b = steady_clock::now();
+          latencies.push_back(duration_cast<duration<double>>(b - a).count() * 1000.0);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << num_samples << " samples, " << threads << " threads" <<
+          (pruning ? ", pruning: " : ": ") <<
+          latencies[latencies.size() / 2] << " ms median, " <<
+          latencies[latencies.size() * 9 / 10] << " ms p90, " <<
+          planner.getSkippedEvaluations() << " critic calls skipped, best (" <<
+          best.traj.velocity.x << ", " << best.traj.velocity.theta << ") " << best.total <<
+          std::endl;
+      }
+    }
+  }
+
+  return 0;
+}
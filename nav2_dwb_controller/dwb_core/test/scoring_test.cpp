@@ -0,0 +1,298 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2021, Locus Robotics
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <omp.h>
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "dwb_core/dwb_local_planner.hpp"
+#include "dwb_core/exceptions.hpp"
+
+using dwb_core::TrajectoryCritic;
+using dwb_core::TrajectoryGenerator;
+
+class GridGenerator : public TrajectoryGenerator
+{
+public:
+  GridGenerator(unsigned int num_x, unsigned int num_theta)
+  : num_x_(num_x), num_theta_(num_theta), index_(0) {}
+
+  void initialize(const nav2_util::LifecycleNode::SharedPtr &, const std::string &) override {}
+  void startNewIteration(const nav_2d_msgs::msg::Twist2D &) override {index_ = 0;}
+  bool hasMoreTwists() override {return index_ < num_x_ * num_theta_;}
+
+  nav_2d_msgs::msg::Twist2D nextTwist() override
+  {
+    nav_2d_msgs::msg::Twist2D twist;
+    twist.x = -0.2 + 0.7 * (index_ / num_theta_) / num_x_;
+    twist.theta = -1.0 + 2.0 * (index_ % num_theta_) / num_theta_;
+    index_++;
+    return twist;
+  }
+
+  dwb_msgs::msg::Trajectory2D generateTrajectory(
+    const geometry_msgs::msg::Pose2D & start_pose,
+    const nav_2d_msgs::msg::Twist2D &,
+    const nav_2d_msgs::msg::Twist2D & cmd_vel) override
+  {
+    dwb_msgs::msg::Trajectory2D traj;
+    traj.velocity = cmd_vel;
+    geometry_msgs::msg::Pose2D pose = start_pose;
+    for (int i = 0; i < 20; i++) {
+      pose.x += 0.1 * cmd_vel.x * cos(pose.theta);
+      pose.y += 0.1 * cmd_vel.x * sin(pose.theta);
+      pose.theta += 0.1 * cmd_vel.theta;
+      traj.poses.push_back(pose);
+    }
+    return traj;
+  }
+
+  bool isThreadSafe() const override {return true;}
+  void setSpeedLimit(const double &, const bool &) override {}
+
+protected:
+  unsigned int num_x_, num_theta_, index_;
+};
+
+// Distance of the trajectory end to a target, rejecting reversing trajectories
+class TargetCritic : public TrajectoryCritic
+{
+public:
+  explicit TargetCritic(bool thread_safe)
+  : thread_safe_(thread_safe), parallel_calls_(0)
+  {
+    name_ = "Target";
+    scale_ = 1.0;
+  }
+
+  double scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj) override
+  {
+    if (omp_in_parallel()) {
+      parallel_calls_++;
+    }
+    if (traj.velocity.x < 0.0) {
+      throw dwb_core::IllegalTrajectoryException(name_, "Reversing.");
+    }
+    // Quantized, so that several trajectories tie for the best score
+    const auto & end = traj.poses.back();
+    return std::round(10.0 * hypot(end.x - 0.5, end.y - 0.3)) / 10.0;
+  }
+
+  bool isThreadSafe() const override {return thread_safe_;}
+
+  bool thread_safe_;
+  std::atomic<int> parallel_calls_;
+};
+
+class TwirlCritic : public TrajectoryCritic
+{
+public:
+  TwirlCritic()
+  {
+    name_ = "Twirl";
+    scale_ = 0.1;
+  }
+
+  double scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj) override
+  {
+    return fabs(traj.velocity.theta);
+  }
+
+  double getLowerBound(const dwb_msgs::msg::Trajectory2D & traj) override
+  {
+    return scoreTrajectory(traj);
+  }
+
+  bool isThreadSafe() const override {return true;}
+};
+
+class ScoringPlanner : public dwb_core::DWBLocalPlanner
+{
+public:
+  ScoringPlanner(
+    std::vector<TrajectoryCritic::Ptr> critics, int scoring_threads, bool critic_pruning = false)
+  {
+    traj_generator_ = std::make_shared<GridGenerator>(20, 21);
+    critics_ = critics;
+    scoring_threads_ = scoring_threads;
+    short_circuit_trajectory_evaluation_ = true;
+    debug_trajectory_details_ = false;
+    critic_pruning_ = critic_pruning;
+  }
+
+  using DWBLocalPlanner::short_circuit_trajectory_evaluation_;
+
+  dwb_msgs::msg::TrajectoryScore score(
+    std::shared_ptr<dwb_msgs::msg::LocalPlanEvaluation> & results)
+  {
+    geometry_msgs::msg::Pose2D pose;
+    nav_2d_msgs::msg::Twist2D velocity;
+    return coreScoringAlgorithm(pose, velocity, results);
+  }
+};
+
+TEST(ParallelScoring, SameResultsAsSerial)
+{
+  auto target = std::make_shared<TargetCritic>(true);
+  std::vector<TrajectoryCritic::Ptr> critics = {target, std::make_shared<TwirlCritic>()};
+
+  auto serial_results = std::make_shared<dwb_msgs::msg::LocalPlanEvaluation>();
+  ScoringPlanner serial(critics, 1);
+  serial.short_circuit_trajectory_evaluation_ = false;
+  auto serial_best = serial.score(serial_results);
+  EXPECT_EQ(target->parallel_calls_, 0);
+
+  // Without short circuiting, every trajectory is scored in full either way
+  for (int threads : {2, 3, 4, 8}) {
+    auto results = std::make_shared<dwb_msgs::msg::LocalPlanEvaluation>();
+    ScoringPlanner parallel(critics, threads);
+    parallel.short_circuit_trajectory_evaluation_ = false;
+    auto best = parallel.score(results);
+    EXPECT_EQ(best.total, serial_best.total);
+    EXPECT_EQ(best.traj.velocity.x, serial_best.traj.velocity.x);
+    EXPECT_EQ(best.traj.velocity.theta, serial_best.traj.velocity.theta);
+    EXPECT_EQ(results->best_index, serial_results->best_index);
+    EXPECT_EQ(results->worst_index, serial_results->worst_index);
+    ASSERT_EQ(results->twists.size(), serial_results->twists.size());
+
+    // Illegal trajectories are reported in sample order, as with serial scoring
+    for (unsigned int i = 0; i < results->twists.size(); i++) {
+      EXPECT_EQ(results->twists[i].total, serial_results->twists[i].total);
+      EXPECT_EQ(
+        results->twists[i].traj.velocity.theta, serial_results->twists[i].traj.velocity.theta);
+    }
+  }
+}
+
+TEST(ParallelScoring, ShortCircuitSameBestAsSerial)
+{
+  auto target = std::make_shared<TargetCritic>(true);
+  std::vector<TrajectoryCritic::Ptr> critics = {target, std::make_shared<TwirlCritic>()};
+
+  auto full_results = std::make_shared<dwb_msgs::msg::LocalPlanEvaluation>();
+  ScoringPlanner full(critics, 1);
+  full.short_circuit_trajectory_evaluation_ = false;
+  full.score(full_results);
+
+  auto serial_results = std::make_shared<dwb_msgs::msg::LocalPlanEvaluation>();
+  ScoringPlanner serial(critics, 1);
+  auto serial_best = serial.score(serial_results);
+  EXPECT_GT(serial_results->pruned_count, 0u);
+
+  for (int threads : {1, 2, 3, 4, 8}) {
+    auto results = std::make_shared<dwb_msgs::msg::LocalPlanEvaluation>();
+    ScoringPlanner parallel(critics, threads);
+    auto best = parallel.score(results);
+    EXPECT_EQ(best.total, serial_best.total);
+    EXPECT_EQ(best.traj.velocity.x, serial_best.traj.velocity.x);
+    EXPECT_EQ(best.traj.velocity.theta, serial_best.traj.velocity.theta);
+    EXPECT_EQ(results->best_index, serial_results->best_index);
+    EXPECT_GT(results->pruned_count, 0u);
+    ASSERT_EQ(results->twists.size(), full_results->twists.size());
+
+    // Each thread short circuits against the best of its own block, not the best so far of
+    // all twists, so only the best trajectory is certain to be scored as in serial scoring.
+    // The others are either scored in full, or cut short once worse than the best.
+    const auto & best_score = results->twists[results->best_index];
+    EXPECT_EQ(best_score.total, full_results->twists[results->best_index].total);
+    ASSERT_EQ(best_score.scores.size(), 2u);
+    for (unsigned int i = 0; i < results->twists.size(); i++) {
+      const double total = results->twists[i].total;
+      const double full_total = full_results->twists[i].total;
+      EXPECT_EQ(
+        results->twists[i].traj.velocity.theta, full_results->twists[i].traj.velocity.theta);
+      EXPECT_EQ(total < 0, full_total < 0);
+      if (total < 0) {
+        continue;
+      }
+      EXPECT_LE(total, full_total) << "twist " << i;
+      if (total != full_total) {
+        EXPECT_GT(total, best.total) << "twist " << i;
+      }
+    }
+  }
+}
+
+TEST(ParallelScoring, SerialFallback)
+{
+  auto target = std::make_shared<TargetCritic>(false);
+  std::vector<TrajectoryCritic::Ptr> critics = {target, std::make_shared<TwirlCritic>()};
+
+  std::shared_ptr<dwb_msgs::msg::LocalPlanEvaluation> results;
+  ScoringPlanner planner(critics, 4);
+  planner.score(results);
+  EXPECT_EQ(target->parallel_calls_, 0);
+
+  // Critics with zero scale are not called, so they don't need to be thread-safe
+  target->setScale(0.0);
+  critics.push_back(std::make_shared<TargetCritic>(true));
+  ScoringPlanner parallel(critics, 4);
+  parallel.score(results);
+  EXPECT_GT(std::static_pointer_cast<TargetCritic>(critics.back())->parallel_calls_, 0);
+}
+
+TEST(CriticPruning, SameBestAsExhaustive)
+{
+  std::vector<TrajectoryCritic::Ptr> critics =
+  {std::make_shared<TargetCritic>(true), std::make_shared<TwirlCritic>()};
+
+  auto exhaustive_results = std::make_shared<dwb_msgs::msg::LocalPlanEvaluation>();
+  ScoringPlanner exhaustive(critics, 1);
+  exhaustive.short_circuit_trajectory_evaluation_ = false;
+  auto exhaustive_best = exhaustive.score(exhaustive_results);
+  EXPECT_EQ(exhaustive_results->pruned_count, 0u);
+
+  for (int threads : {1, 4}) {
+    ScoringPlanner pruning(critics, threads, true);
+    // Several cycles, so critics are reordered by their measured cost and benefit
+    for (int cycle = 0; cycle < 3; cycle++) {
+      auto results = std::make_shared<dwb_msgs::msg::LocalPlanEvaluation>();
+      auto best = pruning.score(results);
+      EXPECT_EQ(best.total, exhaustive_best.total);
+      EXPECT_EQ(results->best_index, exhaustive_results->best_index);
+      EXPECT_GT(results->pruned_count, 0u);
+      EXPECT_GT(results->skipped_critic_evaluations, 0u);
+
+      // Critic scores are reported in the configured order
+      ASSERT_EQ(best.scores.size(), 2u);
+      EXPECT_EQ(best.scores[0].name, "Target");
+      EXPECT_EQ(best.scores[1].name, "Twirl");
+    }
+  }
+}
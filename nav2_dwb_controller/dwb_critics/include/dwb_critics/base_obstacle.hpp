@@ -58,12 +58,23 @@ class BaseObstacleCritic : public dwb_core::TrajectoryCritic
 {
 public:
   void onInit() override;
+
+  /**
+   * @brief Score a trajectory by scoring each of its poses with scorePose
+   *
+   * Unless batch_cost_lookup_ is cleared, the costs of the cells of all poses are looked
+   * up in one batch instead.
+   * @param traj Trajectory to score
+   */
   double scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj) override;
   void addCriticVisualization(
     std::vector<std::pair<std::string, std::vector<float>>> & cost_channels) override;
 
   /**
    * @brief Return the obstacle score for a particular pose
+   *
+   * Derived critics overriding this must clear batch_cost_lookup_ for scoreTrajectory to
+   * call it.
    * @param pose Pose to check
    */
   virtual double scorePose(const geometry_msgs::msg::Pose2D & pose);
@@ -76,8 +87,18 @@ public:
   virtual bool isValidCost(const unsigned char cost);
 
 protected:
+  /**
+   * @brief Score a trajectory by the costs of the cells of its poses, looked up in one
+   * batch. Equivalent to scoring each pose with BaseObstacleCritic::scorePose
+   * @param traj Trajectory to score
+   */
+  double scoreTrajectoryCells(const dwb_msgs::msg::Trajectory2D & traj);
+
   nav2_costmap_2d::Costmap2D * costmap_;
   bool sum_scores_;
+  // Whether scoreTrajectory may skip scorePose and look up the cells in one batch.
+  // Derived critics overriding scorePose must clear it
+  bool batch_cost_lookup_{true};
 };
 }  // namespace dwb_critics
 
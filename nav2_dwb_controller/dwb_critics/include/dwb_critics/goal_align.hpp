@@ -59,6 +59,7 @@ public:
     const geometry_msgs::msg::Pose2D & pose, const nav_2d_msgs::msg::Twist2D & vel,
     const geometry_msgs::msg::Pose2D & goal, const nav_2d_msgs::msg::Path2D & global_plan) override;
   double scorePose(const geometry_msgs::msg::Pose2D & pose) override;
+  bool isThreadSafe() const override {return true;}
 
 protected:
   double forward_point_distance_;
@@ -53,6 +53,7 @@ public:
   bool prepare(
     const geometry_msgs::msg::Pose2D & pose, const nav_2d_msgs::msg::Twist2D & vel,
     const geometry_msgs::msg::Pose2D & goal, const nav_2d_msgs::msg::Path2D & global_plan) override;
+  bool isThreadSafe() const override {return true;}
 
 protected:
   bool getLastPoseOnCostmap(
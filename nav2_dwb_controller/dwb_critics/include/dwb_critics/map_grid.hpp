@@ -64,6 +64,7 @@ public:
   // Standard TrajectoryCritic Interface
   void onInit() override;
   double scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj) override;
+  double getLowerBound(const dwb_msgs::msg::Trajectory2D & traj) override;
   void addCriticVisualization(
     std::vector<std::pair<std::string, std::vector<float>>> & cost_channels) override;
   double getScale() const override {return costmap_->getResolution() * 0.5 * scale_;}
@@ -65,6 +65,7 @@ Footprint getOrientedFootprint(
 class ObstacleFootprintCritic : public BaseObstacleCritic
 {
 public:
+  void onInit() override;
   bool prepare(
     const geometry_msgs::msg::Pose2D & pose, const nav_2d_msgs::msg::Twist2D & vel,
     const geometry_msgs::msg::Pose2D & goal, const nav_2d_msgs::msg::Path2D & global_plan) override;
@@ -73,6 +74,7 @@ public:
     const geometry_msgs::msg::Pose2D & pose,
     const Footprint & oriented_footprint);
   double getScale() const override {return costmap_->getResolution() * scale_;}
+  bool isThreadSafe() const override {return true;}
 
 protected:
   /**
@@ -48,6 +48,7 @@ public:
   bool prepare(
     const geometry_msgs::msg::Pose2D & pose, const nav_2d_msgs::msg::Twist2D & vel,
     const geometry_msgs::msg::Pose2D & goal, const nav_2d_msgs::msg::Path2D & global_plan) override;
+  bool isThreadSafe() const override {return true;}
 };
 
 }  // namespace dwb_critics
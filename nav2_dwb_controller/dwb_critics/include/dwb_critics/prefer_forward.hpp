@@ -57,6 +57,7 @@ public:
   : penalty_(1.0), strafe_x_(0.1), strafe_theta_(0.2), theta_scale_(10.0) {}
   void onInit() override;
   double scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj) override;
+  bool isThreadSafe() const override {return true;}
 
 private:
   double penalty_, strafe_x_, strafe_theta_, theta_scale_;
@@ -63,6 +63,10 @@ void BaseObstacleCritic::onInit()
 
 double BaseObstacleCritic::scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj)
 {
+  if (batch_cost_lookup_) {
+    return scoreTrajectoryCells(traj);
+  }
+
   double score = 0.0;
   for (unsigned int i = 0; i < traj.poses.size(); ++i) {
     double pose_score = scorePose(traj.poses[i]);
@@ -73,6 +77,41 @@ double BaseObstacleCritic::scoreTrajectory(const dwb_msgs::msg::Trajectory2D & t
   return score;
 }
 
+double BaseObstacleCritic::scoreTrajectoryCells(const dwb_msgs::msg::Trajectory2D & traj)
+{
+  // Find the cells of the poses up to the first one off of the grid,
+  // then look up their costs all at once
+  std::vector<unsigned int> cells;
+  cells.reserve(traj.poses.size());
+  unsigned int cell_x, cell_y;
+  for (const auto & pose : traj.poses) {
+    if (!costmap_->worldToMap(pose.x, pose.y, cell_x, cell_y)) {
+      break;
+    }
+    cells.push_back(costmap_->getIndex(cell_x, cell_y));
+  }
+
+  std::vector<unsigned char> costs(cells.size());
+  costmap_->getCosts(cells.data(), cells.size(), costs.data());
+
+  double score = 0.0;
+  for (const unsigned char & cost : costs) {
+    if (!isValidCost(cost)) {
+      throw dwb_core::
+            IllegalTrajectoryException(name_, "Trajectory Hits Obstacle.");
+    }
+    // Optimized/branchless version of if (sum_scores_) score += pose_score,
+    // else score = pose_score;
+    score = static_cast<double>(sum_scores_) * score + cost;
+  }
+
+  if (cells.size() != traj.poses.size()) {
+    throw dwb_core::
+          IllegalTrajectoryException(name_, "Trajectory Goes Off Grid.");
+  }
+  return score;
+}
+
 double BaseObstacleCritic::scorePose(const geometry_msgs::msg::Pose2D & pose)
 {
   unsigned int cell_x, cell_y;
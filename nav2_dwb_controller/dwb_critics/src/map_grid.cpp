@@ -155,6 +155,21 @@ double MapGridCritic::scoreTrajectory(const dwb_msgs::msg::Trajectory2D & traj)
   return score;
 }
 
+double MapGridCritic::getLowerBound(const dwb_msgs::msg::Trajectory2D & traj)
+{
+  // Grid scores are not negative, so the score of the last pose bounds both the sum and
+  // the last score
+  if (traj.poses.empty() || aggregationType_ == ScoreAggregationType::Product) {
+    return 0.0;
+  }
+
+  try {
+    return scorePose(traj.poses.back());
+  } catch (const dwb_core::IllegalTrajectoryException &) {
+    return 0.0;
+  }
+}
+
 double MapGridCritic::scorePose(const geometry_msgs::msg::Pose2D & pose)
 {
   unsigned int cell_x, cell_y;
@@ -60,6 +60,13 @@ Footprint getOrientedFootprint(
   return oriented_footprint;
 }
 
+void ObstacleFootprintCritic::onInit()
+{
+  BaseObstacleCritic::onInit();
+  // Poses are scored by their footprint, not their cell
+  batch_cost_lookup_ = false;
+}
+
 bool ObstacleFootprintCritic::prepare(
   const geometry_msgs::msg::Pose2D &, const nav_2d_msgs::msg::Twist2D &,
   const geometry_msgs::msg::Pose2D &, const nav_2d_msgs::msg::Path2D &)
@@ -90,43 +97,41 @@ double ObstacleFootprintCritic::scorePose(
 {
   // now we really have to lay down the footprint in the costmap grid
   unsigned int x0, x1, y0, y1;
-  double line_cost = 0.0;
-  double footprint_cost = 0.0;
+  const unsigned char * costs = costmap_->getCharMap();
+  unsigned char footprint_cost = 0;
 
-  // we need to rasterize each line in the footprint
-  for (unsigned int i = 0; i < footprint.size() - 1; ++i) {
-    // get the cell coord of the first point
-    if (!costmap_->worldToMap(footprint[i].x, footprint[i].y, x0, y0)) {
-      throw dwb_core::
-            IllegalTrajectoryException(name_, "Footprint Goes Off Grid.");
-    }
+  // we need to rasterize each line in the footprint, including the one
+  // connecting the last point in the footprint to the first point, and
+  // check the cells in one pass as we go
+  if (!costmap_->worldToMap(footprint.front().x, footprint.front().y, x0, y0)) {
+    throw dwb_core::
+          IllegalTrajectoryException(name_, "Footprint Goes Off Grid.");
+  }
 
-    // get the cell coord of the second point
-    if (!costmap_->worldToMap(footprint[i + 1].x, footprint[i + 1].y, x1, y1)) {
+  for (unsigned int i = 1; i <= footprint.size(); ++i) {
+    const geometry_msgs::msg::Point & point = footprint[i % footprint.size()];
+    if (!costmap_->worldToMap(point.x, point.y, x1, y1)) {
       throw dwb_core::
             IllegalTrajectoryException(name_, "Footprint Goes Off Grid.");
     }
 
-    line_cost = lineCost(x0, x1, y0, y1);
-    footprint_cost = std::max(line_cost, footprint_cost);
-  }
-
-  // we also need to connect the first point in the footprint to the last point
-  // get the cell coord of the last point
-  if (!costmap_->worldToMap(footprint.back().x, footprint.back().y, x0, y0)) {
-    throw dwb_core::
-          IllegalTrajectoryException(name_, "Footprint Goes Off Grid.");
-  }
+    for (LineIterator line(x0, y0, x1, y1); line.isValid(); line.advance()) {
+      const unsigned char cost = costs[costmap_->getIndex(line.getX(), line.getY())];
+      // if the cell is in an obstacle the path is invalid or unknown
+      if (cost == nav2_costmap_2d::LETHAL_OBSTACLE) {
+        throw dwb_core::
+              IllegalTrajectoryException(name_, "Trajectory Hits Obstacle.");
+      } else if (cost == nav2_costmap_2d::NO_INFORMATION) {
+        throw dwb_core::
+              IllegalTrajectoryException(name_, "Trajectory Hits Unknown Region.");
+      }
+      footprint_cost = std::max(footprint_cost, cost);
+    }
 
-  // get the cell coord of the first point
-  if (!costmap_->worldToMap(footprint.front().x, footprint.front().y, x1, y1)) {
-    throw dwb_core::
-          IllegalTrajectoryException(name_, "Footprint Goes Off Grid.");
+    x0 = x1;
+    y0 = y1;
   }
 
-  line_cost = lineCost(x0, x1, y0, y1);
-  footprint_cost = std::max(line_cost, footprint_cost);
-
   // if all line costs are legal... then we can return that the footprint is legal
   return footprint_cost;
 }
@@ -157,6 +157,78 @@ TEST(BaseObstacle, CriticVisualization)
   }
 }
 
+// Overrides scorePose, so it opts out of the batch lookup for scoreTrajectory to call it
+// for every pose
+class PoseCountingCritic : public dwb_critics::BaseObstacleCritic
+{
+public:
+  PoseCountingCritic()
+  {
+    batch_cost_lookup_ = false;
+  }
+
+  double scorePose(const geometry_msgs::msg::Pose2D & pose) override
+  {
+    poses_scored_++;
+    return BaseObstacleCritic::scorePose(pose) + 1.0;
+  }
+
+  int poses_scored_{0};
+};
+
+TEST(BaseObstacle, ScoreTrajectory)
+{
+  auto node = nav2_util::LifecycleNode::make_shared("base_obstacle_critic_tester");
+
+  auto costmap_ros = std::make_shared<nav2_costmap_2d::Costmap2DROS>("test_global_costmap");
+  costmap_ros->configure();
+
+  std::string name = "name";
+  std::string ns = "ns";
+
+  auto critic = std::make_shared<dwb_critics::BaseObstacleCritic>();
+  critic->initialize(node, name, ns, costmap_ros);
+  auto counting_critic = std::make_shared<PoseCountingCritic>();
+  counting_critic->initialize(node, name, ns, costmap_ros);
+
+  costmap_ros->getCostmap()->setCost(1, 1, 10);
+  costmap_ros->getCostmap()->setCost(2, 1, 20);
+  costmap_ros->getCostmap()->setCost(3, 1, 30);
+  costmap_ros->getCostmap()->setCost(4, 1, nav2_costmap_2d::LETHAL_OBSTACLE);
+
+  // The (default) resolution is 0.1 m.
+  dwb_msgs::msg::Trajectory2D traj;
+  for (int i = 1; i <= 3; i++) {
+    geometry_msgs::msg::Pose2D pose;
+    pose.x = 0.1 * i + 0.05;
+    pose.y = 0.15;
+    traj.poses.push_back(pose);
+  }
+
+  // Without sum_scores, the score of the last pose
+  double expected_score = 0.0;
+  for (const auto & pose : traj.poses) {
+    expected_score = critic->scorePose(pose);
+  }
+  EXPECT_EQ(critic->scoreTrajectory(traj), expected_score);
+  EXPECT_EQ(critic->scoreTrajectory(traj), 30.0);
+
+  EXPECT_EQ(counting_critic->scoreTrajectory(traj), 31.0);
+  EXPECT_EQ(counting_critic->poses_scored_, 3);
+
+  // Illegal poses throw either way
+  geometry_msgs::msg::Pose2D pose;
+  pose.x = 0.45;
+  pose.y = 0.15;
+  traj.poses.push_back(pose);
+  EXPECT_THROW(critic->scoreTrajectory(traj), dwb_core::IllegalTrajectoryException);
+  EXPECT_THROW(counting_critic->scoreTrajectory(traj), dwb_core::IllegalTrajectoryException);
+
+  traj.poses.back().x = -0.1;
+  EXPECT_THROW(critic->scoreTrajectory(traj), dwb_core::IllegalTrajectoryException);
+  EXPECT_THROW(counting_critic->scoreTrajectory(traj), dwb_core::IllegalTrajectoryException);
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -179,6 +179,59 @@ TEST(ObstacleFootprint, Prepare)
 
 // todo: wilcobonestroo Add tests for other footprint shapes and costmaps.
 
+TEST(ObstacleFootprint, ScoreTrajectory)
+{
+  std::shared_ptr<dwb_critics::ObstacleFootprintCritic> critic =
+    std::make_shared<dwb_critics::ObstacleFootprintCritic>();
+
+  auto node = nav2_util::LifecycleNode::make_shared("costmap_tester");
+
+  auto costmap_ros = std::make_shared<nav2_costmap_2d::Costmap2DROS>("test_global_costmap");
+  costmap_ros->configure();
+
+  std::string name = "name";
+  std::string ns = "ns";
+  critic->initialize(node, name, ns, costmap_ros);
+
+  geometry_msgs::msg::Pose2D pose;
+  nav_2d_msgs::msg::Twist2D vel;
+  geometry_msgs::msg::Pose2D goal;
+  nav_2d_msgs::msg::Path2D global_plan;
+  costmap_ros->setRobotFootprint(getFootprint());
+  ASSERT_TRUE(critic->prepare(pose, vel, goal, global_plan));
+
+  // The footprint at (2.55, 2.55) spans cells 7 to 43 in x and 9 to 41 in y.
+  // Trajectories are scored by the footprint of their poses, not their cells.
+  pose.x = 2.55;
+  pose.y = 2.55;
+  dwb_msgs::msg::Trajectory2D traj;
+  traj.poses.push_back(pose);
+  costmap_ros->getCostmap()->setCost(25, 25, 50);
+  costmap_ros->getCostmap()->setCost(43, 30, 100);
+  EXPECT_EQ(critic->scorePose(pose), 100.0);
+  EXPECT_EQ(critic->scoreTrajectory(traj), 100.0);
+
+  // The first illegal cell along the footprint decides the exception, starting with
+  // the edge from the first to the second point, on the right
+  costmap_ros->getCostmap()->setCost(43, 25, nav2_costmap_2d::NO_INFORMATION);
+  costmap_ros->getCostmap()->setCost(7, 25, nav2_costmap_2d::LETHAL_OBSTACLE);
+  try {
+    critic->scoreTrajectory(traj);
+    FAIL() << "Footprint over an unknown cell";
+  } catch (const dwb_core::IllegalTrajectoryException & e) {
+    EXPECT_STREQ(e.what(), "Trajectory Hits Unknown Region.");
+  }
+
+  costmap_ros->getCostmap()->setCost(43, 25, nav2_costmap_2d::LETHAL_OBSTACLE);
+  costmap_ros->getCostmap()->setCost(7, 25, nav2_costmap_2d::NO_INFORMATION);
+  try {
+    critic->scoreTrajectory(traj);
+    FAIL() << "Footprint over an obstacle";
+  } catch (const dwb_core::IllegalTrajectoryException & e) {
+    EXPECT_STREQ(e.what(), "Trajectory Hits Obstacle.");
+  }
+}
+
 TEST(ObstacleFootprint, PointCost)
 {
   std::shared_ptr<OpenObstacleFootprintCritic> critic =
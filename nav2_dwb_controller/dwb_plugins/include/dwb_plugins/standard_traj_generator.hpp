@@ -67,6 +67,7 @@ public:
     const geometry_msgs::msg::Pose2D & start_pose,
     const nav_2d_msgs::msg::Twist2D & start_vel,
     const nav_2d_msgs::msg::Twist2D & cmd_vel) override;
+  bool isThreadSafe() const override {return true;}
 
   /**
    * @brief Limits the maximum linear speed of the robot.
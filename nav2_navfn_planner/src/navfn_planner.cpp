@@ -206,7 +206,11 @@ NavfnPlanner::makePlan(
   // clear the starting cell within the costmap because we know it can't be an obstacle
   clearRobotCell(mx, my);
 
+  const auto lock_start = std::chrono::steady_clock::now();
   std::unique_lock<nav2_costmap_2d::Costmap2D::mutex_t> lock(*(costmap_->getMutex()));
+  RCLCPP_DEBUG(
+    logger_, "Waited %f seconds for the costmap lock",
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - lock_start).count());
 
   // make sure to resize the underlying array that Navfn uses
   planner_->setNavArr(
@@ -31,6 +31,7 @@ RecoveryServer::RecoveryServer()
   declare_parameter(
     "costmap_topic",
     rclcpp::ParameterValue(std::string("local_costmap/costmap_raw")));
+  declare_parameter("use_costmap_updates", rclcpp::ParameterValue(false));
   declare_parameter(
     "footprint_topic",
     rclcpp::ParameterValue(std::string("local_costmap/published_footprint")));
@@ -74,11 +75,13 @@ RecoveryServer::on_configure(const rclcpp_lifecycle::State & /*state*/)
   transform_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_);
 
   std::string costmap_topic, footprint_topic;
+  bool use_costmap_updates;
   this->get_parameter("costmap_topic", costmap_topic);
+  this->get_parameter("use_costmap_updates", use_costmap_updates);
   this->get_parameter("footprint_topic", footprint_topic);
   this->get_parameter("transform_tolerance", transform_tolerance_);
   costmap_sub_ = std::make_unique<nav2_costmap_2d::CostmapSubscriber>(
-    shared_from_this(), costmap_topic);
+    shared_from_this(), costmap_topic, use_costmap_updates);
   footprint_sub_ = std::make_unique<nav2_costmap_2d::FootprintSubscriber>(
     shared_from_this(), footprint_topic, 1.0);
 
@@ -190,6 +190,13 @@ protected:
    */
   bool inCollision(const double & x, const double & y);
 
+  /**
+   * @brief Find the first of a batch of cells in collision
+   * @param cells Indices of the cells to check, in order
+   * @return Position in cells of the first cell in collision, cells.size() if none are
+   */
+  unsigned int firstCollision(const std::vector<unsigned int> & cells);
+
   /**
    * @brief Cost at a point
    * @param x Pose of pose x
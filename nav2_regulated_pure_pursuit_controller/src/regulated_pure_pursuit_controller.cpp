@@ -17,6 +17,7 @@
 #include <string>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "nav2_regulated_pure_pursuit_controller/regulated_pure_pursuit_controller.hpp"
 #include "nav2_core/exceptions.hpp"
@@ -369,6 +370,9 @@ bool RegulatedPurePursuitController::isCollisionImminent(
   curr_pose.y = robot_pose.pose.position.y;
   curr_pose.theta = tf2::getYaw(robot_pose.pose.orientation);
 
+  // Project the arc, then check all of its cells at once
+  std::vector<unsigned int> cells;
+  unsigned int mx, my;
   int i = 1;
   while (true) {
     // only forward simulate within time requested
@@ -383,17 +387,25 @@ bool RegulatedPurePursuitController::isCollisionImminent(
     curr_pose.y += projection_time * (linear_vel * sin(curr_pose.theta));
     curr_pose.theta += projection_time * angular_vel;
 
+    // nothing to collide with beyond the costmap
+    if (!costmap_->worldToMap(curr_pose.x, curr_pose.y, mx, my)) {
+      break;
+    }
+    cells.push_back(costmap_->getIndex(mx, my));
+
     // store it for visualization
     pose_msg.pose.position.x = curr_pose.x;
     pose_msg.pose.position.y = curr_pose.y;
     pose_msg.pose.position.z = 0.01;
     arc_pts_msg.poses.push_back(pose_msg);
+  }
 
-    // check for collision at this point
-    if (inCollision(curr_pose.x, curr_pose.y)) {
-      carrot_arc_pub_->publish(arc_pts_msg);
-      return true;
-    }
+  // check for collision along the arc, only visualizing it up to the collision
+  const unsigned int collision = firstCollision(cells);
+  if (collision != cells.size()) {
+    arc_pts_msg.poses.resize(collision + 1);
+    carrot_arc_pub_->publish(arc_pts_msg);
+    return true;
   }
 
   carrot_arc_pub_->publish(arc_pts_msg);
@@ -404,7 +416,9 @@ bool RegulatedPurePursuitController::isCollisionImminent(
 bool RegulatedPurePursuitController::inCollision(const double & x, const double & y)
 {
   unsigned int mx, my;
-  costmap_->worldToMap(x, y, mx, my);
+  if (!costmap_->worldToMap(x, y, mx, my)) {
+    return false;
+  }
 
   unsigned char cost = costmap_->getCost(mx, my);
 
@@ -415,6 +429,30 @@ bool RegulatedPurePursuitController::inCollision(const double & x, const double
   }
 }
 
+unsigned int RegulatedPurePursuitController::firstCollision(
+  const std::vector<unsigned int> & cells)
+{
+  // Most cells are far from obstacles, so rule out the batch with a single
+  // reduction before looking at individual costs
+  const unsigned int num_cells = cells.size();
+  if (costmap_->getMaxCost(cells.data(), num_cells) < INSCRIBED_INFLATED_OBSTACLE) {
+    return num_cells;
+  }
+
+  std::vector<unsigned char> costs(num_cells);
+  costmap_->getCosts(cells.data(), num_cells, costs.data());
+  const bool tracking_unknown = costmap_ros_->getLayeredCostmap()->isTrackingUnknown();
+  for (unsigned int i = 0; i != num_cells; i++) {
+    if (costs[i] >= INSCRIBED_INFLATED_OBSTACLE &&
+      !(tracking_unknown && costs[i] == NO_INFORMATION))
+    {
+      return i;
+    }
+  }
+
+  return num_cells;
+}
+
 double RegulatedPurePursuitController::costAtPose(const double & x, const double & y)
 {
   unsigned int mx, my;
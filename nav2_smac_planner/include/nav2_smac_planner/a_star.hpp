@@ -29,6 +29,8 @@
 #include "nav2_smac_planner/node_2d.hpp"
 #include "nav2_smac_planner/node_se2.hpp"
 #include "nav2_smac_planner/node_basic.hpp"
+#include "nav2_smac_planner/node_graph.hpp"
+#include "nav2_smac_planner/open_set.hpp"
 #include "nav2_smac_planner/types.hpp"
 #include "nav2_smac_planner/constants.hpp"
 
@@ -53,28 +55,15 @@ class AStarAlgorithm
 {
 public:
   typedef NodeT * NodePtr;
-  typedef std::unordered_map<unsigned int, NodeT> Graph;
+  typedef NodeGraph<NodeT> Graph;
   typedef std::vector<NodePtr> NodeVector;
-  typedef std::pair<float, NodeBasic<NodeT>> NodeElement;
+  typedef OpenSet<NodeT> NodeQueue;
+  typedef typename NodeQueue::NodeElement NodeElement;
   typedef typename NodeT::Coordinates Coordinates;
   typedef typename NodeT::CoordinateVector CoordinateVector;
   typedef typename NodeVector::iterator NeighborIterator;
   typedef std::function<bool (const unsigned int &, NodeT * &)> NodeGetter;
 
-  /**
-   * @struct nav2_smac_planner::NodeComparator
-   * @brief Node comparison for priority queue sorting
-   */
-  struct NodeComparator
-  {
-    bool operator()(const NodeElement & a, const NodeElement & b) const
-    {
-      return a.first > b.first;
-    }
-  };
-
-  typedef std::priority_queue<NodeElement, std::vector<NodeElement>, NodeComparator> NodeQueue;
-
   /**
    * @brief A constructor for nav2_smac_planner::PlannerServer
    * @param neighborhood The type of neighborhood to use for search (4 or 8 connected)
@@ -93,11 +82,15 @@ public:
    * @param max_on_approach_iterations Maximum number of iterations before returning a valid
    * path once within thresholds to refine path
    * comes at more compute time but smoother paths.
+   * @param graph_storage_type Storage backend of the search graph
+   * @param open_set_type Implementation of the open set
    */
   void initialize(
     const bool & allow_unknown,
     int & max_iterations,
-    const int & max_on_approach_iterations);
+    const int & max_on_approach_iterations,
+    const GraphStorageType & graph_storage_type = GraphStorageType::HASHMAP,
+    const OpenSetType & open_set_type = OpenSetType::PRIORITY_QUEUE);
 
   /**
    * @brief Creating path from given costmap, start, and goal
@@ -120,7 +113,7 @@ public:
     const unsigned int & x,
     const unsigned int & y,
     const unsigned int & dim_3,
-    nav2_costmap_2d::Costmap2D * & costmap);
+    const nav2_costmap_2d::Costmap2D * costmap);
 
   /**
    * @brief Set the goal for planning, as a node index
@@ -215,6 +208,12 @@ public:
    */
   unsigned int & getSizeDim3();
 
+  /**
+   * @brief Get the largest size of the open set during the last search
+   * @return Peak number of open set entries
+   */
+  unsigned int getPeakQueueSize();
+
 protected:
   /**
    * @brief Get pointer to next goal in open set
@@ -313,7 +312,7 @@ protected:
   GridCollisionChecker _collision_checker;
   nav2_costmap_2d::Footprint _footprint;
   bool _is_radius_footprint;
-  nav2_costmap_2d::Costmap2D * _costmap;
+  const nav2_costmap_2d::Costmap2D * _costmap;
 };
 
 }  // namespace nav2_smac_planner
@@ -12,7 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License. Reserved.
 
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
 #include "nav2_costmap_2d/footprint_collision_checker.hpp"
+#include "nav2_util/line_iterator.hpp"
 #include "nav2_smac_planner/constants.hpp"
 
 #ifndef NAV2_SMAC_PLANNER__COLLISION_CHECKER_HPP_
@@ -23,19 +29,61 @@ namespace nav2_smac_planner
 
 /**
  * @class nav2_smac_planner::GridCollisionChecker
- * @brief A costmap grid collision checker
+ * @brief A costmap grid collision checker. For footprints, the rasterized
+ * footprint is precomputed as a mask of cell offsets for each angle bin of
+ * the search and each range of sub-cell position over which the rasterized
+ * footprint does not change, so checking a pose is a max over the costmap at
+ * those offsets.
  */
 class GridCollisionChecker
-  : public nav2_costmap_2d::FootprintCollisionChecker<nav2_costmap_2d::Costmap2D *>
+  : public nav2_costmap_2d::FootprintCollisionChecker<const nav2_costmap_2d::Costmap2D *>
 {
 public:
+  /**
+   * @struct nav2_smac_planner::GridCollisionChecker::FootprintMask
+   * @brief Rasterized footprint cells at an angle bin and sub-cell offset,
+   * relative to the cell of the pose. Empty until first used.
+   */
+  struct FootprintMask
+  {
+    std::vector<std::pair<int, int>> cells;
+    std::vector<int> offsets;
+    int min_x{0};
+    int max_x{0};
+    int min_y{0};
+    int max_y{0};
+  };
+
+  /**
+   * @struct nav2_smac_planner::GridCollisionChecker::AngleBinMasks
+   * @brief Footprint masks of an angle bin. A footprint vertex moves to the
+   * next cell when the sub-cell offset of the pose crosses its threshold, so
+   * there is one mask for each range between consecutive thresholds in x and y.
+   */
+  struct AngleBinMasks
+  {
+    std::vector<std::pair<double, double>> points;
+    std::vector<double> thresholds_x;
+    std::vector<double> thresholds_y;
+    std::vector<FootprintMask> masks;
+  };
+
   /**
    * @brief A constructor for nav2_smac_planner::GridCollisionChecker
    * @param costmap The costmap to collision check against
+   * @param num_quantizations The number of angle bins to precompute footprints for
    */
   GridCollisionChecker(
-    nav2_costmap_2d::Costmap2D * costmap)
-  : FootprintCollisionChecker(costmap)
+    const nav2_costmap_2d::Costmap2D * costmap,
+    const unsigned int & num_quantizations = 1)
+  : FootprintCollisionChecker(costmap),
+    footprint_cost_(0.0),
+    footprint_is_radius_(true),
+    fill_footprint_(false),
+    num_quantizations_(std::max(num_quantizations, 1u)),
+    bin_size_(2.0f * static_cast<float>(M_PI) / static_cast<float>(num_quantizations_)),
+    mask_resolution_(0.0),
+    mask_size_x_(0)
   {
   }
 
@@ -43,11 +91,49 @@ public:
    * @brief Set the footprint to use with collision checker
    * @param footprint The footprint to collision check against
    * @param radius Whether or not the footprint is a circle and use radius collision checking
+   * @param fill Whether to check the area of the footprint rather than only its outline
    */
-  void setFootprint(const nav2_costmap_2d::Footprint & footprint, const bool & radius)
+  void setFootprint(
+    const nav2_costmap_2d::Footprint & footprint,
+    const bool & radius,
+    const bool & fill = false)
   {
     unoriented_footprint_ = footprint;
     footprint_is_radius_ = radius;
+    fill_footprint_ = fill;
+    masks_.clear();
+    updateFootprintMasks();
+  }
+
+  /**
+   * @brief Set the costmap to collision check against, updating the footprint
+   * masks if its resolution or width changed
+   * @param costmap The costmap to collision check against
+   */
+  void setCostmap(const nav2_costmap_2d::Costmap2D * costmap)
+  {
+    costmap_ = costmap;
+    updateFootprintMasks();
+  }
+
+  /**
+   * @brief Get the number of angle bins footprints are precomputed for
+   * @return Number of angle bins
+   */
+  inline const unsigned int & getNumQuantizations() const
+  {
+    return num_quantizations_;
+  }
+
+  /**
+   * @brief Get the precomputed footprint mask of an angle bin, for poses at
+   * whole cells
+   * @param bin Angle bin
+   * @return Footprint mask
+   */
+  const FootprintMask & getFootprintMask(const unsigned int & bin) const
+  {
+    return masks_.at(bin).masks.front();
   }
 
   /**
@@ -64,9 +150,11 @@ public:
     const float & theta,
     const bool & traverse_unknown)
   {
-    // Assumes setFootprint already set
-    double wx, wy;
-    costmap_->mapToWorld(static_cast<double>(x), static_cast<double>(y), wx, wy);
+    // Assumes setFootprint already set. Poses are at fractions of cells, so
+    // the footprint is checked at the pose rather than at its cell's center.
+    const double resolution = costmap_->getResolution();
+    const double wx = costmap_->getOriginX() + (static_cast<double>(x) + 0.5) * resolution;
+    const double wy = costmap_->getOriginY() + (static_cast<double>(y) + 0.5) * resolution;
 
     if (!footprint_is_radius_) {
       // if footprint, then we check for the footprint's points, but first see
@@ -88,9 +176,31 @@ public:
         return true;
       }
 
-      // if possible inscribed, need to check actual footprint pose
-      footprint_cost_ = footprintCostAtPose(
-        wx, wy, static_cast<double>(theta), unoriented_footprint_);
+      // if possible inscribed, need to check actual footprint pose. Use the
+      // precomputed mask if the pose is on an angle bin and fully on the map.
+      const float bin = theta / bin_size_;
+      const float rounded_bin = std::round(bin);
+      const int mx = static_cast<int>(std::floor(x));
+      const int my = static_cast<int>(std::floor(y));
+      const FootprintMask * mask = nullptr;
+      if (!masks_.empty() && std::fabs(bin - rounded_bin) < 1e-3f) {
+        int bin_index = static_cast<int>(rounded_bin) % static_cast<int>(num_quantizations_);
+        if (bin_index < 0) {
+          bin_index += num_quantizations_;
+        }
+        mask = &getSubCellMask(
+          masks_[bin_index], static_cast<double>(x) - mx, static_cast<double>(y) - my);
+      }
+
+      if (mask && mx + mask->min_x >= 0 && my + mask->min_y >= 0 &&
+        mx + mask->max_x < static_cast<int>(costmap_->getSizeInCellsX()) &&
+        my + mask->max_y < static_cast<int>(costmap_->getSizeInCellsY()))
+      {
+        footprint_cost_ = static_cast<double>(maskCost(*mask, mx, my));
+      } else {
+        footprint_cost_ = footprintCostAtPose(
+          wx, wy, static_cast<double>(theta), unoriented_footprint_);
+      }
       if (footprint_cost_ == UNKNOWN && traverse_unknown) {
         return false;
       }
@@ -122,9 +232,236 @@ public:
   }
 
 protected:
+  /**
+   * @brief Get the max cost of the costmap within a footprint mask
+   * @param mask Footprint mask to check
+   * @param mx X cell of footprint center, the mask must be within the costmap
+   * @param my Y cell of footprint center, the mask must be within the costmap
+   * @return Max cost within footprint
+   */
+  inline unsigned char maskCost(const FootprintMask & mask, const int & mx, const int & my) const
+  {
+    const unsigned char * center =
+      costmap_->getCharMap() + my * static_cast<int>(mask_size_x_) + mx;
+    const int * offsets = mask.offsets.data();
+    const unsigned int num_offsets = mask.offsets.size();
+    unsigned char cost = 0;
+    // Branchless, so the compiler may vectorize the gather and max
+    for (unsigned int i = 0; i != num_offsets; i++) {
+      const unsigned char cell_cost = center[offsets[i]];
+      cost = cell_cost > cost ? cell_cost : cost;
+    }
+    return cost;
+  }
+
+  /**
+   * @brief Get the footprint mask of an angle bin for a sub-cell offset of
+   * the pose, rasterizing it on first use
+   * @param bin_masks Masks of the angle bin
+   * @param offset_x Offset of the pose in its cell in x, in [0, 1)
+   * @param offset_y Offset of the pose in its cell in y, in [0, 1)
+   * @return Footprint mask
+   */
+  const FootprintMask & getSubCellMask(
+    AngleBinMasks & bin_masks, const double & offset_x, const double & offset_y)
+  {
+    const auto & tx = bin_masks.thresholds_x;
+    const auto & ty = bin_masks.thresholds_y;
+    const unsigned int ix = std::upper_bound(tx.begin(), tx.end(), offset_x) - tx.begin();
+    const unsigned int iy = std::upper_bound(ty.begin(), ty.end(), offset_y) - ty.begin();
+    FootprintMask & mask = bin_masks.masks[iy * (tx.size() + 1) + ix];
+    if (mask.cells.empty()) {
+      rasterizeFootprint(bin_masks, ix, iy, mask);
+      updateOffsets(mask);
+    }
+    return mask;
+  }
+
+  /**
+   * @brief Set up the masks of each angle bin if the footprint or costmap
+   * resolution changed, and their offsets if the costmap width changed,
+   * since they were last computed. Only the masks for poses at whole cells
+   * are rasterized up front.
+   */
+  void updateFootprintMasks()
+  {
+    if (footprint_is_radius_ || unoriented_footprint_.empty() || !costmap_) {
+      masks_.clear();
+      return;
+    }
+
+    const double resolution = costmap_->getResolution();
+    if (masks_.empty() || resolution != mask_resolution_) {
+      mask_resolution_ = resolution;
+      masks_.assign(num_quantizations_, AngleBinMasks());
+      for (unsigned int i = 0; i != num_quantizations_; i++) {
+        initAngleBin(static_cast<double>(i * bin_size_), masks_[i]);
+      }
+      mask_size_x_ = 0;
+    }
+
+    const unsigned int size_x = costmap_->getSizeInCellsX();
+    if (size_x != mask_size_x_) {
+      mask_size_x_ = size_x;
+      for (auto & bin_masks : masks_) {
+        for (auto & mask : bin_masks.masks) {
+          updateOffsets(mask);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Compute the costmap offsets of a mask's cells for the costmap width
+   * @param mask Mask to update
+   */
+  void updateOffsets(FootprintMask & mask) const
+  {
+    mask.offsets.clear();
+    mask.offsets.reserve(mask.cells.size());
+    for (const auto & cell : mask.cells) {
+      mask.offsets.push_back(cell.second * static_cast<int>(mask_size_x_) + cell.first);
+    }
+  }
+
+  /**
+   * @brief Rotate the footprint to an angle bin and find the sub-cell offsets
+   * at which its vertices move to the next cell
+   * @param theta Angle of footprint
+   * @param bin_masks Masks of the angle bin to set up
+   */
+  void initAngleBin(const double & theta, AngleBinMasks & bin_masks) const
+  {
+    const double cos_th = cos(theta);
+    const double sin_th = sin(theta);
+    bin_masks.points.clear();
+    bin_masks.thresholds_x.clear();
+    bin_masks.thresholds_y.clear();
+    for (const auto & pt : unoriented_footprint_) {
+      const double px = (pt.x * cos_th - pt.y * sin_th) / mask_resolution_;
+      const double py = (pt.x * sin_th + pt.y * cos_th) / mask_resolution_;
+      bin_masks.points.emplace_back(px, py);
+
+      // A vertex is in cell floor(offset + 0.5 + p) of the pose's cell, which
+      // steps up once the offset reaches ceil(0.5 + p) - (0.5 + p)
+      const double step_x = std::ceil(px + 0.5) - (px + 0.5);
+      const double step_y = std::ceil(py + 0.5) - (py + 0.5);
+      if (step_x > 0.0) {
+        bin_masks.thresholds_x.push_back(step_x);
+      }
+      if (step_y > 0.0) {
+        bin_masks.thresholds_y.push_back(step_y);
+      }
+    }
+
+    for (auto * thresholds : {&bin_masks.thresholds_x, &bin_masks.thresholds_y}) {
+      std::sort(thresholds->begin(), thresholds->end());
+      thresholds->erase(std::unique(thresholds->begin(), thresholds->end()), thresholds->end());
+    }
+
+    bin_masks.masks.assign(
+      (bin_masks.thresholds_x.size() + 1) * (bin_masks.thresholds_y.size() + 1),
+      FootprintMask());
+    rasterizeFootprint(bin_masks, 0, 0, bin_masks.masks.front());
+  }
+
+  /**
+   * @brief Rasterize the footprint for a range of sub-cell offsets of the
+   * pose, matching the cells footprintCostAtPose checks for a pose in it
+   * @param bin_masks Masks of the angle bin
+   * @param ix Index of the range of sub-cell offsets in x
+   * @param iy Index of the range of sub-cell offsets in y
+   * @param mask Mask to populate
+   */
+  void rasterizeFootprint(
+    const AngleBinMasks & bin_masks, const unsigned int & ix, const unsigned int & iy,
+    FootprintMask & mask) const
+  {
+    // The vertices are in the same cells over the whole range, so rasterize
+    // them at its middle to stay clear of rounding at its ends. The filled
+    // area is that at the start of the range, so at whole cells for the first.
+    const auto & tx = bin_masks.thresholds_x;
+    const auto & ty = bin_masks.thresholds_y;
+    const double start_x = ix == 0 ? 0.0 : tx[ix - 1];
+    const double start_y = iy == 0 ? 0.0 : ty[iy - 1];
+    const double middle_x = 0.5 * (start_x + (ix == tx.size() ? 1.0 : tx[ix]));
+    const double middle_y = 0.5 * (start_y + (iy == ty.size() ? 1.0 : ty[iy]));
+
+    const std::vector<std::pair<double, double>> & points = bin_masks.points;
+    std::vector<std::pair<int, int>> vertices;
+    vertices.reserve(points.size());
+    for (const auto & point : points) {
+      vertices.emplace_back(
+        static_cast<int>(std::floor(middle_x + 0.5 + point.first)),
+        static_cast<int>(std::floor(middle_y + 0.5 + point.second)));
+    }
+
+    std::vector<std::pair<int, int>> & cells = mask.cells;
+    cells.clear();
+    for (unsigned int i = 0; i != vertices.size(); i++) {
+      const auto & start = vertices[i];
+      const auto & end = vertices[(i + 1) % vertices.size()];
+      for (nav2_util::LineIterator line(start.first, start.second, end.first, end.second);
+        line.isValid(); line.advance())
+      {
+        cells.emplace_back(line.getX(), line.getY());
+      }
+    }
+
+    mask.min_x = mask.max_x = cells.front().first;
+    mask.min_y = mask.max_y = cells.front().second;
+    for (const auto & cell : cells) {
+      mask.min_x = std::min(mask.min_x, cell.first);
+      mask.max_x = std::max(mask.max_x, cell.first);
+      mask.min_y = std::min(mask.min_y, cell.second);
+      mask.max_y = std::max(mask.max_y, cell.second);
+    }
+
+    if (fill_footprint_) {
+      // Add the cells whose centers are inside of the footprint polygon. The
+      // footprint center is offset from the center of cell (0, 0) by the
+      // sub-cell offset, so cell (i, j) has its center at (i, j) less the
+      // offset in the footprint's frame, in cells.
+      for (int j = mask.min_y; j <= mask.max_y; j++) {
+        const double cy = j - start_y;
+        for (int i = mask.min_x; i <= mask.max_x; i++) {
+          const double cx = i - start_x;
+          bool inside = false;
+          for (unsigned int k = 0, l = points.size() - 1; k != points.size(); l = k++) {
+            const auto & a = points[k];
+            const auto & b = points[l];
+            if ((a.second > cy) != (b.second > cy) &&
+              cx < (b.first - a.first) * (cy - a.second) / (b.second - a.second) + a.first)
+            {
+              inside = !inside;
+            }
+          }
+          if (inside) {
+            cells.emplace_back(i, j);
+          }
+        }
+      }
+    }
+
+    // Sort by row for a cache friendly walk over the costmap, and drop
+    // the cells shared by consecutive edges
+    std::sort(
+      cells.begin(), cells.end(),
+      [](const std::pair<int, int> & a, const std::pair<int, int> & b) {
+        return a.second < b.second || (a.second == b.second && a.first < b.first);
+      });
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+  }
+
   nav2_costmap_2d::Footprint unoriented_footprint_;
   double footprint_cost_;
   bool footprint_is_radius_;
+  bool fill_footprint_;
+  unsigned int num_quantizations_;
+  float bin_size_;
+  double mask_resolution_;
+  unsigned int mask_size_x_;
+  std::vector<AngleBinMasks> masks_;
 };
 
 }  // namespace nav2_smac_planner
@@ -59,6 +59,71 @@ inline MotionModel fromString(const std::string & n)
   }
 }
 
+enum class GraphStorageType
+{
+  UNKNOWN = 0,
+  HASHMAP = 1,
+  DENSE = 2,
+};
+
+inline std::string toString(const GraphStorageType & n)
+{
+  switch (n) {
+    case GraphStorageType::HASHMAP:
+      return "Hashmap";
+    case GraphStorageType::DENSE:
+      return "Dense";
+    default:
+      return "Unknown";
+  }
+}
+
+inline GraphStorageType graphStorageTypeFromString(const std::string & n)
+{
+  if (n == "HASHMAP") {
+    return GraphStorageType::HASHMAP;
+  } else if (n == "DENSE") {
+    return GraphStorageType::DENSE;
+  } else {
+    return GraphStorageType::UNKNOWN;
+  }
+}
+
+enum class OpenSetType
+{
+  UNKNOWN = 0,
+  PRIORITY_QUEUE = 1,
+  INDEXED_HEAP = 2,
+  RADIX_HEAP = 3,
+};
+
+inline std::string toString(const OpenSetType & n)
+{
+  switch (n) {
+    case OpenSetType::PRIORITY_QUEUE:
+      return "Priority queue";
+    case OpenSetType::INDEXED_HEAP:
+      return "Indexed 4-ary heap";
+    case OpenSetType::RADIX_HEAP:
+      return "Radix heap";
+    default:
+      return "Unknown";
+  }
+}
+
+inline OpenSetType openSetTypeFromString(const std::string & n)
+{
+  if (n == "PRIORITY_QUEUE") {
+    return OpenSetType::PRIORITY_QUEUE;
+  } else if (n == "INDEXED_HEAP") {
+    return OpenSetType::INDEXED_HEAP;
+  } else if (n == "RADIX_HEAP") {
+    return OpenSetType::RADIX_HEAP;
+  } else {
+    return OpenSetType::UNKNOWN;
+  }
+}
+
 const float UNKNOWN = 255;
 const float OCCUPIED = 254;
 const float INSCRIBED = 253;
@@ -54,7 +54,7 @@ public:
     const nav2_util::LifecycleNode::WeakPtr & node,
     const std::string & global_frame,
     const std::string & topic_name,
-    nav2_costmap_2d::Costmap2D * const costmap,
+    const nav2_costmap_2d::Costmap2D * const costmap,
     const unsigned int & downsampling_factor);
 
   /**
@@ -79,6 +79,15 @@ public:
    */
   nav2_costmap_2d::Costmap2D * downsample(const unsigned int & downsampling_factor);
 
+  /**
+   * @brief Set the costmap to downsample, in place of the one given on configure
+   * @param costmap Costmap to downsample
+   */
+  void setCostmap(const nav2_costmap_2d::Costmap2D * costmap)
+  {
+    _costmap = costmap;
+  }
+
   /**
    * @brief Resize the downsampled costmap. Used in case the costmap changes and we need to update the downsampled version
    */
@@ -105,7 +114,7 @@ protected:
   unsigned int _downsampled_size_y;
   unsigned int _downsampling_factor;
   float _downsampled_resolution;
-  nav2_costmap_2d::Costmap2D * _costmap;
+  const nav2_costmap_2d::Costmap2D * _costmap;
   std::unique_ptr<nav2_costmap_2d::Costmap2D> _downsampled_costmap;
   std::unique_ptr<nav2_costmap_2d::Costmap2DPublisher> _downsampled_costmap_pub;
 };
@@ -0,0 +1,216 @@
+// Copyright (c) 2020, Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#ifndef NAV2_SMAC_PLANNER__DISTANCE_HEURISTIC_TABLE_HPP_
+#define NAV2_SMAC_PLANNER__DISTANCE_HEURISTIC_TABLE_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "ompl/base/StateSpace.h"
+
+#include "nav2_smac_planner/constants.hpp"
+
+namespace nav2_smac_planner
+{
+
+/**
+ * @class nav2_smac_planner::DistanceHeuristicTable
+ * @brief A lookup table of obstacle-free Dubin or Reeds-Shepp distances to a goal,
+ * as in the Hybrid-A* paper. Distances are invariant to translating and rotating
+ * both poses, so the table is indexed by the pose relative to the goal within a
+ * square window around it and is valid for any goal. Relative poses are rounded
+ * to the nearest cell, so each entry holds the least distance over its cell and
+ * lookups are lowered by the rounding slack, to not overestimate the exact distance
+ * and keep the heuristic admissible. Near the goal, where a fraction of a cell can
+ * change the distance by a whole loop, nodes are left to the exact distance. The
+ * table may be persisted to and memory-mapped from a cache file.
+ */
+class DistanceHeuristicTable
+{
+public:
+  /**
+   * @brief A constructor for nav2_smac_planner::DistanceHeuristicTable
+   */
+  DistanceHeuristicTable();
+
+  /**
+   * @brief A destructor for nav2_smac_planner::DistanceHeuristicTable
+   */
+  ~DistanceHeuristicTable();
+
+  DistanceHeuristicTable(const DistanceHeuristicTable &) = delete;
+  DistanceHeuristicTable & operator=(const DistanceHeuristicTable &) = delete;
+
+  /**
+   * @brief Build the table, or map it from the cache file if one exists for
+   * the same configuration
+   * @param state_space OMPL state space to compute distances with
+   * @param motion_model Motion model of the state space
+   * @param minimum_turning_radius Minimum turning radius in cells
+   * @param num_angle_quantization Number of angle bins
+   * @param window_size Width of the square window around the goal, in cells
+   * @param cache_dir Directory of the cache file, or empty to not persist the table
+   */
+  void initialize(
+    const ompl::base::StateSpacePtr & state_space,
+    const MotionModel & motion_model,
+    const float & minimum_turning_radius,
+    const unsigned int & num_angle_quantization,
+    const unsigned int & window_size,
+    const std::string & cache_dir);
+
+  /**
+   * @brief Get the distance from a node to the goal if within the window
+   * @param node_x Node X coordinate, in cells
+   * @param node_y Node Y coordinate, in cells
+   * @param node_theta Node angle bin
+   * @param goal_x Goal X coordinate, in cells
+   * @param goal_y Goal Y coordinate, in cells
+   * @param goal_theta Goal angle bin
+   * @param distance Lower bound of the distance, in cells, if found
+   * @return Whether the node is within the window of the table and far enough from the goal
+   */
+  inline bool lookup(
+    const float & node_x, const float & node_y, const float & node_theta,
+    const float & goal_x, const float & goal_y, const float & goal_theta,
+    float & distance) const
+  {
+    if (!_data) {
+      return false;
+    }
+
+    // De-rotate the node about the goal, so the goal is at (0, 0, 0)
+    const unsigned int goal_bin = static_cast<unsigned int>(goal_theta) % _num_angle_quantization;
+    const float cos_th = _cos_bins[goal_bin];
+    const float sin_th = -_sin_bins[goal_bin];
+    const float dx = node_x - goal_x;
+    const float dy = node_y - goal_y;
+    if (dx * dx + dy * dy < _exact_radius_sq) {
+      return false;
+    }
+
+    const int x = static_cast<int>(std::lround(dx * cos_th - dy * sin_th));
+    const int y = static_cast<int>(std::lround(dx * sin_th + dy * cos_th));
+    if (x < -_half_size || x > _half_size || y < -_half_size || y > _half_size) {
+      return false;
+    }
+
+    int dtheta = static_cast<int>(node_theta) - static_cast<int>(goal_bin);
+    const int bins = static_cast<int>(_num_angle_quantization);
+    dtheta = ((dtheta % bins) + bins) % bins;
+
+    distance = std::max(_data[getIndex(x, y, static_cast<unsigned int>(dtheta))] - _slack, 0.0f);
+    return true;
+  }
+
+  /**
+   * @brief Whether the table was initialized with a configuration
+   * @param motion_model Motion model of the state space
+   * @param minimum_turning_radius Minimum turning radius in cells
+   * @param num_angle_quantization Number of angle bins
+   * @param window_size Width of the square window around the goal, in cells
+   * @param cache_dir Directory of the cache file
+   * @return If initialize would give the same table
+   */
+  inline bool isInitializedFor(
+    const MotionModel & motion_model,
+    const float & minimum_turning_radius,
+    const unsigned int & num_angle_quantization,
+    const unsigned int & window_size,
+    const std::string & cache_dir) const
+  {
+    return _data && _motion_model == motion_model &&
+           _minimum_turning_radius == minimum_turning_radius &&
+           _num_angle_quantization == num_angle_quantization &&
+           _half_size == static_cast<int>(window_size / 2) && _cache_dir == cache_dir;
+  }
+
+  /**
+   * @brief Whether the table was mapped from a cache file rather than built
+   * @return If loaded from cache
+   */
+  inline bool wasLoadedFromCache() const
+  {
+    return _mapping != nullptr;
+  }
+
+  /**
+   * @brief Get the path of the cache file for the current configuration
+   * @return Cache file path, empty if not persisted
+   */
+  inline const std::string & getCachePath() const
+  {
+    return _cache_path;
+  }
+
+protected:
+  /**
+   * @brief Index of a goal-relative pose in the table
+   * @param x Relative X, in [-half_size, half_size]
+   * @param y Relative Y, in [-half_size, half_size]
+   * @param dtheta Relative angle bin
+   * @return Index
+   */
+  inline unsigned int getIndex(const int & x, const int & y, const unsigned int & dtheta) const
+  {
+    return (static_cast<unsigned int>(y + _half_size) * _width +
+           static_cast<unsigned int>(x + _half_size)) * _num_angle_quantization + dtheta;
+  }
+
+  /**
+   * @brief Compute the table with the state space
+   * @param state_space OMPL state space to compute distances with
+   */
+  void build(const ompl::base::StateSpacePtr & state_space);
+
+  /**
+   * @brief Memory-map the table from the cache file if it matches the configuration
+   * @return Whether the table was loaded
+   */
+  bool load();
+
+  /**
+   * @brief Write the table to the cache file
+   * @return Whether the table was saved
+   */
+  bool save() const;
+
+  /**
+   * @brief Release the built or mapped table
+   */
+  void release();
+
+  MotionModel _motion_model;
+  float _minimum_turning_radius;
+  unsigned int _num_angle_quantization;
+  int _half_size;
+  unsigned int _width;
+  float _slack;
+  float _exact_radius_sq;
+  std::string _cache_dir;
+  std::string _cache_path;
+  std::vector<float> _cos_bins;
+  std::vector<float> _sin_bins;
+  std::vector<float> _table;
+  const float * _data;
+  void * _mapping;
+  size_t _mapping_size;
+};
+
+}  // namespace nav2_smac_planner
+
+#endif  // NAV2_SMAC_PLANNER__DISTANCE_HEURISTIC_TABLE_HPP_
@@ -145,6 +145,24 @@ public:
     _is_queued = true;
   }
 
+  /**
+   * @brief Gets the handle of this node in an indexed open set
+   * @return Reference to open set handle
+   */
+  inline unsigned int & getOpenSetIndex()
+  {
+    return _open_set_index;
+  }
+
+  /**
+   * @brief Sets the handle of this node in an indexed open set
+   * @param idx Open set handle
+   */
+  inline void setOpenSetIndex(const unsigned int & idx)
+  {
+    _open_set_index = idx;
+  }
+
   /**
    * @brief Gets cell index
    * @return Reference to cell index
@@ -160,7 +178,7 @@ public:
    * @param collision_checker Pointer to collision checker object
    * @return whether this node is valid and collision free
    */
-  bool isNodeValid(const bool & traverse_unknown, GridCollisionChecker collision_checker);
+  bool isNodeValid(const bool & traverse_unknown, GridCollisionChecker & collision_checker);
 
   /**
    * @brief get traversal cost from this node to child node
@@ -227,7 +245,7 @@ public:
   static void getNeighbors(
     NodePtr & node,
     std::function<bool(const unsigned int &, nav2_smac_planner::Node2D * &)> & validity_checker,
-    GridCollisionChecker collision_checker,
+    GridCollisionChecker & collision_checker,
     const bool & traverse_unknown,
     NodeVector & neighbors);
 
@@ -241,6 +259,7 @@ private:
   unsigned int _index;
   bool _was_visited;
   bool _is_queued;
+  unsigned int _open_set_index;
 };
 
 }  // namespace nav2_smac_planner
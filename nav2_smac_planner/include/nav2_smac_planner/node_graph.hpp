@@ -0,0 +1,243 @@
+// Copyright (c) 2020, Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#ifndef NAV2_SMAC_PLANNER__NODE_GRAPH_HPP_
+#define NAV2_SMAC_PLANNER__NODE_GRAPH_HPP_
+
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "nav2_smac_planner/constants.hpp"
+
+namespace nav2_smac_planner
+{
+
+/**
+ * @class nav2_smac_planner::NodeGraph
+ * @brief Storage of the nodes discovered during a search. Either a hashmap
+ * of nodes or a dense, chunked slab of nodes indexed directly by node index.
+ * The dense slab is kept between searches and invalidated by bumping a
+ * generation counter rather than by deallocating or resetting each node.
+ * Node pointers remain valid until the next clear() or resize().
+ */
+template<typename NodeT>
+class NodeGraph
+{
+public:
+  typedef std::unordered_map<unsigned int, NodeT> HashGraph;
+
+  // 4096 nodes per chunk, allocated only once the search touches them
+  static constexpr unsigned int chunk_bits = 12;
+  static constexpr unsigned int chunk_size = 1u << chunk_bits;
+  static constexpr unsigned int chunk_mask = chunk_size - 1u;
+
+  /**
+   * @struct nav2_smac_planner::NodeGraph::Chunk
+   * @brief A slab of contiguous nodes with their generation stamps
+   */
+  struct Chunk
+  {
+    std::vector<NodeT> nodes;
+    std::vector<unsigned int> generations;
+  };
+
+  /**
+   * @brief A constructor for nav2_smac_planner::NodeGraph
+   * @param type Storage backend to use
+   */
+  explicit NodeGraph(const GraphStorageType & type = GraphStorageType::HASHMAP)
+  : _type(type),
+    _max_index(0),
+    _generation(1),
+    _size(0)
+  {
+    _hash_graph.reserve(100000);
+  }
+
+  /**
+   * @brief Set the storage backend to use, drops all stored nodes
+   * @param type Storage backend to use
+   */
+  void setType(const GraphStorageType & type)
+  {
+    if (type != GraphStorageType::HASHMAP && type != GraphStorageType::DENSE) {
+      throw std::runtime_error("Invalid graph storage type selected.");
+    }
+
+    _type = type;
+    _chunks.clear();
+    _chunks.resize(_type == GraphStorageType::DENSE ? numChunks() : 0);
+    clear();
+  }
+
+  /**
+   * @brief Get the storage backend in use
+   * @return Storage backend type
+   */
+  inline const GraphStorageType & getType() const
+  {
+    return _type;
+  }
+
+  /**
+   * @brief Set the total number of node indices which may be stored.
+   * Existing slab memory is kept if the size has not changed.
+   * @param max_index Total number of possible node indices in the graph
+   */
+  void resize(const unsigned int & max_index)
+  {
+    if (max_index != _max_index) {
+      _max_index = max_index;
+      _chunks.clear();
+      if (_type == GraphStorageType::DENSE) {
+        _chunks.resize(numChunks());
+      }
+    }
+    clear();
+  }
+
+  /**
+   * @brief Invalidate all nodes stored in the graph for a new search
+   */
+  void clear()
+  {
+    _size = 0;
+
+    if (_type == GraphStorageType::HASHMAP) {
+      HashGraph g;
+      g.reserve(100000);
+      std::swap(_hash_graph, g);
+      return;
+    }
+
+    _generation++;
+    if (_generation == 0) {
+      // Stamps wrapped around, must actually reset them this time
+      for (auto & chunk : _chunks) {
+        if (chunk) {
+          std::fill(chunk->generations.begin(), chunk->generations.end(), 0u);
+        }
+      }
+      _generation = 1;
+    }
+  }
+
+  /**
+   * @brief Whether any node has been added since the last clear
+   * @return If graph is empty
+   */
+  inline bool empty() const
+  {
+    return _size == 0;
+  }
+
+  /**
+   * @brief Number of nodes added since the last clear
+   * @return Number of nodes
+   */
+  inline unsigned int size() const
+  {
+    return _size;
+  }
+
+  /**
+   * @brief Get the node at an index, constructing it from the arguments
+   * if it does not yet exist in this search
+   * @param index Index of node
+   * @param args Arguments to the node constructor
+   * @return Pointer to node in graph
+   */
+  template<typename ... Args>
+  inline NodeT * emplace(const unsigned int & index, Args && ... args)
+  {
+    if (_type == GraphStorageType::HASHMAP) {
+      auto result = _hash_graph.try_emplace(index, std::forward<Args>(args)...);
+      if (result.second) {
+        _size++;
+      }
+      return &(result.first->second);
+    }
+
+    if (index >= _max_index) {
+      throw std::out_of_range("Node index is outside of the graph.");
+    }
+
+    std::unique_ptr<Chunk> & chunk = _chunks[index >> chunk_bits];
+    const unsigned int offset = index & chunk_mask;
+    if (!chunk) {
+      // Seed every slot of the new slab with this node, they're all stale anyway
+      chunk = std::make_unique<Chunk>();
+      chunk->nodes.assign(chunk_size, NodeT(args ...));
+      chunk->generations.assign(chunk_size, 0u);
+      chunk->nodes[offset] = NodeT(args ...);
+    } else if (chunk->generations[offset] != _generation) {
+      chunk->nodes[offset] = NodeT(std::forward<Args>(args)...);
+    } else {
+      return &(chunk->nodes[offset]);
+    }
+
+    chunk->generations[offset] = _generation;
+    _size++;
+    return &(chunk->nodes[offset]);
+  }
+
+  /**
+   * @brief Get an existing node at an index
+   * @param index Index of node
+   * @return Reference to node, throws std::out_of_range if not in graph
+   */
+  NodeT & at(const unsigned int & index)
+  {
+    if (_type == GraphStorageType::HASHMAP) {
+      return _hash_graph.at(index);
+    }
+
+    if (index >= _max_index) {
+      throw std::out_of_range("Node index is outside of the graph.");
+    }
+
+    std::unique_ptr<Chunk> & chunk = _chunks[index >> chunk_bits];
+    const unsigned int offset = index & chunk_mask;
+    if (!chunk || chunk->generations[offset] != _generation) {
+      throw std::out_of_range("Node index was not added to the graph.");
+    }
+
+    return chunk->nodes[offset];
+  }
+
+protected:
+  /**
+   * @brief Number of chunks required to cover the graph
+   * @return Number of chunks
+   */
+  inline unsigned int numChunks() const
+  {
+    return (_max_index + chunk_mask) >> chunk_bits;
+  }
+
+  GraphStorageType _type;
+  unsigned int _max_index;
+  unsigned int _generation;
+  unsigned int _size;
+  HashGraph _hash_graph;
+  std::vector<std::unique_ptr<Chunk>> _chunks;
+};
+
+}  // namespace nav2_smac_planner
+
+#endif  // NAV2_SMAC_PLANNER__NODE_GRAPH_HPP_
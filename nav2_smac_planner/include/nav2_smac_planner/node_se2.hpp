@@ -30,6 +30,7 @@
 #include "nav2_smac_planner/constants.hpp"
 #include "nav2_smac_planner/types.hpp"
 #include "nav2_smac_planner/collision_checker.hpp"
+#include "nav2_smac_planner/distance_heuristic_table.hpp"
 
 namespace nav2_smac_planner
 {
@@ -118,6 +119,13 @@ struct MotionTable
    */
   MotionPose getProjection(const NodeSE2 * node, const unsigned int & motion_index);
 
+  /**
+   * @brief Precompute the obstacle-free distance heuristic table, if requested
+   * @param motion_model Motion model of the state space
+   * @param search_info Parameters for searching
+   */
+  void initDistanceHeuristicTable(const MotionModel & motion_model, SearchInfo & search_info);
+
   MotionPoses projections;
   unsigned int size_x;
   unsigned int num_angle_quantization;
@@ -128,6 +136,7 @@ struct MotionTable
   float cost_penalty;
   float reverse_penalty;
   ompl::base::StateSpacePtr state_space;
+  std::shared_ptr<DistanceHeuristicTable> distance_heuristic_table;
   std::vector<std::vector<double>> delta_xs;
   std::vector<std::vector<double>> delta_ys;
 };
@@ -283,6 +292,24 @@ public:
     _is_queued = true;
   }
 
+  /**
+   * @brief Gets the handle of this node in an indexed open set
+   * @return Reference to open set handle
+   */
+  inline unsigned int & getOpenSetIndex()
+  {
+    return _open_set_index;
+  }
+
+  /**
+   * @brief Sets the handle of this node in an indexed open set
+   * @param idx Open set handle
+   */
+  inline void setOpenSetIndex(const unsigned int & idx)
+  {
+    _open_set_index = idx;
+  }
+
   /**
    * @brief Gets cell index
    * @return Reference to cell index
@@ -297,7 +324,7 @@ public:
    * @param traverse_unknown If we can explore unknown nodes on the graph
    * @return whether this node is valid and collision free
    */
-  bool isNodeValid(const bool & traverse_unknown, GridCollisionChecker collision_checker);
+  bool isNodeValid(const bool & traverse_unknown, GridCollisionChecker & collision_checker);
 
   /**
    * @brief Get traversal cost of parent node to child node
@@ -380,7 +407,22 @@ public:
     SearchInfo & search_info);
 
   /**
-   * @brief Compute the wavefront heuristic
+   * @brief Set how the wavefront heuristic is computed
+   * @param use_cache Whether to reuse the last field if the goal and costmap are unchanged
+   * @param num_threads Number of threads to build the field with, 1 for serial
+   * or <= 0 for all available
+   */
+  static void setWavefrontHeuristicOptions(const bool & use_cache, const int & num_threads);
+
+  /**
+   * @brief Get the wavefront heuristic computation statistics
+   * @return Reference to the statistics
+   */
+  static WavefrontHeuristicStats & getWavefrontHeuristicStats();
+
+  /**
+   * @brief Compute the wavefront heuristic, or reuse the previous one if
+   * caching is enabled and neither the goal nor the costmap has changed
    * @param costmap Costmap to use to compute heuristic
    * @param start_x Coordinate of Start X
    * @param start_y Coordinate of Start Y
@@ -388,7 +430,7 @@ public:
    * @param goal_y Coordinate of Goal Y
    */
   static void computeWavefrontHeuristic(
-    nav2_costmap_2d::Costmap2D * & costmap,
+    const nav2_costmap_2d::Costmap2D * costmap,
     const unsigned int & start_x, const unsigned int & start_y,
     const unsigned int & goal_x, const unsigned int & goal_y);
 
@@ -401,7 +443,7 @@ public:
   static void getNeighbors(
     const NodePtr & node,
     std::function<bool(const unsigned int &, nav2_smac_planner::NodeSE2 * &)> & validity_checker,
-    GridCollisionChecker collision_checker,
+    GridCollisionChecker & collision_checker,
     const bool & traverse_unknown,
     NodeVector & neighbors);
 
@@ -416,8 +458,15 @@ private:
   unsigned int _index;
   bool _was_visited;
   bool _is_queued;
+  unsigned int _open_set_index;
   unsigned int _motion_primitive_index;
   static std::vector<unsigned int> _wavefront_heuristic;
+  static std::vector<unsigned char> _wavefront_costmap;
+  static unsigned int _wavefront_goal_index;
+  static unsigned int _wavefront_size_x;
+  static bool _wavefront_use_cache;
+  static int _wavefront_threads;
+  static WavefrontHeuristicStats _wavefront_stats;
 };
 
 }  // namespace nav2_smac_planner
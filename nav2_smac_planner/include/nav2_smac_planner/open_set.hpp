@@ -0,0 +1,406 @@
+// Copyright (c) 2020, Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#ifndef NAV2_SMAC_PLANNER__OPEN_SET_HPP_
+#define NAV2_SMAC_PLANNER__OPEN_SET_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "nav2_smac_planner/node_basic.hpp"
+#include "nav2_smac_planner/constants.hpp"
+
+namespace nav2_smac_planner
+{
+
+/**
+ * @class nav2_smac_planner::OpenSet
+ * @brief The A* open set, sorted by the total cost of the queued nodes. Either
+ * a std::priority_queue which queues duplicate entries for nodes whose cost
+ * improves, an indexed 4-ary heap or a monotone radix heap. The latter two
+ * keep exactly one entry per node and support decrease-key through the
+ * open set handle stored in the graph node.
+ */
+template<typename NodeT>
+class OpenSet
+{
+public:
+  typedef std::pair<float, NodeBasic<NodeT>> NodeElement;
+
+  /**
+   * @struct nav2_smac_planner::OpenSet::NodeComparator
+   * @brief Node comparison for priority queue sorting
+   */
+  struct NodeComparator
+  {
+    bool operator()(const NodeElement & a, const NodeElement & b) const
+    {
+      return a.first > b.first;
+    }
+  };
+
+  typedef std::priority_queue<NodeElement, std::vector<NodeElement>, NodeComparator> NodeQueue;
+
+  // Radix heap handles store the bucket in the upper bits, position in the lower
+  static constexpr unsigned int radix_buckets = 33;
+  static constexpr unsigned int radix_position_bits = 26;
+  static constexpr unsigned int radix_position_mask = (1u << radix_position_bits) - 1u;
+  static constexpr unsigned int invalid_handle = std::numeric_limits<unsigned int>::max();
+
+  /**
+   * @brief A constructor for nav2_smac_planner::OpenSet
+   * @param type Open set implementation to use
+   */
+  explicit OpenSet(const OpenSetType & type = OpenSetType::PRIORITY_QUEUE)
+  : _type(type),
+    _size(0),
+    _peak_size(0),
+    _last_key(0)
+  {
+    _buckets.resize(radix_buckets);
+  }
+
+  /**
+   * @brief Set the open set implementation to use, drops all queued nodes
+   * @param type Open set implementation to use
+   */
+  void setType(const OpenSetType & type)
+  {
+    if (type != OpenSetType::PRIORITY_QUEUE && type != OpenSetType::INDEXED_HEAP &&
+      type != OpenSetType::RADIX_HEAP)
+    {
+      throw std::runtime_error("Invalid open set type selected.");
+    }
+
+    _type = type;
+    clear();
+  }
+
+  /**
+   * @brief Get the open set implementation in use
+   * @return Open set type
+   */
+  inline const OpenSetType & getType() const
+  {
+    return _type;
+  }
+
+  /**
+   * @brief Remove all nodes from the open set and reset statistics.
+   * Does not touch the graph nodes, as they may have been freed already.
+   */
+  void clear()
+  {
+    NodeQueue q;
+    std::swap(_queue, q);
+    _heap.clear();
+    for (auto & bucket : _buckets) {
+      bucket.clear();
+    }
+    _size = 0;
+    _peak_size = 0;
+    _last_key = 0;
+  }
+
+  /**
+   * @brief Whether the open set is empty
+   * @return If empty
+   */
+  inline bool empty() const
+  {
+    return _size == 0;
+  }
+
+  /**
+   * @brief Number of entries in the open set
+   * @return Number of entries
+   */
+  inline unsigned int size() const
+  {
+    return _size;
+  }
+
+  /**
+   * @brief Largest number of entries in the open set since the last clear
+   * @return Peak number of entries
+   */
+  inline unsigned int getPeakSize() const
+  {
+    return _peak_size;
+  }
+
+  /**
+   * @brief Add a node to the open set, or update its cost (and pose) if it
+   * is already queued for indexed implementations
+   * @param cost The cost to sort into the open set of the node
+   * @param node Queue entry to add
+   */
+  void push(const float & cost, const NodeBasic<NodeT> & node)
+  {
+    switch (_type) {
+      case OpenSetType::INDEXED_HEAP:
+        heapPush(cost, node);
+        break;
+      case OpenSetType::RADIX_HEAP:
+        radixPush(cost, node);
+        break;
+      default:
+        _queue.emplace(cost, node);
+        _size++;
+        break;
+    }
+
+    if (_size > _peak_size) {
+      _peak_size = _size;
+    }
+  }
+
+  /**
+   * @brief Remove and return the lowest cost entry of the open set
+   * @return Lowest cost queue entry
+   */
+  NodeBasic<NodeT> pop()
+  {
+    _size--;
+    switch (_type) {
+      case OpenSetType::INDEXED_HEAP:
+        return heapPop();
+      case OpenSetType::RADIX_HEAP:
+        return radixPop();
+      default:
+        {
+          NodeBasic<NodeT> node = _queue.top().second;
+          _queue.pop();
+          return node;
+        }
+    }
+  }
+
+protected:
+  /**
+   * @brief Whether a node has a valid handle into this open set
+   * @param node Graph node to check
+   * @return If the node is in the open set
+   */
+  inline bool inHeap(NodeT * node) const
+  {
+    const unsigned int & handle = node->getOpenSetIndex();
+    return handle < _heap.size() && _heap[handle].second.graph_node_ptr == node;
+  }
+
+  inline void heapPush(const float & cost, const NodeBasic<NodeT> & node)
+  {
+    NodeT * graph_node = node.graph_node_ptr;
+    if (inHeap(graph_node)) {
+      // Decrease-key: update in place and restore heap order
+      const unsigned int pos = graph_node->getOpenSetIndex();
+      const float old_cost = _heap[pos].first;
+      _heap[pos] = NodeElement(cost, node);
+      if (cost < old_cost) {
+        siftUp(pos);
+      } else {
+        siftDown(pos);
+      }
+      return;
+    }
+
+    _heap.emplace_back(cost, node);
+    _size++;
+    siftUp(_heap.size() - 1);
+  }
+
+  inline NodeBasic<NodeT> heapPop()
+  {
+    NodeBasic<NodeT> top = _heap.front().second;
+    top.graph_node_ptr->setOpenSetIndex(invalid_handle);
+    _heap.front() = _heap.back();
+    _heap.pop_back();
+    if (!_heap.empty()) {
+      siftDown(0);
+    }
+    return top;
+  }
+
+  inline void siftUp(unsigned int pos)
+  {
+    NodeElement element = _heap[pos];
+    while (pos > 0) {
+      const unsigned int parent = (pos - 1) >> 2;
+      if (!(element.first < _heap[parent].first)) {
+        break;
+      }
+      _heap[pos] = _heap[parent];
+      _heap[pos].second.graph_node_ptr->setOpenSetIndex(pos);
+      pos = parent;
+    }
+    _heap[pos] = element;
+    element.second.graph_node_ptr->setOpenSetIndex(pos);
+  }
+
+  inline void siftDown(unsigned int pos)
+  {
+    const unsigned int heap_size = _heap.size();
+    NodeElement element = _heap[pos];
+    while (true) {
+      const unsigned int first_child = (pos << 2) + 1;
+      if (first_child >= heap_size) {
+        break;
+      }
+
+      // Find the smallest of up to 4 children
+      unsigned int best_child = first_child;
+      const unsigned int last_child = std::min(first_child + 4, heap_size);
+      for (unsigned int child = first_child + 1; child < last_child; ++child) {
+        if (_heap[child].first < _heap[best_child].first) {
+          best_child = child;
+        }
+      }
+
+      if (!(_heap[best_child].first < element.first)) {
+        break;
+      }
+      _heap[pos] = _heap[best_child];
+      _heap[pos].second.graph_node_ptr->setOpenSetIndex(pos);
+      pos = best_child;
+    }
+    _heap[pos] = element;
+    element.second.graph_node_ptr->setOpenSetIndex(pos);
+  }
+
+  /**
+   * @brief Map a non-negative cost to an integer key with the same ordering
+   * @param cost Cost of node
+   * @return Radix key
+   */
+  static inline uint32_t toKey(const float & cost)
+  {
+    // IEEE-754 bit patterns of non-negative floats sort like unsigned integers
+    const float positive_cost = cost > 0.0f ? cost : 0.0f;
+    uint32_t key;
+    std::memcpy(&key, &positive_cost, sizeof(key));
+    return key;
+  }
+
+  /**
+   * @brief Bucket of a key relative to the last removed key
+   * @param key Radix key
+   * @return Bucket index
+   */
+  inline unsigned int bucketOf(const uint32_t & key) const
+  {
+    const uint32_t diff = key ^ _last_key;
+    return diff == 0 ? 0 : 32 - __builtin_clz(diff);
+  }
+
+  inline void radixInsert(const uint32_t & key, const NodeElement & element)
+  {
+    const unsigned int bucket = bucketOf(key);
+    const unsigned int pos = _buckets[bucket].size();
+    if (pos > radix_position_mask) {
+      throw std::runtime_error("Radix heap bucket capacity exceeded.");
+    }
+    _buckets[bucket].push_back(element);
+    element.second.graph_node_ptr->setOpenSetIndex((bucket << radix_position_bits) | pos);
+  }
+
+  inline void radixPush(const float & cost, const NodeBasic<NodeT> & node)
+  {
+    // A radix heap is monotone: keys below the last removed key (from an
+    // inconsistent heuristic) are clamped to it, so they are expanded next,
+    // just as a regular heap would do.
+    uint32_t key = toKey(cost);
+    if (key < _last_key) {
+      key = _last_key;
+    }
+
+    NodeT * graph_node = node.graph_node_ptr;
+    const unsigned int & handle = graph_node->getOpenSetIndex();
+    const unsigned int bucket = handle >> radix_position_bits;
+    const unsigned int pos = handle & radix_position_mask;
+    if (handle != invalid_handle && bucket < radix_buckets && pos < _buckets[bucket].size() &&
+      _buckets[bucket][pos].second.graph_node_ptr == graph_node)
+    {
+      // Decrease-key: remove the old entry and reinsert
+      radixRemove(bucket, pos);
+    } else {
+      _size++;
+    }
+
+    NodeElement element(cost, node);
+    std::memcpy(&element.first, &key, sizeof(key));
+    radixInsert(key, element);
+  }
+
+  inline void radixRemove(const unsigned int & bucket, const unsigned int & pos)
+  {
+    std::vector<NodeElement> & entries = _buckets[bucket];
+    if (pos + 1 != entries.size()) {
+      entries[pos] = entries.back();
+      entries[pos].second.graph_node_ptr->setOpenSetIndex((bucket << radix_position_bits) | pos);
+    }
+    entries.pop_back();
+  }
+
+  inline NodeBasic<NodeT> radixPop()
+  {
+    if (_buckets[0].empty()) {
+      // Find the first non-empty bucket and redistribute it about its minimum
+      unsigned int i = 1;
+      while (_buckets[i].empty()) {
+        ++i;
+      }
+
+      std::swap(_scratch, _buckets[i]);
+      uint32_t min_key = std::numeric_limits<uint32_t>::max();
+      uint32_t key;
+      for (const auto & entry : _scratch) {
+        std::memcpy(&key, &entry.first, sizeof(key));
+        if (key < min_key) {
+          min_key = key;
+        }
+      }
+
+      _last_key = min_key;
+      for (const auto & entry : _scratch) {
+        std::memcpy(&key, &entry.first, sizeof(key));
+        radixInsert(key, entry);
+      }
+      _scratch.clear();
+    }
+
+    NodeBasic<NodeT> top = _buckets[0].back().second;
+    _buckets[0].pop_back();
+    top.graph_node_ptr->setOpenSetIndex(invalid_handle);
+    return top;
+  }
+
+  OpenSetType _type;
+  unsigned int _size;
+  unsigned int _peak_size;
+  uint32_t _last_key;
+  NodeQueue _queue;
+  std::vector<NodeElement> _heap;
+  std::vector<std::vector<NodeElement>> _buckets;
+  std::vector<NodeElement> _scratch;
+};
+
+}  // namespace nav2_smac_planner
+
+#endif  // NAV2_SMAC_PLANNER__OPEN_SET_HPP_
@@ -100,7 +100,7 @@ public:
    */
   bool smooth(
     std::vector<Eigen::Vector2d> & path,
-    nav2_costmap_2d::Costmap2D * costmap,
+    const nav2_costmap_2d::Costmap2D * costmap,
     const SmootherParams & params)
   {
     _options.max_solver_time_in_seconds = params.max_time;
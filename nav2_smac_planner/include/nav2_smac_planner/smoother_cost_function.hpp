@@ -49,7 +49,7 @@ public:
    */
   UnconstrainedSmootherCostFunction(
     std::vector<Eigen::Vector2d> * original_path,
-    nav2_costmap_2d::Costmap2D * costmap,
+    const nav2_costmap_2d::Costmap2D * costmap,
     const SmootherParams & params)
   : _original_path(original_path),
     _num_params(2 * original_path->size()),
@@ -506,7 +506,7 @@ protected:
 
   std::vector<Eigen::Vector2d> * _original_path{nullptr};
   int _num_params;
-  nav2_costmap_2d::Costmap2D * _costmap{nullptr};
+  const nav2_costmap_2d::Costmap2D * _costmap{nullptr};
   SmootherParams _params;
 };
 
@@ -15,6 +15,7 @@
 #ifndef NAV2_SMAC_PLANNER__TYPES_HPP_
 #define NAV2_SMAC_PLANNER__TYPES_HPP_
 
+#include <string>
 #include <vector>
 #include <utility>
 
@@ -35,6 +36,20 @@ struct SearchInfo
   float reverse_penalty;
   float cost_penalty;
   float analytic_expansion_ratio;
+  float lookup_table_size{0.0f};  // in cells, 0 to not precompute the distance heuristic
+  std::string lookup_table_cache_dir;  // empty to not persist the distance heuristic
+};
+
+/**
+ * @struct nav2_smac_planner::WavefrontHeuristicStats
+ * @brief Statistics of the wavefront heuristic computation
+ */
+struct WavefrontHeuristicStats
+{
+  double compute_time{0.0};  // seconds spent on the last request, including cache checks
+  unsigned int cache_hits{0};
+  unsigned int cache_misses{0};
+  bool last_was_cache_hit{false};
 };
 
 }  // namespace nav2_smac_planner
@@ -51,7 +51,6 @@ AStarAlgorithm<NodeT>::AStarAlgorithm(
   _motion_model(motion_model),
   _collision_checker(nullptr)
 {
-  _graph.reserve(100000);
 }
 
 template<typename NodeT>
@@ -63,11 +62,15 @@ template<typename NodeT>
 void AStarAlgorithm<NodeT>::initialize(
   const bool & allow_unknown,
   int & max_iterations,
-  const int & max_on_approach_iterations)
+  const int & max_on_approach_iterations,
+  const GraphStorageType & graph_storage_type,
+  const OpenSetType & open_set_type)
 {
   _traverse_unknown = allow_unknown;
   _max_iterations = max_iterations;
   _max_on_approach_iterations = max_on_approach_iterations;
+  _graph.setType(graph_storage_type);
+  _queue.setType(open_set_type);
 }
 
 template<>
@@ -75,14 +78,14 @@ void AStarAlgorithm<Node2D>::createGraph(
   const unsigned int & x_size,
   const unsigned int & y_size,
   const unsigned int & dim_3_size,
-  nav2_costmap_2d::Costmap2D * & costmap)
+  const nav2_costmap_2d::Costmap2D * costmap)
 {
   if (dim_3_size != 1) {
     throw std::runtime_error("Node type Node2D cannot be given non-1 dim 3 quantization.");
   }
   _costmap = costmap;
   _dim3_size = dim_3_size;  // 2D search MUST be 2D, not 3D or SE2.
-  clearGraph();
+  _graph.resize(x_size * y_size * _dim3_size);
 
   if (getSizeX() != x_size || getSizeY() != y_size) {
     _x_size = x_size;
@@ -96,15 +99,19 @@ void AStarAlgorithm<NodeSE2>::createGraph(
   const unsigned int & x_size,
   const unsigned int & y_size,
   const unsigned int & dim_3_size,
-  nav2_costmap_2d::Costmap2D * & costmap)
+  const nav2_costmap_2d::Costmap2D * costmap)
 {
   _costmap = costmap;
-  _collision_checker = GridCollisionChecker(costmap);
-  _collision_checker.setFootprint(_footprint, _is_radius_footprint);
+  if (_collision_checker.getNumQuantizations() != dim_3_size) {
+    // Footprint masks are precomputed once per angle bin, not per plan
+    _collision_checker = GridCollisionChecker(costmap, dim_3_size);
+    _collision_checker.setFootprint(_footprint, _is_radius_footprint);
+  } else {
+    _collision_checker.setCostmap(costmap);
+  }
 
   _dim3_size = dim_3_size;
-  unsigned int index;
-  clearGraph();
+  _graph.resize(x_size * y_size * _dim3_size);
 
   if (getSizeX() != x_size || getSizeY() != y_size) {
     _x_size = x_size;
@@ -118,20 +125,21 @@ void AStarAlgorithm<NodeT>::setFootprint(nav2_costmap_2d::Footprint footprint, b
 {
   _footprint = footprint;
   _is_radius_footprint = use_radius;
+  _collision_checker.setFootprint(_footprint, _is_radius_footprint);
 }
 
 template<>
 typename AStarAlgorithm<Node2D>::NodePtr AStarAlgorithm<Node2D>::addToGraph(
   const unsigned int & index)
 {
-  return &(_graph.emplace(index, Node2D(_costmap->getCharMap()[index], index)).first->second);
+  return _graph.emplace(index, _costmap->getCharMap()[index], index);
 }
 
 template<>
 typename AStarAlgorithm<NodeSE2>::NodePtr AStarAlgorithm<NodeSE2>::addToGraph(
   const unsigned int & index)
 {
-  return &(_graph.emplace(index, NodeSE2(index)).first->second);
+  return _graph.emplace(index, index);
 }
 
 template<>
@@ -487,16 +495,13 @@ typename AStarAlgorithm<NodeT>::NodePtr & AStarAlgorithm<NodeT>::getGoal()
 template<typename NodeT>
 typename AStarAlgorithm<NodeT>::NodePtr AStarAlgorithm<NodeT>::getNextNode()
 {
-  NodeBasic<NodeT> node = _queue.top().second;
-  _queue.pop();
-  return node.graph_node_ptr;
+  return _queue.pop().graph_node_ptr;
 }
 
 template<>
 typename AStarAlgorithm<NodeSE2>::NodePtr AStarAlgorithm<NodeSE2>::getNextNode()
 {
-  NodeBasic<NodeSE2> node = _queue.top().second;
-  _queue.pop();
+  NodeBasic<NodeSE2> node = _queue.pop();
 
   if (!node.graph_node_ptr->wasVisited()) {
     node.graph_node_ptr->pose = node.pose;
@@ -510,7 +515,7 @@ void AStarAlgorithm<NodeT>::addNode(const float cost, NodePtr & node)
 {
   NodeBasic<NodeT> queued_node(node->getIndex());
   queued_node.graph_node_ptr = node;
-  _queue.emplace(cost, queued_node);
+  _queue.push(cost, queued_node);
 }
 
 template<>
@@ -519,7 +524,7 @@ void AStarAlgorithm<NodeSE2>::addNode(const float cost, NodePtr & node)
   NodeBasic<NodeSE2> queued_node(node->getIndex());
   queued_node.pose = node->pose;
   queued_node.graph_node_ptr = node;
-  _queue.emplace(cost, queued_node);
+  _queue.push(cost, queued_node);
 }
 
 template<typename NodeT>
@@ -554,16 +559,13 @@ float AStarAlgorithm<NodeT>::getHeuristicCost(const NodePtr & node)
 template<typename NodeT>
 void AStarAlgorithm<NodeT>::clearQueue()
 {
-  NodeQueue q;
-  std::swap(_queue, q);
+  _queue.clear();
 }
 
 template<typename NodeT>
 void AStarAlgorithm<NodeT>::clearGraph()
 {
-  Graph g;
-  g.reserve(100000);
-  std::swap(_graph, g);
+  _graph.clear();
 }
 
 template<typename NodeT>
@@ -602,6 +604,12 @@ unsigned int & AStarAlgorithm<NodeT>::getSizeDim3()
   return _dim3_size;
 }
 
+template<typename NodeT>
+unsigned int AStarAlgorithm<NodeT>::getPeakQueueSize()
+{
+  return _queue.getPeakSize();
+}
+
 template<typename NodeT>
 typename AStarAlgorithm<NodeT>::NodePtr AStarAlgorithm<NodeT>::tryAnalyticExpansion(
   const NodePtr & current_node, const NodeGetter & getter, int & analytic_iterations,
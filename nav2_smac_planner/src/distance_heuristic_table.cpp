@@ -0,0 +1,278 @@
+// Copyright (c) 2020, Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+#include <fcntl.h>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ompl/base/ScopedState.h"
+
+#include "nav2_smac_planner/distance_heuristic_table.hpp"
+
+namespace nav2_smac_planner
+{
+
+namespace
+{
+
+// Bump when the layout or contents of the table change
+constexpr uint32_t cache_version = 2;
+constexpr char cache_magic[8] = {'S', 'M', 'A', 'C', 'D', 'H', 'T', '\0'};
+
+struct CacheHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t motion_model;
+  uint32_t num_angle_quantization;
+  uint32_t half_size;
+  float minimum_turning_radius;
+  uint32_t reserved;
+};
+
+}  // namespace
+
+DistanceHeuristicTable::DistanceHeuristicTable()
+: _motion_model(MotionModel::UNKNOWN),
+  _minimum_turning_radius(0.0f),
+  _num_angle_quantization(0),
+  _half_size(0),
+  _width(0),
+  _slack(0.0f),
+  _exact_radius_sq(0.0f),
+  _data(nullptr),
+  _mapping(nullptr),
+  _mapping_size(0)
+{
+}
+
+DistanceHeuristicTable::~DistanceHeuristicTable()
+{
+  release();
+}
+
+void DistanceHeuristicTable::release()
+{
+  if (_mapping) {
+    munmap(_mapping, _mapping_size);
+    _mapping = nullptr;
+    _mapping_size = 0;
+  }
+  _table.clear();
+  _table.shrink_to_fit();
+  _data = nullptr;
+}
+
+void DistanceHeuristicTable::initialize(
+  const ompl::base::StateSpacePtr & state_space,
+  const MotionModel & motion_model,
+  const float & minimum_turning_radius,
+  const unsigned int & num_angle_quantization,
+  const unsigned int & window_size,
+  const std::string & cache_dir)
+{
+  release();
+
+  _motion_model = motion_model;
+  _minimum_turning_radius = minimum_turning_radius;
+  _num_angle_quantization = num_angle_quantization;
+  _half_size = static_cast<int>(window_size / 2);
+  _width = 2 * static_cast<unsigned int>(_half_size) + 1;
+
+  const float bin_size =
+    2.0f * static_cast<float>(M_PI) / static_cast<float>(_num_angle_quantization);
+  // Between the center and corners of a cell the distance may still dip a little lower.
+  // Allow for about a cell of position and the turn of one angle bin.
+  _slack = 1.0f + _minimum_turning_radius * bin_size;
+
+  // Within a couple of turning radii of the goal a small offset can save a whole loop, so
+  // no sample of a cell has to be near its least distance
+  const float exact_radius = 2.0f * _minimum_turning_radius + 1.0f;
+  _exact_radius_sq = exact_radius * exact_radius;
+
+  _cos_bins.resize(_num_angle_quantization);
+  _sin_bins.resize(_num_angle_quantization);
+  for (unsigned int i = 0; i != _num_angle_quantization; i++) {
+    _cos_bins[i] = cos(bin_size * i);
+    _sin_bins[i] = sin(bin_size * i);
+  }
+
+  _cache_dir = cache_dir;
+  _cache_path.clear();
+  if (!cache_dir.empty()) {
+    _cache_path = cache_dir + "/smac_distance_heuristic_" + toString(_motion_model) +
+      "_r" + std::to_string(std::lround(_minimum_turning_radius * 1000.0f)) +
+      "_q" + std::to_string(_num_angle_quantization) +
+      "_w" + std::to_string(_width) + ".bin";
+    for (auto & c : _cache_path) {
+      if (c == ' ') {
+        c = '_';
+      }
+    }
+
+    if (load()) {
+      return;
+    }
+  }
+
+  build(state_space);
+
+  if (!_cache_path.empty()) {
+    save();
+  }
+}
+
+void DistanceHeuristicTable::build(const ompl::base::StateSpacePtr & state_space)
+{
+  const float bin_size =
+    2.0f * static_cast<float>(M_PI) / static_cast<float>(_num_angle_quantization);
+  const unsigned int bins = _num_angle_quantization;
+  _table.resize(static_cast<size_t>(_width) * _width * bins);
+
+  // A cell holds every relative pose that rounds to it. Store the least distance of its
+  // center and corners, so a pose off the center is not overestimated where the
+  // distance jumps within the cell. Corners are shared, so compute them once:
+  // corner (i, j) is at (i - half_size - 0.5, j - 0.5).
+  const unsigned int corner_rows = static_cast<unsigned int>(_half_size) + 2;
+  const unsigned int corner_cols = _width + 1;
+  std::vector<float> corners(static_cast<size_t>(corner_rows) * corner_cols * bins);
+
+  // Both models are symmetric about the goal's heading: d(x, y, th) = d(x, -y, -th),
+  // so only compute the upper half of the window and mirror it.
+  #pragma omp parallel
+  {
+    ompl::base::ScopedState<> from(state_space), to(state_space);
+    to[0] = 0.0;
+    to[1] = 0.0;
+    to[2] = 0.0;
+
+    #pragma omp for schedule(dynamic)
+    for (unsigned int j = 0; j < corner_rows; j++) {
+      for (unsigned int i = 0; i < corner_cols; i++) {
+        for (unsigned int th = 0; th != bins; th++) {
+          from[0] = static_cast<double>(i) - _half_size - 0.5;
+          from[1] = static_cast<double>(j) - 0.5;
+          from[2] = th * bin_size;
+          corners[(j * corner_cols + i) * bins + th] =
+            static_cast<float>(state_space->distance(from(), to()));
+        }
+      }
+    }
+
+    #pragma omp for schedule(dynamic)
+    for (int y = 0; y <= _half_size; y++) {
+      for (int x = -_half_size; x <= _half_size; x++) {
+        const unsigned int i = static_cast<unsigned int>(x + _half_size);
+        const unsigned int j = static_cast<unsigned int>(y);
+        for (unsigned int th = 0; th != bins; th++) {
+          from[0] = x;
+          from[1] = y;
+          from[2] = th * bin_size;
+          const float d = std::min(
+            {static_cast<float>(state_space->distance(from(), to())),
+              corners[(j * corner_cols + i) * bins + th],
+              corners[(j * corner_cols + i + 1) * bins + th],
+              corners[((j + 1) * corner_cols + i) * bins + th],
+              corners[((j + 1) * corner_cols + i + 1) * bins + th]});
+          _table[getIndex(x, y, th)] = d;
+          _table[getIndex(x, -y, (bins - th) % bins)] = d;
+        }
+      }
+    }
+  }
+
+  _data = _table.data();
+}
+
+bool DistanceHeuristicTable::load()
+{
+  const int fd = open(_cache_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  const size_t table_size = sizeof(float) * _width * _width * _num_angle_quantization;
+  const size_t file_size = sizeof(CacheHeader) + table_size;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) != file_size) {
+    close(fd);
+    return false;
+  }
+
+  void * mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  const CacheHeader * header = static_cast<const CacheHeader *>(mapping);
+  if (std::memcmp(header->magic, cache_magic, sizeof(cache_magic)) != 0 ||
+    header->version != cache_version ||
+    header->motion_model != static_cast<uint32_t>(_motion_model) ||
+    header->num_angle_quantization != _num_angle_quantization ||
+    header->half_size != static_cast<uint32_t>(_half_size) ||
+    header->minimum_turning_radius != _minimum_turning_radius)
+  {
+    munmap(mapping, file_size);
+    return false;
+  }
+
+  _mapping = mapping;
+  _mapping_size = file_size;
+  _data = reinterpret_cast<const float *>(
+    static_cast<const char *>(mapping) + sizeof(CacheHeader));
+  return true;
+}
+
+bool DistanceHeuristicTable::save() const
+{
+  CacheHeader header;
+  std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+  header.version = cache_version;
+  header.motion_model = static_cast<uint32_t>(_motion_model);
+  header.num_angle_quantization = _num_angle_quantization;
+  header.half_size = static_cast<uint32_t>(_half_size);
+  header.minimum_turning_radius = _minimum_turning_radius;
+  header.reserved = 0;
+
+  // Write to a temporary file and rename, so concurrent planners never map a partial table
+  const std::string tmp_path = _cache_path + ".tmp" + std::to_string(getpid());
+  FILE * file = fopen(tmp_path.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+
+  bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(_table.data(), sizeof(float), _table.size(), file) == _table.size();
+  success = fclose(file) == 0 && success;
+
+  if (!success || rename(tmp_path.c_str(), _cache_path.c_str()) != 0) {
+    remove(tmp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace nav2_smac_planner
@@ -31,7 +31,8 @@ Node2D::Node2D(unsigned char & cost_in, const unsigned int index)
   _accumulated_cost(std::numeric_limits<float>::max()),
   _index(index),
   _was_visited(false),
-  _is_queued(false)
+  _is_queued(false),
+  _open_set_index(std::numeric_limits<unsigned int>::max())
 {
 }
 
@@ -47,11 +48,12 @@ void Node2D::reset(const unsigned char & cost)
   _accumulated_cost = std::numeric_limits<float>::max();
   _was_visited = false;
   _is_queued = false;
+  _open_set_index = std::numeric_limits<unsigned int>::max();
 }
 
 bool Node2D::isNodeValid(
   const bool & traverse_unknown,
-  GridCollisionChecker /*collision_checker*/)
+  GridCollisionChecker & /*collision_checker*/)
 {
   // NOTE(stevemacenski): Right now, we do not check if the node has wrapped around
   // the regular grid (e.g. your node is on the edge of the costmap and i+1
@@ -119,7 +121,7 @@ void Node2D::initNeighborhood(
 void Node2D::getNeighbors(
   NodePtr & node,
   std::function<bool(const unsigned int &, nav2_smac_planner::Node2D * &)> & NeighborGetter,
-  GridCollisionChecker collision_checker,
+  GridCollisionChecker & collision_checker,
   const bool & traverse_unknown,
   NodeVector & neighbors)
 {
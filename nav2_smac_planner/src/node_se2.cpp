@@ -14,6 +14,7 @@
 // limitations under the License. Reserved.
 
 #include <math.h>
+#include <omp.h>
 #include <chrono>
 #include <vector>
 #include <memory>
@@ -34,6 +35,12 @@ namespace nav2_smac_planner
 
 // defining static member for all instance to share
 std::vector<unsigned int> NodeSE2::_wavefront_heuristic;
+std::vector<unsigned char> NodeSE2::_wavefront_costmap;
+unsigned int NodeSE2::_wavefront_goal_index = std::numeric_limits<unsigned int>::max();
+unsigned int NodeSE2::_wavefront_size_x = 0;
+bool NodeSE2::_wavefront_use_cache = false;
+int NodeSE2::_wavefront_threads = 1;
+WavefrontHeuristicStats NodeSE2::_wavefront_stats;
 double NodeSE2::neutral_cost = sqrt(2);
 MotionTable NodeSE2::motion_table;
 
@@ -102,6 +109,7 @@ void MotionTable::initDubin(
 
   // Create the correct OMPL state space
   state_space = std::make_unique<ompl::base::DubinsStateSpace>(search_info.minimum_turning_radius);
+  initDistanceHeuristicTable(MotionModel::DUBIN, search_info);
 
   // Precompute projection deltas
   delta_xs.resize(projections.size());
@@ -164,6 +172,7 @@ void MotionTable::initReedsShepp(
   // Create the correct OMPL state space
   state_space = std::make_unique<ompl::base::ReedsSheppStateSpace>(
     search_info.minimum_turning_radius);
+  initDistanceHeuristicTable(MotionModel::REEDS_SHEPP, search_info);
 
   // Precompute projection deltas
   delta_xs.resize(projections.size());
@@ -182,6 +191,31 @@ void MotionTable::initReedsShepp(
   }
 }
 
+void MotionTable::initDistanceHeuristicTable(
+  const MotionModel & motion_model,
+  SearchInfo & search_info)
+{
+  if (search_info.lookup_table_size <= 0.0f) {
+    distance_heuristic_table.reset();
+    return;
+  }
+
+  // The table does not depend on the costmap, so keep it across costmap size changes
+  const unsigned int window_size = static_cast<unsigned int>(search_info.lookup_table_size);
+  if (distance_heuristic_table &&
+    distance_heuristic_table->isInitializedFor(
+      motion_model, search_info.minimum_turning_radius, num_angle_quantization, window_size,
+      search_info.lookup_table_cache_dir))
+  {
+    return;
+  }
+
+  distance_heuristic_table = std::make_shared<DistanceHeuristicTable>();
+  distance_heuristic_table->initialize(
+    state_space, motion_model, search_info.minimum_turning_radius, num_angle_quantization,
+    window_size, search_info.lookup_table_cache_dir);
+}
+
 MotionPoses MotionTable::getProjections(const NodeSE2 * node)
 {
   MotionPoses projection_list;
@@ -221,6 +255,7 @@ NodeSE2::NodeSE2(const unsigned int index)
   _index(index),
   _was_visited(false),
   _is_queued(false),
+  _open_set_index(std::numeric_limits<unsigned int>::max()),
   _motion_primitive_index(std::numeric_limits<unsigned int>::max())
 {
 }
@@ -237,13 +272,16 @@ void NodeSE2::reset()
   _accumulated_cost = std::numeric_limits<float>::max();
   _was_visited = false;
   _is_queued = false;
+  _open_set_index = std::numeric_limits<unsigned int>::max();
   _motion_primitive_index = std::numeric_limits<unsigned int>::max();
   pose.x = 0.0f;
   pose.y = 0.0f;
   pose.theta = 0.0f;
 }
 
-bool NodeSE2::isNodeValid(const bool & traverse_unknown, GridCollisionChecker collision_checker)
+bool NodeSE2::isNodeValid(
+  const bool & traverse_unknown,
+  GridCollisionChecker & collision_checker)
 {
   if (collision_checker.inCollision(
       this->pose.x, this->pose.y, this->pose.theta * motion_table.bin_size, traverse_unknown))
@@ -298,17 +336,24 @@ float NodeSE2::getHeuristicCost(
   const Coordinates & node_coords,
   const Coordinates & goal_coords)
 {
-  // Dubin or Reeds-Shepp shortest distances
-  // Create OMPL states for checking
-  ompl::base::ScopedState<> from(motion_table.state_space), to(motion_table.state_space);
-  from[0] = node_coords.x;
-  from[1] = node_coords.y;
-  from[2] = node_coords.theta * motion_table.bin_size;
-  to[0] = goal_coords.x;
-  to[1] = goal_coords.y;
-  to[2] = goal_coords.theta * motion_table.bin_size;
-
-  const float motion_heuristic = motion_table.state_space->distance(from(), to());
+  // Dubin or Reeds-Shepp shortest distances, from the precomputed table if near the goal
+  float motion_heuristic;
+  if (!motion_table.distance_heuristic_table ||
+    !motion_table.distance_heuristic_table->lookup(
+      node_coords.x, node_coords.y, node_coords.theta,
+      goal_coords.x, goal_coords.y, goal_coords.theta, motion_heuristic))
+  {
+    // Create OMPL states for checking
+    ompl::base::ScopedState<> from(motion_table.state_space), to(motion_table.state_space);
+    from[0] = node_coords.x;
+    from[1] = node_coords.y;
+    from[2] = node_coords.theta * motion_table.bin_size;
+    to[0] = goal_coords.x;
+    to[1] = goal_coords.y;
+    to[2] = goal_coords.theta * motion_table.bin_size;
+
+    motion_heuristic = motion_table.state_space->distance(from(), to());
+  }
 
   const unsigned int & wavefront_idx = static_cast<unsigned int>(node_coords.y) *
     motion_table.size_x + static_cast<unsigned int>(node_coords.x);
@@ -348,83 +393,177 @@ void NodeSE2::initMotionModel(
   }
 }
 
+void NodeSE2::setWavefrontHeuristicOptions(const bool & use_cache, const int & num_threads)
+{
+  _wavefront_use_cache = use_cache;
+  _wavefront_threads = num_threads > 0 ? num_threads : omp_get_max_threads();
+  if (!_wavefront_use_cache) {
+    _wavefront_costmap.clear();
+    _wavefront_costmap.shrink_to_fit();
+  }
+}
+
+WavefrontHeuristicStats & NodeSE2::getWavefrontHeuristicStats()
+{
+  return _wavefront_stats;
+}
+
 void NodeSE2::computeWavefrontHeuristic(
-  nav2_costmap_2d::Costmap2D * & costmap,
-  const unsigned int & start_x, const unsigned int & start_y,
+  const nav2_costmap_2d::Costmap2D * costmap,
+  const unsigned int & /*start_x*/, const unsigned int & /*start_y*/,
   const unsigned int & goal_x, const unsigned int & goal_y)
 {
-  unsigned int size = costmap->getSizeInCellsX() * costmap->getSizeInCellsY();
-  if (_wavefront_heuristic.size() == size) {
-    // must reset all values
-    for (unsigned int i = 0; i != _wavefront_heuristic.size(); i++) {
-      _wavefront_heuristic[i] = 0;
-    }
-  } else {
-    unsigned int wavefront_size = _wavefront_heuristic.size();
-    _wavefront_heuristic.resize(size, 0);
-    // must reset values for non-constructed indices
-    for (unsigned int i = 0; i != wavefront_size; i++) {
-      _wavefront_heuristic[i] = 0;
-    }
-  }
+  steady_clock::time_point a = steady_clock::now();
 
   const unsigned int & size_x = motion_table.size_x;
   const int size_x_int = static_cast<int>(size_x);
   const unsigned int size_y = costmap->getSizeInCellsY();
+  const unsigned int size = costmap->getSizeInCellsX() * size_y;
   const unsigned int goal_index = goal_y * size_x + goal_x;
-  const unsigned int start_index = start_y * size_x + start_x;
-  unsigned int mx, my, mx_idx, my_idx;
+  const unsigned char * charmap = costmap->getCharMap();
+
+  // The field only depends on the goal and the costmap, so reuse it if neither changed.
+  // The width is compared too, as a costmap of another shape can have the same cells.
+  if (_wavefront_use_cache && _wavefront_heuristic.size() == size &&
+    _wavefront_costmap.size() == size && _wavefront_size_x == costmap->getSizeInCellsX() &&
+    _wavefront_goal_index == goal_index &&
+    std::equal(charmap, charmap + size, _wavefront_costmap.begin()))
+  {
+    _wavefront_stats.cache_hits++;
+    _wavefront_stats.last_was_cache_hit = true;
+    _wavefront_stats.compute_time =
+      duration_cast<duration<double>>(steady_clock::now() - a).count();
+    return;
+  }
 
-  std::queue<unsigned int> q;
-  q.emplace(goal_index);
+  _wavefront_stats.cache_misses++;
+  _wavefront_stats.last_was_cache_hit = false;
+  if (_wavefront_use_cache) {
+    _wavefront_costmap.assign(charmap, charmap + size);
+    _wavefront_size_x = costmap->getSizeInCellsX();
+    _wavefront_goal_index = goal_index;
+  }
 
-  unsigned int idx = goal_index;
-  _wavefront_heuristic[idx] = 2;
+  // must reset all values
+  _wavefront_heuristic.resize(size);
+  std::fill(_wavefront_heuristic.begin(), _wavefront_heuristic.end(), 0u);
 
-  static const std::vector<int> neighborhood = {1, -1,  // left right
+  const std::vector<int> neighborhood = {1, -1,  // left right
     size_x_int, -size_x_int,  // up down
     size_x_int + 1, size_x_int - 1,  // upper diagonals
     -size_x_int + 1, -size_x_int - 1};  // lower diagonals
 
-  while (!q.empty() || idx == start_index) {
-    // get next one
-    idx = q.front();
-    q.pop();
-
-    my_idx = idx / size_x;
-    mx_idx = idx - (my_idx * size_x);
-
-    // find neighbors
-    for (unsigned int i = 0; i != neighborhood.size(); i++) {
-      unsigned int new_idx = static_cast<unsigned int>(static_cast<int>(idx) + neighborhood[i]);
-      unsigned int last_wave_cost = _wavefront_heuristic[idx];
-
-      // if neighbor is unvisited and non-lethal, set N and add to queue
-      if (new_idx > 0 && new_idx < size_x * size_y &&
-        _wavefront_heuristic[new_idx] == 0 &&
-        static_cast<float>(costmap->getCost(idx)) < INSCRIBED)
-      {
-        my = new_idx / size_x;
-        mx = new_idx - (my * size_x);
-
-        if (mx == 0 && mx_idx >= size_x - 1 || mx >= size_x - 1 && mx_idx == 0) {
-          continue;
+  // Whether a neighbor is on the map and does not wrap around its edges
+  auto is_valid_neighbor = [&](const unsigned int & idx, const unsigned int & new_idx) -> bool
+    {
+      if (new_idx == 0 || new_idx >= size_x * size_y) {
+        return false;
+      }
+
+      const unsigned int my_idx = idx / size_x;
+      const unsigned int mx_idx = idx - (my_idx * size_x);
+      const unsigned int my = new_idx / size_x;
+      const unsigned int mx = new_idx - (my * size_x);
+
+      if ((mx == 0 && mx_idx >= size_x - 1) || (mx >= size_x - 1 && mx_idx == 0)) {
+        return false;
+      }
+      if ((my == 0 && my_idx >= size_y - 1) || (my >= size_y - 1 && my_idx == 0)) {
+        return false;
+      }
+      return true;
+    };
+
+  _wavefront_heuristic[goal_index] = 2;
+
+  if (_wavefront_threads <= 1) {
+    std::queue<unsigned int> q;
+    q.emplace(goal_index);
+
+    unsigned int idx;
+    while (!q.empty()) {
+      // get next one
+      idx = q.front();
+      q.pop();
+
+      // lethal cells are given a cost but are not expanded
+      if (static_cast<float>(charmap[idx]) >= INSCRIBED) {
+        continue;
+      }
+
+      const unsigned int last_wave_cost = _wavefront_heuristic[idx];
+
+      // if neighbor is unvisited, set N and add to queue
+      for (unsigned int i = 0; i != neighborhood.size(); i++) {
+        unsigned int new_idx = static_cast<unsigned int>(static_cast<int>(idx) + neighborhood[i]);
+        if (is_valid_neighbor(idx, new_idx) && _wavefront_heuristic[new_idx] == 0) {
+          _wavefront_heuristic[new_idx] = last_wave_cost + 1;
+          q.emplace(new_idx);
         }
-        if (my == 0 && my_idx >= size_y - 1 || my >= size_y - 1 && my_idx == 0) {
-          continue;
+      }
+    }
+  } else {
+    // Level-synchronous breadth first search: each wave is split across threads,
+    // which claim unvisited cells atomically. The wave cost of a cell is its BFS
+    // depth, so the field is identical to the serial search regardless of order.
+    std::vector<unsigned int> frontier(1, goal_index);
+    std::vector<unsigned int> next_frontier;
+    unsigned int * field = _wavefront_heuristic.data();
+    unsigned int next_wave_cost = 3;
+
+    #pragma omp parallel num_threads(_wavefront_threads)
+    {
+      std::vector<unsigned int> local_frontier;
+
+      while (!frontier.empty()) {
+        local_frontier.clear();
+        const int frontier_size = static_cast<int>(frontier.size());
+
+        #pragma omp for schedule(static)
+        for (int f = 0; f < frontier_size; f++) {
+          const unsigned int idx = frontier[f];
+          if (static_cast<float>(charmap[idx]) >= INSCRIBED) {
+            continue;
+          }
+
+          for (unsigned int i = 0; i != neighborhood.size(); i++) {
+            unsigned int new_idx =
+              static_cast<unsigned int>(static_cast<int>(idx) + neighborhood[i]);
+            unsigned int unvisited = 0;
+            if (is_valid_neighbor(idx, new_idx) &&
+              __atomic_load_n(&field[new_idx], __ATOMIC_RELAXED) == 0 &&
+              __atomic_compare_exchange_n(
+                &field[new_idx], &unvisited, next_wave_cost, false,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+              local_frontier.push_back(new_idx);
+            }
+          }
         }
 
-        _wavefront_heuristic[new_idx] = last_wave_cost + 1;
-        q.emplace(idx + neighborhood[i]);
+        #pragma omp critical
+        next_frontier.insert(next_frontier.end(), local_frontier.begin(), local_frontier.end());
+
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+          std::swap(frontier, next_frontier);
+          next_frontier.clear();
+          next_wave_cost++;
+        }
       }
     }
   }
+
+  _wavefront_stats.compute_time =
+    duration_cast<duration<double>>(steady_clock::now() - a).count();
 }
 
 void NodeSE2::getNeighbors(
   const NodePtr & node,
   std::function<bool(const unsigned int &, nav2_smac_planner::NodeSE2 * &)> & NeighborGetter,
-  GridCollisionChecker collision_checker,
+  GridCollisionChecker & collision_checker,
   const bool & traverse_unknown,
   NodeVector & neighbors)
 {
@@ -52,6 +52,7 @@ void SmacPlanner::configure(
   _logger = node->get_logger();
   _clock = node->get_clock();
   _costmap = costmap_ros->getCostmap();
+  _costmap_ros = costmap_ros;
   _name = name;
   _global_frame = costmap_ros->getGlobalFrameID();
 
@@ -61,7 +62,11 @@ void SmacPlanner::configure(
   int angle_quantizations;
   SearchInfo search_info;
   bool smooth_path;
+  bool cache_wavefront_heuristic;
+  int wavefront_heuristic_threads;
   std::string motion_model_for_search;
+  std::string graph_storage_type_str;
+  std::string open_set_type_str;
 
   // General planner params
   nav2_util::declare_parameter_if_not_declared(
@@ -110,6 +115,23 @@ void SmacPlanner::configure(
     node, name + ".analytic_expansion_ratio", rclcpp::ParameterValue(2.0));
   node->get_parameter(name + ".analytic_expansion_ratio", search_info.analytic_expansion_ratio);
 
+  double lookup_table_size;
+  nav2_util::declare_parameter_if_not_declared(
+    node, name + ".heuristic_lookup_table_size", rclcpp::ParameterValue(0.0));
+  node->get_parameter(name + ".heuristic_lookup_table_size", lookup_table_size);
+  nav2_util::declare_parameter_if_not_declared(
+    node, name + ".heuristic_lookup_table_cache_dir", rclcpp::ParameterValue(std::string("")));
+  node->get_parameter(
+    name + ".heuristic_lookup_table_cache_dir", search_info.lookup_table_cache_dir);
+
+  nav2_util::declare_parameter_if_not_declared(
+    node, name + ".cache_wavefront_heuristic", rclcpp::ParameterValue(true));
+  node->get_parameter(name + ".cache_wavefront_heuristic", cache_wavefront_heuristic);
+  nav2_util::declare_parameter_if_not_declared(
+    node, name + ".wavefront_heuristic_threads", rclcpp::ParameterValue(1));
+  node->get_parameter(name + ".wavefront_heuristic_threads", wavefront_heuristic_threads);
+  NodeSE2::setWavefrontHeuristicOptions(cache_wavefront_heuristic, wavefront_heuristic_threads);
+
   nav2_util::declare_parameter_if_not_declared(
     node, name + ".max_planning_time", rclcpp::ParameterValue(5.0));
   node->get_parameter(name + ".max_planning_time", _max_planning_time);
@@ -126,6 +148,32 @@ void SmacPlanner::configure(
       motion_model_for_search.c_str());
   }
 
+  nav2_util::declare_parameter_if_not_declared(
+    node, name + ".graph_storage_type", rclcpp::ParameterValue(std::string("HASHMAP")));
+  node->get_parameter(name + ".graph_storage_type", graph_storage_type_str);
+  GraphStorageType graph_storage_type = graphStorageTypeFromString(graph_storage_type_str);
+  if (graph_storage_type == GraphStorageType::UNKNOWN) {
+    RCLCPP_WARN(
+      _logger,
+      "Unable to get GraphStorageType. Given '%s', "
+      "valid options are HASHMAP, DENSE. Using HASHMAP.",
+      graph_storage_type_str.c_str());
+    graph_storage_type = GraphStorageType::HASHMAP;
+  }
+
+  nav2_util::declare_parameter_if_not_declared(
+    node, name + ".open_set_type", rclcpp::ParameterValue(std::string("PRIORITY_QUEUE")));
+  node->get_parameter(name + ".open_set_type", open_set_type_str);
+  OpenSetType open_set_type = openSetTypeFromString(open_set_type_str);
+  if (open_set_type == OpenSetType::UNKNOWN) {
+    RCLCPP_WARN(
+      _logger,
+      "Unable to get OpenSetType. Given '%s', "
+      "valid options are PRIORITY_QUEUE, INDEXED_HEAP, RADIX_HEAP. Using PRIORITY_QUEUE.",
+      open_set_type_str.c_str());
+    open_set_type = OpenSetType::PRIORITY_QUEUE;
+  }
+
   if (max_on_approach_iterations <= 0) {
     RCLCPP_INFO(
       _logger, "On approach iteration selected as <= 0, "
@@ -144,12 +192,16 @@ void SmacPlanner::configure(
   const double minimum_turning_radius_global_coords = search_info.minimum_turning_radius;
   search_info.minimum_turning_radius =
     search_info.minimum_turning_radius / (_costmap->getResolution() * _downsampling_factor);
+  search_info.lookup_table_size = static_cast<float>(
+    lookup_table_size / (_costmap->getResolution() * _downsampling_factor));
 
   _a_star = std::make_unique<AStarAlgorithm<NodeSE2>>(motion_model, search_info);
   _a_star->initialize(
     allow_unknown,
     max_iterations,
-    max_on_approach_iterations);
+    max_on_approach_iterations,
+    graph_storage_type,
+    open_set_type);
   _a_star->setFootprint(costmap_ros->getRobotFootprint(), costmap_ros->getUseRadius());
 
   if (smooth_path) {
@@ -172,10 +224,12 @@ void SmacPlanner::configure(
   RCLCPP_INFO(
     _logger, "Configured plugin %s of type SmacPlanner with "
     "tolerance %.2f, maximum iterations %i, "
-    "max on approach iterations %i, and %s. Using motion model: %s.",
+    "max on approach iterations %i, and %s. Using motion model: %s, "
+    "graph storage: %s and open set: %s.",
     _name.c_str(), _tolerance, max_iterations, max_on_approach_iterations,
     allow_unknown ? "allowing unknown traversal" : "not allowing unknown traversal",
-    toString(motion_model).c_str());
+    toString(motion_model).c_str(), toString(graph_storage_type).c_str(),
+    toString(open_set_type).c_str());
 }
 
 void SmacPlanner::activate()
@@ -209,6 +263,7 @@ void SmacPlanner::cleanup()
   _smoother.reset();
   _costmap_downsampler->on_cleanup();
   _costmap_downsampler.reset();
+  _costmap_ros.reset();
   _raw_plan_publisher.reset();
 }
 
@@ -218,11 +273,23 @@ nav_msgs::msg::Path SmacPlanner::createPlan(
 {
   steady_clock::time_point a = steady_clock::now();
 
-  std::unique_lock<nav2_costmap_2d::Costmap2D::mutex_t> lock(*(_costmap->getMutex()));
+  // Plan on a snapshot of the costmap if it is double buffered, so that it keeps
+  // updating during long plans, else lock the costmap for the whole plan
+  std::shared_ptr<const nav2_costmap_2d::Costmap2D> snapshot =
+    _costmap_ros->getCostmapSnapshot();
+  const nav2_costmap_2d::Costmap2D * costmap = snapshot ? snapshot.get() : _costmap;
+  std::unique_lock<nav2_costmap_2d::Costmap2D::mutex_t> lock(
+    *(_costmap->getMutex()), std::defer_lock);
+  if (!snapshot) {
+    lock.lock();
+    RCLCPP_DEBUG(
+      _logger, "Waited %f seconds for the costmap lock",
+      duration_cast<duration<double>>(steady_clock::now() - a).count());
+  }
 
   // Downsample costmap, if required
-  nav2_costmap_2d::Costmap2D * costmap = _costmap;
   if (_costmap_downsampler) {
+    _costmap_downsampler->setCostmap(costmap);
     costmap = _costmap_downsampler->downsample(_downsampling_factor);
   }
 
@@ -283,6 +350,19 @@ nav_msgs::msg::Path SmacPlanner::createPlan(
     error += e.what();
   }
 
+  RCLCPP_DEBUG(
+    _logger,
+    "%s: search ran %i iterations with a peak open set size of %u.",
+    _name.c_str(), num_iterations, _a_star->getPeakQueueSize());
+
+  const WavefrontHeuristicStats & wavefront_stats = NodeSE2::getWavefrontHeuristicStats();
+  RCLCPP_DEBUG(
+    _logger,
+    "%s: wavefront heuristic %s in %.3f ms (%u cache hits, %u cache misses).",
+    _name.c_str(), wavefront_stats.last_was_cache_hit ? "reused" : "computed",
+    wavefront_stats.compute_time * 1000.0, wavefront_stats.cache_hits,
+    wavefront_stats.cache_misses);
+
   if (!error.empty()) {
     RCLCPP_WARN(
       _logger,
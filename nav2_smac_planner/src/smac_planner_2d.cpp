@@ -50,6 +50,7 @@ void SmacPlanner2D::configure(
   _logger = node->get_logger();
   _clock = node->get_clock();
   _costmap = costmap_ros->getCostmap();
+  _costmap_ros = costmap_ros;
   _name = name;
   _global_frame = costmap_ros->getGlobalFrameID();
 
@@ -59,6 +60,8 @@ void SmacPlanner2D::configure(
   bool smooth_path;
   double minimum_turning_radius;
   std::string motion_model_for_search;
+  std::string graph_storage_type_str;
+  std::string open_set_type_str;
 
   // General planner params
   nav2_util::declare_parameter_if_not_declared(
@@ -103,6 +106,32 @@ void SmacPlanner2D::configure(
       motion_model_for_search.c_str());
   }
 
+  nav2_util::declare_parameter_if_not_declared(
+    node, name + ".graph_storage_type", rclcpp::ParameterValue(std::string("HASHMAP")));
+  node->get_parameter(name + ".graph_storage_type", graph_storage_type_str);
+  GraphStorageType graph_storage_type = graphStorageTypeFromString(graph_storage_type_str);
+  if (graph_storage_type == GraphStorageType::UNKNOWN) {
+    RCLCPP_WARN(
+      _logger,
+      "Unable to get GraphStorageType. Given '%s', "
+      "valid options are HASHMAP, DENSE. Using HASHMAP.",
+      graph_storage_type_str.c_str());
+    graph_storage_type = GraphStorageType::HASHMAP;
+  }
+
+  nav2_util::declare_parameter_if_not_declared(
+    node, name + ".open_set_type", rclcpp::ParameterValue(std::string("PRIORITY_QUEUE")));
+  node->get_parameter(name + ".open_set_type", open_set_type_str);
+  OpenSetType open_set_type = openSetTypeFromString(open_set_type_str);
+  if (open_set_type == OpenSetType::UNKNOWN) {
+    RCLCPP_WARN(
+      _logger,
+      "Unable to get OpenSetType. Given '%s', "
+      "valid options are PRIORITY_QUEUE, INDEXED_HEAP, RADIX_HEAP. Using PRIORITY_QUEUE.",
+      open_set_type_str.c_str());
+    open_set_type = OpenSetType::PRIORITY_QUEUE;
+  }
+
   if (max_on_approach_iterations <= 0) {
     RCLCPP_INFO(
       _logger, "On approach iteration selected as <= 0, "
@@ -121,7 +150,9 @@ void SmacPlanner2D::configure(
   _a_star->initialize(
     allow_unknown,
     max_iterations,
-    max_on_approach_iterations);
+    max_on_approach_iterations,
+    graph_storage_type,
+    open_set_type);
 
   if (smooth_path) {
     _smoother = std::make_unique<Smoother>();
@@ -143,10 +174,12 @@ void SmacPlanner2D::configure(
   RCLCPP_INFO(
     _logger, "Configured plugin %s of type SmacPlanner2D with "
     "tolerance %.2f, maximum iterations %i, "
-    "max on approach iterations %i, and %s. Using motion model: %s.",
+    "max on approach iterations %i, and %s. Using motion model: %s, "
+    "graph storage: %s and open set: %s.",
     _name.c_str(), _tolerance, max_iterations, max_on_approach_iterations,
     allow_unknown ? "allowing unknown traversal" : "not allowing unknown traversal",
-    toString(motion_model).c_str());
+    toString(motion_model).c_str(), toString(graph_storage_type).c_str(),
+    toString(open_set_type).c_str());
 }
 
 void SmacPlanner2D::activate()
@@ -180,6 +213,7 @@ void SmacPlanner2D::cleanup()
   _smoother.reset();
   _costmap_downsampler->on_cleanup();
   _costmap_downsampler.reset();
+  _costmap_ros.reset();
   _raw_plan_publisher.reset();
 }
 
@@ -189,11 +223,23 @@ nav_msgs::msg::Path SmacPlanner2D::createPlan(
 {
   steady_clock::time_point a = steady_clock::now();
 
-  std::unique_lock<nav2_costmap_2d::Costmap2D::mutex_t> lock(*(_costmap->getMutex()));
+  // Plan on a snapshot of the costmap if it is double buffered, so that it keeps
+  // updating during long plans, else lock the costmap for the whole plan
+  std::shared_ptr<const nav2_costmap_2d::Costmap2D> snapshot =
+    _costmap_ros->getCostmapSnapshot();
+  const nav2_costmap_2d::Costmap2D * costmap = snapshot ? snapshot.get() : _costmap;
+  std::unique_lock<nav2_costmap_2d::Costmap2D::mutex_t> lock(
+    *(_costmap->getMutex()), std::defer_lock);
+  if (!snapshot) {
+    lock.lock();
+    RCLCPP_DEBUG(
+      _logger, "Waited %f seconds for the costmap lock",
+      duration_cast<duration<double>>(steady_clock::now() - a).count());
+  }
 
   // Downsample costmap, if required
-  nav2_costmap_2d::Costmap2D * costmap = _costmap;
   if (_costmap_downsampler) {
+    _costmap_downsampler->setCostmap(costmap);
     costmap = _costmap_downsampler->downsample(_downsampling_factor);
   }
 
@@ -244,6 +290,11 @@ nav_msgs::msg::Path SmacPlanner2D::createPlan(
     error += e.what();
   }
 
+  RCLCPP_DEBUG(
+    _logger,
+    "%s: search ran %i iterations with a peak open set size of %u.",
+    _name.c_str(), num_iterations, _a_star->getPeakQueueSize());
+
   if (!error.empty()) {
     RCLCPP_WARN(
       _logger,
@@ -0,0 +1,105 @@
+// Copyright (c) 2020, Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+// Compares footprint collision checking with the precomputed footprint masks
+// of the GridCollisionChecker against rotating and rasterizing the footprint
+// at every pose with FootprintCollisionChecker::footprintCostAtPose.
+// Usage: benchmark_collision_checker [num_checks] [footprint_length_m]
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_smac_planner/collision_checker.hpp"
+
+using namespace std::chrono;  // NOLINT
+
+int main(int argc, char ** argv)
+{
+  const unsigned int num_checks = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  const double length = argc > 2 ? std::atof(argv[2]) : 1.0;
+  const unsigned int bins = 72;
+  const float bin_size = 2.0f * M_PI / bins;
+  const unsigned int size = 1000;
+
+  // Possibly inscribed everywhere, so every check must look at the full footprint
+  auto costmap = std::make_unique<nav2_costmap_2d::Costmap2D>(size, size, 0.05, 0.0, 0.0, 0);
+  std::srand(42);
+  for (unsigned int i = 0; i != size; i++) {
+    for (unsigned int j = 0; j != size; j++) {
+      costmap->setCost(i, j, 128 + std::rand() % 100);
+    }
+  }
+
+  geometry_msgs::msg::Point p1, p2, p3, p4;
+  p1.x = length / 2.0;
+  p1.y = length / 3.0;
+  p2.x = length / 2.0;
+  p2.y = -length / 3.0;
+  p3.x = -length / 2.0;
+  p3.y = -length / 3.0;
+  p4.x = -length / 2.0;
+  p4.y = length / 3.0;
+  nav2_costmap_2d::Footprint footprint = {p1, p2, p3, p4};
+
+  // Same sequence of poses for each method, at fractions of cells like search poses
+  std::vector<float> xs(num_checks), ys(num_checks);
+  std::vector<unsigned int> thetas(num_checks);
+  for (unsigned int i = 0; i != num_checks; i++) {
+    xs[i] = 100 + std::rand() % (size - 200) + (std::rand() % 64) / 64.0f;
+    ys[i] = 100 + std::rand() % (size - 200) + (std::rand() % 64) / 64.0f;
+    thetas[i] = std::rand() % bins;
+  }
+
+  nav2_costmap_2d::FootprintCollisionChecker<nav2_costmap_2d::Costmap2D *> rasterizing_checker(
+    costmap.get());
+  double wx, wy, rasterized_sum = 0.0;
+  steady_clock::time_point a = steady_clock::now();
+  for (unsigned int i = 0; i != num_checks; i++) {
+    wx = (xs[i] + 0.5) * costmap->getResolution();
+    wy = (ys[i] + 0.5) * costmap->getResolution();
+    rasterized_sum += rasterizing_checker.footprintCostAtPose(
+      wx, wy, thetas[i] * bin_size, footprint);
+  }
+  steady_clock::time_point b = steady_clock::now();
+  std::cout << "Rasterized footprint: " <<
+    duration_cast<duration<double>>(b - a).count() * 1e9 / num_checks << " ns/check" << std::endl;
+
+  for (const bool fill : {false, true}) {
+    nav2_smac_planner::GridCollisionChecker mask_checker(costmap.get(), bins);
+    a = steady_clock::now();
+    mask_checker.setFootprint(footprint, false, fill);
+    b = steady_clock::now();
+    const double precompute_ms = duration_cast<duration<double>>(b - a).count() * 1000.0;
+
+    double mask_sum = 0.0;
+    a = steady_clock::now();
+    for (unsigned int i = 0; i != num_checks; i++) {
+      mask_checker.inCollision(xs[i], ys[i], thetas[i] * bin_size, false);
+      mask_sum += mask_checker.getCost();
+    }
+    b = steady_clock::now();
+    std::cout << (fill ? "Area" : "Outline") << " footprint mask: " <<
+      duration_cast<duration<double>>(b - a).count() * 1e9 / num_checks << " ns/check, " <<
+      mask_checker.getFootprintMask(0).offsets.size() << " cells, " << precompute_ms <<
+      " ms to precompute" << (fill || mask_sum == rasterized_sum ? "" : " (MISMATCH)") <<
+      std::endl;
+  }
+
+  return 0;
+}
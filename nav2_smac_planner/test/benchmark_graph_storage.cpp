@@ -0,0 +1,107 @@
+// Copyright (c) 2020, Samsung Research America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License. Reserved.
+
+// Compares the search graph storage backends of the A* template on large
+// open maps and large maps with sparse, scattered obstacles.
+// Usage: benchmark_graph_storage [size_in_cells] [runs]
+
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nav2_costmap_2d/costmap_2d.hpp"
+#include "nav2_smac_planner/a_star.hpp"
+
+using namespace std::chrono;  // NOLINT
+using nav2_smac_planner::GraphStorageType;
+
+template<typename NodeT>
+void benchmark(
+  const std::string & map_name,
+  nav2_costmap_2d::Costmap2D * costmap,
+  const nav2_smac_planner::MotionModel & motion_model,
+  const unsigned int & dim_3,
+  const GraphStorageType & type,
+  const int & runs)
+{
+  nav2_smac_planner::SearchInfo info;
+  info.change_penalty = 1.2;
+  info.non_straight_penalty = 1.4;
+  info.reverse_penalty = 2.1;
+  info.cost_penalty = 1.0;
+  info.minimum_turning_radius = 8.0;
+  info.analytic_expansion_ratio = 3.5;
+  int max_iterations = std::numeric_limits<int>::max();
+
+  nav2_smac_planner::AStarAlgorithm<NodeT> a_star(motion_model, info);
+  a_star.initialize(false, max_iterations, std::numeric_limits<int>::max(), type);
+  a_star.setFootprint(nav2_costmap_2d::Footprint(), true);
+
+  const unsigned int size_x = costmap->getSizeInCellsX();
+  const unsigned int size_y = costmap->getSizeInCellsY();
+  double total_ms = 0.0;
+  int num_it = 0;
+
+  for (int run = 0; run != runs; run++) {
+    steady_clock::time_point a = steady_clock::now();
+    a_star.createGraph(size_x, size_y, dim_3, costmap);
+    a_star.setStart(10u, 10u, 0u);
+    a_star.setGoal(size_x - 10u, size_y - 10u, 0u);
+    typename NodeT::CoordinateVector path;
+    num_it = 0;
+    a_star.createPath(path, num_it, 0.0);
+    steady_clock::time_point b = steady_clock::now();
+    total_ms += duration_cast<duration<double>>(b - a).count() * 1000.0;
+  }
+
+  std::cout << map_name << " " << toString(motion_model) << " " << toString(type) <<
+    ": " << total_ms / runs << " ms/plan with " << num_it << " iterations." << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+  const unsigned int size = argc > 1 ? std::atoi(argv[1]) : 4000;
+  const int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  // Open, empty map
+  auto open_map = std::make_unique<nav2_costmap_2d::Costmap2D>(size, size, 0.05, 0.0, 0.0, 0);
+
+  // Same map with a sparse scattering of lethal cells and a cost gradient
+  auto sparse_map = std::make_unique<nav2_costmap_2d::Costmap2D>(size, size, 0.05, 0.0, 0.0, 0);
+  std::srand(42);
+  for (unsigned int i = 0; i != size * size / 200; i++) {
+    unsigned int mx = 20 + std::rand() % (size - 40);
+    unsigned int my = 20 + std::rand() % (size - 40);
+    sparse_map->setCost(mx, my, 254);
+    sparse_map->setCost(mx + 1, my, 128);
+    sparse_map->setCost(mx, my + 1, 128);
+  }
+
+  for (auto type : {GraphStorageType::HASHMAP, GraphStorageType::DENSE}) {
+    benchmark<nav2_smac_planner::Node2D>(
+      "open", open_map.get(), nav2_smac_planner::MotionModel::MOORE, 1, type, runs);
+    benchmark<nav2_smac_planner::Node2D>(
+      "sparse", sparse_map.get(), nav2_smac_planner::MotionModel::MOORE, 1, type, runs);
+    benchmark<nav2_smac_planner::NodeSE2>(
+      "open", open_map.get(), nav2_smac_planner::MotionModel::DUBIN, 72, type, runs);
+    benchmark<nav2_smac_planner::NodeSE2>(
+      "sparse", sparse_map.get(), nav2_smac_planner::MotionModel::DUBIN, 72, type, runs);
+  }
+
+  return 0;
+}
@@ -163,6 +163,133 @@ TEST(AStarTest, test_a_star_se2)
   delete costmapA;
 }
 
+TEST(AStarTest, test_a_star_dense_graph)
+{
+  nav2_smac_planner::SearchInfo info;
+  int max_iterations = 10000;
+  float tolerance = 0.0;
+  int it_on_approach = 10;
+
+  nav2_costmap_2d::Costmap2D * costmapA =
+    new nav2_costmap_2d::Costmap2D(100, 100, 0.1, 0.0, 0.0, 0);
+  // island in the middle of lethal cost to cross
+  for (unsigned int i = 40; i <= 60; ++i) {
+    for (unsigned int j = 40; j <= 60; ++j) {
+      costmapA->setCost(i, j, 254);
+    }
+  }
+
+  nav2_smac_planner::AStarAlgorithm<nav2_smac_planner::Node2D> a_star(
+    nav2_smac_planner::MotionModel::MOORE, info);
+  a_star.initialize(
+    false, max_iterations, it_on_approach, nav2_smac_planner::GraphStorageType::DENSE);
+  a_star.setFootprint(nav2_costmap_2d::Footprint(), true);
+
+  // the slab is reused between searches, results must match the hashmap graph
+  for (unsigned int run = 0; run != 3; run++) {
+    int num_it = 0;
+    a_star.createGraph(costmapA->getSizeInCellsX(), costmapA->getSizeInCellsY(), 1, costmapA);
+    a_star.setStart(20u, 20u, 0);
+    a_star.setGoal(80u, 80u, 0);
+    nav2_smac_planner::Node2D::CoordinateVector path;
+    EXPECT_TRUE(a_star.createPath(path, num_it, tolerance));
+    EXPECT_EQ(num_it, 556);
+    EXPECT_EQ(path.size(), 81u);
+    for (unsigned int i = 0; i != path.size(); i++) {
+      EXPECT_EQ(costmapA->getCost(path[i].x, path[i].y), 0);
+    }
+  }
+
+  // a new obstacle must be seen in the next search on the same slab
+  costmapA->setCost(20, 21, 254);
+  int num_it = 0;
+  a_star.createGraph(costmapA->getSizeInCellsX(), costmapA->getSizeInCellsY(), 1, costmapA);
+  a_star.setStart(20u, 20u, 0);
+  a_star.setGoal(20u, 21u, 0);
+  nav2_smac_planner::Node2D::CoordinateVector path;
+  EXPECT_THROW(a_star.createPath(path, num_it, tolerance), std::runtime_error);
+
+  delete costmapA;
+}
+
+TEST(AStarTest, test_a_star_open_sets)
+{
+  nav2_smac_planner::SearchInfo info;
+  int max_iterations = 10000;
+  float tolerance = 0.0;
+  int it_on_approach = 10;
+
+  nav2_costmap_2d::Costmap2D * costmapA =
+    new nav2_costmap_2d::Costmap2D(100, 100, 0.1, 0.0, 0.0, 0);
+  // island in the middle of lethal cost to cross, with a cost gradient around it
+  for (unsigned int i = 30; i <= 70; ++i) {
+    for (unsigned int j = 30; j <= 70; ++j) {
+      costmapA->setCost(i, j, 100);
+    }
+  }
+  for (unsigned int i = 40; i <= 60; ++i) {
+    for (unsigned int j = 40; j <= 60; ++j) {
+      costmapA->setCost(i, j, 254);
+    }
+  }
+
+  unsigned int priority_queue_peak = 0;
+  for (auto type : {nav2_smac_planner::OpenSetType::PRIORITY_QUEUE,
+      nav2_smac_planner::OpenSetType::INDEXED_HEAP,
+      nav2_smac_planner::OpenSetType::RADIX_HEAP})
+  {
+    nav2_smac_planner::AStarAlgorithm<nav2_smac_planner::Node2D> a_star(
+      nav2_smac_planner::MotionModel::MOORE, info);
+    a_star.initialize(
+      false, max_iterations, it_on_approach,
+      nav2_smac_planner::GraphStorageType::HASHMAP, type);
+    a_star.setFootprint(nav2_costmap_2d::Footprint(), true);
+
+    int num_it = 0;
+    a_star.createGraph(costmapA->getSizeInCellsX(), costmapA->getSizeInCellsY(), 1, costmapA);
+    a_star.setStart(20u, 20u, 0);
+    a_star.setGoal(80u, 80u, 0);
+    nav2_smac_planner::Node2D::CoordinateVector path;
+    EXPECT_TRUE(a_star.createPath(path, num_it, tolerance));
+    EXPECT_GT(path.size(), 60u);
+    for (unsigned int i = 0; i != path.size(); i++) {
+      EXPECT_LT(costmapA->getCost(path[i].x, path[i].y), 254);
+    }
+
+    // decrease-key keeps at most one entry per node in the open set
+    if (type == nav2_smac_planner::OpenSetType::PRIORITY_QUEUE) {
+      priority_queue_peak = a_star.getPeakQueueSize();
+    } else {
+      EXPECT_LE(a_star.getPeakQueueSize(), priority_queue_peak);
+    }
+    EXPECT_GT(a_star.getPeakQueueSize(), 0u);
+  }
+
+  // SE2 search with an indexed heap
+  info.change_penalty = 1.2;
+  info.non_straight_penalty = 1.4;
+  info.reverse_penalty = 2.1;
+  info.minimum_turning_radius = 2.0;  // in grid coordinates
+  nav2_smac_planner::AStarAlgorithm<nav2_smac_planner::NodeSE2> a_star_se2(
+    nav2_smac_planner::MotionModel::DUBIN, info);
+  a_star_se2.initialize(
+    false, max_iterations, it_on_approach,
+    nav2_smac_planner::GraphStorageType::DENSE, nav2_smac_planner::OpenSetType::INDEXED_HEAP);
+  a_star_se2.setFootprint(nav2_costmap_2d::Footprint(), true);
+  a_star_se2.createGraph(
+    costmapA->getSizeInCellsX(), costmapA->getSizeInCellsY(), 72, costmapA);
+  a_star_se2.setStart(10u, 10u, 0u);
+  a_star_se2.setGoal(80u, 80u, 40u);
+  nav2_smac_planner::NodeSE2::CoordinateVector path_se2;
+  int num_it = 0;
+  EXPECT_TRUE(a_star_se2.createPath(path_se2, num_it, 10.0));
+  for (unsigned int i = 0; i != path_se2.size(); i++) {
+    EXPECT_LT(costmapA->getCost(path_se2[i].x, path_se2[i].y), 254);
+  }
+
+  delete costmapA;
+}
+
 TEST(AStarTest, test_constants)
 {
   nav2_smac_planner::MotionModel mm = nav2_smac_planner::MotionModel::UNKNOWN;  // unknown
@@ -185,4 +312,43 @@ TEST(AStarTest, test_constants)
     nav2_smac_planner::fromString(
       "REEDS_SHEPP"), nav2_smac_planner::MotionModel::REEDS_SHEPP);
   EXPECT_EQ(nav2_smac_planner::fromString("NONE"), nav2_smac_planner::MotionModel::UNKNOWN);
+
+  nav2_smac_planner::GraphStorageType gs = nav2_smac_planner::GraphStorageType::UNKNOWN;
+  EXPECT_EQ(nav2_smac_planner::toString(gs), std::string("Unknown"));
+  gs = nav2_smac_planner::GraphStorageType::HASHMAP;
+  EXPECT_EQ(nav2_smac_planner::toString(gs), std::string("Hashmap"));
+  gs = nav2_smac_planner::GraphStorageType::DENSE;
+  EXPECT_EQ(nav2_smac_planner::toString(gs), std::string("Dense"));
+
+  EXPECT_EQ(
+    nav2_smac_planner::graphStorageTypeFromString("HASHMAP"),
+    nav2_smac_planner::GraphStorageType::HASHMAP);
+  EXPECT_EQ(
+    nav2_smac_planner::graphStorageTypeFromString("DENSE"),
+    nav2_smac_planner::GraphStorageType::DENSE);
+  EXPECT_EQ(
+    nav2_smac_planner::graphStorageTypeFromString("NONE"),
+    nav2_smac_planner::GraphStorageType::UNKNOWN);
+
+  nav2_smac_planner::OpenSetType os = nav2_smac_planner::OpenSetType::UNKNOWN;
+  EXPECT_EQ(nav2_smac_planner::toString(os), std::string("Unknown"));
+  os = nav2_smac_planner::OpenSetType::PRIORITY_QUEUE;
+  EXPECT_EQ(nav2_smac_planner::toString(os), std::string("Priority queue"));
+  os = nav2_smac_planner::OpenSetType::INDEXED_HEAP;
+  EXPECT_EQ(nav2_smac_planner::toString(os), std::string("Indexed 4-ary heap"));
+  os = nav2_smac_planner::OpenSetType::RADIX_HEAP;
+  EXPECT_EQ(nav2_smac_planner::toString(os), std::string("Radix heap"));
+
+  EXPECT_EQ(
+    nav2_smac_planner::openSetTypeFromString("PRIORITY_QUEUE"),
+    nav2_smac_planner::OpenSetType::PRIORITY_QUEUE);
+  EXPECT_EQ(
+    nav2_smac_planner::openSetTypeFromString("INDEXED_HEAP"),
+    nav2_smac_planner::OpenSetType::INDEXED_HEAP);
+  EXPECT_EQ(
+    nav2_smac_planner::openSetTypeFromString("RADIX_HEAP"),
+    nav2_smac_planner::OpenSetType::RADIX_HEAP);
+  EXPECT_EQ(
+    nav2_smac_planner::openSetTypeFromString("NONE"),
+    nav2_smac_planner::OpenSetType::UNKNOWN);
 }
@@ -16,6 +16,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <random>
 
 #include "gtest/gtest.h"
 #include "nav2_smac_planner/collision_checker.hpp"
@@ -169,3 +170,158 @@ TEST(collision_footprint, test_point_and_line_cost)
   EXPECT_NEAR(right_value, 254.0, 0.001);
   delete costmap_;
 }
+
+TEST(collision_footprint, test_footprint_masks)
+{
+  nav2_costmap_2d::Costmap2D * costmap_ = new nav2_costmap_2d::Costmap2D(
+    100, 100, 0.05, 0, 0.0, 0);
+
+  // A gradient of possibly inscribed costs, so every footprint check is not trivial
+  for (unsigned int i = 0; i != 100; ++i) {
+    for (unsigned int j = 0; j != 100; ++j) {
+      costmap_->setCost(i, j, 128 + (i * 7 + j * 13) % 100);
+    }
+  }
+
+  geometry_msgs::msg::Point p1;
+  p1.x = 0.5;
+  p1.y = 0.3;
+  geometry_msgs::msg::Point p2;
+  p2.x = 0.5;
+  p2.y = -0.3;
+  geometry_msgs::msg::Point p3;
+  p3.x = -0.5;
+  p3.y = -0.3;
+  geometry_msgs::msg::Point p4;
+  p4.x = -0.5;
+  p4.y = 0.3;
+
+  nav2_costmap_2d::Footprint footprint = {p1, p2, p3, p4};
+
+  const unsigned int bins = 72;
+  const float bin_size = 2.0f * M_PI / bins;
+  nav2_smac_planner::GridCollisionChecker collision_checker(costmap_, bins);
+  collision_checker.setFootprint(footprint, false /*use footprint*/);
+  nav2_costmap_2d::FootprintCollisionChecker<nav2_costmap_2d::Costmap2D *> ref(costmap_);
+
+  // Masks give the same cost as rasterizing the footprint at each pose
+  double wx, wy;
+  for (unsigned int bin = 0; bin != bins; bin++) {
+    EXPECT_FALSE(collision_checker.getFootprintMask(bin).offsets.empty());
+    for (unsigned int x = 10; x < 90; x += 7) {
+      for (unsigned int y = 10; y < 90; y += 5) {
+        costmap_->mapToWorld(x, y, wx, wy);
+        collision_checker.inCollision(x, y, bin * bin_size, true);
+        EXPECT_EQ(
+          collision_checker.getCost(),
+          static_cast<float>(ref.footprintCostAtPose(wx, wy, bin * bin_size, footprint)));
+      }
+    }
+  }
+
+  // Off of the map is still in collision
+  collision_checker.inCollision(2, 50, 0.0, false);
+  EXPECT_NEAR(collision_checker.getCost(), 254.0, 0.001);
+
+  // An obstacle inside of the footprint is only found by checking its area
+  for (unsigned int i = 0; i != 100; ++i) {
+    for (unsigned int j = 0; j != 100; ++j) {
+      costmap_->setCost(i, j, 128);
+    }
+  }
+  costmap_->setCost(52, 50, 254);
+  collision_checker.inCollision(50, 50, 0.0, false);
+  EXPECT_NEAR(collision_checker.getCost(), 128.0, 0.001);
+
+  nav2_smac_planner::GridCollisionChecker area_checker(costmap_, bins);
+  area_checker.setFootprint(footprint, false /*use footprint*/, true /*fill*/);
+  EXPECT_GT(
+    area_checker.getFootprintMask(0).offsets.size(),
+    collision_checker.getFootprintMask(0).offsets.size());
+  EXPECT_TRUE(area_checker.inCollision(50, 50, 0.0, false));
+  EXPECT_NEAR(area_checker.getCost(), 254.0, 0.001);
+  delete costmap_;
+}
+
+TEST(collision_footprint, test_footprint_masks_sub_cell)
+{
+  nav2_costmap_2d::Costmap2D * costmap_ = new nav2_costmap_2d::Costmap2D(
+    100, 100, 0.05, 0, 0.0, 0);
+
+  // Possibly inscribed everywhere, with a wall that only some footprints reach
+  for (unsigned int i = 0; i != 100; ++i) {
+    for (unsigned int j = 0; j != 100; ++j) {
+      costmap_->setCost(i, j, i == 50 && j > 20 && j < 80 ? 254 : 128);
+    }
+  }
+
+  geometry_msgs::msg::Point p1;
+  p1.x = 0.5;
+  p1.y = 0.3;
+  geometry_msgs::msg::Point p2;
+  p2.x = 0.62;
+  p2.y = 0.0;
+  geometry_msgs::msg::Point p3;
+  p3.x = 0.5;
+  p3.y = -0.3;
+  geometry_msgs::msg::Point p4;
+  p4.x = -0.5;
+  p4.y = -0.3;
+  geometry_msgs::msg::Point p5;
+  p5.x = -0.5;
+  p5.y = 0.3;
+
+  nav2_costmap_2d::Footprint footprint = {p1, p2, p3, p4, p5};
+
+  const unsigned int bins = 72;
+  const float bin_size = 2.0f * M_PI / bins;
+  nav2_smac_planner::GridCollisionChecker collision_checker(costmap_, bins);
+  collision_checker.setFootprint(footprint, false /*use footprint*/);
+  nav2_costmap_2d::FootprintCollisionChecker<nav2_costmap_2d::Costmap2D *> ref(costmap_);
+
+  // Search poses are at fractions of cells. The masks give the same cost as
+  // rasterizing the footprint at the pose, as done without masks, although
+  // the footprint is often not in the same cells as for a pose at its cell.
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> x_dist(30.0f, 70.0f);
+  std::uniform_real_distribution<float> y_dist(25.0f, 75.0f);
+  std::uniform_int_distribution<unsigned int> bin_dist(0, bins - 1);
+  double wx, wy;
+  unsigned int collisions = 0, moved = 0;
+  for (unsigned int i = 0; i != 5000; i++) {
+    const float x = x_dist(rng);
+    const float y = y_dist(rng);
+    const float theta = bin_dist(rng) * bin_size;
+    if (costmap_->getCost(static_cast<unsigned int>(x), static_cast<unsigned int>(y)) == 254) {
+      continue;
+    }
+
+    wx = (x + 0.5) * costmap_->getResolution();
+    wy = (y + 0.5) * costmap_->getResolution();
+    const double expected = ref.footprintCostAtPose(wx, wy, theta, footprint);
+    const bool collision = collision_checker.inCollision(x, y, theta, false);
+    EXPECT_EQ(collision_checker.getCost(), static_cast<float>(expected)) <<
+      "pose (" << x << ", " << y << ", " << theta << ")";
+    EXPECT_EQ(collision, expected >= 253.0);
+    collisions += collision;
+
+    costmap_->mapToWorld(std::floor(x), std::floor(y), wx, wy);
+    moved += ref.footprintCostAtPose(wx, wy, theta, footprint) != expected;
+  }
+  EXPECT_GT(collisions, 0u);
+  EXPECT_GT(moved, 0u);
+
+  // The filled area is still checked at fractions of cells
+  for (unsigned int i = 0; i != 100; ++i) {
+    for (unsigned int j = 0; j != 100; ++j) {
+      costmap_->setCost(i, j, 128);
+    }
+  }
+  costmap_->setCost(53, 50, 254);
+  EXPECT_FALSE(collision_checker.inCollision(50.3f, 50.2f, 0.0f, false));
+  nav2_smac_planner::GridCollisionChecker area_checker(costmap_, bins);
+  area_checker.setFootprint(footprint, false /*use footprint*/, true /*fill*/);
+  EXPECT_TRUE(area_checker.inCollision(50.3f, 50.2f, 0.0f, false));
+  EXPECT_NEAR(area_checker.getCost(), 254.0, 0.001);
+  delete costmap_;
+}
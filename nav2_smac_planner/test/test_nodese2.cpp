@@ -13,6 +13,8 @@
 // limitations under the License. Reserved.
 
 #include <math.h>
+#include <algorithm>
+#include <cstdio>
 #include <memory>
 #include <string>
 #include <vector>
@@ -24,6 +26,8 @@
 #include "nav2_util/lifecycle_node.hpp"
 #include "nav2_smac_planner/node_se2.hpp"
 #include "nav2_smac_planner/collision_checker.hpp"
+#include "ompl/base/ScopedState.h"
+#include "ompl/base/spaces/DubinsStateSpace.h"
 
 class RclCppFixture
 {
@@ -212,3 +216,212 @@ TEST(NodeSE2Test, test_node_2d_neighbors)
   // should be empty since totally invalid
   EXPECT_EQ(neighbors.size(), 0u);
 }
+
+TEST(NodeSE2Test, test_node_se2_wavefront_heuristic)
+{
+  nav2_smac_planner::SearchInfo info;
+  info.change_penalty = 1.2;
+  info.non_straight_penalty = 1.4;
+  info.reverse_penalty = 2.1;
+  info.minimum_turning_radius = 0.20;
+  unsigned int size_x = 100;
+  unsigned int size_y = 100;
+  unsigned int size_theta = 72;
+  nav2_smac_planner::NodeSE2::initMotionModel(
+    nav2_smac_planner::MotionModel::DUBIN, size_x, size_y, size_theta, info);
+
+  nav2_costmap_2d::Costmap2D * costmapA = new nav2_costmap_2d::Costmap2D(
+    size_x, size_y, 0.05, 0.0, 0.0, 0);
+  // wall with a gap so the wavefront must go around it
+  for (unsigned int j = 0; j != 80; ++j) {
+    costmapA->setCost(50, j, 254);
+  }
+
+  nav2_smac_planner::NodeSE2::Coordinates goal(90.0, 10.0, 0.0);
+  std::vector<nav2_smac_planner::NodeSE2::Coordinates> samples = {
+    {10.0, 10.0, 0.0}, {49.0, 50.0, 0.0}, {60.0, 90.0, 0.0}, {90.0, 90.0, 0.0}};
+
+  // serial, uncached baseline
+  nav2_smac_planner::NodeSE2::setWavefrontHeuristicOptions(false, 1);
+  nav2_smac_planner::WavefrontHeuristicStats & stats =
+    nav2_smac_planner::NodeSE2::getWavefrontHeuristicStats();
+  const unsigned int misses = stats.cache_misses;
+  nav2_smac_planner::NodeSE2::computeWavefrontHeuristic(costmapA, 10u, 10u, 90u, 10u);
+  std::vector<float> expected;
+  for (const auto & sample : samples) {
+    expected.push_back(nav2_smac_planner::NodeSE2::getHeuristicCost(sample, goal));
+  }
+  EXPECT_FALSE(stats.last_was_cache_hit);
+  EXPECT_EQ(stats.cache_misses, misses + 1);
+
+  // parallel build must be identical
+  nav2_smac_planner::NodeSE2::setWavefrontHeuristicOptions(true, 4);
+  nav2_smac_planner::NodeSE2::computeWavefrontHeuristic(costmapA, 10u, 10u, 90u, 10u);
+  EXPECT_FALSE(stats.last_was_cache_hit);
+  for (unsigned int i = 0; i != samples.size(); i++) {
+    EXPECT_EQ(nav2_smac_planner::NodeSE2::getHeuristicCost(samples[i], goal), expected[i]);
+  }
+
+  // same goal and costmap reuses the field, from any start
+  const unsigned int hits = stats.cache_hits;
+  nav2_smac_planner::NodeSE2::computeWavefrontHeuristic(costmapA, 20u, 20u, 90u, 10u);
+  EXPECT_TRUE(stats.last_was_cache_hit);
+  EXPECT_EQ(stats.cache_hits, hits + 1);
+  for (unsigned int i = 0; i != samples.size(); i++) {
+    EXPECT_EQ(nav2_smac_planner::NodeSE2::getHeuristicCost(samples[i], goal), expected[i]);
+  }
+
+  // a costmap change must recompute it
+  costmapA->setCost(50, 85, 254);
+  nav2_smac_planner::NodeSE2::computeWavefrontHeuristic(costmapA, 20u, 20u, 90u, 10u);
+  EXPECT_FALSE(stats.last_was_cache_hit);
+
+  // as must a new goal
+  nav2_smac_planner::NodeSE2::computeWavefrontHeuristic(costmapA, 20u, 20u, 90u, 11u);
+  EXPECT_FALSE(stats.last_was_cache_hit);
+
+  // and a costmap of another shape with the same cells and goal index
+  unsigned int size_x_b = 50;
+  unsigned int size_y_b = 200;
+  nav2_smac_planner::NodeSE2::initMotionModel(
+    nav2_smac_planner::MotionModel::DUBIN, size_x_b, size_y_b, size_theta, info);
+  nav2_costmap_2d::Costmap2D * costmapB = new nav2_costmap_2d::Costmap2D(
+    size_x_b, size_y_b, 0.05, 0.0, 0.0, 0);
+  std::copy(
+    costmapA->getCharMap(), costmapA->getCharMap() + size_x * size_y, costmapB->getCharMap());
+  nav2_smac_planner::NodeSE2::computeWavefrontHeuristic(costmapB, 20u, 20u, 40u, 23u);
+  EXPECT_FALSE(stats.last_was_cache_hit);
+  delete costmapB;
+
+  nav2_smac_planner::NodeSE2::setWavefrontHeuristicOptions(false, 1);
+  delete costmapA;
+}
+
+TEST(NodeSE2Test, test_distance_heuristic_table)
+{
+  const float turning_radius = 8.0f;
+  const unsigned int bins = 72;
+  const float bin_size = 2.0f * M_PI / bins;
+  ompl::base::StateSpacePtr state_space =
+    std::make_shared<ompl::base::DubinsStateSpace>(turning_radius);
+
+  nav2_smac_planner::DistanceHeuristicTable table;
+  table.initialize(
+    state_space, nav2_smac_planner::MotionModel::DUBIN, turning_radius, bins, 81, "");
+  EXPECT_FALSE(table.wasLoadedFromCache());
+  EXPECT_TRUE(table.getCachePath().empty());
+
+  // Lookups within the window never overestimate the exact distance, and are close to it
+  // on the whole
+  ompl::base::ScopedState<> from(state_space), to(state_space);
+  float distance;
+  unsigned int found = 0;
+  double total = 0.0, total_exact = 0.0;
+  for (unsigned int goal_theta = 0; goal_theta < bins; goal_theta += 7) {
+    for (int x = 12; x <= 68; x += 4) {
+      for (int y = 12; y <= 68; y += 4) {
+        for (unsigned int theta = 0; theta < bins; theta += 5) {
+          if (!table.lookup(x, y, theta, 40.0f, 40.0f, goal_theta, distance)) {
+            // Only near the goal, where the exact distance is used
+            EXPECT_LT(std::hypot(x - 40.0f, y - 40.0f), 2.0f * turning_radius + 1.0f);
+            continue;
+          }
+          found++;
+          from[0] = x;
+          from[1] = y;
+          from[2] = theta * bin_size;
+          to[0] = 40.0;
+          to[1] = 40.0;
+          to[2] = goal_theta * bin_size;
+          const float exact = state_space->distance(from(), to());
+          EXPECT_LE(distance, exact + 1e-3f);
+          total += distance;
+          total_exact += exact;
+        }
+      }
+    }
+  }
+  EXPECT_GT(found, 0u);
+  EXPECT_GT(total / total_exact, 0.9);
+
+  // Out of the window
+  EXPECT_FALSE(table.lookup(100.0f, 100.0f, 0.0f, 40.0f, 40.0f, 0.0f, distance));
+
+  // Persist the table and map it back from the cache
+  const std::string cache_dir = "/tmp";
+  nav2_smac_planner::DistanceHeuristicTable built;
+  built.initialize(
+    state_space, nav2_smac_planner::MotionModel::DUBIN, turning_radius, bins, 41, cache_dir);
+  std::remove(built.getCachePath().c_str());
+  built.initialize(
+    state_space, nav2_smac_planner::MotionModel::DUBIN, turning_radius, bins, 41, cache_dir);
+  EXPECT_FALSE(built.wasLoadedFromCache());
+
+  nav2_smac_planner::DistanceHeuristicTable loaded;
+  loaded.initialize(
+    state_space, nav2_smac_planner::MotionModel::DUBIN, turning_radius, bins, 41, cache_dir);
+  EXPECT_TRUE(loaded.wasLoadedFromCache());
+  EXPECT_EQ(loaded.getCachePath(), built.getCachePath());
+
+  float built_distance, loaded_distance;
+  for (unsigned int theta = 0; theta < bins; theta++) {
+    EXPECT_TRUE(built.lookup(25.0f, 30.0f, theta, 40.0f, 40.0f, 3.0f, built_distance));
+    EXPECT_TRUE(loaded.lookup(25.0f, 30.0f, theta, 40.0f, 40.0f, 3.0f, loaded_distance));
+    EXPECT_EQ(built_distance, loaded_distance);
+  }
+
+  // A different configuration does not reuse the cache
+  nav2_smac_planner::DistanceHeuristicTable other;
+  other.initialize(
+    state_space, nav2_smac_planner::MotionModel::DUBIN, turning_radius, bins, 21, cache_dir);
+  EXPECT_NE(other.getCachePath(), built.getCachePath());
+
+  std::remove(built.getCachePath().c_str());
+  std::remove(other.getCachePath().c_str());
+}
+
+TEST(NodeSE2Test, test_distance_heuristic_table_reuse)
+{
+  nav2_smac_planner::SearchInfo info;
+  info.change_penalty = 1.2;
+  info.non_straight_penalty = 1.4;
+  info.reverse_penalty = 2.1;
+  info.minimum_turning_radius = 4.0;
+  info.lookup_table_size = 21.0;
+  unsigned int size_x = 100;
+  unsigned int size_y = 100;
+  unsigned int size_theta = 72;
+  nav2_smac_planner::NodeSE2::initMotionModel(
+    nav2_smac_planner::MotionModel::DUBIN, size_x, size_y, size_theta, info);
+  const auto table = nav2_smac_planner::NodeSE2::motion_table.distance_heuristic_table;
+  ASSERT_TRUE(table);
+
+  // A new costmap size keeps the table
+  size_x = 200;
+  nav2_smac_planner::NodeSE2::initMotionModel(
+    nav2_smac_planner::MotionModel::DUBIN, size_x, size_y, size_theta, info);
+  EXPECT_EQ(nav2_smac_planner::NodeSE2::motion_table.distance_heuristic_table, table);
+
+  // A new window, turning radius or motion model rebuilds it
+  info.lookup_table_size = 31.0;
+  nav2_smac_planner::NodeSE2::initMotionModel(
+    nav2_smac_planner::MotionModel::DUBIN, size_x, size_y, size_theta, info);
+  EXPECT_NE(nav2_smac_planner::NodeSE2::motion_table.distance_heuristic_table, table);
+
+  const auto window_table = nav2_smac_planner::NodeSE2::motion_table.distance_heuristic_table;
+  info.minimum_turning_radius = 5.0;
+  nav2_smac_planner::NodeSE2::initMotionModel(
+    nav2_smac_planner::MotionModel::DUBIN, size_x, size_y, size_theta, info);
+  EXPECT_NE(nav2_smac_planner::NodeSE2::motion_table.distance_heuristic_table, window_table);
+
+  const auto radius_table = nav2_smac_planner::NodeSE2::motion_table.distance_heuristic_table;
+  nav2_smac_planner::NodeSE2::initMotionModel(
+    nav2_smac_planner::MotionModel::REEDS_SHEPP, size_x, size_y, size_theta, info);
+  EXPECT_NE(nav2_smac_planner::NodeSE2::motion_table.distance_heuristic_table, radius_table);
+
+  // Disabling it drops the table
+  info.lookup_table_size = 0.0;
+  nav2_smac_planner::NodeSE2::initMotionModel(
+    nav2_smac_planner::MotionModel::REEDS_SHEPP, size_x, size_y, size_theta, info);
+  EXPECT_FALSE(nav2_smac_planner::NodeSE2::motion_table.distance_heuristic_table);
+}
@@ -46,12 +46,6 @@
 #include <algorithm>
 #include "rclcpp/rclcpp.hpp"
 
-/**
- * @class VoxelGrid
- * @brief A 3D grid structure that stores points as an integer array.
- *        X and Y index the array and Z selects which bit of the integer
- *        is used giving a limit of 16 vertical cells.
- */
 namespace nav2_voxel_grid
 {
 
@@ -62,29 +56,185 @@ enum VoxelStatus
   MARKED = 2,
 };
 
-class VoxelGrid
+/**
+ * @struct Column128
+ * @brief A 128 bit column of 64 vertical cells, stored as two 64 bit words with the
+ *        layout of the two halves of the narrower columns: a cell is unknown when
+ *        only its low bit is set and marked when both its bits are set.
+ */
+struct Column128
+{
+  uint64_t low;
+  uint64_t high;
+
+  inline Column128 operator|(const Column128 & other) const
+  {
+    return Column128{low | other.low, high | other.high};
+  }
+
+  inline Column128 operator&(const Column128 & other) const
+  {
+    return Column128{low & other.low, high & other.high};
+  }
+
+  inline Column128 operator~() const
+  {
+    return Column128{~low, ~high};
+  }
+
+  inline Column128 & operator|=(const Column128 & other)
+  {
+    low |= other.low;
+    high |= other.high;
+    return *this;
+  }
+
+  inline Column128 & operator&=(const Column128 & other)
+  {
+    low &= other.low;
+    high &= other.high;
+    return *this;
+  }
+
+  inline bool operator==(const Column128 & other) const
+  {
+    return low == other.low && high == other.high;
+  }
+};
+
+/**
+ * @struct ColumnTraits
+ * @brief The bit operations on a column word of a voxel grid. The low half of a
+ *        column holds a bit per cell that is set while the cell is unknown or marked,
+ *        the high half a bit per cell that is set while it is marked. Bits are
+ *        counted with popcount instructions rather than by clearing them one by one.
+ */
+template<typename ColumnT>
+struct ColumnTraits;
+
+template<>
+struct ColumnTraits<uint32_t>
+{
+  static constexpr unsigned int levels = 16;
+
+  static inline uint32_t unknown() {return ~((uint32_t)0) >> 16;}
+
+  static inline uint32_t mask(unsigned int z) {return ((uint32_t)1 << z << 16) | (1 << z);}
+
+  static inline unsigned int numBits(uint32_t col) {return __builtin_popcount(col);}
+
+  static inline unsigned int markedBits(uint32_t col) {return __builtin_popcount(col >> 16);}
+
+  static inline unsigned int unknownBits(uint32_t col)
+  {
+    return __builtin_popcount(uint16_t(col >> 16) ^ uint16_t(col));
+  }
+
+  static inline void shiftUp(uint32_t & z_mask) {z_mask <<= 1;}
+
+  static inline void shiftDown(uint32_t & z_mask) {z_mask >>= 1;}
+};
+
+template<>
+struct ColumnTraits<uint64_t>
+{
+  static constexpr unsigned int levels = 32;
+
+  static inline uint64_t unknown() {return ~((uint64_t)0) >> 32;}
+
+  static inline uint64_t mask(unsigned int z)
+  {
+    return ((uint64_t)1 << z << 32) | ((uint64_t)1 << z);
+  }
+
+  static inline unsigned int numBits(uint64_t col) {return __builtin_popcountll(col);}
+
+  static inline unsigned int markedBits(uint64_t col) {return __builtin_popcountll(col >> 32);}
+
+  static inline unsigned int unknownBits(uint64_t col)
+  {
+    return __builtin_popcount(uint32_t(col >> 32) ^ uint32_t(col));
+  }
+
+  static inline void shiftUp(uint64_t & z_mask) {z_mask <<= 1;}
+
+  static inline void shiftDown(uint64_t & z_mask) {z_mask >>= 1;}
+};
+
+template<>
+struct ColumnTraits<Column128>
+{
+  static constexpr unsigned int levels = 64;
+
+  static inline Column128 unknown() {return Column128{~((uint64_t)0), 0};}
+
+  static inline Column128 mask(unsigned int z)
+  {
+    return Column128{(uint64_t)1 << z, (uint64_t)1 << z};
+  }
+
+  static inline unsigned int numBits(const Column128 & col)
+  {
+    return __builtin_popcountll(col.low) + __builtin_popcountll(col.high);
+  }
+
+  static inline unsigned int markedBits(const Column128 & col)
+  {
+    return __builtin_popcountll(col.high);
+  }
+
+  static inline unsigned int unknownBits(const Column128 & col)
+  {
+    return __builtin_popcountll(col.low ^ col.high);
+  }
+
+  static inline void shiftUp(Column128 & z_mask)
+  {
+    z_mask.low <<= 1;
+    z_mask.high <<= 1;
+  }
+
+  static inline void shiftDown(Column128 & z_mask)
+  {
+    z_mask.low >>= 1;
+    z_mask.high >>= 1;
+  }
+};
+
+/**
+ * @class BasicVoxelGrid
+ * @brief A 3D grid structure that stores points as an array of column words.
+ *        X and Y index the array and Z selects which bits of the column word
+ *        are used, giving a limit of 16 vertical cells for 32 bit columns, 32 for
+ *        64 bit columns and 64 for 128 bit columns.
+ */
+template<typename ColumnT>
+class BasicVoxelGrid
 {
 public:
+  typedef ColumnT Column;
+  typedef ColumnTraits<ColumnT> Traits;
+
   /**
    * @brief  Constructor for a voxel grid
    * @param size_x The x size of the grid
    * @param size_y The y size of the grid
-   * @param size_z The z size of the grid, only sizes <= 16 are supported
+   * @param size_z The z size of the grid, only sizes <= Traits::levels are supported
    */
-  VoxelGrid(unsigned int size_x, unsigned int size_y, unsigned int size_z);
+  BasicVoxelGrid(unsigned int size_x, unsigned int size_y, unsigned int size_z);
 
-  ~VoxelGrid();
+  ~BasicVoxelGrid();
 
   /**
    * @brief  Resizes a voxel grid to the desired size
    * @param size_x The x size of the grid
    * @param size_y The y size of the grid
-   * @param size_z The z size of the grid, only sizes <= 16 are supported
+   * @param size_z The z size of the grid, only sizes <= Traits::levels are supported
    */
   void resize(unsigned int size_x, unsigned int size_y, unsigned int size_z);
 
   void reset();
-  uint32_t * getData() {return data_;}
+  ColumnT * getData() {return data_;}
 
   inline void markVoxel(unsigned int x, unsigned int y, unsigned int z)
   {
@@ -92,8 +242,7 @@ public:
       RCLCPP_DEBUG(logger, "Error, voxel out of bounds.\n");
       return;
     }
-    uint32_t full_mask = ((uint32_t)1 << z << 16) | (1 << z);
-    data_[y * size_x_ + x] |= full_mask;  // clear unknown and mark cell
+    data_[y * size_x_ + x] |= Traits::mask(z);  // clear unknown and mark cell
   }
 
   inline bool markVoxelInMap(
@@ -106,14 +255,11 @@ public:
     }
 
     int index = y * size_x_ + x;
-    uint32_t * col = &data_[index];
-    uint32_t full_mask = ((uint32_t)1 << z << 16) | (1 << z);
-    *col |= full_mask;  // clear unknown and mark cell
-
-    unsigned int marked_bits = *col >> 16;
+    ColumnT * col = &data_[index];
+    *col |= Traits::mask(z);  // clear unknown and mark cell
 
     // make sure the number of bits in each is below our thesholds
-    return !bitsBelowThreshold(marked_bits, marked_threshold);
+    return Traits::markedBits(*col) > marked_threshold;
   }
 
   inline void clearVoxel(unsigned int x, unsigned int y, unsigned int z)
@@ -122,14 +268,24 @@ public:
       RCLCPP_DEBUG(logger, "Error, voxel out of bounds.\n");
       return;
     }
-    uint32_t full_mask = ((uint32_t)1 << z << 16) | (1 << z);
-    data_[y * size_x_ + x] &= ~(full_mask);  // clear unknown and clear cell
+    data_[y * size_x_ + x] &= ~Traits::mask(z);  // clear unknown and clear cell
   }
 
   inline void clearVoxelColumn(unsigned int index)
   {
     assert(index < size_x_ * size_y_);
-    data_[index] = 0;
+    data_[index] = ColumnT();
+  }
+
+  /**
+   * @brief  Clears a run of consecutive columns, as a single fill of the column words
+   * @param index The index of the first column
+   * @param count The number of columns to clear
+   */
+  inline void clearVoxelColumns(unsigned int index, unsigned int count)
+  {
+    assert(index + count <= size_x_ * size_y_);
+    std::fill(data_ + index, data_ + index + count, ColumnT());
   }
 
   inline void clearVoxelInMap(unsigned int x, unsigned int y, unsigned int z)
@@ -139,51 +295,33 @@ public:
       return;
     }
     int index = y * size_x_ + x;
-    uint32_t * col = &data_[index];
-    uint32_t full_mask = ((uint32_t)1 << z << 16) | (1 << z);
-    *col &= ~(full_mask);  // clear unknown and clear cell
-
-    unsigned int unknown_bits = uint16_t(*col >> 16) ^ uint16_t(*col);
-    unsigned int marked_bits = *col >> 16;
+    ColumnT * col = &data_[index];
+    *col &= ~Traits::mask(z);  // clear unknown and clear cell
 
     // make sure the number of bits in each is below our thesholds
-    if (bitsBelowThreshold(unknown_bits, 1) && bitsBelowThreshold(marked_bits, 1)) {
+    if (Traits::unknownBits(*col) <= 1 && Traits::markedBits(*col) <= 1) {
       costmap[index] = 0;
     }
   }
 
   inline bool bitsBelowThreshold(unsigned int n, unsigned int bit_threshold)
   {
-    unsigned int bit_count;
-    for (bit_count = 0; n; ) {
-      ++bit_count;
-      if (bit_count > bit_threshold) {
-        return false;
-      }
-      n &= n - 1;  // clear the least significant bit set
-    }
-    return true;
+    return numBits(n) <= bit_threshold;
   }
 
   static inline unsigned int numBits(unsigned int n)
   {
-    unsigned int bit_count;
-    for (bit_count = 0; n; ++bit_count) {
-      n &= n - 1;  // clear the least significant bit set
-    }
-    return bit_count;
+    return __builtin_popcount(n);
   }
 
   static VoxelStatus getVoxel(
     unsigned int x, unsigned int y, unsigned int z,
-    unsigned int size_x, unsigned int size_y, unsigned int size_z, const uint32_t * data)
+    unsigned int size_x, unsigned int size_y, unsigned int size_z, const ColumnT * data)
   {
     if (x >= size_x || y >= size_y || z >= size_z) {
       return UNKNOWN;
     }
-    uint32_t full_mask = ((uint32_t)1 << z << 16) | (1 << z);
-    uint32_t result = data[y * size_x + x] & full_mask;
-    unsigned int bits = numBits(result);
+    unsigned int bits = Traits::numBits(data[y * size_x + x] & Traits::mask(z));
 
     // known marked: 11 = 2 bits, unknown: 01 = 1 bit, known free: 00 = 0 bits
     if (bits < 2) {
@@ -252,7 +390,7 @@ public:
     double min_z0 = z0 + dz / dist * min_length;
 
 
-    unsigned int z_mask = ((1 << 16) | 1) << (unsigned int)min_z0;
+    ColumnT z_mask = Traits::mask((unsigned int)min_z0);
     unsigned int offset = (unsigned int)min_y0 * size_x_ + (unsigned int)min_x0;
 
     GridOffset grid_off(offset);
@@ -301,7 +439,7 @@ private:
     ActionType at, OffA off_a, OffB off_b, OffC off_c,
     unsigned int abs_da, unsigned int abs_db, unsigned int abs_dc,
     int error_b, int error_c, int offset_a, int offset_b, int offset_c, unsigned int & offset,
-    unsigned int & z_mask, unsigned int max_length = UINT_MAX)
+    ColumnT & z_mask, unsigned int max_length = UINT_MAX)
   {
     unsigned int end = std::min(max_length, abs_da);
     for (unsigned int i = 0; i < end; ++i) {
@@ -332,7 +470,7 @@ private:
   }
 
   unsigned int size_x_, size_y_, size_z_;
-  uint32_t * data_;
+  ColumnT * data_;
   unsigned char * costmap;
   rclcpp::Logger logger;
 
@@ -341,36 +479,36 @@ private:
   class MarkVoxel
   {
 public:
-    explicit MarkVoxel(uint32_t * data)
+    explicit MarkVoxel(ColumnT * data)
     : data_(data) {}
-    inline void operator()(unsigned int offset, unsigned int z_mask)
+    inline void operator()(unsigned int offset, const ColumnT & z_mask)
     {
       data_[offset] |= z_mask;  // clear unknown and mark cell
     }
 
 private:
-    uint32_t * data_;
+    ColumnT * data_;
   };
 
   class ClearVoxel
   {
 public:
-    explicit ClearVoxel(uint32_t * data)
+    explicit ClearVoxel(ColumnT * data)
     : data_(data) {}
-    inline void operator()(unsigned int offset, unsigned int z_mask)
+    inline void operator()(unsigned int offset, const ColumnT & z_mask)
     {
       data_[offset] &= ~(z_mask);  // clear unknown and clear cell
     }
 
 private:
-    uint32_t * data_;
+    ColumnT * data_;
   };
 
   class ClearVoxelInMap
   {
 public:
     ClearVoxelInMap(
-      uint32_t * data, unsigned char * costmap,
+      ColumnT * data, unsigned char * costmap,
       unsigned int unknown_clear_threshold, unsigned int marked_clear_threshold,
       unsigned char free_cost = 0, unsigned char unknown_cost = 255)
     : data_(data), costmap_(costmap),
@@ -380,17 +518,14 @@ public:
     {
     }
 
-    inline void operator()(unsigned int offset, unsigned int z_mask)
+    inline void operator()(unsigned int offset, const ColumnT & z_mask)
     {
-      uint32_t * col = &data_[offset];
+      ColumnT * col = &data_[offset];
       *col &= ~(z_mask);  // clear unknown and clear cell
 
-      unsigned int unknown_bits = uint16_t(*col >> 16) ^ uint16_t(*col);
-      unsigned int marked_bits = *col >> 16;
-
       // make sure the number of bits in each is below our thesholds
-      if (bitsBelowThreshold(marked_bits, marked_clear_threshold_)) {
-        if (bitsBelowThreshold(unknown_bits, unknown_clear_threshold_)) {
+      if (Traits::markedBits(*col) <= marked_clear_threshold_) {
+        if (Traits::unknownBits(*col) <= unknown_clear_threshold_) {
           costmap_[offset] = free_cost_;
         } else {
           costmap_[offset] = unknown_cost_;
@@ -399,20 +534,7 @@ public:
     }
 
 private:
-    inline bool bitsBelowThreshold(unsigned int n, unsigned int bit_threshold)
-    {
-      unsigned int bit_count;
-      for (bit_count = 0; n; ) {
-        ++bit_count;
-        if (bit_count > bit_threshold) {
-          return false;
-        }
-        n &= n - 1;  // clear the least significant bit set
-      }
-      return true;
-    }
-
-    uint32_t * data_;
+    ColumnT * data_;
     unsigned char * costmap_;
     unsigned int unknown_clear_threshold_, marked_clear_threshold_;
     unsigned char free_cost_, unknown_cost_;
@@ -435,18 +557,27 @@ private:
   class ZOffset
   {
 public:
-    explicit ZOffset(unsigned int & z_mask)
+    explicit ZOffset(ColumnT & z_mask)
     : z_mask_(z_mask) {}
     inline void operator()(int offset_val)
     {
-      offset_val > 0 ? z_mask_ <<= 1 : z_mask_ >>= 1;
+      offset_val > 0 ? Traits::shiftUp(z_mask_) : Traits::shiftDown(z_mask_);
     }
 
 private:
-    unsigned int & z_mask_;
+    ColumnT & z_mask_;
   };
 };
 
+// The 16 level grid of 32 bit columns, matching the layout of nav2_msgs/VoxelGrid
+typedef BasicVoxelGrid<uint32_t> VoxelGrid;
+typedef BasicVoxelGrid<uint64_t> VoxelGrid32;
+typedef BasicVoxelGrid<Column128> VoxelGrid64;
+
+extern template class BasicVoxelGrid<uint32_t>;
+extern template class BasicVoxelGrid<uint64_t>;
+extern template class BasicVoxelGrid<Column128>;
+
 }  // namespace nav2_voxel_grid
 
 #endif  // NAV2_VOXEL_GRID__VOXEL_GRID_HPP_
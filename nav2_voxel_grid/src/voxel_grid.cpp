@@ -38,30 +38,29 @@
 
 namespace nav2_voxel_grid
 {
-VoxelGrid::VoxelGrid(unsigned int size_x, unsigned int size_y, unsigned int size_z)
+template<typename ColumnT>
+BasicVoxelGrid<ColumnT>::BasicVoxelGrid(
+  unsigned int size_x, unsigned int size_y,
+  unsigned int size_z)
 : logger(rclcpp::get_logger("voxel_grid"))
 {
   size_x_ = size_x;
   size_y_ = size_y;
   size_z_ = size_z;
 
-  if (size_z_ > 16) {
+  if (size_z_ > Traits::levels) {
     RCLCPP_INFO(
-      logger, "Error, this implementation can only support up to 16 z values (%d)",
-      size_z_);
-    size_z_ = 16;
+      logger, "Error, this implementation can only support up to %u z values (%d)",
+      Traits::levels, size_z_);
+    size_z_ = Traits::levels;
   }
 
-  data_ = new uint32_t[size_x_ * size_y_];
-  uint32_t unknown_col = ~((uint32_t)0) >> 16;
-  uint32_t * col = data_;
-  for (unsigned int i = 0; i < size_x_ * size_y_; ++i) {
-    *col = unknown_col;
-    ++col;
-  }
+  data_ = new ColumnT[size_x_ * size_y_];
+  std::fill(data_, data_ + size_x_ * size_y_, Traits::unknown());
 }
 
-void VoxelGrid::resize(unsigned int size_x, unsigned int size_y, unsigned int size_z)
+template<typename ColumnT>
+void BasicVoxelGrid<ColumnT>::resize(unsigned int size_x, unsigned int size_y, unsigned int size_z)
 {
   // if we're not actually changing the size, we can just reset things
   if (size_x == size_x_ && size_y == size_y_ && size_z == size_z_) {
@@ -74,38 +73,31 @@ void VoxelGrid::resize(unsigned int size_x, unsigned int size_y, unsigned int si
   size_y_ = size_y;
   size_z_ = size_z;
 
-  if (size_z_ > 16) {
+  if (size_z_ > Traits::levels) {
     RCLCPP_INFO(
-      logger, "Error, this implementation can only support up to 16 z values (%d)",
-      size_z);
-    size_z_ = 16;
+      logger, "Error, this implementation can only support up to %u z values (%d)",
+      Traits::levels, size_z_);
+    size_z_ = Traits::levels;
   }
 
-  data_ = new uint32_t[size_x_ * size_y_];
-  uint32_t unknown_col = ~((uint32_t)0) >> 16;
-  uint32_t * col = data_;
-  for (unsigned int i = 0; i < size_x_ * size_y_; ++i) {
-    *col = unknown_col;
-    ++col;
-  }
+  data_ = new ColumnT[size_x_ * size_y_];
+  std::fill(data_, data_ + size_x_ * size_y_, Traits::unknown());
 }
 
-VoxelGrid::~VoxelGrid()
+template<typename ColumnT>
+BasicVoxelGrid<ColumnT>::~BasicVoxelGrid()
 {
   delete[] data_;
 }
 
-void VoxelGrid::reset()
+template<typename ColumnT>
+void BasicVoxelGrid<ColumnT>::reset()
 {
-  uint32_t unknown_col = ~((uint32_t)0) >> 16;
-  uint32_t * col = data_;
-  for (unsigned int i = 0; i < size_x_ * size_y_; ++i) {
-    *col = unknown_col;
-    ++col;
-  }
+  std::fill(data_, data_ + size_x_ * size_y_, Traits::unknown());
 }
 
-void VoxelGrid::markVoxelLine(
+template<typename ColumnT>
+void BasicVoxelGrid<ColumnT>::markVoxelLine(
   double x0, double y0, double z0, double x1, double y1, double z1,
   unsigned int max_length)
 {
@@ -124,7 +116,8 @@ void VoxelGrid::markVoxelLine(
   raytraceLine(mv, x0, y0, z0, x1, y1, z1, max_length);
 }
 
-void VoxelGrid::clearVoxelLine(
+template<typename ColumnT>
+void BasicVoxelGrid<ColumnT>::clearVoxelLine(
   double x0, double y0, double z0, double x1, double y1, double z1,
   unsigned int max_length, unsigned int min_length)
 {
@@ -143,7 +136,8 @@ void VoxelGrid::clearVoxelLine(
   raytraceLine(cv, x0, y0, z0, x1, y1, z1, max_length, min_length);
 }
 
-void VoxelGrid::clearVoxelLineInMap(
+template<typename ColumnT>
+void BasicVoxelGrid<ColumnT>::clearVoxelLineInMap(
   double x0, double y0, double z0, double x1, double y1, double z1, unsigned char * map_2d,
   unsigned int unknown_threshold, unsigned int mark_threshold, unsigned char free_cost,
   unsigned char unknown_cost, unsigned int max_length, unsigned int min_length)
@@ -169,15 +163,14 @@ void VoxelGrid::clearVoxelLineInMap(
   raytraceLine(cvm, x0, y0, z0, x1, y1, z1, max_length, min_length);
 }
 
-VoxelStatus VoxelGrid::getVoxel(unsigned int x, unsigned int y, unsigned int z)
+template<typename ColumnT>
+VoxelStatus BasicVoxelGrid<ColumnT>::getVoxel(unsigned int x, unsigned int y, unsigned int z)
 {
   if (x >= size_x_ || y >= size_y_ || z >= size_z_) {
     RCLCPP_DEBUG(logger, "Error, voxel out of bounds. (%d, %d, %d)\n", x, y, z);
     return UNKNOWN;
   }
-  uint32_t full_mask = ((uint32_t)1 << z << 16) | (1 << z);
-  uint32_t result = data_[y * size_x_ + x] & full_mask;
-  unsigned int bits = numBits(result);
+  unsigned int bits = Traits::numBits(data_[y * size_x_ + x] & Traits::mask(z));
 
   // known marked: 11 = 2 bits, unknown: 01 = 1 bit, known free: 00 = 0 bits
   if (bits < 2) {
@@ -191,7 +184,8 @@ VoxelStatus VoxelGrid::getVoxel(unsigned int x, unsigned int y, unsigned int z)
   return MARKED;
 }
 
-VoxelStatus VoxelGrid::getVoxelColumn(
+template<typename ColumnT>
+VoxelStatus BasicVoxelGrid<ColumnT>::getVoxelColumn(
   unsigned int x, unsigned int y,
   unsigned int unknown_threshold, unsigned int marked_threshold)
 {
@@ -200,40 +194,41 @@ VoxelStatus VoxelGrid::getVoxelColumn(
     return UNKNOWN;
   }
 
-  uint32_t * col = &data_[y * size_x_ + x];
-
-  unsigned int unknown_bits = uint16_t(*col >> 16) ^ uint16_t(*col);
-  unsigned int marked_bits = *col >> 16;
+  const ColumnT & col = data_[y * size_x_ + x];
 
   // check if the number of marked bits qualifies the col as marked
-  if (!bitsBelowThreshold(marked_bits, marked_threshold)) {
+  if (Traits::markedBits(col) > marked_threshold) {
     return MARKED;
   }
 
   // check if the number of unkown bits qualifies the col as unknown
-  if (!bitsBelowThreshold(unknown_bits, unknown_threshold)) {
+  if (Traits::unknownBits(col) > unknown_threshold) {
     return UNKNOWN;
   }
 
   return FREE;
 }
 
-unsigned int VoxelGrid::sizeX()
+template<typename ColumnT>
+unsigned int BasicVoxelGrid<ColumnT>::sizeX()
 {
   return size_x_;
 }
 
-unsigned int VoxelGrid::sizeY()
+template<typename ColumnT>
+unsigned int BasicVoxelGrid<ColumnT>::sizeY()
 {
   return size_y_;
 }
 
-unsigned int VoxelGrid::sizeZ()
+template<typename ColumnT>
+unsigned int BasicVoxelGrid<ColumnT>::sizeZ()
 {
   return size_z_;
 }
 
-void VoxelGrid::printVoxelGrid()
+template<typename ColumnT>
+void BasicVoxelGrid<ColumnT>::printVoxelGrid()
 {
   for (unsigned int z = 0; z < size_z_; z++) {
     printf("Layer z = %u:\n", z);
@@ -246,14 +241,20 @@ void VoxelGrid::printVoxelGrid()
   }
 }
 
-void VoxelGrid::printColumnGrid()
+template<typename ColumnT>
+void BasicVoxelGrid<ColumnT>::printColumnGrid()
 {
   printf("Column view:\n");
   for (unsigned int y = 0; y < size_y_; y++) {
     for (unsigned int x = 0; x < size_x_; x++) {
-      printf((getVoxelColumn(x, y, 16, 0) == nav2_voxel_grid::MARKED) ? "#" : " ");
+      printf((getVoxelColumn(x, y, Traits::levels, 0) == nav2_voxel_grid::MARKED) ? "#" : " ");
     }
     printf("|\n");
   }
 }
+
+template class BasicVoxelGrid<uint32_t>;
+template class BasicVoxelGrid<uint64_t>;
+template class BasicVoxelGrid<Column128>;
+
 }  // namespace nav2_voxel_grid
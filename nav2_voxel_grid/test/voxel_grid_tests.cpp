@@ -197,6 +197,69 @@ TEST(voxel_grid, GetVoxelData) {
   delete[] data;
 }
 
+template<typename GridT>
+void testColumnLevels(unsigned int size_z)
+{
+  int size_x = 10, size_y = 10;
+  GridT vg(size_x, size_y, size_z);
+  EXPECT_EQ(vg.sizeZ(), size_z);
+
+  // every level of a column is marked and cleared on its own
+  for (unsigned int z = 0; z < size_z; ++z) {
+    EXPECT_EQ(vg.getVoxel(3, 4, z), nav2_voxel_grid::UNKNOWN);
+    vg.markVoxel(3, 4, z);
+    EXPECT_EQ(vg.getVoxel(3, 4, z), nav2_voxel_grid::MARKED);
+  }
+  EXPECT_EQ(vg.getVoxelColumn(3, 4, 0, size_z - 1), nav2_voxel_grid::MARKED);
+  EXPECT_EQ(vg.getVoxelColumn(3, 4, 0, size_z), nav2_voxel_grid::FREE);
+
+  vg.clearVoxel(3, 4, size_z - 1);
+  EXPECT_EQ(vg.getVoxel(3, 4, size_z - 1), nav2_voxel_grid::FREE);
+  EXPECT_EQ(vg.getVoxel(3, 4, size_z - 2), nav2_voxel_grid::MARKED);
+
+  // a vertical line clears the topmost levels of the column
+  vg.clearVoxelLine(3, 4, 0, 3, 4, size_z - 1);
+  for (unsigned int z = 0; z < size_z; ++z) {
+    EXPECT_EQ(vg.getVoxel(3, 4, z), nav2_voxel_grid::FREE);
+  }
+
+  // the marked and unknown levels of a column are counted against the thresholds
+  EXPECT_FALSE(vg.markVoxelInMap(5, 5, size_z - 1, 1));
+  EXPECT_TRUE(vg.markVoxelInMap(5, 5, size_z - 3, 1));
+  vg.markVoxel(5, 5, 0);
+  unsigned char map_2d[100];
+  map_2d[55] = 254;
+  vg.clearVoxelLineInMap(5, 5, size_z - 1, 5, 5, size_z - 3, map_2d, size_z, 0);
+  EXPECT_EQ(map_2d[55], 254);
+  vg.clearVoxelLineInMap(5, 5, size_z - 1, 5, 5, size_z - 3, map_2d, 0, 1, 0, 255);
+  EXPECT_EQ(map_2d[55], 255);
+  vg.clearVoxelLineInMap(5, 5, size_z - 1, 5, 5, size_z - 3, map_2d, size_z, 1);
+  EXPECT_EQ(map_2d[55], 0);
+
+  vg.clearVoxelColumns(50, 10);
+  EXPECT_EQ(vg.getVoxelColumn(5, 5, 0, 0), nav2_voxel_grid::FREE);
+  EXPECT_EQ(vg.getVoxelColumn(0, 6, 0, 0), nav2_voxel_grid::UNKNOWN);
+
+  vg.reset();
+  EXPECT_EQ(vg.getVoxel(3, 4, size_z - 1), nav2_voxel_grid::UNKNOWN);
+
+  // sizes above the levels of the column are capped
+  vg.resize(size_x, size_y, GridT::Traits::levels + 1);
+  EXPECT_EQ(vg.sizeZ(), GridT::Traits::levels);
+}
+
+TEST(voxel_grid, ColumnLevels16) {
+  testColumnLevels<nav2_voxel_grid::VoxelGrid>(16);
+}
+
+TEST(voxel_grid, ColumnLevels32) {
+  testColumnLevels<nav2_voxel_grid::VoxelGrid32>(32);
+}
+
+TEST(voxel_grid, ColumnLevels64) {
+  testColumnLevels<nav2_voxel_grid::VoxelGrid64>(64);
+}
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);